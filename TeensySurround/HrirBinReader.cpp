@@ -0,0 +1,413 @@
+#include "HrirBinReader.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+HrirBinReader::HrirBinReader()
+: variable(false), fileSampleRate(0), fixedLength(0), measurementCount(0),
+  measurementIndex(0), maxFixed(0), pcaComponents(0), fileMinimumPhase(0), leftOnly(false),
+  sectionCount(0), coeffStride(0), spectrumBlock(0), spectrumSize(0),
+  currentSection(-1), sectionRead(0), sectionCrc(0),
+  az(0.0f), el(0.0f), dist(0.0f), len(0),
+  leftBuf(nullptr), rightBuf(nullptr), capacity(0), weightBuf(nullptr), itdL(0.0f), itdR(0.0f)
+{
+}
+
+HrirBinReader::~HrirBinReader() {
+    close();
+    free(leftBuf);
+    free(rightBuf);
+    free(weightBuf);
+}
+
+// CRC-32 (polynôme 0xEDB88320, celui de zlib.crc32), table calculée au premier appel
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t n) {
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        ready = true;
+    }
+    for (size_t i = 0; i < n; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t u32At(const uint8_t* p) {
+    return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+bool HrirBinReader::readU32(uint32_t& val) {
+    byte tmp[4];
+    if (f.read(tmp, 4) < 4) {
+        return false;
+    }
+    val = (uint32_t)(tmp[0] | (tmp[1] << 8) | (tmp[2] << 16) | (tmp[3] << 24));
+    return true;
+}
+
+float HrirBinReader::readFloat() {
+    byte tmp[4];
+    if (f.read(tmp, 4) < 4) {
+        return 0.0f;
+    }
+    union {
+        uint32_t u;
+        float f;
+    } conv;
+    conv.u = (uint32_t)(tmp[0] | (tmp[1] << 8) | (tmp[2] << 16) | (tmp[3] << 24));
+    return conv.f;
+}
+
+bool HrirBinReader::reserve(size_t n) {
+    if (n <= capacity) {
+        return true;
+    }
+    float* l = (float*)realloc(leftBuf, n * sizeof(float));
+    if (l) {
+        leftBuf = l;
+    }
+    float* r = (float*)realloc(rightBuf, n * sizeof(float));
+    if (r) {
+        rightBuf = r;
+    }
+    if (!l || !r) {
+        return false;
+    }
+    capacity = n;
+    return true;
+}
+
+bool HrirBinReader::open(const String& filename, size_t maxFixedLength) {
+    close();
+    f = SD.open(filename.c_str(), FILE_READ);
+    if (!f) {
+        Serial.print("Impossible d'ouvrir le fichier ");
+        Serial.println(filename);
+        return false;
+    }
+
+    char magic[4];
+    if (f.read(magic, 4) < 4) {
+        Serial.println("Lecture magic échouée");
+        close();
+        return false;
+    }
+    // "HRIR" : longueur commune à toutes les mesures, tronquée à maxFixedLength
+    // "HRIV" : longueur propre à chaque mesure (BRIR)
+    // "HRIP" : base de composantes principales et poids par mesure
+    // "HRB2" : sections lues en bloc par la banque
+    bool pca = false;
+    bool v2 = false;
+    if (strncmp(magic, "HRIV", 4) == 0) {
+        variable = true;
+    } else if (strncmp(magic, "HRIR", 4) == 0) {
+        variable = false;
+    } else if (strncmp(magic, "HRIP", 4) == 0) {
+        variable = false;
+        pca = true;
+    } else if (strncmp(magic, "HRB2", 4) == 0) {
+        variable = false;
+        v2 = true;
+    } else {
+        Serial.println("Fichier bin invalide: magic != 'HRIR'/'HRIV'/'HRIP'/'HRB2'");
+        close();
+        return false;
+    }
+
+    pcaComponents = 0;
+    fileMinimumPhase = 0;
+    sectionCount = 0;
+    currentSection = -1;
+    bool headerOk;
+    if (v2) {
+        headerOk = readSections();
+        if (headerOk && (fixedLength > maxFixedLength || coeffStride < 2 * fixedLength ||
+                         coeffStride > 2 * maxFixedLength)) {
+            // Les taps sont lus tels quels dans la banque : pas de troncature
+            Serial.println("Fichier HRB2 invalide : filtres trop longs");
+            close();
+            return false;
+        }
+        len = fixedLength;
+    } else if (variable) {
+        headerOk = readU32(fileSampleRate) && readU32(measurementCount);
+    } else if (pca) {
+        headerOk = readU32(fileSampleRate) && readU32(fixedLength) && readU32(pcaComponents) &&
+                   readU32(measurementCount) && readU32(fileMinimumPhase);
+    } else {
+        headerOk = readU32(fileSampleRate) && readU32(fixedLength) && readU32(measurementCount);
+    }
+    if (headerOk && pca) {
+        // Les filtres reconstruits ne sont pas tronqués : la base doit tenir en maxFixedLength
+        if (pcaComponents == 0 || fixedLength == 0 || fixedLength > maxFixedLength) {
+            Serial.println("Fichier PCA invalide : base vide ou filtres trop longs");
+            close();
+            return false;
+        }
+        float* w = (float*)realloc(weightBuf, pcaComponents * sizeof(float));
+        if (!w) {
+            Serial.println("Mémoire insuffisante pour les poids PCA");
+            close();
+            return false;
+        }
+        weightBuf = w;
+        // Longueur commune des filtres, connue dès l'en-tête (readBasis)
+        len = fixedLength;
+    }
+    if (!headerOk) {
+        Serial.println("Erreur de lecture des entiers dans le fichier bin");
+        close();
+        return false;
+    }
+    maxFixed = maxFixedLength;
+    measurementIndex = 0;
+    return true;
+}
+
+bool HrirBinReader::readSections() {
+    // En-tête après le magic : version, headerBytes, sampleRate, M, longueur, stride, longueur de
+    // phase minimale, bloc et taille des spectres, nombre de sections, CRC de l'en-tête et de la
+    // table ; puis la table des sections (tag, offset, octets, CRC)
+    uint8_t header[48];
+    memcpy(header, "HRB2", 4);
+    if (f.read(header + 4, 44) < 44) {
+        return false;
+    }
+    const uint32_t version = u32At(header + 4);
+    const uint32_t count = u32At(header + 40);
+    if (version != 2 || count == 0 || count > (uint32_t)MAX_SECTIONS) {
+        Serial.println("Fichier HRB2 : version ou table de sections non reconnue");
+        return false;
+    }
+    uint8_t table[MAX_SECTIONS * 16];
+    if (f.read(table, count * 16) < (int)(count * 16)) {
+        return false;
+    }
+    uint32_t crc = crc32Update(0xFFFFFFFFu, header, 44);
+    crc = crc32Update(crc, table, count * 16);
+    if ((crc ^ 0xFFFFFFFFu) != u32At(header + 44)) {
+        Serial.println("Fichier HRB2 : en-tête corrompu (CRC)");
+        return false;
+    }
+    fileSampleRate   = u32At(header + 12);
+    measurementCount = u32At(header + 16);
+    fixedLength      = u32At(header + 20);
+    coeffStride      = u32At(header + 24);
+    fileMinimumPhase = u32At(header + 28);
+    spectrumBlock    = u32At(header + 32);
+    spectrumSize     = u32At(header + 36);
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(sections[i].tag, table + 16 * i, 4);
+        sections[i].offset = u32At(table + 16 * i + 4);
+        sections[i].bytes  = u32At(table + 16 * i + 8);
+        sections[i].crc    = u32At(table + 16 * i + 12);
+    }
+    sectionCount = (int)count;
+    return true;
+}
+
+int HrirBinReader::findSection(const char* tag) const {
+    for (int i = 0; i < sectionCount; i++) {
+        if (strncmp(sections[i].tag, tag, 4) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool HrirBinReader::openSection(const char* tag, uint32_t* bytes) {
+    currentSection = -1;
+    const int i = findSection(tag);
+    if (!f || i < 0 || !f.seek(sections[i].offset)) {
+        return false;
+    }
+    currentSection = i;
+    sectionRead = 0;
+    sectionCrc = 0xFFFFFFFFu;
+    if (bytes) {
+        *bytes = sections[i].bytes;
+    }
+    return true;
+}
+
+bool HrirBinReader::readSection(void* dest, size_t bytes) {
+    if (currentSection < 0 || sectionRead + bytes > sections[currentSection].bytes) {
+        return false;
+    }
+    if (f.read(dest, bytes) < (int)bytes) {
+        return false;
+    }
+    sectionCrc = crc32Update(sectionCrc, (const uint8_t*)dest, bytes);
+    sectionRead += bytes;
+    return true;
+}
+
+bool HrirBinReader::sectionValid() const {
+    return currentSection >= 0 && sectionRead == sections[currentSection].bytes &&
+           (sectionCrc ^ 0xFFFFFFFFu) == sections[currentSection].crc;
+}
+
+bool HrirBinReader::readBasis(float* basis) {
+    if (!f || pcaComponents == 0 || measurementIndex > 0) {
+        return false;
+    }
+    for (uint32_t v = 0; v <= pcaComponents; v++) {
+        float* filter = basis + (size_t)v * 2 * fixedLength;
+        for (uint32_t i = 0; i < fixedLength; i++) {
+            filter[2 * i] = readFloat();
+        }
+        for (uint32_t i = 0; i < fixedLength; i++) {
+            filter[2 * i + 1] = readFloat();
+        }
+    }
+    return true;
+}
+
+bool HrirBinReader::readAt(uint32_t index, bool withTaps) {
+    if (!f || !randomAccess() || index >= measurementCount) {
+        return false;
+    }
+    if (sectionCount == 0) {
+        // "HRIR" : en-tête de 16 octets, puis M x (az, el, dist, gauche[], droite[])
+        const uint32_t record = 12 + 8 * fixedLength;
+        if (!f.seek(16 + (uint64_t)index * record)) {
+            return false;
+        }
+        itdL = 0.0f;
+        itdR = 0.0f;
+        if (withTaps) {
+            measurementIndex = index;
+            return next();
+        }
+        az   = readFloat();
+        el   = readFloat();
+        dist = readFloat();
+        measurementIndex = index + 1;
+        return true;
+    }
+
+    // "HRB2" : description dans "META", taps entrelacés au pas stride() dans "COEF"
+    const int meta = findSection("META");
+    const int coef = findSection("COEF");
+    HrirBinMeta m;
+    if (meta < 0 || coef < 0 ||
+        (uint64_t)(index + 1) * sizeof(HrirBinMeta) > sections[meta].bytes ||
+        (uint64_t)(index + 1) * coeffStride * sizeof(float) > sections[coef].bytes ||
+        !f.seek(sections[meta].offset + (uint64_t)index * sizeof(HrirBinMeta)) ||
+        f.read(&m, sizeof(m)) < (int)sizeof(m)) {
+        return false;
+    }
+    az   = m.azimuth;
+    el   = m.elevation;
+    dist = m.distance;
+    itdL = m.itdLeft;
+    itdR = m.itdRight;
+    len  = (m.length > fixedLength) ? fixedLength : m.length;
+    currentSection = -1;
+    measurementIndex = index + 1;
+    if (!withTaps) {
+        return true;
+    }
+    // Bloc entrelacé lu dans rightBuf, puis séparé (droite sur place : rightBuf[i] vient de
+    // rightBuf[2i + 1], déjà lu quand i est écrit)
+    if (!reserve(coeffStride) ||
+        !f.seek(sections[coef].offset + (uint64_t)index * coeffStride * sizeof(float)) ||
+        f.read(rightBuf, coeffStride * sizeof(float)) < (int)(coeffStride * sizeof(float))) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        leftBuf[i] = rightBuf[2 * i];
+    }
+    for (size_t i = 0; i < len; i++) {
+        rightBuf[i] = rightBuf[2 * i + 1];
+    }
+    return true;
+}
+
+void HrirBinReader::close() {
+    if (f) {
+        f.close();
+    }
+}
+
+bool HrirBinReader::next() {
+    if (!f || sectionCount > 0 || measurementIndex >= measurementCount) {
+        return false;
+    }
+
+    // Lecture des angles et de la distance
+    az   = readFloat();
+    el   = readFloat();
+    dist = readFloat();
+
+    if (pcaComponents > 0) {
+        itdL = readFloat();
+        itdR = readFloat();
+        for (uint32_t k = 0; k < pcaComponents; k++) {
+            weightBuf[k] = readFloat();
+        }
+        len = fixedLength;
+        measurementIndex++;
+        return true;
+    }
+
+    uint32_t fileLen = fixedLength;
+    if (variable && !readU32(fileLen)) {
+        return false;
+    }
+    len = (!variable && fileLen > maxFixed) ? maxFixed : fileLen;
+    if (!reserve(len)) {
+        Serial.println("Mémoire insuffisante pour la réponse longue");
+        return false;
+    }
+
+    if (isLeftOnly()) {
+        // Gauche seule, brute : le reste de l'enregistrement (fin de la gauche, droite) est sauté
+        for (size_t i = 0; i < len; i++) {
+            leftBuf[i] = readFloat();
+        }
+        if (!f.seek(f.position() + (uint64_t)(2 * fileLen - len) * sizeof(float))) {
+            return false;
+        }
+        measurementIndex++;
+        return true;
+    }
+    for (uint32_t i = 0; i < fileLen; i++) {
+        float val = readFloat();
+        if (i < len) {
+            leftBuf[i] = val;
+        }
+    }
+    for (uint32_t i = 0; i < fileLen; i++) {
+        float val = readFloat();
+        if (i < len) {
+            rightBuf[i] = val;
+        }
+    }
+
+    //Normalisation : calculer la valeur maximale absolue et diviser chaque échantillon par ce maximum
+    float maxVal = 0.0f;
+    for (size_t i = 0; i < len; i++) {
+        float absLeft = fabs(leftBuf[i]);
+        float absRight = fabs(rightBuf[i]);
+        if (absLeft > maxVal) maxVal = absLeft;
+        if (absRight > maxVal) maxVal = absRight;
+    }
+    if (maxVal > 0.0f) {
+        float normFactor = 1.0f / maxVal;
+        for (size_t i = 0; i < len; i++) {
+            leftBuf[i]  *= normFactor;
+            rightBuf[i] *= normFactor;
+        }
+    }
+    measurementIndex++;
+    return true;
+}
@@ -0,0 +1,138 @@
+#ifndef HRIR_BIN_READER_H
+#define HRIR_BIN_READER_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+// Lecture séquentielle d'un fichier de HRIR sur la carte SD.
+// Formats reconnus :
+//   "HRIR" : sampleRate, longueur commune, M, puis M x (az, el, dist, gauche[], droite[])
+//   "HRIV" : sampleRate, M, puis M x (az, el, dist, longueur, gauche[], droite[])
+//   "HRIP" : sampleRate, longueur, K, M, longueur de phase minimale (0 : phase mesurée), puis
+//            la base (moyenne et K composantes : gauche[], droite[]), puis
+//            M x (az, el, dist, itdGauche, itdDroite, K poids) (assets/extractPcaToBin.py)
+//   "HRB2" : en-tête fixe et table de sections alignées sur 32 octets, chacune avec son CRC-32
+//            (assets/convertBinToV2.py) : description des mesures ("META"), taps entrelacés
+//            au pas stride() ("COEF"), spectres précalculés facultatifs ("SPEC"). Pas de
+//            lecture mesure par mesure : la banque lit chaque section en gros blocs
+//            (openSection/readSection) directement dans son stockage.
+// Chaque mesure est normalisée (maximum absolu des deux oreilles ramené à 1) ; les mesures d'un
+// fichier "HRIP" ou "HRB2" le sont déjà, et ne sont décrites que par leurs poids pour "HRIP".
+// Description d'une mesure dans la section "META" d'un fichier "HRB2" (32 octets)
+struct HrirBinMeta {
+    float azimuth;
+    float elevation;
+    float distance;
+    float itdLeft;       // retard fractionnaire (phase minimale), en échantillons
+    float itdRight;
+    uint32_t length;     // taps utiles par oreille (au plus length() du fichier)
+    uint32_t reserved[2];
+};
+
+class HrirBinReader {
+public:
+    HrirBinReader();
+    ~HrirBinReader();
+
+    // maxFixedLength : troncature appliquée au format "HRIR" à longueur commune
+    bool open(const String& filename, size_t maxFixedLength);
+    void close();
+
+    uint32_t sampleRate() const { return fileSampleRate; }
+    uint32_t count() const { return measurementCount; }
+    bool variableLength() const { return variable; }
+    // Fichier "HRIP" : nombre de composantes K (0 sinon)
+    uint32_t components() const { return pcaComponents; }
+    // Fichier "HRIP" ou "HRB2" : longueur de phase minimale des filtres (0 : phase mesurée)
+    uint32_t minimumPhaseLength() const { return fileMinimumPhase; }
+
+    // Fichier "HRB2" : floats par mesure dans "COEF" (length() taps entrelacés, complétés
+    // jusqu'à un multiple de 32 octets), taille de bloc et floats par mesure de "SPEC" (0 : absente)
+    bool sectioned() const { return sectionCount > 0; }
+    uint32_t stride() const { return coeffStride; }
+    uint32_t spectrumBlockSize() const { return spectrumBlock; }
+    uint32_t spectrumFloats() const { return spectrumSize; }
+    // Se place au début de la section tag ; bytes reçoit sa taille
+    bool openSection(const char* tag, uint32_t* bytes = nullptr);
+    // Lit les bytes octets suivants de la section ouverte (floats en little-endian, comme le
+    // Teensy) et les ajoute à son CRC
+    bool readSection(void* dest, size_t bytes);
+    // true si toute la section a été lue et que son CRC est celui de la table
+    bool sectionValid() const;
+
+    // Base d'un fichier "HRIP", à lire avant la première mesure : moyenne puis composantes,
+    // (K + 1) filtres de length() taps gauche/droite entrelacés mis bout à bout
+    bool readBasis(float* basis);
+
+    // Lit la mesure suivante ; les buffers restent valides jusqu'au prochain appel
+    bool next();
+    // Fichier "HRIR" : next() ne lit que l'oreille gauche (la droite est sautée, right() n'est
+    // pas rempli) et la rend sans normalisation, pour le stockage symétrique de la banque qui
+    // normalise chaque mesure avec sa mesure miroir. Sans effet sur les autres formats.
+    void setLeftOnly(bool enabled) { leftOnly = enabled; }
+    bool isLeftOnly() const { return leftOnly && !variable && pcaComponents == 0 &&
+                                     sectionCount == 0; }
+    // Accès direct à la mesure index, pour les fichiers à enregistrements de taille fixe
+    // ("HRIR" et "HRB2", voir randomAccess) ; withTaps = false : direction et distance
+    // seulement (et ITD pour "HRB2"). La mesure suivante lue par next() est index + 1.
+    bool randomAccess() const { return !variable && pcaComponents == 0; }
+    bool readAt(uint32_t index, bool withTaps = true);
+
+    float azimuth() const { return az; }
+    float elevation() const { return el; }
+    float distance() const { return dist; }
+    size_t length() const { return len; }
+    const float* left() const { return leftBuf; }
+    const float* right() const { return rightBuf; }
+    // Fichier "HRIP" (left() et right() ne sont pas remplis) : K poids et ITD en échantillons
+    const float* weights() const { return weightBuf; }
+    float itdLeft() const { return itdL; }
+    float itdRight() const { return itdR; }
+
+private:
+    HrirBinReader(const HrirBinReader&);
+    HrirBinReader& operator=(const HrirBinReader&);
+
+    bool readU32(uint32_t& val);
+    float readFloat();
+    bool reserve(size_t n);
+    bool readSections();
+    int findSection(const char* tag) const;
+
+    File f;
+    bool variable;
+    uint32_t fileSampleRate;
+    uint32_t fixedLength;
+    uint32_t measurementCount;
+    uint32_t measurementIndex;
+    size_t maxFixed;
+    uint32_t pcaComponents;
+    uint32_t fileMinimumPhase;
+    bool leftOnly;
+
+    static const int MAX_SECTIONS = 8;
+    struct Section {
+        char tag[4];
+        uint32_t offset;
+        uint32_t bytes;
+        uint32_t crc;
+    };
+    Section sections[MAX_SECTIONS];
+    int sectionCount;
+    uint32_t coeffStride;
+    uint32_t spectrumBlock;
+    uint32_t spectrumSize;
+    int currentSection;     // -1 : aucune
+    uint32_t sectionRead;   // octets lus dans la section ouverte
+    uint32_t sectionCrc;    // CRC en cours (avant inversion finale)
+
+    float az, el, dist;
+    size_t len;
+    float* leftBuf;
+    float* rightBuf;
+    size_t capacity;
+    float* weightBuf;
+    float itdL, itdR;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "HrtfAmbisonicMixer.h"
+#include <string.h>
+#include <stdlib.h>
+
+HrtfAmbisonicMixer::HrtfAmbisonicMixer()
+: sourceCount(0), blockSize(0), bus(nullptr), targetYaw(0.0f), currentYaw(0.0f)
+{
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        sources[i].azimuth = 0;
+        sources[i].elevation = 0;
+        sources[i].gain = 1.0f;
+        memset(sources[i].target, 0, sizeof(sources[i].target));
+        memset(sources[i].current, 0, sizeof(sources[i].current));
+    }
+}
+
+HrtfAmbisonicMixer::~HrtfAmbisonicMixer() {
+    free(bus);
+}
+
+bool HrtfAmbisonicMixer::init(const HrtfBank& bank, int order, int count) {
+    sourceCount = (count < 0) ? 0 : (count > MAX_SOURCES ? MAX_SOURCES : count);
+    blockSize = bank.getBlockSize();
+    bool ok = decoder.init(bank, order);
+
+    free(bus);
+    bus = (float*)malloc((size_t)decoder.getChannelCount() * blockSize * sizeof(float));
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        setSource(i, sources[i].azimuth, sources[i].elevation, sources[i].gain);
+        memcpy(sources[i].current, sources[i].target, sizeof(sources[i].current));
+    }
+    currentYaw = targetYaw;
+    return ok && bus;
+}
+
+void HrtfAmbisonicMixer::setSource(int index, int azimuthDeg, int elevationDeg, float gain) {
+    if (index < 0 || index >= MAX_SOURCES) {
+        return;
+    }
+    // Normaliser l'azimut dans [0,359]
+    azimuthDeg = (azimuthDeg % 360 + 360) % 360;
+    Source& src = sources[index];
+    src.azimuth = azimuthDeg;
+    src.elevation = elevationDeg;
+    src.gain = gain;
+
+    const int C = decoder.getChannelCount();
+    float g[HRTF_AMBI_MAX_CHANNELS];
+    hrtfAmbisonicEncode(decoder.getOrder(), (float)azimuthDeg, (float)elevationDeg, g);
+    for (int c = 0; c < C; c++) {
+        src.target[c] = g[c] * gain;
+    }
+}
+
+void HrtfAmbisonicMixer::rotate() {
+    // Les paires (l, -m)/(l, m) tournent de m*yaw ; la matrice glisse linéairement de
+    // l'ancien au nouvel angle sur le bloc, comme les gains d'encodage
+    const int order = decoder.getOrder();
+    const int B = blockSize;
+    if (currentYaw == targetYaw && targetYaw == 0.0f) {
+        return;
+    }
+    float cos0[HRTF_AMBI_MAX_ORDER], sin0[HRTF_AMBI_MAX_ORDER];
+    float cos1[HRTF_AMBI_MAX_ORDER], sin1[HRTF_AMBI_MAX_ORDER];
+    hrtfAmbisonicYaw(order, currentYaw, cos0, sin0);
+    hrtfAmbisonicYaw(order, targetYaw, cos1, sin1);
+    const float inv = 1.0f / B;
+    for (int l = 1; l <= order; l++) {
+        for (int m = 1; m <= l; m++) {
+            float* S = bus + (size_t)(l * l + l - m) * B;
+            float* C = bus + (size_t)(l * l + l + m) * B;
+            const float c0 = cos0[m - 1], s0 = sin0[m - 1];
+            const float dc = (cos1[m - 1] - c0) * inv, ds = (sin1[m - 1] - s0) * inv;
+            for (int n = 0; n < B; n++) {
+                const float cm = c0 + dc * (n + 1);
+                const float sm = s0 + ds * (n + 1);
+                const float cv = C[n], sv = S[n];
+                C[n] = cv * cm - sv * sm;
+                S[n] = sv * cm + cv * sm;
+            }
+        }
+    }
+    currentYaw = targetYaw;
+}
+
+void HrtfAmbisonicMixer::process(const float* const* inputs,
+                                 const float* const* bformat, int bformatChannels,
+                                 float* outLeft, float* outRight) {
+    const int B = blockSize;
+    const int C = decoder.getChannelCount();
+    if (!bus) {
+        memset(outLeft, 0, B * sizeof(float));
+        memset(outRight, 0, B * sizeof(float));
+        return;
+    }
+
+    // Flux déjà encodé : recopié tel quel, les composantes manquantes restent nulles
+    for (int c = 0; c < C; c++) {
+        float* dst = bus + (size_t)c * B;
+        if (bformat && c < bformatChannels && bformat[c]) {
+            memcpy(dst, bformat[c], B * sizeof(float));
+        } else {
+            memset(dst, 0, B * sizeof(float));
+        }
+    }
+
+    // Encodage : quelques gains par source, interpolés si la position a changé
+    const float inv = 1.0f / B;
+    for (int i = 0; i < sourceCount; i++) {
+        Source& src = sources[i];
+        const float* in = inputs ? inputs[i] : nullptr;
+        if (!in) {
+            memcpy(src.current, src.target, sizeof(src.current));
+            continue;
+        }
+        for (int c = 0; c < C; c++) {
+            float* dst = bus + (size_t)c * B;
+            const float g0 = src.current[c];
+            const float g1 = src.target[c];
+            if (g0 == g1) {
+                if (g1 != 0.0f) {
+                    for (int n = 0; n < B; n++) {
+                        dst[n] += g1 * in[n];
+                    }
+                }
+            } else {
+                const float dg = (g1 - g0) * inv;
+                for (int n = 0; n < B; n++) {
+                    dst[n] += (g0 + dg * (n + 1)) * in[n];
+                }
+            }
+            src.current[c] = g1;
+        }
+    }
+
+    rotate();
+
+    const float* channels[HRTF_AMBI_MAX_CHANNELS];
+    for (int c = 0; c < C; c++) {
+        channels[c] = bus + (size_t)c * B;
+    }
+    decoder.process(channels, outLeft, outRight);
+}
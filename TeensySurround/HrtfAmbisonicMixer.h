@@ -0,0 +1,70 @@
+#ifndef HRTF_AMBISONIC_MIXER_H
+#define HRTF_AMBISONIC_MIXER_H
+
+#include <stddef.h>
+#include "HrtfBank.h"
+#include "HrtfAmbisonics.h"
+
+// Rendu de sources mono par un bus ambisonique (AmbiX, ordre 1 à 3).
+// Chaque source n'est qu'un jeu de gains d'encodage ; le bus est tourné (lacet de la scène)
+// puis décodé une seule fois par bloc : le coût de convolution ne dépend plus du nombre de
+// sources. Un flux B-format déjà encodé (fichier AmbiX) peut être ajouté au bus.
+class HrtfAmbisonicMixer {
+public:
+    static const int MAX_SOURCES = 32;
+
+    HrtfAmbisonicMixer();
+    ~HrtfAmbisonicMixer();
+
+    // Alloue le bus et le décodeur (hors interruption audio)
+    bool init(const HrtfBank& bank, int order, int sourceCount);
+    int getOrder() const { return decoder.getOrder(); }
+    int getChannelCount() const { return decoder.getChannelCount(); }
+    int getSourceCount() const { return sourceCount; }
+
+    // Position et gain d'une source (azimut/élévation en degrés) ; les gains d'encodage
+    // glissent sur le bloc suivant
+    void setSource(int index, int azimuthDeg, int elevationDeg, float gain);
+    int getAzimuth(int index) const { return sources[index].azimuth; }
+    int getElevation(int index) const { return sources[index].elevation; }
+    float getGain(int index) const { return sources[index].gain; }
+
+    // Rotation de toute la scène autour de l'axe vertical, en degrés
+    void setRotation(float yawDeg) { targetYaw = yawDeg; }
+    float getRotation() const { return targetYaw; }
+
+    // inputs[i] : bloc de la source i (nul = muette).
+    // bformat[c] : composante ACN/SN3D c d'un flux déjà encodé, bformatChannels canaux
+    // (bformat nul si aucun) ; les composantes au-delà de l'ordre du décodeur sont ignorées.
+    void process(const float* const* inputs,
+                 const float* const* bformat, int bformatChannels,
+                 float* outLeft, float* outRight);
+
+    void setConvolutionMode(HrtfConvolutionMode mode) { decoder.setConvolutionMode(mode); }
+
+private:
+    HrtfAmbisonicMixer(const HrtfAmbisonicMixer&);
+    HrtfAmbisonicMixer& operator=(const HrtfAmbisonicMixer&);
+
+    void rotate();
+
+    struct Source {
+        int azimuth;
+        int elevation;
+        float gain;
+        float target[HRTF_AMBI_MAX_CHANNELS];   // gains d'encodage demandés
+        float current[HRTF_AMBI_MAX_CHANNELS];  // gains atteints à la fin du bloc précédent
+    };
+
+    int sourceCount;
+    int blockSize;
+    Source sources[MAX_SOURCES];
+
+    float* bus;           // getChannelCount() blocs, composante ACN c en bus + c*blockSize
+    float targetYaw;
+    float currentYaw;
+
+    HrtfAmbisonicDecoder decoder;
+};
+
+#endif
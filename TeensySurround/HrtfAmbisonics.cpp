@@ -0,0 +1,369 @@
+#include "HrtfAmbisonics.h"
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Pondération max-rE par degré l (décodage 3D), indexée par [ordre][l]
+static const float MAX_RE_WEIGHTS[HRTF_AMBI_MAX_ORDER + 1][HRTF_AMBI_MAX_ORDER + 1] = {
+    { 1.0f, 0.0f,    0.0f,    0.0f    },
+    { 1.0f, 0.5774f, 0.0f,    0.0f    },
+    { 1.0f, 0.7746f, 0.4000f, 0.0f    },
+    { 1.0f, 0.8611f, 0.6123f, 0.3047f }
+};
+
+// Degré l de la composante ACN c (c = l*l + l + m)
+static int acnDegree(int c) {
+    int l = 0;
+    while ((l + 1) * (l + 1) <= c) {
+        l++;
+    }
+    return l;
+}
+
+void hrtfAmbisonicEncode(int order, float azimuthDeg, float elevationDeg, float* g) {
+    const float az = azimuthDeg * 3.14159265f / 180.0f;
+    const float el = elevationDeg * 3.14159265f / 180.0f;
+    const float x = cosf(el) * cosf(az);
+    const float y = cosf(el) * sinf(az);
+    const float z = sinf(el);
+
+    // Harmoniques sphériques réelles SN3D exprimées sur le vecteur unitaire (x, y, z)
+    g[0] = 1.0f;
+    if (order >= 1) {
+        g[1] = y;
+        g[2] = z;
+        g[3] = x;
+    }
+    if (order >= 2) {
+        const float s3 = 1.7320508f;  // sqrt(3)
+        g[4] = s3 * x * y;
+        g[5] = s3 * y * z;
+        g[6] = 0.5f * (3.0f * z * z - 1.0f);
+        g[7] = s3 * x * z;
+        g[8] = 0.5f * s3 * (x * x - y * y);
+    }
+    if (order >= 3) {
+        const float a = 0.7905694f;   // sqrt(5/8)
+        const float b = 3.8729833f;   // sqrt(15)
+        const float c = 0.6123724f;   // sqrt(3/8)
+        g[9]  = a * y * (3.0f * x * x - y * y);
+        g[10] = b * x * y * z;
+        g[11] = c * y * (5.0f * z * z - 1.0f);
+        g[12] = 0.5f * z * (5.0f * z * z - 3.0f);
+        g[13] = c * x * (5.0f * z * z - 1.0f);
+        g[14] = 0.5f * b * z * (x * x - y * y);
+        g[15] = a * x * (x * x - 3.0f * y * y);
+    }
+}
+
+void hrtfAmbisonicYaw(int order, float yawDeg, float* cosines, float* sines) {
+    const float yaw = yawDeg * 3.14159265f / 180.0f;
+    for (int m = 1; m <= order; m++) {
+        cosines[m - 1] = cosf(m * yaw);
+        sines[m - 1]   = sinf(m * yaw);
+    }
+}
+
+HrtfAmbisonicDecoder::HrtfAmbisonicDecoder()
+: bank(nullptr), order(0), channelCount(0), speakerCount(0), blockSize(0),
+  filters(nullptr), spectra(nullptr), fftSize(0),
+  spectrumAcc(nullptr), voiceLeft(nullptr), voiceRight(nullptr), silence(nullptr)
+{
+}
+
+HrtfAmbisonicDecoder::~HrtfAmbisonicDecoder() {
+    free(filters);
+    free(spectra);
+    free(spectrumAcc);
+    free(voiceLeft);
+    free(voiceRight);
+    free(silence);
+}
+
+bool HrtfAmbisonicDecoder::init(const HrtfBank& b, int ord) {
+    bank = &b;
+    order = (ord < 1) ? 1 : (ord > HRTF_AMBI_MAX_ORDER ? HRTF_AMBI_MAX_ORDER : ord);
+    channelCount = hrtfAmbisonicChannels(order);
+    blockSize = b.getBlockSize();
+    speakerCount = 0;
+
+    free(filters);
+    free(spectra);
+    free(spectrumAcc);
+    free(voiceLeft);
+    free(voiceRight);
+    free(silence);
+    spectra = nullptr;
+    spectrumAcc = nullptr;
+    fftSize = 0;
+    filters    = (float*)calloc((size_t)channelCount * 2 * MAX_HRIR_LENGTH, sizeof(float));
+    voiceLeft  = (float*)malloc(blockSize * sizeof(float));
+    voiceRight = (float*)malloc(blockSize * sizeof(float));
+    silence    = (float*)calloc(blockSize, sizeof(float));
+    if (!filters || !voiceLeft || !voiceRight || !silence) {
+        return false;
+    }
+    if (b.getFftSize() > 0) {
+        spectra = (float*)malloc((size_t)channelCount * b.getSpectrumSize() * sizeof(float));
+        if (spectra && fft.init(b.getFftSize())) {
+            spectrumAcc = (float*)malloc(2 * b.getFftSize() * sizeof(float));
+            if (spectrumAcc) {
+                fftSize = b.getFftSize();
+            }
+        }
+    }
+
+    SelectedHrir speakers[MAX_SPEAKERS];
+    const int count = chooseSpeakers(b, speakers);
+    float matrix[MAX_SPEAKERS * HRTF_AMBI_MAX_CHANNELS];
+    if (count == 0 || !computeDecodingMatrix(speakers, count, matrix)) {
+        return false;
+    }
+    speakerCount = count;
+    buildFilters(b, speakers, count, matrix);
+
+    bool ok = true;
+    for (int c = 0; c < channelCount; c++) {
+        ok = voices[c].init(b) && ok;
+    }
+    return ok;
+}
+
+int HrtfAmbisonicDecoder::chooseSpeakers(const HrtfBank& b, SelectedHrir* speakers) const {
+    // Anneau horizontal de 2N+2 haut-parleurs, un sur deux repris à +45° et -45°, plus les
+    // deux pôles. Une direction absente de la banque retombe sur une mesure déjà retenue et
+    // n'est pas dupliquée : avec une banque horizontale, seul l'anneau reste.
+    const int ring = 2 * order + 2;
+    float dirs[MAX_SPEAKERS][2];
+    int n = 0;
+    for (int k = 0; k < ring; k++) {
+        dirs[n][0] = 360.0f * k / ring;
+        dirs[n][1] = 0.0f;
+        n++;
+    }
+    for (int side = 0; side < 2; side++) {
+        for (int k = 0; k < ring; k += 2) {
+            dirs[n][0] = 360.0f * k / ring;
+            dirs[n][1] = side ? -45.0f : 45.0f;
+            n++;
+        }
+    }
+    dirs[n][0] = 0.0f;
+    dirs[n][1] = 90.0f;
+    n++;
+    dirs[n][0] = 0.0f;
+    dirs[n][1] = -90.0f;
+    n++;
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        SelectedHrir sel = b.getHrir((int)dirs[i][0], (int)dirs[i][1]);
+        if (sel.index < 0) {
+            continue;
+        }
+        bool duplicate = false;
+        for (int j = 0; j < count; j++) {
+            if (speakers[j].index == sel.index) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            speakers[count++] = sel;
+        }
+    }
+    return count;
+}
+
+bool HrtfAmbisonicDecoder::computeDecodingMatrix(const SelectedHrir* speakers, int count,
+                                                 float* matrix) const {
+    // Mode-matching : D = Y^T (Y Y^T + lambda I)^-1, Y (canaux x haut-parleurs) encodant
+    // les directions réellement mesurées. La régularisation annule les composantes que la
+    // disposition ne peut pas reproduire (élévation d'une banque horizontale).
+    const int C = channelCount;
+    double Y[HRTF_AMBI_MAX_CHANNELS][MAX_SPEAKERS];
+    for (int k = 0; k < count; k++) {
+        float g[HRTF_AMBI_MAX_CHANNELS];
+        hrtfAmbisonicEncode(order, (float)speakers[k].azimuth, (float)speakers[k].elevation, g);
+        for (int c = 0; c < C; c++) {
+            Y[c][k] = g[c];
+        }
+    }
+
+    // Système augmenté [Y Y^T + lambda I | Y], résolu par Gauss-Jordan
+    double A[HRTF_AMBI_MAX_CHANNELS][HRTF_AMBI_MAX_CHANNELS + MAX_SPEAKERS];
+    double trace = 0.0;
+    for (int i = 0; i < C; i++) {
+        for (int j = 0; j < C; j++) {
+            double s = 0.0;
+            for (int k = 0; k < count; k++) {
+                s += Y[i][k] * Y[j][k];
+            }
+            A[i][j] = s;
+        }
+        trace += A[i][i];
+        for (int k = 0; k < count; k++) {
+            A[i][C + k] = Y[i][k];
+        }
+    }
+    const double lambda = 1e-3 * trace / C;
+    for (int i = 0; i < C; i++) {
+        A[i][i] += lambda;
+    }
+    const int W = C + count;
+    for (int col = 0; col < C; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < C; r++) {
+            if (fabs(A[r][col]) > fabs(A[pivot][col])) {
+                pivot = r;
+            }
+        }
+        if (fabs(A[pivot][col]) < 1e-12) {
+            return false;
+        }
+        if (pivot != col) {
+            for (int j = 0; j < W; j++) {
+                double t = A[col][j];
+                A[col][j] = A[pivot][j];
+                A[pivot][j] = t;
+            }
+        }
+        const double inv = 1.0 / A[col][col];
+        for (int j = 0; j < W; j++) {
+            A[col][j] *= inv;
+        }
+        for (int r = 0; r < C; r++) {
+            if (r != col && A[r][col] != 0.0) {
+                const double f = A[r][col];
+                for (int j = 0; j < W; j++) {
+                    A[r][j] -= f * A[col][j];
+                }
+            }
+        }
+    }
+
+    // matrix[k*C + c] : gain du canal c vers le haut-parleur k, pondéré max-rE
+    for (int k = 0; k < count; k++) {
+        for (int c = 0; c < C; c++) {
+            matrix[k * C + c] = (float)A[c][C + k] * MAX_RE_WEIGHTS[order][acnDegree(c)];
+        }
+    }
+
+    // Normalisation : une source de face garde un gain total unitaire
+    float front[HRTF_AMBI_MAX_CHANNELS];
+    hrtfAmbisonicEncode(order, 0.0f, 0.0f, front);
+    float total = 0.0f;
+    for (int k = 0; k < count; k++) {
+        for (int c = 0; c < C; c++) {
+            total += matrix[k * C + c] * front[c];
+        }
+    }
+    if (total > 1e-6f) {
+        for (int i = 0; i < count * C; i++) {
+            matrix[i] /= total;
+        }
+    }
+    return true;
+}
+
+void HrtfAmbisonicDecoder::buildFilters(const HrtfBank& b, const SelectedHrir* speakers,
+                                        int count, const float* matrix) {
+    // Filtre du canal c = somme des HRIR des haut-parleurs pondérées par la matrice.
+    // Les HRIR à phase minimale retrouvent ici leur ITD (interpolation linéaire) :
+    // les filtres combinés n'ont plus de retard propre à appliquer en sortie.
+    const int C = channelCount;
+    size_t length = 0;
+    for (int k = 0; k < count; k++) {
+        // Banque compacte : la mesure est décodée une fois pour tous les canaux
+        float decoded[2 * MAX_HRIR_LENGTH];
+        const SelectedHrir sp = b.isCompact() ? b.decodeHrir(speakers[k], decoded, nullptr)
+                                              : speakers[k];
+        for (int c = 0; c < C; c++) {
+            float* h = filters + (size_t)c * 2 * MAX_HRIR_LENGTH;
+            const float gain = matrix[k * C + c];
+            for (int ear = 0; ear < 2; ear++) {
+                const float itd = ear ? sp.itdRight : sp.itdLeft;
+                const int shift = (int)itd;
+                const float frac = itd - (float)shift;
+                for (size_t i = 0; i < sp.length; i++) {
+                    const float v = gain * sp.coeffs[2 * i + ear];
+                    const size_t t = i + shift;
+                    if (t < (size_t)MAX_HRIR_LENGTH) {
+                        h[2 * t + ear] += (1.0f - frac) * v;
+                    }
+                    if (t + 1 < (size_t)MAX_HRIR_LENGTH) {
+                        h[2 * (t + 1) + ear] += frac * v;
+                    }
+                }
+                size_t end = sp.length + shift + 1;
+                if (end > length) {
+                    length = end;
+                }
+            }
+        }
+    }
+    if (length > (size_t)MAX_HRIR_LENGTH) {
+        length = MAX_HRIR_LENGTH;
+    }
+
+    const size_t specSize = b.getSpectrumSize();
+    for (int c = 0; c < C; c++) {
+        SelectedHrir& sel = channelHrir[c];
+        memset(&sel, 0, sizeof(sel));
+        sel.coeffs = filters + (size_t)c * 2 * MAX_HRIR_LENGTH;
+        sel.index = -1;
+        sel.length = length;
+        sel.fullLength = length;
+        sel.spectrum = nullptr;
+        if (spectra) {
+            float* spec = spectra + (size_t)c * specSize;
+            b.computeSpectrum(sel.coeffs, length, spec);
+            sel.spectrum = spec;
+        }
+    }
+}
+
+void HrtfAmbisonicDecoder::setConvolutionMode(HrtfConvolutionMode mode) {
+    for (int c = 0; c < channelCount; c++) {
+        voices[c].setConvolutionMode(mode);
+    }
+}
+
+void HrtfAmbisonicDecoder::process(const float* const* channels,
+                                   float* outLeft, float* outRight) {
+    const int B = blockSize;
+    memset(outLeft, 0, B * sizeof(float));
+    memset(outRight, 0, B * sizeof(float));
+    if (!bank || !silence || speakerCount == 0) {
+        return;
+    }
+    if (spectrumAcc) {
+        memset(spectrumAcc, 0, 2 * fftSize * sizeof(float));
+    }
+
+    // Même schéma que HrtfMixer : une voix par canal, une seule IFFT
+    bool spectral = false;
+    for (int c = 0; c < channelCount; c++) {
+        const float* in = channels[c] ? channels[c] : silence;
+        if (spectrumAcc &&
+            voices[c].accumulateBlock(in, spectrumAcc, outLeft, outRight, channelHrir[c])) {
+            spectral = true;
+            continue;
+        }
+        voices[c].processBlock(in, voiceLeft, voiceRight, channelHrir[c]);
+        for (int n = 0; n < B; n++) {
+            outLeft[n]  += voiceLeft[n];
+            outRight[n] += voiceRight[n];
+        }
+    }
+
+    if (spectral) {
+        fft.inverse(spectrumAcc);
+        const float s = fft.inverseNorm();
+        for (int n = 0; n < B; n++) {
+            outLeft[n]  += spectrumAcc[2 * (B + n)] * s;
+            outRight[n] += spectrumAcc[2 * (B + n) + 1] * s;
+        }
+    }
+}
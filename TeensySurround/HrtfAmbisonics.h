@@ -0,0 +1,77 @@
+#ifndef HRTF_AMBISONICS_H
+#define HRTF_AMBISONICS_H
+
+#include <stddef.h>
+#include "HrtfBank.h"
+#include "HrtfVoice.h"
+#include "HrtfFft.h"
+
+// Ambisonie d'ordre 1 à 3 au format AmbiX : canaux dans l'ordre ACN, normalisation SN3D.
+// Azimut compté dans le sens trigonométrique (90° = gauche), comme les mesures SOFA de la banque.
+static const int HRTF_AMBI_MAX_ORDER = 3;
+static const int HRTF_AMBI_MAX_CHANNELS = (HRTF_AMBI_MAX_ORDER + 1) * (HRTF_AMBI_MAX_ORDER + 1);
+
+static inline int hrtfAmbisonicChannels(int order) {
+    return (order + 1) * (order + 1);
+}
+
+// Gains d'encodage d'une onde plane venant de (azimut, élévation), hrtfAmbisonicChannels(order) valeurs
+void hrtfAmbisonicEncode(int order, float azimuthDeg, float elevationDeg, float* gains);
+
+// Matrice de rotation autour de l'axe vertical : la scène tourne de yawDeg (une source à
+// l'azimut a passe à a + yawDeg). Seules les paires (l, -m)/(l, m) se mélangent :
+// cosines[m - 1], sines[m - 1] pour m = 1..order.
+void hrtfAmbisonicYaw(int order, float yawDeg, float* cosines, float* sines);
+
+// Décodage binaural d'un flux ambisonique par un jeu fixe de haut-parleurs virtuels pris
+// dans la banque. La matrice de décodage (mode-matching régularisé, pondération max-rE) et
+// les HRIR des haut-parleurs sont combinées au chargement en un filtre binaural par canal :
+// le coût est celui de hrtfAmbisonicChannels(order) voix partageant une IFFT, quel que soit
+// le nombre de sources encodées. Les queues des réponses longues (BRIR) ne sont pas utilisées.
+class HrtfAmbisonicDecoder {
+public:
+    static const int MAX_SPEAKERS = 32;
+
+    HrtfAmbisonicDecoder();
+    ~HrtfAmbisonicDecoder();
+
+    // Choisit les haut-parleurs virtuels et calcule les filtres (hors interruption audio)
+    bool init(const HrtfBank& bank, int order);
+    int getOrder() const { return order; }
+    int getChannelCount() const { return channelCount; }
+    int getSpeakerCount() const { return speakerCount; }
+
+    // channels[c] : bloc de la composante ACN c (nul = silencieuse)
+    void process(const float* const* channels, float* outLeft, float* outRight);
+
+    void setConvolutionMode(HrtfConvolutionMode mode);
+
+private:
+    HrtfAmbisonicDecoder(const HrtfAmbisonicDecoder&);
+    HrtfAmbisonicDecoder& operator=(const HrtfAmbisonicDecoder&);
+
+    int chooseSpeakers(const HrtfBank& bank, SelectedHrir* speakers) const;
+    bool computeDecodingMatrix(const SelectedHrir* speakers, int count, float* matrix) const;
+    void buildFilters(const HrtfBank& bank, const SelectedHrir* speakers, int count,
+                      const float* matrix);
+
+    const HrtfBank* bank;
+    int order;
+    int channelCount;
+    int speakerCount;
+    int blockSize;
+
+    float* filters;     // channelCount x MAX_HRIR_LENGTH taps gauche/droite entrelacés
+    float* spectra;     // channelCount x bank.getSpectrumSize()
+    SelectedHrir channelHrir[HRTF_AMBI_MAX_CHANNELS];
+    HrtfVoice voices[HRTF_AMBI_MAX_CHANNELS];
+
+    HrtfFft fft;          // IFFT commune
+    int fftSize;
+    float* spectrumAcc;
+    float* voiceLeft;
+    float* voiceRight;
+    float* silence;
+};
+
+#endif
@@ -0,0 +1,1846 @@
+#include "HrtfBank.h"
+#include "HrirBinReader.h"
+#include "HrtfCacheStore.h"
+#include "HrtfCompactStore.h"
+#include "HrtfConfig.h"
+#include "HrtfMemory.h"
+#include "HrtfMinimumPhase.h"
+#include "HrtfPcaStore.h"
+#include "HrtfResampler.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <SD.h>
+#include <SPI.h>
+
+HrtfBank::HrtfBank()
+: coeffPool(nullptr), coeffBlock(nullptr), coeffCapacity(0),
+  hrirCount(0), sampleRate(44100), blockSize(128),
+  fftSize(0), partitionCount(0),
+  spectraPool(nullptr), spectraCapacity(0), generation(0),
+  maxTailLength(0), flashCount(0), flashSpectra(false), minimumPhaseLength(0), filterMinimumPhase(0),
+  compactStorage(false), compact(false), store(nullptr), compactStore(nullptr),
+  pcaStore(nullptr), cacheStore(nullptr),
+  symmetricStorage(false), symmetric(false), symmetryErrorDeg(0.0f),
+  cacheSize(0), cacheVersionBase(0),
+  loadReader(nullptr), loadPhase(LOAD_IDLE), loadResult(false), loadIntact(true),
+  loadConvert(false), loadWhole(false), loadMeta(nullptr), loadCount(0), loadPosition(0),
+  loadPeaks(nullptr), engineRate(44100), rateResampler(nullptr), rateRatio(1.0f),
+  loadResampled(nullptr),
+  loadResampledCapacity(0),
+  lookupCandidates(nullptr), lookupCandidateCount(0),
+  triangles(nullptr), triangleCount(0), vertexTriangle(nullptr),
+  ringOrder(nullptr), ringAzimuth(nullptr), ringCount(0)
+{
+    memset(azimuthIndex, 0, sizeof(azimuthIndex));
+    memset(lookupStart, 0, sizeof(lookupStart));
+    for (int i = 0; i < MAX_HRIR_SLOTS; i++) {
+        slotAzimuth[i] = 0;
+        slotElevation[i] = 0;
+        directionVector(0.0f, 0.0f, slotDirection[i]);
+        slotDistance[i] = 0.0f;
+        slotLength[i] = 0;
+        slotFullLength[i] = 0;
+        slotDelayLeft[i] = 0;
+        slotDelayRight[i] = 0;
+        slotItdLeft[i] = 0.0f;
+        slotItdRight[i] = 0.0f;
+        slotCoeffs[i] = nullptr;
+        slotSpectrum[i] = nullptr;
+        slotTail[i] = nullptr;
+    }
+}
+
+HrtfBank::~HrtfBank() {
+    endLoad();
+    delete rateResampler;
+    releaseTails();
+    releaseStore();
+    releaseCoeffs();
+    free(spectraPool);
+    free(lookupCandidates);
+    free(triangles);
+    free(vertexTriangle);
+    free(ringOrder);
+    free(ringAzimuth);
+}
+
+void HrtfBank::init(int sRate, int bSize) {
+    sampleRate = sRate;
+    engineRate = sRate;
+    blockSize  = bSize;
+    releaseTails();
+    releaseStore();
+    delete rateResampler;
+    rateResampler = nullptr;
+    releaseCoeffs();
+    hrirCount  = 0;
+    flashCount = 0;
+    maxTailLength = 0;
+    triangleCount = 0;
+    ringCount = 0;
+    tailLayout.init(bSize, MAX_HRIR_LENGTH);
+
+    // Overlap-save : FFT de taille 2*blockSize, la HRIR est découpée en partitions de blockSize
+    fftSize = 0;
+    partitionCount = 0;
+    // (fftSize reste nul si la taille n'est pas une puissance de 2 : les voix passent en direct)
+    if (fft.init(2 * blockSize)) {
+        fftSize = 2 * blockSize;
+        partitionCount = (MAX_HRIR_LENGTH + blockSize - 1) / blockSize;
+    }
+    generation++;
+}
+
+void HrtfBank::releaseTails() {
+    for (int i = 0; i < MAX_HRIR_SLOTS; i++) {
+        hrtfRelease(slotTail[i]);
+        slotTail[i] = nullptr;
+        if (slotFullLength[i] > slotLength[i]) {
+            slotFullLength[i] = slotLength[i];
+        }
+    }
+}
+
+bool HrtfBank::reserveCoeffs(int count) {
+    count = (count > MAX_HRIR_SLOTS) ? MAX_HRIR_SLOTS : count;
+    if (count <= coeffCapacity) {
+        return true;
+    }
+    // Nouveau bloc aligné sur 32 octets ; les coefficients des mesures déjà chargées y sont
+    // recopiés (hors mesures en flash)
+    void* block = malloc((size_t)count * COEFF_STRIDE * sizeof(float) + 31);
+    if (!block) {
+        return false;
+    }
+    float* pool = (float*)(((uintptr_t)block + 31) & ~(uintptr_t)31);
+    for (int i = flashCount; i < hrirCount; i++) {
+        memcpy(pool + (size_t)i * COEFF_STRIDE, coeffPool + (size_t)i * COEFF_STRIDE,
+               COEFF_STRIDE * sizeof(float));
+        slotCoeffs[i] = pool + (size_t)i * COEFF_STRIDE;
+    }
+    free(coeffBlock);
+    coeffBlock = block;
+    coeffPool = pool;
+    coeffCapacity = count;
+    generation++;  // les voix ne doivent plus lire les anciens coefficients
+    return true;
+}
+
+void HrtfBank::releaseCoeffs() {
+    free(coeffBlock);
+    coeffBlock = nullptr;
+    coeffPool = nullptr;
+    coeffCapacity = 0;
+}
+
+void HrtfBank::storeSlot(int index, float azimuthDeg, float elevationDeg, float distance,
+                         const HrirData& data) {
+    slotAzimuth[index] = (int16_t)roundf(azimuthDeg);
+    slotElevation[index] = (int16_t)roundf(elevationDeg);
+    directionVector(azimuthDeg, elevationDeg, slotDirection[index]);
+    slotDistance[index] = distance;
+    slotLength[index] = (uint16_t)data.length;
+    slotFullLength[index] = (uint32_t)data.length;
+    slotDelayLeft[index] = data.delayLeft;
+    slotDelayRight[index] = data.delayRight;
+    slotItdLeft[index] = data.itdLeft;
+    slotItdRight[index] = data.itdRight;
+    float* coeffs = coeffPool + (size_t)index * COEFF_STRIDE;
+    memcpy(coeffs, data.coeffs, sizeof(data.coeffs));
+    slotCoeffs[index] = coeffs;
+    slotTail[index] = nullptr;
+}
+
+bool HrtfBank::reserveSpectra() {
+    // spectraPool agrandi pour hrirCount slots (realloc garde les spectres déjà calculés)
+    const size_t perSlot = getSpectrumSize();
+    const size_t needed = perSlot * hrirCount;
+    if (needed > spectraCapacity) {
+        float* pool = (float*)realloc(spectraPool, needed * sizeof(float));
+        if (!pool) {
+            Serial.println("Mémoire insuffisante pour les spectres HRIR");
+            for (int i = flashSpectra ? flashCount : 0; i < hrirCount; i++) {
+                slotSpectrum[i] = nullptr;
+            }
+            return false;
+        }
+        spectraPool = pool;
+        generation++;  // les voix ne doivent plus lire les anciens spectres
+        spectraCapacity = needed;
+    }
+    // (les spectres compilés en flash restent lus en place)
+    const int first = flashSpectra ? flashCount : 0;
+    for (int i = first; i < hrirCount; i++) {
+        slotSpectrum[i] = spectraPool + perSlot * i;
+    }
+    return true;
+}
+
+void HrtfBank::computeSpectra(int firstSlot) {
+    // Banque compacte : les spectres sont calculés par les voix, au décodage
+    if (compact || fftSize == 0 || hrirCount == 0 || !reserveSpectra()) {
+        return;
+    }
+    if (flashSpectra && firstSlot < flashCount) {
+        firstSlot = flashCount;
+    }
+    for (int i = firstSlot; i < hrirCount; i++) {
+        computeSpectrum(slotCoeffs[i], slotLength[i],
+                        spectraPool + getSpectrumSize() * i);
+    }
+}
+
+void HrtfBank::computeSpectrum(const float* coeffs, size_t length, float* spectrum) const {
+    // Chaque partition p contient les taps [p*B, (p+1)*B) complétés par B zéros,
+    // gauche dans la partie réelle et droite dans la partie imaginaire.
+    for (int p = 0; p < partitionCount; p++) {
+        float* spec = spectrum + (size_t)p * 2 * fftSize;
+        memset(spec, 0, 2 * fftSize * sizeof(float));
+        for (int i = 0; i < blockSize; i++) {
+            size_t idx = (size_t)p * blockSize + i;
+            if (idx < length) {
+                spec[2 * i]     = coeffs[2 * idx];
+                spec[2 * i + 1] = coeffs[2 * idx + 1];
+            }
+        }
+        fft.forward(spec);
+    }
+}
+
+void HrtfBank::addHrir(int azimuthDeg,
+                       const float* left, const float* right,
+                       unsigned delayLeft, unsigned delayRight,
+                       size_t length) {
+    addHrir(azimuthDeg, 0, left, right, delayLeft, delayRight, length);
+}
+
+void HrtfBank::addHrir(int azimuthDeg, int elevationDeg,
+                       const float* left, const float* right,
+                       unsigned delayLeft, unsigned delayRight,
+                       size_t length) {
+    if (compact) {
+        if (!storeCompact((float)azimuthDeg, (float)elevationDeg, 0.0f, left, right, length)) {
+            Serial.println("Mémoire insuffisante pour la banque compacte");
+            return;
+        }
+        triangulate();
+        buildLookup();
+        if (symmetric) {
+            resolveMirrors();
+        }
+        return;
+    }
+    if (hrirCount >= MAX_HRIR_SLOTS) {
+        return;
+    }
+    // Pool agrandi par moitié (une banque construite mesure par mesure)
+    if (!reserveCoeffs((hrirCount < 8) ? 8 : hrirCount + hrirCount / 2)) {
+        Serial.println("Mémoire insuffisante pour les coefficients HRIR");
+        return;
+    }
+    HrirData work;
+    copyHead(work, left, right, length);
+    work.delayLeft  = delayLeft;
+    work.delayRight = delayRight;
+    if (minimumPhaseLength > 0) {
+        convertMinimumPhase(work);
+    }
+    storeSlot(hrirCount, (float)azimuthDeg, (float)elevationDeg, 0.0f, work);
+    hrirCount++;
+    computeSpectra(hrirCount - 1);
+    triangulate();
+    buildLookup();
+}
+
+bool HrtfBank::loadFromBin(const String &filename) {
+    if (!beginLoad(filename)) {
+        return false;
+    }
+    while (loadStep(0xFFFFFFFFu)) {
+    }
+    return loadResult;
+}
+
+bool HrtfBank::beginLoad(const String& filename) {
+    endLoad();
+    HrirBinReader* reader = new HrirBinReader();
+    if (!reader || !reader->open(filename, MAX_HRIR_LENGTH)) {
+        delete reader;
+        return false;
+    }
+    loadReader = reader;
+    loadFilename = filename;
+    loadResult = false;
+    loadIntact = true;
+
+    releaseTails();
+    releaseStore();
+    delete rateResampler;
+    rateResampler = nullptr;
+    sampleRate = reader->sampleRate();
+    hrirCount = 0;
+    flashCount = 0;
+    flashSpectra = false;
+    maxTailLength = 0;
+    filterMinimumPhase = minimumPhaseLength;
+    // Une base PCA ou une banque à la demande n'existent qu'en stockage compact ; le fichier
+    // suivant reprend le stockage demandé
+    const bool onDemand = cacheSize > 0 && reader->randomAccess();
+    // Stockage symétrique : fichier "HRIR" lu oreille gauche seulement
+    symmetric = symmetricStorage && !onDemand && !reader->variableLength() &&
+                reader->components() == 0 && !reader->sectioned();
+    if (symmetricStorage && !symmetric) {
+        Serial.println("Stockage symétrique indisponible pour ce fichier : deux oreilles gardées");
+    }
+    reader->setLeftOnly(symmetric);
+    compact = compactStorage || reader->components() > 0 || onDemand || symmetric;
+    // Coefficients résidents réservés pour toutes les mesures du fichier ; aucun pour une
+    // banque compacte
+    releaseCoeffs();
+    if (!compact && !reserveCoeffs((int)reader->count())) {
+        Serial.println("Mémoire insuffisante pour les coefficients HRIR");
+    }
+    // Base PCA et banque à la demande : stockage créé à la lecture (stepBulk). Stockage
+    // compact : toutes les mesures du fichier, descriptions réservées d'un coup
+    loadCount = (reader->count() > (uint32_t)HrtfStore::MAX_SLOTS) ? HrtfStore::MAX_SLOTS
+                                                                   : (int)reader->count();
+    if (compact && !onDemand && reader->components() == 0 && useCompactStore()) {
+        compactStore->reserve(loadCount);
+    }
+    // Stockage symétrique : maximum de chaque gauche brute, avant phase minimale et troncature
+    // (HrtfCompactStore::normalizeMirrors)
+    if (symmetric && compactStore && loadCount > 0) {
+        loadPeaks = (float*)malloc(loadCount * sizeof(float));
+    }
+    if (onDemand || reader->components() > 0) {
+        loadPhase = LOAD_BULK;
+    } else if (reader->sectioned()) {
+        loadPhase = LOAD_SECTION_META;
+    } else {
+        loadPhase = LOAD_MEASUREMENTS;
+    }
+    if (sampleRate != engineRate && engineRate > 0) {
+#if HRTF_RESAMPLE_QUALITY > 0
+        // Tous les formats convertis à la fréquence du moteur en les rangeant : mesures, taps
+        // "HRB2", base PCA (loadPca) et filtres lus par le cache (fillCache)
+        rateResampler = new HrtfResampler();
+        if (rateResampler && rateResampler->init(sampleRate, engineRate, 1,
+                                                 (HrtfResampleQuality)HRTF_RESAMPLE_QUALITY)) {
+            rateRatio = (float)engineRate / (float)sampleRate;
+            sampleRate = engineRate;
+        } else {
+            delete rateResampler;
+            rateResampler = nullptr;
+            Serial.println("Mémoire insuffisante pour la conversion de fréquence des HRIR");
+        }
+#endif
+        if (!rateResampler) {
+            Serial.print("HRIR gardées à ");
+            Serial.print(sampleRate);
+            Serial.println(" Hz (fréquence du fichier)");
+        }
+    }
+    return true;
+}
+
+bool HrtfBank::resampleMeasurement(const float*& left, const float*& right, size_t& length) {
+    // Longueur convertie ; bornée à MAX_HRIR_LENGTH pour un fichier à longueur commune (sans
+    // queue à convoluer pour quelques taps de plus)
+    size_t outLength = rateResampler->outputLength((uint32_t)length);
+    if (!loadReader->variableLength() && outLength > (size_t)MAX_HRIR_LENGTH) {
+        outLength = MAX_HRIR_LENGTH;
+    }
+    if (outLength > loadResampledCapacity) {
+        float* grown = (float*)realloc(loadResampled, 2 * outLength * sizeof(float));
+        if (!grown) {
+            return false;
+        }
+        loadResampled = grown;
+        loadResampledCapacity = outLength;
+    }
+    float* convertedLeft = loadResampled;
+    float* convertedRight = loadResampled + loadResampledCapacity;
+    rateResampler->convert(left, (int)length, convertedLeft, (int)outLength);
+    if (right != left) {
+        rateResampler->convert(right, (int)length, convertedRight, (int)outLength);
+        right = convertedRight;
+    } else {
+        right = convertedLeft;
+    }
+    left = convertedLeft;
+    length = outLength;
+    return true;
+}
+
+bool HrtfBank::isLoadReadingCard() const {
+    return loadPhase != LOAD_IDLE && loadPhase != LOAD_SPECTRA && loadPhase != LOAD_INDEX;
+}
+
+bool HrtfBank::loadStep(uint32_t budgetMicros) {
+    const uint32_t start = micros();
+    const bool reading = isLoadReadingCard();
+    while (loadPhase != LOAD_IDLE) {
+        switch (loadPhase) {
+        case LOAD_BULK:            stepBulk(); break;
+        case LOAD_MEASUREMENTS:    stepMeasurement(); break;
+        case LOAD_SECTION_META:    stepSectionMeta(); break;
+        case LOAD_SECTION_COEFFS:  stepSectionCoeffs(); break;
+        case LOAD_SECTION_SPECTRA: stepSectionSpectra(); break;
+        case LOAD_SPECTRA:         stepSpectrum(); break;
+        default:                   finishLoad(); break;
+        }
+        if (isLoadReadingCard() != reading || (uint32_t)(micros() - start) >= budgetMicros) {
+            break;
+        }
+    }
+    return loadPhase != LOAD_IDLE;
+}
+
+void HrtfBank::stepBulk() {
+    if (loadReader->components() > 0) {
+        if (!loadPca(*loadReader)) {
+            Serial.println("Mémoire insuffisante pour la base PCA");
+            releaseStore();
+        }
+    } else if (!loadIndex(*loadReader, loadFilename)) {
+        Serial.println("Mémoire insuffisante pour le cache de HRIR");
+        releaseStore();
+    }
+    loadPhase = LOAD_INDEX;
+}
+
+void HrtfBank::stepMeasurement() {
+    HrirBinReader& reader = *loadReader;
+    if ((!compact && hrirCount >= coeffCapacity) || !reader.next()) {
+        startSpectra();
+        return;
+    }
+    // (oreille droite non lue en stockage symétrique)
+    const float* leftBuf = reader.left();
+    const float* rightBuf = symmetric ? reader.left() : reader.right();
+    size_t length = reader.length();
+    if (rateResampler && !resampleMeasurement(leftBuf, rightBuf, length)) {
+        Serial.println("Mémoire insuffisante pour la conversion de fréquence : chargement arrêté");
+        startSpectra();
+        return;
+    }
+    if (compact) {
+        if (loadPeaks && hrirCount < loadCount) {
+            float peak = 0.0f;
+            for (size_t i = 0; i < length; i++) {
+                peak = (fabsf(leftBuf[i]) > peak) ? fabsf(leftBuf[i]) : peak;
+            }
+            loadPeaks[hrirCount] = peak;
+        }
+        if (!storeCompact(reader.azimuth(), reader.elevation(), reader.distance(),
+                          leftBuf, rightBuf, length)) {
+            Serial.println("Mémoire insuffisante : banque compacte tronquée");
+            startSpectra();
+        }
+        return;
+    }
+
+    // On n'utilise ici que l'azimuth pour la sélection, mais on stocke la distance pour l'atténuation
+    const int maxLen = (int)length;
+
+    // Tête de la HRIR normalisée, préparée avant d'être rangée dans le pool
+    HrirData work;
+    copyHead(work, leftBuf, rightBuf, maxLen);
+
+    // Queue au-delà de MAX_HRIR_LENGTH : spectres précalculés pour la convolution non uniforme
+    size_t fullLength = work.length;
+    float* tail = nullptr;
+    if (maxLen > MAX_HRIR_LENGTH) {
+        size_t specSize = tailLayout.spectrumSize(maxLen);
+        tail = (float*)hrtfAllocate(specSize * sizeof(float));
+        if (tail) {
+            tailLayout.computeSpectrum(leftBuf, rightBuf, maxLen, tail);
+            fullLength = maxLen;
+            if ((size_t)maxLen > maxTailLength) {
+                maxTailLength = maxLen;
+            }
+        } else {
+            Serial.println("Mémoire insuffisante : queue de la réponse ignorée");
+        }
+    }
+    // Une tête à phase minimale ne se raccorderait plus à sa queue : seules les HRIR courtes
+    if (minimumPhaseLength > 0 && !tail) {
+        convertMinimumPhase(work);
+    }
+    storeSlot(hrirCount, reader.azimuth(), reader.elevation(), reader.distance(), work);
+    if (tail) {
+        slotFullLength[hrirCount] = (uint32_t)fullLength;
+        slotTail[hrirCount] = tail;
+    }
+    hrirCount++;
+}
+
+void HrtfBank::stepSectionMeta() {
+    HrirBinReader& reader = *loadReader;
+    const int capacity = compact ? HrtfStore::MAX_SLOTS : MAX_HRIR_SLOTS;
+    loadCount = (reader.count() > (uint32_t)capacity) ? capacity : (int)reader.count();
+    // Filtres déjà normalisés ; convertis seulement s'ils sont à phase mesurée
+    loadConvert = minimumPhaseLength > 0 && reader.minimumPhaseLength() == 0;
+    filterMinimumPhase = loadConvert ? minimumPhaseLength
+                                     : rateLength(reader.minimumPhaseLength());
+    // Les CRC portent sur des sections entières : non vérifiés si la banque est tronquée
+    loadWhole = (loadCount == (int)reader.count());
+    loadPhase = LOAD_INDEX;
+
+    // Description de toutes les mesures en une lecture
+    loadMeta = (HrirBinMeta*)malloc((size_t)loadCount * sizeof(HrirBinMeta));
+    if (!loadMeta) {
+        Serial.println("Mémoire insuffisante pour la description des mesures");
+        return;
+    }
+    if (!reader.openSection("META") ||
+        !reader.readSection(loadMeta, (size_t)loadCount * sizeof(HrirBinMeta)) ||
+        (loadWhole && !reader.sectionValid())) {
+        Serial.println("Section META illisible ou corrompue");
+        loadIntact = false;
+        return;
+    }
+    loadIntact = reader.openSection("COEF");
+    loadPosition = 0;
+    loadPhase = LOAD_SECTION_COEFFS;
+}
+
+void HrtfBank::stepSectionCoeffs() {
+    // Taps : le bloc de chaque mesure est lu d'une traite, puis rangé dans le pool (ou compacté)
+    HrirBinReader& reader = *loadReader;
+    const size_t stride = reader.stride();
+    if (loadIntact && loadPosition < (size_t)loadCount &&
+        (compact || hrirCount < coeffCapacity)) {
+        HrirData work;
+        if (reader.readSection(work.coeffs, stride * sizeof(float))) {
+            memset(work.coeffs + stride, 0, (2 * MAX_HRIR_LENGTH - stride) * sizeof(float));
+            const HrirBinMeta& m = loadMeta[loadPosition++];
+            work.length     = (m.length > reader.length()) ? reader.length() : m.length;
+            work.delayLeft  = 0;
+            work.delayRight = 0;
+            work.itdLeft    = m.itdLeft;
+            work.itdRight   = m.itdRight;
+            if (rateResampler) {
+                convertRate(work);
+            }
+            if (loadConvert) {
+                convertMinimumPhase(work);
+            }
+            if (!compact) {
+                storeSlot(hrirCount, m.azimuth, m.elevation, m.distance, work);
+                hrirCount++;
+                return;
+            }
+            if (useCompactStore() &&
+                compactStore->add(m.azimuth, m.elevation, m.distance, work)) {
+                hrirCount = compactStore->count();
+                return;
+            }
+            Serial.println("Mémoire insuffisante : banque compacte tronquée");
+            loadWhole = false;
+        } else {
+            loadIntact = false;
+        }
+    }
+
+    // Section lue
+    free(loadMeta);
+    loadMeta = nullptr;
+    loadPhase = LOAD_INDEX;
+    if (!loadIntact || (loadWhole && !reader.sectionValid())) {
+        Serial.println("Section COEF illisible ou corrompue");
+        loadIntact = false;
+        return;
+    }
+    if (compact || fftSize == 0 || hrirCount == 0) {
+        return;
+    }
+
+    // Spectres du fichier, par morceaux, s'ils ont le découpage de la banque et que les taps
+    // n'ont été convertis ni en phase minimale ni en fréquence ; sinon calculés comme pour les
+    // autres formats
+    if (loadConvert || rateResampler || reader.spectrumBlockSize() != (uint32_t)blockSize ||
+        reader.spectrumFloats() != getSpectrumSize() || !reader.openSection("SPEC")) {
+        startSpectra();
+        return;
+    }
+    if (reserveSpectra()) {
+        loadPosition = 0;
+        loadPhase = LOAD_SECTION_SPECTRA;
+    }
+}
+
+void HrtfBank::stepSectionSpectra() {
+    HrirBinReader& reader = *loadReader;
+    const size_t total = (size_t)hrirCount * getSpectrumSize() * sizeof(float);
+    const size_t bytes = (total - loadPosition > SPECTRA_CHUNK_BYTES) ? SPECTRA_CHUNK_BYTES
+                                                                      : total - loadPosition;
+    if (reader.readSection((uint8_t*)spectraPool + loadPosition, bytes)) {
+        loadPosition += bytes;
+        if (loadPosition < total) {
+            return;
+        }
+        if (!loadWhole || reader.sectionValid()) {
+            loadPhase = LOAD_INDEX;
+            return;
+        }
+    }
+    Serial.println("Section SPEC illisible ou corrompue : spectres recalculés");
+    startSpectra();
+}
+
+void HrtfBank::startSpectra() {
+    // Banque compacte : les spectres sont calculés par les voix, au décodage
+    loadPosition = 0;
+    loadPhase = (compact || fftSize == 0 || hrirCount == 0 || !reserveSpectra()) ? LOAD_INDEX
+                                                                                 : LOAD_SPECTRA;
+}
+
+void HrtfBank::stepSpectrum() {
+    const size_t i = loadPosition++;
+    computeSpectrum(slotCoeffs[i], slotLength[i], spectraPool + getSpectrumSize() * i);
+    if (loadPosition >= (size_t)hrirCount) {
+        loadPhase = LOAD_INDEX;
+    }
+}
+
+void HrtfBank::finishLoad() {
+    if (!loadIntact) {
+        // Section corrompue : rien de ce qui a été lu n'est gardé
+        hrirCount = 0;
+        releaseStore();
+    }
+    triangulate();
+    buildLookup();
+    if (symmetric && compactStore) {
+        resolveMirrors();
+        compactStore->normalizeMirrors(loadPeaks);
+    }
+    const String filename = loadFilename;
+    loadResult = loadIntact;
+    endLoad();
+    if (!loadResult) {
+        Serial.print("loadFromBin : fichier corrompu ");
+        Serial.println(filename);
+        return;
+    }
+    Serial.print("loadFromBin OK, hrirCount=");
+    Serial.print(hrirCount);
+    Serial.print(", triangles=");
+    Serial.print(triangleCount);
+    if (compact) {
+        Serial.print(", compact octets=");
+        Serial.print((unsigned long)getCompactBytes());
+    }
+    if (symmetric) {
+        Serial.print(", symétrique (écart ");
+        Serial.print(symmetryErrorDeg, 1);
+        Serial.print(" deg)");
+    }
+    if (pcaStore) {
+        Serial.print(", composantes PCA=");
+        Serial.print(pcaStore->getComponents());
+    }
+    if (cacheStore) {
+        Serial.print(", cache=");
+        Serial.print(cacheStore->getSlots());
+        Serial.print(" (");
+        Serial.print(cacheStore->getPinned());
+        Serial.print(" fixes)");
+    }
+    Serial.println();
+}
+
+void HrtfBank::endLoad() {
+    delete loadReader;
+    loadReader = nullptr;
+    free(loadMeta);
+    loadMeta = nullptr;
+    free(loadPeaks);
+    loadPeaks = nullptr;
+    // Banque à la demande : les filtres lus ensuite sont convertis comme au chargement
+    if (!cacheStore) {
+        delete rateResampler;
+        rateResampler = nullptr;
+    }
+    free(loadResampled);
+    loadResampled = nullptr;
+    loadResampledCapacity = 0;
+    loadPhase = LOAD_IDLE;
+}
+
+void HrtfBank::setMinimumPhase(size_t length) {
+    minimumPhaseLength = (length > (size_t)MAX_HRIR_LENGTH) ? MAX_HRIR_LENGTH : length;
+    filterMinimumPhase = minimumPhaseLength;
+}
+
+void HrtfBank::convertMinimumPhase(HrirData& data) {
+    const size_t len = data.length;
+    const size_t outLen = (minimumPhaseLength < len) ? minimumPhaseLength : len;
+    float left[MAX_HRIR_LENGTH];
+    float right[MAX_HRIR_LENGTH];
+    for (size_t i = 0; i < len; i++) {
+        left[i]  = data.coeffs[2 * i];
+        right[i] = data.coeffs[2 * i + 1];
+    }
+
+    // ITD : écart entre les instants d'arrivée ; seule l'oreille la plus tardive est retardée.
+    // Stockage symétrique : l'oreille gauche seule, son instant d'arrivée est gardé tel quel et
+    // l'ITD vient de celui de la mesure miroir (HrtfCompactStore::itd)
+    const float onsetLeft = hrtfOnset(left, len, 1);
+    float itd = symmetric ? onsetLeft : onsetLeft - hrtfOnset(right, len, 1);
+
+    float minLeft[MAX_HRIR_LENGTH];
+    float minRight[MAX_HRIR_LENGTH];
+    if (!hrtfMinimumPhase(left, len, minLeft, outLen) ||
+        (!symmetric && !hrtfMinimumPhase(right, len, minRight, outLen))) {
+        Serial.println("Mémoire insuffisante : HRIR gardée en phase mesurée");
+        return;
+    }
+    for (size_t i = 0; i < MAX_HRIR_LENGTH; i++) {
+        data.coeffs[2 * i]     = (i < outLen) ? minLeft[i]  : 0.0f;
+        data.coeffs[2 * i + 1] = (i < outLen && !symmetric) ? minRight[i] : 0.0f;
+    }
+    data.length = outLen;
+    if (symmetric) {
+        data.itdLeft  = itd;
+        data.itdRight = 0.0f;
+        return;
+    }
+    data.itdLeft  = (itd > 0.0f) ? itd : 0.0f;
+    data.itdRight = (itd < 0.0f) ? -itd : 0.0f;
+}
+
+void HrtfBank::convertRate(HrirData& data) {
+    const size_t len = data.length;
+    const size_t outLen = rateLength(len);
+    float left[MAX_HRIR_LENGTH];
+    float right[MAX_HRIR_LENGTH];
+    for (size_t i = 0; i < MAX_HRIR_LENGTH; i++) {
+        left[i]  = data.coeffs[2 * i];
+        right[i] = data.coeffs[2 * i + 1];
+    }
+    float convertedLeft[MAX_HRIR_LENGTH];
+    float convertedRight[MAX_HRIR_LENGTH];
+    rateResampler->convert(left, (int)len, convertedLeft, (int)outLen);
+    rateResampler->convert(right, (int)len, convertedRight, (int)outLen);
+    for (size_t i = 0; i < MAX_HRIR_LENGTH; i++) {
+        data.coeffs[2 * i]     = (i < outLen) ? convertedLeft[i]  : 0.0f;
+        data.coeffs[2 * i + 1] = (i < outLen) ? convertedRight[i] : 0.0f;
+    }
+    data.length = outLen;
+    // ITD en échantillons : même durée à la fréquence du moteur
+    data.itdLeft  *= rateRatio;
+    data.itdRight *= rateRatio;
+}
+
+size_t HrtfBank::rateLength(size_t length) const {
+    if (!rateResampler || length == 0) {
+        return length;
+    }
+    // Bornée à MAX_HRIR_LENGTH : la tête est tronquée de quelques taps en montant en fréquence
+    const size_t converted = rateResampler->outputLength((uint32_t)length);
+    return (converted > (size_t)MAX_HRIR_LENGTH) ? MAX_HRIR_LENGTH : converted;
+}
+
+
+void HrtfBank::setCompactStorage(bool enabled) {
+    if (enabled == compactStorage) {
+        return;
+    }
+    // Changement de stockage : la banque est vidée, à recharger
+    releaseTails();
+    releaseStore();
+    releaseCoeffs();
+    hrirCount = 0;
+    flashCount = 0;
+    maxTailLength = 0;
+    triangleCount = 0;
+    ringCount = 0;
+    compactStorage = enabled;
+    compact = enabled || symmetricStorage;
+    symmetric = symmetricStorage;
+    filterMinimumPhase = minimumPhaseLength;
+    generation++;
+}
+
+void HrtfBank::setSymmetricStorage(bool enabled) {
+    if (enabled == symmetricStorage) {
+        return;
+    }
+    // Changement de stockage : la banque est vidée, à recharger
+    releaseTails();
+    releaseStore();
+    releaseCoeffs();
+    hrirCount = 0;
+    flashCount = 0;
+    maxTailLength = 0;
+    triangleCount = 0;
+    ringCount = 0;
+    symmetricStorage = enabled;
+    symmetric = enabled;
+    compact = compactStorage || enabled;
+    filterMinimumPhase = minimumPhaseLength;
+    generation++;
+}
+
+void HrtfBank::releaseStore() {
+    if (cacheStore) {
+        cacheVersionBase += cacheStore->getVersion();
+    }
+    delete store;
+    store = nullptr;
+    compactStore = nullptr;
+    pcaStore = nullptr;
+    cacheStore = nullptr;
+}
+
+size_t HrtfBank::getCompactBytes() const {
+    return (compact && store) ? store->bytes() : 0;
+}
+
+float HrtfBank::getCompactErrorDb() const {
+    return compactStore ? compactStore->errorDb() : -200.0f;
+}
+
+size_t HrtfBank::getIndexBytes() const {
+    size_t bytes = sizeof(azimuthIndex) + sizeof(lookupStart);
+    bytes += lookupCandidateCount * sizeof(uint16_t);
+    bytes += (size_t)triangleCount * sizeof(HrirTriangle);
+    bytes += vertexTriangle ? (size_t)hrirCount * sizeof(uint16_t) : 0;
+    bytes += (size_t)ringCount * (sizeof(uint16_t) + sizeof(float));
+    return bytes;
+}
+
+void HrtfBank::copyHead(HrirData& data, const float* left, const float* right, size_t length) {
+    const size_t len = (length > (size_t)MAX_HRIR_LENGTH) ? MAX_HRIR_LENGTH : length;
+    for (size_t i = 0; i < MAX_HRIR_LENGTH; i++) {
+        data.coeffs[2 * i]     = (i < len) ? left[i]  : 0.0f;
+        data.coeffs[2 * i + 1] = (i < len) ? right[i] : 0.0f;
+    }
+    data.length = len;
+    data.delayLeft = 0;
+    data.delayRight = 0;
+    data.itdLeft = 0.0f;
+    data.itdRight = 0.0f;
+}
+
+HrtfCompactStore* HrtfBank::useCompactStore() {
+    if (!compactStore) {
+        // Un seul stockage par banque : celui d'un autre format est libéré
+        releaseStore();
+        hrirCount = 0;
+        compactStore = new HrtfCompactStore(symmetric);
+        store = compactStore;
+    }
+    return compactStore;
+}
+
+bool HrtfBank::storeCompact(float azimuthDeg, float elevationDeg, float distance,
+                            const float* left, const float* right, size_t length) {
+    // Même préparation qu'une mesure résidente (tête, phase minimale), dans un bloc de travail
+    HrirData work;
+    copyHead(work, left, right, length);
+    if (minimumPhaseLength > 0) {
+        convertMinimumPhase(work);
+    }
+    if (!useCompactStore() || !compactStore->add(azimuthDeg, elevationDeg, distance, work)) {
+        return false;
+    }
+    hrirCount = compactStore->count();
+    return true;
+}
+
+bool HrtfBank::loadPca(HrirBinReader& reader) {
+    pcaStore = new HrtfPcaStore();
+    store = pcaStore;
+    if (!pcaStore || !pcaStore->load(reader) ||
+        (rateResampler && !pcaStore->convertRate(*rateResampler, rateRatio, MAX_HRIR_LENGTH))) {
+        return false;
+    }
+    hrirCount = pcaStore->count();
+    filterMinimumPhase = rateLength(reader.minimumPhaseLength());
+    return true;
+}
+
+bool HrtfBank::loadFromFlash(const HrtfFlashBank& flash) {
+    if (flash.count == 0 || flash.length == 0 || flash.length > (uint32_t)MAX_HRIR_LENGTH ||
+        flash.stride < 2 * flash.length) {
+        Serial.println("loadFromFlash : banque compilée inutilisable");
+        return false;
+    }
+
+    releaseTails();
+    releaseStore();
+    releaseCoeffs();
+    delete rateResampler;
+    rateResampler = nullptr;
+    compact = false;
+    sampleRate = flash.sampleRate;
+    maxTailLength = 0;
+    filterMinimumPhase = flash.minimumPhaseLength;
+    hrirCount = (flash.count > (uint32_t)MAX_HRIR_SLOTS) ? MAX_HRIR_SLOTS : (int)flash.count;
+    flashCount = hrirCount;
+    flashSpectra = fftSize > 0 && flash.spectra && flash.spectrumBlock == (uint32_t)blockSize &&
+                   flash.spectrumFloats == getSpectrumSize();
+
+    // Description copiée dans les slots ; coefficients et spectres lus en place
+    for (int i = 0; i < hrirCount; i++) {
+        const HrtfFlashMeasurement& m = flash.index[i];
+        slotAzimuth[i] = (int16_t)roundf(m.azimuth);
+        slotElevation[i] = (int16_t)roundf(m.elevation);
+        directionVector(m.azimuth, m.elevation, slotDirection[i]);
+        slotDistance[i] = m.distance;
+        slotLength[i] = (uint16_t)flash.length;
+        slotFullLength[i] = flash.length;
+        slotDelayLeft[i] = 0;
+        slotDelayRight[i] = 0;
+        slotItdLeft[i] = m.itdLeft;
+        slotItdRight[i] = m.itdRight;
+        slotCoeffs[i] = flash.coeffs + (size_t)i * flash.stride;
+        slotSpectrum[i] = flashSpectra ? flash.spectra + (size_t)i * flash.spectrumFloats : nullptr;
+        slotTail[i] = nullptr;
+    }
+    if (flashSpectra) {
+        generation++;  // les voix ne doivent plus lire les anciens spectres
+    } else {
+        computeSpectra(0);
+    }
+    triangulate();
+    buildLookup();
+    Serial.print("loadFromFlash OK, hrirCount=");
+    Serial.print(hrirCount);
+    Serial.print(", triangles=");
+    Serial.print(triangleCount);
+    Serial.println(flashSpectra ? ", spectres en flash" : ", spectres calculés en RAM");
+    return true;
+}
+
+void HrtfBank::setPcaComponents(int count) {
+    if (pcaStore) {
+        pcaStore->setComponents(count);
+    }
+    // Les filtres reconstruits par les voix changent
+    generation++;
+}
+
+int HrtfBank::getPcaComponents() const {
+    return pcaStore ? pcaStore->getComponents() : 0;
+}
+
+int HrtfBank::getPcaStoredComponents() const {
+    return pcaStore ? pcaStore->getStoredComponents() : 0;
+}
+
+size_t HrtfBank::getPcaLength() const {
+    return pcaStore ? pcaStore->getLength() : 0;
+}
+
+const float* HrtfBank::getPcaBasis(int component) const {
+    return pcaStore ? pcaStore->getBasis(component) : nullptr;
+}
+
+const float* HrtfBank::getPcaWeights(int index) const {
+    return pcaStore ? pcaStore->getWeights(index) : nullptr;
+}
+
+void HrtfBank::setCacheSize(int measurements) {
+    cacheSize = (measurements < 0) ? 0 : (measurements > HrtfCacheStore::MAX_CACHE_SLOTS
+                                          ? HrtfCacheStore::MAX_CACHE_SLOTS : measurements);
+}
+
+bool HrtfBank::loadIndex(HrirBinReader& reader, const String& filename) {
+    cacheStore = new HrtfCacheStore();
+    store = cacheStore;
+    if (!cacheStore || !cacheStore->open(reader, filename, cacheSize)) {
+        return false;
+    }
+    hrirCount = cacheStore->count();
+    filterMinimumPhase = (minimumPhaseLength > 0 && reader.minimumPhaseLength() == 0)
+                       ? minimumPhaseLength : rateLength(reader.minimumPhaseLength());
+    pinCache();
+    cacheStore->resetCounters();
+    return true;
+}
+
+void HrtfBank::pinCache() {
+    // Un quart du cache garde des mesures réparties sur la sphère (à chaque tirage, la plus
+    // éloignée de celles déjà prises) : la mesure de remplacement n'est jamais loin
+    float* closest = (float*)malloc(hrirCount * sizeof(float));
+    if (!closest || hrirCount == 0) {
+        free(closest);
+        return;
+    }
+    for (int i = 0; i < hrirCount; i++) {
+        closest[i] = -2.0f;
+    }
+    float front[3];
+    directionVector(0.0f, 0.0f, front);
+    int next = nearestIndex(front, nullptr, hrirCount);
+    while (cacheStore->getPinned() < cacheStore->getSlots() / 4 && next >= 0 &&
+           fillCache(next)) {
+        cacheStore->pin();
+        const float* d = directionOf(next);
+        float farthest = 2.0f;
+        next = -1;
+        for (int i = 0; i < hrirCount; i++) {
+            const float* e = directionOf(i);
+            const float dot = d[0] * e[0] + d[1] * e[1] + d[2] * e[2];
+            closest[i] = (dot > closest[i]) ? dot : closest[i];
+            if (closest[i] < farthest) {
+                farthest = closest[i];
+                next = i;
+            }
+        }
+    }
+    free(closest);
+}
+
+bool HrtfBank::fillCache(int index) {
+    const int slot = cacheStore->read(index);
+    if (slot < 0) {
+        return false;
+    }
+
+    // Même préparation qu'au chargement complet : taps déjà normalisés par le lecteur,
+    // fréquence du moteur, phase minimale si le fichier ne l'est pas déjà
+    const HrirBinReader& reader = cacheStore->reader();
+    HrirData work;
+    copyHead(work, reader.left(), reader.right(), reader.length());
+    work.itdLeft = reader.itdLeft();
+    work.itdRight = reader.itdRight();
+    if (rateResampler) {
+        convertRate(work);
+    }
+    if (minimumPhaseLength > 0 && reader.minimumPhaseLength() == 0) {
+        convertMinimumPhase(work);
+    }
+    cacheStore->publish(index, slot, work);
+    return true;
+}
+
+int HrtfBank::residentIndex(int index) const {
+    return cacheStore ? cacheStore->resident(index) : index;
+}
+
+void HrtfBank::prefetch(const float* azimuthsDeg, const float* elevationsDeg, int count) {
+    if (cacheStore) {
+        cacheStore->prefetch(azimuthsDeg, elevationsDeg, count);
+    }
+}
+
+bool HrtfBank::loadNext() {
+    if (!cacheStore) {
+        return false;
+    }
+    const int requested = cacheStore->nextRequest();
+    if (requested >= 0) {
+        return fillCache(requested);
+    }
+    // Sommets des triangles des directions à venir, la plus proche d'abord : les résidents sont
+    // marqués utilisés, le premier absent est lu
+    int hint = -1;
+    for (int p = 0; p < cacheStore->getPrefetchCount(); p++) {
+        const HrirInterpolation interp =
+            locateInterpolation(cacheStore->getPrefetchAzimuth(p),
+                                cacheStore->getPrefetchElevation(p), hint);
+        hint = interp.triangle;
+        for (int k = 0; k < 3; k++) {
+            const int index = interp.slots[k];
+            if (index >= 0 && !cacheStore->touch(index)) {
+                return fillCache(index);
+            }
+        }
+    }
+    return false;
+}
+
+int HrtfBank::getCacheResident() const {
+    return cacheStore ? cacheStore->getResident() : 0;
+}
+
+uint32_t HrtfBank::getCacheHits() const {
+    return cacheStore ? cacheStore->getHits() : 0;
+}
+
+uint32_t HrtfBank::getCacheMisses() const {
+    return cacheStore ? cacheStore->getMisses() : 0;
+}
+
+uint32_t HrtfBank::getCacheLoads() const {
+    return cacheStore ? cacheStore->getLoads() : 0;
+}
+
+uint32_t HrtfBank::getCacheVersion() const {
+    return cacheVersionBase + (cacheStore ? cacheStore->getVersion() : 0);
+}
+
+void HrtfBank::resolveMirrors() {
+    // Direction miroir (azimut opposé, même élévation) : y change de signe
+    float worst = 1.0f;
+    for (int i = 0; i < hrirCount; i++) {
+        const float* d = directionOf(i);
+        const float mirrored[3] = { d[0], -d[1], d[2] };
+        const float az = atan2f(mirrored[1], mirrored[0]) * 180.0f / 3.14159265f;
+        const float el = asinf(d[2] > 1.0f ? 1.0f : (d[2] < -1.0f ? -1.0f : d[2])) *
+                         180.0f / 3.14159265f;
+        const int j = nearestMeasurement(mirrored, az, el);
+        compactStore->setMirror(i, j);
+        const float* e = directionOf(j);
+        const float dot = e[0] * mirrored[0] + e[1] * mirrored[1] + e[2] * mirrored[2];
+        worst = (dot < worst) ? dot : worst;
+    }
+    worst = (worst < -1.0f) ? -1.0f : worst;
+    symmetryErrorDeg = acosf(worst) * 180.0f / 3.14159265f;
+}
+
+size_t HrtfBank::mixHrirs(const int* indices, const float* weights, int count,
+                          float* coeffs) const {
+    memset(coeffs, 0, 2 * MAX_HRIR_LENGTH * sizeof(float));
+    if (store) {
+        return store->mix(indices, weights, count, coeffs);
+    }
+    // Banque résidente : coefficients des slots
+    size_t length = 0;
+    for (int k = 0; k < count; k++) {
+        const int index = indices[k];
+        if (index < 0 || index >= hrirCount) {
+            continue;
+        }
+        const float* c = slotCoeffs[index];
+        const size_t n = slotLength[index];
+        for (size_t i = 0; i < 2 * n; i++) {
+            coeffs[i] += weights[k] * c[i];
+        }
+        length = (n > length) ? n : length;
+    }
+    return length;
+}
+
+SelectedHrir HrtfBank::decodeHrir(const SelectedHrir& sel, float* coeffs, float* spectrum) const {
+    if (sel.index < 0 || sel.index >= hrirCount) {
+        return emptySelection();
+    }
+    SelectedHrir decoded = sel;
+    const float one = 1.0f;
+    decoded.length = mixHrirs(&sel.index, &one, 1, coeffs);
+    decoded.coeffs = coeffs;
+    decoded.spectrum = nullptr;
+    if (spectrum && fftSize > 0) {
+        computeSpectrum(coeffs, decoded.length, spectrum);
+        decoded.spectrum = spectrum;
+    }
+    return decoded;
+}
+
+static inline int wrapAzimuth(int azimuthDeg) {
+    return (azimuthDeg % 360 + 360) % 360;
+}
+
+SelectedHrir HrtfBank::getHrir(int azimuthDeg) const {
+    if (hrirCount == 0) {
+        return emptySelection();
+    }
+    const int index = residentIndex(azimuthIndex[wrapAzimuth(azimuthDeg)]);
+    return (index >= 0) ? selectMeasurement(index, azimuthDeg) : emptySelection();
+}
+
+SelectedHrir HrtfBank::getHrir(int azimuthDeg, int elevationDeg) const {
+    if (hrirCount == 0) {
+        return emptySelection();
+    }
+    if (!lookupCandidates && triangleCount == 0) {
+        return getHrir(azimuthDeg);
+    }
+
+    // Mesure la plus proche sur la sphère : produit scalaire maximal entre directions
+    float target[3];
+    directionVector((float)azimuthDeg, (float)elevationDeg, target);
+    const int index = residentIndex(nearestMeasurement(target, (float)azimuthDeg,
+                                                       (float)elevationDeg));
+    return (index >= 0) ? selectMeasurement(index, azimuthDeg) : emptySelection();
+}
+
+int HrtfBank::nearestMeasurement(const float* direction, float azimuthDeg,
+                                 float elevationDeg) const {
+    if (!lookupCandidates) {
+        return nearestIndex(direction, nullptr, hrirCount);
+    }
+    const float el = (elevationDeg < -90.0f) ? -90.0f : (elevationDeg > 90.0f ? 90.0f : elevationDeg);
+    int row = (int)((el + 90.0f) / LOOKUP_STEP);
+    row = (row >= LOOKUP_ROWS) ? LOOKUP_ROWS - 1 : row;
+    float az = fmodf(azimuthDeg, 360.0f);
+    az = (az < 0.0f) ? az + 360.0f : az;
+    int col = (int)(az / LOOKUP_STEP);
+    col = (col >= LOOKUP_COLUMNS) ? LOOKUP_COLUMNS - 1 : col;
+    const int cell = row * LOOKUP_COLUMNS + col;
+    const int first = lookupStart[cell];
+    return nearestIndex(direction, lookupCandidates + first, lookupStart[cell + 1] - first);
+}
+
+int HrtfBank::nearestIndex(const float* direction, const uint16_t* candidates, int count) const {
+    // candidates nul : toutes les mesures. À égalité, la première (ordre de la banque).
+    int bestIndex = candidates ? candidates[0] : 0;
+    float bestDot = -2.0f;
+    for (int k = 0; k < count; k++) {
+        const int i = candidates ? candidates[k] : k;
+        const float* d = directionOf(i);
+        float dot = d[0] * direction[0] + d[1] * direction[1] + d[2] * direction[2];
+        if (dot > bestDot) {
+            bestDot = dot;
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+void HrtfBank::buildLookup() {
+    // Azimut seul : même critère que le parcours linéaire (première mesure à égalité)
+    for (int a = 0; a < 360; a++) {
+        int bestIndex = 0;
+        int bestDiff = 361;
+        for (int i = 0; i < hrirCount; i++) {
+            int diff = abs(a - wrapAzimuth(azimuthOf(i)));
+            if (diff > 180) {
+                diff = 360 - diff;
+            }
+            if (diff < bestDiff) {
+                bestDiff = diff;
+                bestIndex = i;
+            }
+        }
+        azimuthIndex[a] = (uint16_t)bestIndex;
+    }
+
+    free(lookupCandidates);
+    lookupCandidates = nullptr;
+    lookupCandidateCount = 0;
+    memset(lookupStart, 0, sizeof(lookupStart));
+    if (triangleCount == 0) {
+        return;  // anneau : la table des azimuts suffit
+    }
+
+    // Grille : pour un point q de la cellule de centre c et de rayon r, la plus proche m*
+    // vérifie angle(c, m*) <= angle(q, m*) + r <= angle(q, n) + r <= angle(c, n) + 2r,
+    // n étant la plus proche du centre : seules ces mesures sont gardées.
+    const float degToRad = 3.14159265f / 180.0f;
+    const float margin = 0.5f * degToRad;
+    size_t capacity = 4 * LOOKUP_COLUMNS * LOOKUP_ROWS;
+    size_t total = 0;
+    uint16_t* list = (uint16_t*)malloc(capacity * sizeof(uint16_t));
+    for (int row = 0; row < LOOKUP_ROWS && list; row++) {
+        const float el0 = -90.0f + row * LOOKUP_STEP;
+        for (int col = 0; col < LOOKUP_COLUMNS && list; col++) {
+            const float az0 = (float)(col * LOOKUP_STEP);
+            float centre[3];
+            directionVector(az0 + 0.5f * LOOKUP_STEP, el0 + 0.5f * LOOKUP_STEP, centre);
+
+            // Rayon : coin le plus éloigné du centre
+            float minCorner = 1.0f;
+            for (int k = 0; k < 4; k++) {
+                float corner[3];
+                directionVector(az0 + (k & 1) * LOOKUP_STEP, el0 + (k >> 1) * LOOKUP_STEP, corner);
+                float dot = corner[0] * centre[0] + corner[1] * centre[1] + corner[2] * centre[2];
+                minCorner = (dot < minCorner) ? dot : minCorner;
+            }
+            const float radius = acosf(minCorner > 1.0f ? 1.0f : minCorner);
+
+            const int nearest = nearestIndex(centre, nullptr, hrirCount);
+            const float* dn = directionOf(nearest);
+            float nearestDot = dn[0] * centre[0] + dn[1] * centre[1] + dn[2] * centre[2];
+            nearestDot = (nearestDot > 1.0f) ? 1.0f : (nearestDot < -1.0f ? -1.0f : nearestDot);
+            const float limit = acosf(nearestDot) + 2.0f * radius + margin;
+            const float threshold = (limit >= 3.14159265f) ? -2.0f : cosf(limit);
+
+            lookupStart[row * LOOKUP_COLUMNS + col] = (uint16_t)total;
+            for (int i = 0; i < hrirCount; i++) {
+                const float* d = directionOf(i);
+                if (d[0] * centre[0] + d[1] * centre[1] + d[2] * centre[2] < threshold) {
+                    continue;
+                }
+                if (total == capacity) {
+                    uint16_t* grown = (uint16_t*)realloc(list, 2 * capacity * sizeof(uint16_t));
+                    if (!grown) {
+                        free(list);
+                        list = nullptr;
+                        break;
+                    }
+                    list = grown;
+                    capacity *= 2;
+                }
+                list[total++] = (uint16_t)i;
+            }
+            if (total > 0xFFFF) {
+                free(list);
+                list = nullptr;
+            }
+        }
+    }
+    if (!list) {
+        // Parcours complet de la banque en secours
+        Serial.println("Mémoire insuffisante pour la grille de recherche des HRIR");
+        memset(lookupStart, 0, sizeof(lookupStart));
+        return;
+    }
+    lookupStart[LOOKUP_COLUMNS * LOOKUP_ROWS] = (uint16_t)total;
+    uint16_t* fitted = (uint16_t*)realloc(list, total * sizeof(uint16_t));
+    lookupCandidates = fitted ? fitted : list;
+    lookupCandidateCount = total;
+}
+
+SelectedHrir HrtfBank::getHrirAt(int index) const {
+    if (index < 0 || index >= hrirCount) {
+        return emptySelection();
+    }
+    return selectMeasurement(index, azimuthOf(index));
+}
+
+void HrtfBank::triangulate() {
+    free(triangles);
+    free(vertexTriangle);
+    free(ringOrder);
+    free(ringAzimuth);
+    triangles = nullptr;
+    vertexTriangle = nullptr;
+    ringOrder = nullptr;
+    ringAzimuth = nullptr;
+    triangleCount = 0;
+    ringCount = 0;
+    if (!buildHull() || !linkTriangles()) {
+        free(triangles);
+        free(vertexTriangle);
+        triangles = nullptr;
+        vertexTriangle = nullptr;
+        triangleCount = 0;
+        buildRing();
+    }
+}
+
+// Normale (non normalisée) du triangle abc, sens direct
+static void hullNormal(const double* a, const double* b, const double* c, double* normal) {
+    const double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    normal[0] = u[1] * v[2] - u[2] * v[1];
+    normal[1] = u[2] * v[0] - u[0] * v[2];
+    normal[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+// Distance signée de p au plan du triangle abc (positive du côté de la normale)
+static double hullDistance(const double* a, const double* b, const double* c, const double* p) {
+    double nrm[3];
+    hullNormal(a, b, c, nrm);
+    const double len = sqrt(nrm[0] * nrm[0] + nrm[1] * nrm[1] + nrm[2] * nrm[2]);
+    if (len <= 0.0) {
+        return 0.0;
+    }
+    return (nrm[0] * (p[0] - a[0]) + nrm[1] * (p[1] - a[1]) + nrm[2] * (p[2] - a[2])) / len;
+}
+
+bool HrtfBank::buildHull() {
+    // Enveloppe convexe incrémentale des directions : ses faces triangulent la sphère.
+    // Le coût (O(n^2) faces visitées) ne se paie qu'au chargement.
+    const int n = hrirCount;
+    if (n < 4) {
+        return false;
+    }
+    // Au plus 2n - 4 faces, à chaque étape comme à la fin
+    const int capacity = 2 * n;
+    double* pts = (double*)malloc((size_t)n * 3 * sizeof(double));
+    bool* visible = (bool*)malloc(capacity * sizeof(bool));
+    uint16_t* horizon = (uint16_t*)malloc((size_t)capacity * 2 * sizeof(uint16_t));
+    triangles = (HrirTriangle*)malloc(capacity * sizeof(HrirTriangle));
+    if (!pts || !visible || !horizon || !triangles) {
+        Serial.println("Mémoire insuffisante pour la triangulation des HRIR");
+        free(pts);
+        free(visible);
+        free(horizon);
+        return false;
+    }
+    // Sur une grille régulière, quatre mesures de deux anneaux voisins sont cocycliques donc
+    // coplanaires : un rayon légèrement différent par mesure (1e-6, bien en deçà de la flèche
+    // entre mesures voisines) lève l'ambiguïté sans qu'aucune mesure ne passe à l'intérieur.
+    for (int i = 0; i < n; i++) {
+        const double golden = 0.6180339887498949;
+        const double r = 1.0 + 1e-6 * (i * golden - floor(i * golden));
+        for (int c = 0; c < 3; c++) {
+            pts[3 * i + c] = r * directionOf(i)[c];
+        }
+    }
+    const double eps = 1e-10;
+    bool ok = false;
+
+    // Tétraèdre initial : point le plus éloigné, puis de la droite, puis du plan
+    int i1 = 0;
+    int i2 = 0;
+    int i3 = 0;
+    double best = 0.0;
+    for (int i = 1; i < n; i++) {
+        double d = 0.0;
+        for (int c = 0; c < 3; c++) {
+            d += (pts[3 * i + c] - pts[c]) * (pts[3 * i + c] - pts[c]);
+        }
+        if (d > best) {
+            best = d;
+            i1 = i;
+        }
+    }
+    if (best >= 1e-8) {
+        best = 0.0;
+        for (int i = 1; i < n; i++) {
+            double nrm[3];
+            hullNormal(pts, pts + 3 * i1, pts + 3 * i, nrm);
+            double d = nrm[0] * nrm[0] + nrm[1] * nrm[1] + nrm[2] * nrm[2];
+            if (d > best) {
+                best = d;
+                i2 = i;
+            }
+        }
+    }
+    if (best >= 1e-8) {
+        best = 0.0;
+        for (int i = 1; i < n; i++) {
+            double d = fabs(hullDistance(pts, pts + 3 * i1, pts + 3 * i2, pts + 3 * i));
+            if (d > best) {
+                best = d;
+                i3 = i;
+            }
+        }
+        // Mesures coplanaires (un seul anneau d'élévation) : pas de triangulation
+        ok = best >= 1e-4;
+    }
+
+    if (ok) {
+        const uint16_t initial[4] = { 0, (uint16_t)i1, (uint16_t)i2, (uint16_t)i3 };
+        double centre[3] = { 0.0, 0.0, 0.0 };
+        for (int k = 0; k < 4; k++) {
+            for (int c = 0; c < 3; c++) {
+                centre[c] += 0.25 * pts[3 * initial[k] + c];
+            }
+        }
+        static const int tetraFaces[4][3] = { {0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3} };
+        for (int f = 0; f < 4; f++) {
+            uint16_t* v = triangles[f].vertex;
+            v[0] = initial[tetraFaces[f][0]];
+            v[1] = initial[tetraFaces[f][1]];
+            v[2] = initial[tetraFaces[f][2]];
+            if (hullDistance(pts + 3 * v[0], pts + 3 * v[1], pts + 3 * v[2], centre) > 0.0) {
+                uint16_t tmp = v[1];
+                v[1] = v[2];
+                v[2] = tmp;
+            }
+        }
+        triangleCount = 4;
+    }
+
+    for (int i = 1; ok && i < n; i++) {
+        if (i == i1 || i == i2 || i == i3) {
+            continue;
+        }
+
+        // Faces vues depuis le nouveau point (un point intérieur est ignoré)
+        bool any = false;
+        for (int f = 0; f < triangleCount; f++) {
+            const uint16_t* v = triangles[f].vertex;
+            visible[f] = hullDistance(pts + 3 * v[0], pts + 3 * v[1], pts + 3 * v[2],
+                                      pts + 3 * i) > eps;
+            any = any || visible[f];
+        }
+        if (!any) {
+            continue;
+        }
+
+        // Horizon : arêtes des faces visibles dont la face voisine (arête inverse) est cachée
+        int horizonCount = 0;
+        for (int f = 0; f < triangleCount; f++) {
+            if (!visible[f]) {
+                continue;
+            }
+            for (int e = 0; e < 3; e++) {
+                const uint16_t u = triangles[f].vertex[e];
+                const uint16_t v = triangles[f].vertex[(e + 1) % 3];
+                bool border = false;
+                for (int g = 0; g < triangleCount && !border; g++) {
+                    if (visible[g]) {
+                        continue;
+                    }
+                    const uint16_t* w = triangles[g].vertex;
+                    border = (w[0] == v && w[1] == u) || (w[1] == v && w[2] == u) ||
+                             (w[2] == v && w[0] == u);
+                }
+                if (border && horizonCount < capacity) {
+                    horizon[2 * horizonCount]     = u;
+                    horizon[2 * horizonCount + 1] = v;
+                    horizonCount++;
+                }
+            }
+        }
+
+        // Les faces visibles sont remplacées par un éventail reliant l'horizon au point
+        int kept = 0;
+        for (int f = 0; f < triangleCount; f++) {
+            if (!visible[f]) {
+                triangles[kept++] = triangles[f];
+            }
+        }
+        if (kept + horizonCount > capacity) {
+            ok = false;
+            break;
+        }
+        triangleCount = kept;
+        for (int h = 0; h < horizonCount; h++) {
+            uint16_t* v = triangles[triangleCount++].vertex;
+            v[0] = horizon[2 * h];
+            v[1] = horizon[2 * h + 1];
+            v[2] = (uint16_t)i;
+        }
+    }
+    free(pts);
+    free(visible);
+    free(horizon);
+    if (ok) {
+        HrirTriangle* fitted = (HrirTriangle*)realloc(triangles,
+                                                      triangleCount * sizeof(HrirTriangle));
+        triangles = fitted ? fitted : triangles;
+    }
+    return ok;
+}
+
+bool HrtfBank::linkTriangles() {
+    // Voisins par arête (la recherche passe d'un triangle à l'autre) et un triangle par mesure,
+    // via la liste temporaire des triangles de chaque mesure
+    const int n = hrirCount;
+    const int F = triangleCount;
+    vertexTriangle = (uint16_t*)malloc(n * sizeof(uint16_t));
+    uint32_t* first = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    uint16_t* incident = (uint16_t*)malloc((size_t)3 * F * sizeof(uint16_t));
+    if (!vertexTriangle || !first || !incident) {
+        Serial.println("Mémoire insuffisante pour la triangulation des HRIR");
+        free(first);
+        free(incident);
+        return false;
+    }
+    memset(first, 0, (n + 1) * sizeof(uint32_t));
+    for (int f = 0; f < F; f++) {
+        for (int k = 0; k < 3; k++) {
+            first[triangles[f].vertex[k] + 1]++;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        first[i + 1] += first[i];
+        vertexTriangle[i] = NO_TRIANGLE;  // mesure à l'intérieur de l'enveloppe (doublon)
+    }
+    for (int f = 0; f < F; f++) {
+        for (int k = 0; k < 3; k++) {
+            const uint16_t v = triangles[f].vertex[k];
+            if (vertexTriangle[v] == NO_TRIANGLE) {
+                vertexTriangle[v] = (uint16_t)f;
+            }
+            // first[v] sert de curseur d'écriture, décalé d'une mesure ensuite
+            incident[first[v]++] = (uint16_t)f;
+        }
+    }
+    for (int i = n; i > 0; i--) {
+        first[i] = first[i - 1];
+    }
+    first[0] = 0;
+
+    for (int f = 0; f < F; f++) {
+        for (int k = 0; k < 3; k++) {
+            // Arête (a, b) opposée au sommet k, parcourue en sens inverse par le voisin
+            const uint16_t a = triangles[f].vertex[(k + 1) % 3];
+            const uint16_t b = triangles[f].vertex[(k + 2) % 3];
+            uint16_t neighbour = NO_TRIANGLE;
+            for (uint32_t j = first[b]; j < first[b + 1] && neighbour == NO_TRIANGLE; j++) {
+                const uint16_t* w = triangles[incident[j]].vertex;
+                if ((w[0] == b && w[1] == a) || (w[1] == b && w[2] == a) ||
+                    (w[2] == b && w[0] == a)) {
+                    neighbour = incident[j];
+                }
+            }
+            triangles[f].neighbour[k] = neighbour;
+        }
+    }
+    free(first);
+    free(incident);
+    return true;
+}
+
+void HrtfBank::buildRing() {
+    // Tri par insertion selon l'azimut exact, repris du vecteur direction (les azimuts des
+    // mesures sont arrondis au degré : 2.5° d'écart deviendraient 2 ou 3)
+    if (hrirCount == 0) {
+        return;
+    }
+    ringOrder = (uint16_t*)malloc(hrirCount * sizeof(uint16_t));
+    ringAzimuth = (float*)malloc(hrirCount * sizeof(float));
+    if (!ringOrder || !ringAzimuth) {
+        Serial.println("Mémoire insuffisante pour l'anneau des HRIR");
+        return;
+    }
+    ringCount = hrirCount;
+    for (int i = 0; i < ringCount; i++) {
+        const float* d = directionOf(i);
+        float az = atan2f(d[1], d[0]) * 180.0f / 3.14159265f;
+        if (az < 0.0f) {
+            az += 360.0f;
+        }
+        if (az >= 360.0f) {
+            az = 0.0f;
+        }
+        int j = i;
+        while (j > 0 && ringAzimuth[j - 1] > az) {
+            ringOrder[j] = ringOrder[j - 1];
+            ringAzimuth[j] = ringAzimuth[j - 1];
+            j--;
+        }
+        ringOrder[j] = (uint16_t)i;
+        ringAzimuth[j] = az;
+    }
+}
+
+void HrtfBank::triangleWeights(int triangle, const float* x, float* weights) const {
+    // direction = w0*d0 + w1*d1 + w2*d2, soit w = [d0 d1 d2]^-1 * direction : chaque ligne de
+    // l'inverse est le produit vectoriel des deux autres sommets divisé par le déterminant.
+    // Un triangle passant par le centre (sphère incomplète) donne des poids nuls.
+    const uint16_t* v = triangles[triangle].vertex;
+    const float* d[3] = { directionOf(v[0]), directionOf(v[1]), directionOf(v[2]) };
+    float rows[9];
+    for (int r = 0; r < 3; r++) {
+        const float* a = d[(r + 1) % 3];
+        const float* b = d[(r + 2) % 3];
+        rows[3 * r]     = a[1] * b[2] - a[2] * b[1];
+        rows[3 * r + 1] = a[2] * b[0] - a[0] * b[2];
+        rows[3 * r + 2] = a[0] * b[1] - a[1] * b[0];
+    }
+    const float det = d[0][0] * rows[0] + d[0][1] * rows[1] + d[0][2] * rows[2];
+    const float inv = (fabsf(det) > 1e-9f) ? 1.0f / det : 0.0f;
+    for (int r = 0; r < 3; r++) {
+        weights[r] = (rows[3 * r] * x[0] + rows[3 * r + 1] * x[1] + rows[3 * r + 2] * x[2]) * inv;
+    }
+}
+
+HrirInterpolation HrtfBank::getInterpolation(float azimuthDeg, float elevationDeg, int hint) const {
+    HrirInterpolation result = locateInterpolation(azimuthDeg, elevationDeg, hint);
+    if (cacheStore) {
+        // Mesures absentes remplacées par la plus proche résidente, qui reprend leur poids
+        for (int k = 0; k < 3; k++) {
+            if (result.slots[k] >= 0 && result.weights[k] > 0.0f) {
+                result.slots[k] = residentIndex(result.slots[k]);
+            }
+        }
+    }
+    return result;
+}
+
+HrirInterpolation HrtfBank::locateInterpolation(float azimuthDeg, float elevationDeg,
+                                                int hint) const {
+    HrirInterpolation result;
+    for (int k = 0; k < 3; k++) {
+        result.slots[k] = -1;
+        result.weights[k] = 0.0f;
+    }
+    result.triangle = -1;
+    if (hrirCount == 0) {
+        return result;
+    }
+
+    if (triangleCount == 0 && ringCount > 0) {
+        // Anneau : interpolation linéaire entre les deux voisines en azimut
+        float az = fmodf(azimuthDeg, 360.0f);
+        if (az < 0.0f) {
+            az += 360.0f;
+        }
+        int upper = 0;
+        while (upper < ringCount && ringAzimuth[upper] <= az) {
+            upper++;
+        }
+        const int lower = (upper + ringCount - 1) % ringCount;
+        if (upper == ringCount) {
+            upper = 0;
+        }
+        // Écart entre les deux voisines (360 s'il n'y a qu'une mesure sur l'anneau)
+        float span = ringAzimuth[upper] - ringAzimuth[lower];
+        if (span < 0.0f || (span == 0.0f && ringCount == 1)) {
+            span += 360.0f;
+        }
+        float pos = az - ringAzimuth[lower];
+        if (pos < 0.0f) {
+            pos += 360.0f;
+        }
+        const float w = (span > 0.0f) ? pos / span : 0.0f;
+        result.slots[0] = ringOrder[lower];
+        result.weights[0] = 1.0f - w;
+        result.slots[1] = ringOrder[upper];
+        result.weights[1] = w;
+        return result;
+    }
+
+    float x[3];
+    directionVector(azimuthDeg, elevationDeg, x);
+    int bestTriangle = -1;
+    float bestWeights[3] = { 0.0f, 0.0f, 0.0f };
+    if (triangleCount > 0) {
+        // Marche : on part du triangle hint ou d'un triangle de la mesure la plus proche, et on
+        // passe au voisin de l'autre côté de l'arête dont le poids est le plus négatif
+        int f = hint;
+        if (f < 0 || f >= triangleCount) {
+            const int nearest = nearestMeasurement(x, azimuthDeg, elevationDeg);
+            f = (vertexTriangle[nearest] != NO_TRIANGLE) ? vertexTriangle[nearest] : 0;
+        }
+        for (int step = 0; step < triangleCount; step++) {
+            float w[3];
+            triangleWeights(f, x, w);
+            const float sum = w[0] + w[1] + w[2];
+            if (sum <= 0.0f) {
+                break;  // triangle à l'opposé de la direction
+            }
+            int lowest = (w[1] < w[0]) ? 1 : 0;
+            lowest = (w[2] < w[lowest]) ? 2 : lowest;
+            if (w[lowest] >= -1e-6f * sum) {
+                bestTriangle = f;
+                bestWeights[0] = w[0];
+                bestWeights[1] = w[1];
+                bestWeights[2] = w[2];
+                break;
+            }
+            if (triangles[f].neighbour[lowest] == NO_TRIANGLE) {
+                break;
+            }
+            f = triangles[f].neighbour[lowest];
+        }
+    }
+
+    // Marche interrompue (sphère incomplète, dont l'enveloppe a des faces loin de la sphère) :
+    // tous les triangles, le premier qui contient la direction ou à défaut le moins éloigné
+    int scanTriangle = -1;
+    float bestScore = -1e30f;
+    for (int f = 0; bestTriangle < 0 && f < triangleCount && bestScore < -1e-6f; f++) {
+        float w[3];
+        triangleWeights(f, x, w);
+        const float sum = w[0] + w[1] + w[2];
+        if (sum <= 0.0f) {
+            continue;
+        }
+        float lowest = (w[0] < w[1]) ? w[0] : w[1];
+        lowest = (w[2] < lowest) ? w[2] : lowest;
+        const float score = lowest / sum;
+        if (score > bestScore) {
+            bestScore = score;
+            scanTriangle = f;
+            bestWeights[0] = w[0];
+            bestWeights[1] = w[1];
+            bestWeights[2] = w[2];
+        }
+    }
+    if (bestTriangle < 0) {
+        bestTriangle = scanTriangle;
+    }
+
+    if (bestTriangle < 0) {
+        // Aucune face devant la direction (sphère très incomplète) : mesure la plus proche
+        result.slots[0] = nearestMeasurement(x, azimuthDeg, elevationDeg);
+        result.weights[0] = 1.0f;
+        return result;
+    }
+
+    // Projection sur le triangle : poids négatifs (arrondis) ramenés à zéro, somme à 1
+    float sum = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        bestWeights[k] = (bestWeights[k] > 0.0f) ? bestWeights[k] : 0.0f;
+        sum += bestWeights[k];
+    }
+    for (int k = 0; k < 3; k++) {
+        result.slots[k] = triangles[bestTriangle].vertex[k];
+        result.weights[k] = bestWeights[k] / sum;
+    }
+    result.triangle = bestTriangle;
+    return result;
+}
+
+SelectedHrir HrtfBank::emptySelection() {
+    SelectedHrir sel;
+    sel.coeffs = nullptr;
+    sel.delayLeft = 0;
+    sel.delayRight = 0;
+    sel.length = 0;
+    sel.distance = 0.0f;  // si besoin d'utiliser la distance ailleurs
+    sel.spectrum = nullptr;
+    sel.tailSpectrum = nullptr;
+    sel.fullLength = 0;
+    sel.itdLeft = 0.0f;
+    sel.itdRight = 0.0f;
+    sel.azimuth = 0;
+    sel.elevation = 0;
+    sel.index = -1;
+    return sel;
+}
+
+void HrtfBank::directionVector(float azimuthDeg, float elevationDeg, float* v) {
+    const float az = azimuthDeg * 3.14159265f / 180.0f;
+    const float el = elevationDeg * 3.14159265f / 180.0f;
+    v[0] = cosf(el) * cosf(az);
+    v[1] = cosf(el) * sinf(az);
+    v[2] = sinf(el);
+}
+
+SelectedHrir HrtfBank::selectMeasurement(int bestIndex, int azimuthDeg) const {
+    SelectedHrir sel = emptySelection();
+    sel.index = bestIndex;
+    unsigned delayLeft = 0;
+    unsigned delayRight = 0;
+
+    if (store) {
+        // Filtre à décoder par l'appelant (decodeHrir) : coeffs et spectrum restent nuls
+        const HrtfStoreSlot& m = store->slot(bestIndex);
+        sel.length = store->length(bestIndex);
+        sel.fullLength = sel.length;
+        sel.distance = m.distance;
+        store->itd(bestIndex, sel.itdLeft, sel.itdRight);
+        sel.azimuth = m.azimuth;
+        sel.elevation = m.elevation;
+    } else {
+        // Récupérer les données du HRIR sélectionné
+        sel.coeffs = slotCoeffs[bestIndex];
+        sel.length = slotLength[bestIndex];
+        sel.distance = slotDistance[bestIndex]; // si vous utilisez la distance plus tard
+        sel.spectrum = slotSpectrum[bestIndex];
+        sel.tailSpectrum = slotTail[bestIndex];
+        sel.fullLength = slotFullLength[bestIndex];
+        sel.itdLeft = slotItdLeft[bestIndex];
+        sel.itdRight = slotItdRight[bestIndex];
+        sel.azimuth = slotAzimuth[bestIndex];
+        sel.elevation = slotElevation[bestIndex];
+        delayLeft = slotDelayLeft[bestIndex];
+        delayRight = slotDelayRight[bestIndex];
+    }
+
+    // Si les délais stockés sont zéro, on calcule l'ITD approximatif basé sur l'azimut
+    if (delayLeft == 0 && delayRight == 0) {
+        // Convertir l'azimut en angle entre -180 et 180
+        float effectiveAz = (azimuthDeg > 180) ? azimuthDeg - 360 : (float)azimuthDeg;
+        float rad = effectiveAz * 3.14159265f / 180.0f;
+
+        // Paramètres hypothétiques : rayon de la tête et vitesse du son
+        float headRadius = 0.15f;      // en mètres (15 cm)
+        float speedOfSound = 343.0f;       // en m/s
+        // Calcul de l'ITD (en secondes) : ITD = (headRadius / speedOfSound) * sin(angle)
+        float itd = headRadius / speedOfSound * sin(rad);
+        // Convertir l'ITD en nombre d'échantillons
+        unsigned delaySamples = (unsigned)round(fabs(itd) * sampleRate);
+
+        // Appliquer le délai : si l'ITD est négatif, on retarde le canal gauche, sinon le canal droit
+        if (itd < 0) {
+            sel.delayLeft = delaySamples;
+            sel.delayRight = 0;
+        } else {
+            sel.delayLeft = 0;
+            sel.delayRight = delaySamples;
+        }
+    } else {
+        sel.delayLeft  = delayLeft;
+        sel.delayRight = delayRight;
+    }
+
+    return sel;
+}
@@ -0,0 +1,430 @@
+#ifndef HRTF_BANK_H
+#define HRTF_BANK_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "HrtfFft.h"
+#include "HrtfLongConvolver.h"
+#include "HrtfFlashBank.h"
+#include "HrtfStore.h"
+
+class HrirBinReader;
+class HrtfResampler;
+struct HrirBinMeta;
+class HrtfCompactStore;
+class HrtfPcaStore;
+class HrtfCacheStore;
+
+// Longueur maximale d'une HRIR (tête convoluée sans latence ; au-delà, voir HrtfLongConvolver)
+static const int MAX_HRIR_LENGTH = 128;
+
+struct HrirData {
+    unsigned delayLeft;   // en échantillons
+    unsigned delayRight;  // en échantillons
+    float coeffs[2 * MAX_HRIR_LENGTH];  // taps gauche/droite entrelacés
+    size_t length;
+    float itdLeft;        // retard fractionnaire retiré de la HRIR (phase minimale), en échantillons
+    float itdRight;
+};
+
+struct SelectedHrir {
+    const float* coeffs;    // taps gauche/droite entrelacés (coeffs[2k] = gauche, coeffs[2k+1] = droite)
+    unsigned delayLeft;
+    unsigned delayRight;
+    size_t length;
+    float distance;  // Nouvelle donnée : distance en mètres (par exemple)
+    const float* spectrum;  // Spectres précalculés (gauche + j*droite), une partition après l'autre
+    const float* tailSpectrum;  // Spectres de la queue au-delà de MAX_HRIR_LENGTH (nul si absente)
+    size_t fullLength;          // Longueur totale de la réponse (tête + queue)
+    float itdLeft;              // Retard fractionnaire à appliquer en sortie (phase minimale, sinon 0)
+    float itdRight;
+    int azimuth;                // Direction de la mesure retenue (en degrés)
+    int elevation;
+    int index;                  // Mesure retenue dans la banque (getHrirAt), -1 si aucune
+};
+
+// Mesures encadrant une direction et leurs poids barycentriques (voir HrtfBank::getInterpolation)
+struct HrirInterpolation {
+    int slots[3];       // indices des mesures, -1 si inutilisé
+    float weights[3];   // poids positifs de somme 1
+    int triangle;       // triangle retenu (-1 sur un anneau), à repasser en hint à l'appel suivant
+};
+
+// Banque de HRIR en lecture seule, chargée une fois et partagée par toutes les voix (HrtfVoice).
+// Banque résidente : elle contient les coefficients, leurs spectres précalculés et les spectres
+// des queues. Banque à décoder (isCompact) : les filtres sont dans un stockage propre au
+// format (HrtfStore), la banque gardant la recherche et la sélection. L'état de convolution
+// propre à chaque source est dans HrtfVoice.
+class HrtfBank {
+public:
+    HrtfBank();
+    ~HrtfBank();
+
+    // Initialisation : sampleRate, blockSize (ex : 44100, 128). Les fichiers chargés ensuite
+    // (tous les formats de loadFromBin) sont convertis à sampleRate s'ils sont à une autre
+    // fréquence (HRTF_RESAMPLE_QUALITY) ; une banque compilée garde la sienne (getSampleRate).
+    void init(int sRate, int bSize);
+    void addHrir(int azimuthDeg,
+                 const float* left, const float* right,
+                 unsigned delayLeft, unsigned delayRight,
+                 size_t length);
+    void addHrir(int azimuthDeg, int elevationDeg,
+                 const float* left, const float* right,
+                 unsigned delayLeft, unsigned delayRight,
+                 size_t length);
+    // Formats "HRIR", "HRIV", "HRIP" (base PCA) et "HRB2" (sections lues en bloc, spectres
+    // repris du fichier s'ils sont au découpage de la banque), voir HrirBinReader. false si le
+    // fichier ne s'ouvre pas, ou si une section "HRB2" est corrompue (banque alors vide).
+    // Index seul pour une banque à la demande (setCacheSize). Fichier à une autre fréquence que
+    // celle d'init : mesures, taps, base PCA et filtres lus par le cache convertis au chargement.
+    bool loadFromBin(const String &filename);
+    // Chargement par étapes, pour préparer une banque depuis loop() pendant que l'audio tourne
+    // sur une autre (MyDsp::loadSubject) : beginLoad ouvre le fichier (false s'il ne s'ouvre
+    // pas, banque alors inchangée), puis chaque appel de loadStep enchaîne des étapes tant que
+    // budgetMicros n'est pas écoulé (une au moins) et rend false quand la banque est complète,
+    // getLoadResult donnant alors le résultat de loadFromBin. Une étape : une mesure ("HRIR",
+    // "HRIV", taps d'un "HRB2"), SPECTRA_CHUNK_BYTES de spectres lus, le spectre d'une mesure,
+    // ou la recherche et la triangulation ; la base PCA et l'index d'une banque à la demande
+    // sont lus en une étape. La banque n'est pas utilisable avant la fin du chargement.
+    bool beginLoad(const String& filename);
+    bool loadStep(uint32_t budgetMicros);
+    bool isLoading() const { return loadPhase != LOAD_IDLE; }
+    // L'étape suivante lit la carte SD (partagée avec les lecteurs WAV de l'interruption
+    // audio) ; un appel de loadStep ne mêle pas lectures et calculs
+    bool isLoadReadingCard() const;
+    bool getLoadResult() const { return loadResult; }
+    // Banque compilée en flash (HrtfFlashData.h) : les mesures pointent sur ses coefficients et,
+    // s'ils sont au découpage de la banque, sur ses spectres ; sinon les spectres sont calculés
+    // en RAM. Aucune conversion (phase minimale et fréquence faites par le générateur), ni
+    // stockage compact ou cache. false si la banque compilée n'est pas utilisable (vide, trop
+    // longue).
+    bool loadFromFlash(const HrtfFlashBank& flash);
+
+    // Conversion des HRIR en phase minimale + ITD fractionnaire, tronquées à length taps
+    // (0 : HRIR mesurées telles quelles). À régler avant addHrir/loadFromBin ; les réponses
+    // longues (BRIR) ne sont pas converties, ni les fichiers PCA (convertis à l'extraction) ou
+    // "HRB2" déjà à phase minimale.
+    void setMinimumPhase(size_t length);
+    // Longueur de phase minimale des filtres chargés : celle du fichier pour une base PCA
+    size_t getMinimumPhaseLength() const { return filterMinimumPhase; }
+
+    // Stockage compact des grandes banques (les ~1550 mesures de hrtf_nh2.bin), à régler avant
+    // addHrir/loadFromBin. Chaque mesure est gardée en int16 avec un pas propre, sans les taps
+    // de début et de fin qui ne portent que 1e-6 de son énergie : ni coefficients flottants ni
+    // spectres ne sont résidents. getHrir/getHrirAt rendent alors la description de la mesure
+    // sans filtre (coeffs et spectrum nuls, index renseigné) ; HrtfVoice la décode dans ses
+    // propres buffers (decodeHrir). Les queues des réponses longues (BRIR) et les retards
+    // entiers passés à addHrir sont ignorés.
+    void setCompactStorage(bool enabled);
+    // Filtres à décoder par les voix : stockage compact, ou base PCA chargée
+    bool isCompact() const { return compact; }
+    // Octets résidents de la banque compacte : codes int16 ou base et poids PCA, et
+    // description des mesures
+    size_t getCompactBytes() const;
+    // Énergie de l'erreur de stockage (taps retirés et quantification) rapportée à celle des
+    // filtres, sur toute la banque compacte, en dB (l'erreur d'une base PCA n'est pas connue
+    // ici : voir assets/extractPcaToBin.py et BENCH:PCA)
+    float getCompactErrorDb() const;
+
+    // Stockage symétrique, pour une tête supposée symétrique (écart d'un sujet mesuré par
+    // assets/checkSymmetry.py), à régler avant addHrir/loadFromBin : une seule oreille est gardée
+    // par direction, l'oreille droite à l'azimut a étant la gauche de la mesure miroir (-a, même
+    // élévation, la plus proche si la grille n'est pas symétrique). La banque est alors
+    // compacte, avec deux fois moins de codes ; d'un fichier "HRIR", seules les oreilles gauches
+    // sont lues sur la carte SD (et converties en phase minimale). Chaque paire de mesures
+    // miroirs est normalisée par le maximum de leurs deux oreilles gauches, soit le maximum des
+    // deux oreilles de chacune, comme HrirBinReader. Fichiers "HRIR" et addHrir seulement : les
+    // autres formats et la banque à la demande sont chargés avec leurs deux oreilles.
+    void setSymmetricStorage(bool enabled);
+    bool isSymmetric() const { return symmetric; }
+    // Plus grand écart (en degrés) entre la direction miroir d'une mesure et celle de la mesure
+    // qui fournit son oreille droite (0 sur une grille symétrique)
+    float getSymmetryErrorDeg() const { return symmetryErrorDeg; }
+
+    // Base PCA (fichier "HRIP") : chaque filtre est la moyenne plus la somme pondérée de K
+    // composantes communes, soit K floats par mesure ; la banque est alors compacte. Les voix
+    // reconstruisent le filtre à la sélection (interpolation comprise : les poids des mesures
+    // sont mélangés avant une seule reconstruction) ; HrtfPcaMixer convolue plutôt les
+    // composantes une fois par bloc pour toutes les sources.
+    // setPcaComponents limite le nombre de composantes utilisées (au plus celles du fichier).
+    void setPcaComponents(int count);
+    int getPcaComponents() const;
+    int getPcaStoredComponents() const;
+    size_t getPcaLength() const;
+    // Filtre component de la base (0 : moyenne, 1..K : composantes), getPcaLength() taps
+    // gauche/droite entrelacés
+    const float* getPcaBasis(int component) const;
+    // Poids de la mesure index (getPcaStoredComponents() floats), nul hors de la base
+    const float* getPcaWeights(int index) const;
+    // Banque à la demande, pour les fichiers à enregistrements fixes ("HRIR", "HRB2") : à régler
+    // avant loadFromBin (0 : banque chargée en entier). loadFromBin ne lit que l'index (direction
+    // et distance de chaque mesure) ; les filtres sont lus sur la carte SD dans un cache LRU de
+    // measurements emplacements, dont un quart reste occupé par des mesures réparties sur la
+    // sphère. La banque est alors compacte (filtres décodés par les voix). Sur l'interruption
+    // audio, une mesure absente n'est jamais lue : getHrir et getInterpolation rendent à sa
+    // place la plus proche des mesures résidentes et la demandent à loadNext.
+    void setCacheSize(int measurements);
+    int getCacheSize() const { return cacheSize; }
+    bool isCached() const { return cacheStore != nullptr; }
+    // Directions que la source va traverser (la première est la direction courante) : leurs
+    // mesures sont chargées par loadNext et ne sont pas évincées avant le prochain appel
+    void prefetch(const float* azimuthsDeg, const float* elevationsDeg, int count);
+    // Hors interruption audio (loop), carte SD libre : lit une mesure manquante, celles
+    // demandées par l'interruption d'abord, puis celles des directions de prefetch. false s'il
+    // n'y a rien à lire (ou plus de place sans évincer une mesure encore utile).
+    bool loadNext();
+    // Compteurs du cache : mesures trouvées et absentes à la sélection, lectures sur la carte
+    uint32_t getCacheHits() const;
+    uint32_t getCacheMisses() const;
+    uint32_t getCacheLoads() const;
+    int getCacheResident() const;
+    // Incrémenté à chaque mesure chargée : une sélection servie par une mesure de remplacement
+    // est à refaire (HrtfVoice), sans toucher aux spectres comme getGeneration
+    uint32_t getCacheVersion() const;
+
+    // Octets des structures de recherche (triangles, grille, anneau), quel que soit le stockage
+    size_t getIndexBytes() const;
+
+    // Filtre de la mesure sel.index décodé dans coeffs (2*MAX_HRIR_LENGTH floats, taps
+    // entrelacés) et, si spectrum n'est pas nul, son spectre (getSpectrumSize() floats) : copie
+    // de sel pointant sur ces buffers. Sur une banque résidente, simple copie des coefficients.
+    SelectedHrir decodeHrir(const SelectedHrir& sel, float* coeffs, float* spectrum) const;
+    // coeffs (2*MAX_HRIR_LENGTH floats) = somme des weights[k] * filtre de la mesure
+    // indices[k] ; retourne la longueur du mélange en taps
+    size_t mixHrirs(const int* indices, const float* weights, int count, float* coeffs) const;
+
+    // Mesure la plus proche en azimut, en temps constant (table par degré)
+    SelectedHrir getHrir(int azimuthDeg) const;
+    // Mesure la plus proche en azimut et en élévation (banques multi-élévations) : seules les
+    // quelques candidates de la cellule de la grille de recherche sont comparées
+    SelectedHrir getHrir(int azimuthDeg, int elevationDeg) const;
+
+    // Filtre interpolé pour une direction quelconque (degrés fractionnaires) : les trois mesures
+    // du triangle qui la contient, sur la triangulation de la sphère des mesures calculée au
+    // chargement (enveloppe convexe). La recherche part du triangle hint (celui de l'appel
+    // précédent) ou d'un triangle de la mesure la plus proche, et passe de voisin en voisin
+    // vers la direction : quelques triangles testés quel que soit le nombre de mesures.
+    // Banque à un seul anneau d'élévation : les deux voisines en azimut, élévation ignorée.
+    HrirInterpolation getInterpolation(float azimuthDeg, float elevationDeg, int hint = -1) const;
+    // Mesure d'indice donné (0 <= index < getHrirCount())
+    SelectedHrir getHrirAt(int index) const;
+
+    int getHrirCount() const { return hrirCount; }
+    int getTriangleCount() const { return triangleCount; }
+    int getSampleRate() const { return sampleRate; }
+    int getBlockSize() const { return blockSize; }
+
+    // Découpage des spectres précalculés (fftSize = 0 si la FFT est indisponible)
+    int getFftSize() const { return fftSize; }
+    int getPartitionCount() const { return partitionCount; }
+    // Taille (en floats) des spectres d'une HRIR et calcul pour des coefficients quelconques
+    // (taps gauche/droite entrelacés, length <= MAX_HRIR_LENGTH), au même découpage que la banque
+    size_t getSpectrumSize() const { return (size_t)partitionCount * 2 * fftSize; }
+    void computeSpectrum(const float* coeffs, size_t length, float* spectrum) const;
+    // Plus longue réponse de la banque (dimensionne la convolution des queues des voix)
+    size_t getMaxTailLength() const { return maxTailLength; }
+    // Incrémenté quand les spectres sont déplacés en mémoire (rechargement)
+    uint32_t getGeneration() const { return generation; }
+
+    // Vecteur unitaire d'une direction (degrés), pour la recherche sur la sphère
+    static void directionVector(float azimuthDeg, float elevationDeg, float* v);
+
+private:
+    HrtfBank(const HrtfBank&);
+    HrtfBank& operator=(const HrtfBank&);
+
+    // Banque résidente : jusqu'à MAX_HRIR_SLOTS mesures. Banque à décoder : jusqu'à
+    // HrtfStore::MAX_SLOTS mesures
+    static const int MAX_HRIR_SLOTS = 128;
+    // Floats par mesure dans coeffPool : 1 Ko, un multiple de 32 octets
+    static const size_t COEFF_STRIDE = 2 * MAX_HRIR_LENGTH;
+
+    // Triangle de l'enveloppe convexe des directions mesurées, orienté vers l'extérieur.
+    // neighbour[k] : triangle de l'autre côté de l'arête opposée au sommet k.
+    static const uint16_t NO_TRIANGLE = 0xFFFF;
+    struct HrirTriangle {
+        uint16_t vertex[3];
+        uint16_t neighbour[3];
+    };
+
+    const float* directionOf(int index) const {
+        return store ? store->slot(index).direction : slotDirection[index];
+    }
+    int azimuthOf(int index) const {
+        return store ? store->slot(index).azimuth : slotAzimuth[index];
+    }
+    SelectedHrir selectMeasurement(int index, int azimuthDeg) const;
+    static SelectedHrir emptySelection();
+    void convertMinimumPhase(HrirData& data);
+    // Tête convertie à engineRate (rateResampler), ITD comprises
+    void convertRate(HrirData& data);
+    // Taps d'un filtre de length taps une fois converti (length sans conversion)
+    size_t rateLength(size_t length) const;
+    bool reserveCoeffs(int count);
+    void releaseCoeffs();
+    // Mesure résidente index : description et tête (data) copiées, sans queue ni spectre
+    void storeSlot(int index, float azimuthDeg, float elevationDeg, float distance,
+                   const HrirData& data);
+    bool reserveSpectra();
+    void computeSpectra(int firstSlot);
+    void releaseTails();
+    static void copyHead(HrirData& data, const float* left, const float* right, size_t length);
+    // Stockage compact de la banque, créé au premier appel (leftOnly : stockage symétrique)
+    HrtfCompactStore* useCompactStore();
+    // Mesure préparée (tête, phase minimale) puis quantifiée dans le stockage compact
+    bool storeCompact(float azimuthDeg, float elevationDeg, float distance,
+                      const float* left, const float* right, size_t length);
+    // Stockage symétrique : mesure miroir de chaque mesure (après buildLookup)
+    void resolveMirrors();
+    bool loadPca(HrirBinReader& reader);
+    // Étapes du chargement (beginLoad, loadStep), une par phase
+    enum LoadPhase {
+        LOAD_IDLE,
+        LOAD_BULK,             // base PCA ou index d'une banque à la demande
+        LOAD_MEASUREMENTS,     // "HRIR", "HRIV" : une mesure
+        LOAD_SECTION_META,     // "HRB2" : description de toutes les mesures
+        LOAD_SECTION_COEFFS,   // "HRB2" : bloc de taps d'une mesure
+        LOAD_SECTION_SPECTRA,  // "HRB2" : SPECTRA_CHUNK_BYTES de spectres du fichier
+        LOAD_SPECTRA,          // spectre calculé d'une mesure
+        LOAD_INDEX             // recherche, triangulation, miroirs
+    };
+    static const size_t SPECTRA_CHUNK_BYTES = 8192;
+    void stepBulk();
+    void stepMeasurement();
+    // Mesure lue convertie à engineRate (rateResampler) : pointeurs et longueur remplacés par
+    // ceux de loadResampled ; false si mémoire insuffisante
+    bool resampleMeasurement(const float*& left, const float*& right, size_t& length);
+    void stepSectionMeta();
+    void stepSectionCoeffs();
+    void stepSectionSpectra();
+    void stepSpectrum();
+    void startSpectra();
+    void finishLoad();
+    void endLoad();
+    void releaseStore();
+    void buildLookup();
+    int nearestIndex(const float* direction, const uint16_t* candidates, int count) const;
+    int nearestMeasurement(const float* direction, float azimuthDeg, float elevationDeg) const;
+    void triangulate();
+    bool buildHull();
+    bool linkTriangles();
+    void buildRing();
+    void triangleWeights(int triangle, const float* direction, float* weights) const;
+    HrirInterpolation locateInterpolation(float azimuthDeg, float elevationDeg, int hint) const;
+    bool loadIndex(HrirBinReader& reader, const String& filename);
+    void pinCache();
+    // Mesure index lue par le cache, préparée (phase minimale) puis publiée
+    bool fillCache(int index);
+    int residentIndex(int index) const;
+
+    // Banque résidente, rangée par champ : la recherche et la sélection ne lisent que des
+    // tableaux de quelques octets par mesure, sans traverser les coefficients. Ceux-ci sont
+    // dans coeffPool, un bloc contigu aligné sur 32 octets de COEFF_STRIDE floats par mesure
+    // (taps gauche/droite entrelacés), alloué pour les mesures chargées seulement : une banque
+    // compacte ou compilée en flash n'en a pas.
+    int16_t slotAzimuth[MAX_HRIR_SLOTS];
+    int16_t slotElevation[MAX_HRIR_SLOTS];
+    float slotDirection[MAX_HRIR_SLOTS][3];  // vecteur unitaire, pour la recherche sur la sphère
+    float slotDistance[MAX_HRIR_SLOTS];
+    uint16_t slotLength[MAX_HRIR_SLOTS];     // taps de la tête
+    uint32_t slotFullLength[MAX_HRIR_SLOTS]; // tête + queue (format HRIV)
+    unsigned slotDelayLeft[MAX_HRIR_SLOTS];  // retards entiers passés à addHrir
+    unsigned slotDelayRight[MAX_HRIR_SLOTS];
+    float slotItdLeft[MAX_HRIR_SLOTS];       // retard fractionnaire retiré (phase minimale)
+    float slotItdRight[MAX_HRIR_SLOTS];
+    const float* slotCoeffs[MAX_HRIR_SLOTS];   // dans coeffPool, ou en flash (loadFromFlash)
+    const float* slotSpectrum[MAX_HRIR_SLOTS]; // dans spectraPool, ou en flash
+    float* slotTail[MAX_HRIR_SLOTS];  // hrtfAllocate si fullLength > MAX_HRIR_LENGTH
+    float* coeffPool;
+    void* coeffBlock;                 // bloc alloué (malloc), coeffPool y est aligné
+    int coeffCapacity;                // mesures
+    int hrirCount;
+    int sampleRate;
+    int blockSize;
+
+    // Partitions de blockSize échantillons, FFT de taille 2*blockSize.
+    // Les deux oreilles sont dans un seul spectre complexe (gauche = réel, droite = imaginaire).
+    HrtfFft fft;
+    int fftSize;
+    int partitionCount;
+    float* spectraPool;   // hrirCount * partitionCount * fftSize complexes
+    size_t spectraCapacity; // taille allouée de spectraPool (en floats)
+    uint32_t generation;
+
+    // Découpage des queues (seuls spectrumSize et computeSpectrum sont utilisés ici)
+    HrtfLongConvolver tailLayout;
+    size_t maxTailLength;
+
+    // Banque compilée : les flashCount premières mesures sont lues en place, leurs spectres
+    // aussi si flashSpectra
+    int flashCount;
+    bool flashSpectra;
+
+    size_t minimumPhaseLength;   // conversion demandée (setMinimumPhase)
+    size_t filterMinimumPhase;   // phase minimale des filtres chargés (celle du fichier si déjà convertis)
+
+    // Banque à décoder : hrirCount mesures dans store, le stockage du format chargé ; celui
+    // des trois pointeurs typés qui lui correspond le désigne aussi, les autres sont nuls.
+    // compact est le stockage effectif : demandé (compactStorage) ou imposé par le fichier.
+    bool compactStorage;
+    bool compact;
+    HrtfStore* store;
+    HrtfCompactStore* compactStore;
+    HrtfPcaStore* pcaStore;
+    HrtfCacheStore* cacheStore;
+    // Stockage symétrique demandé et effectif (fichier "HRIR" ou addHrir)
+    bool symmetricStorage;
+    bool symmetric;
+    float symmetryErrorDeg;
+
+    // Banque à la demande : emplacements demandés (setCacheSize) ; versions des caches déjà
+    // libérés, pour que getCacheVersion ne revienne jamais en arrière
+    int cacheSize;
+    uint32_t cacheVersionBase;
+
+    // Chargement en cours (beginLoad) : fichier ouvert et position dans la phase
+    HrirBinReader* loadReader;
+    String loadFilename;
+    LoadPhase loadPhase;
+    bool loadResult;
+    bool loadIntact;       // false : section "HRB2" corrompue, banque vidée à la fin
+    bool loadConvert;      // "HRB2" : taps à convertir en phase minimale
+    bool loadWhole;        // "HRB2" : banque entière, CRC des sections vérifiés
+    HrirBinMeta* loadMeta; // "HRB2" : description des loadCount mesures
+    int loadCount;         // "HRB2" : mesures lues ; stockage symétrique : taille de loadPeaks
+    size_t loadPosition;   // prochaine mesure de la section, octet des spectres ou mesure
+    float* loadPeaks;      // stockage symétrique : maximum de chaque gauche brute
+    int engineRate;                  // fréquence donnée à init
+    HrtfResampler* rateResampler;    // fichier à une autre fréquence qu'engineRate ; gardé
+                                     // pour les lectures d'une banque à la demande
+    float rateRatio;                 // engineRate / fréquence du fichier (ITD en échantillons)
+    float* loadResampled;            // mesure convertie, gauche puis droite
+    size_t loadResampledCapacity;    // échantillons par oreille
+
+    // Recherche en temps constant, reconstruite à chaque chargement :
+    //  - azimuthIndex : mesure la plus proche en azimut pour chaque degré ;
+    //  - grille de LOOKUP_STEP degrés en azimut et en élévation : pour chaque cellule, les
+    //    mesures qui peuvent être la plus proche d'un point de la cellule (celles à moins de
+    //    la distance du centre à sa plus proche + le diamètre de la cellule). Absente pour un
+    //    anneau, où la plus proche sur la sphère est aussi la plus proche en azimut.
+    static const int LOOKUP_STEP = 5;
+    static const int LOOKUP_COLUMNS = 360 / LOOKUP_STEP;
+    static const int LOOKUP_ROWS = 180 / LOOKUP_STEP;
+    uint16_t azimuthIndex[360];
+    uint16_t lookupStart[LOOKUP_COLUMNS * LOOKUP_ROWS + 1];
+    uint16_t* lookupCandidates;
+    size_t lookupCandidateCount;
+
+    // Interpolation : triangles de la sphère (vertexTriangle : un triangle par mesure, point de
+    // départ de la recherche), ou anneau trié par azimut si les mesures sont toutes dans un même
+    // plan (une seule élévation). Tableaux alloués au chargement.
+    HrirTriangle* triangles;
+    int triangleCount;
+    uint16_t* vertexTriangle;
+    uint16_t* ringOrder;
+    float* ringAzimuth;  // azimut exact (non arrondi) des mesures, dans [0, 360)
+    int ringCount;
+};
+
+#endif
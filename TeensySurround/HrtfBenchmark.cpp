@@ -0,0 +1,1611 @@
+#include "HrtfBenchmark.h"
+#include "HrtfKernels.h"
+#include "HrtfFft.h"
+#include "HrtfBank.h"
+#include "HrtfVoice.h"
+#include "HrtfMixer.h"
+#include "HrtfAmbisonicMixer.h"
+#include "HrtfPcaMixer.h"
+#include "HrtfResampler.h"
+#include "ImaAdpcm.h"
+#include "SdMediaLibrary.h"
+#include "SdStemReader.h"
+#include "SdWavReader.h"
+#include <Audio.h>
+#include <SD.h>
+#include <math.h>
+#include <string.h>
+
+static const int BENCH_BLOCK = 128;
+static const int BENCH_REPEAT = 20;
+
+static void fillNoise(float* data, int n) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (float)(int32_t)seed * (1.0f / 2147483648.0f);
+    }
+}
+
+void hrtfBenchmarkKernels(Print& out) {
+    const int taps = MAX_HRIR_LENGTH;
+    const int N = 2 * BENCH_BLOCK;
+    float* x      = (float*)malloc((taps - 1 + BENCH_BLOCK) * sizeof(float));
+    float* coeffs = (float*)malloc(2 * taps * sizeof(float));
+    float* outL   = (float*)malloc(BENCH_BLOCK * sizeof(float));
+    float* outR   = (float*)malloc(BENCH_BLOCK * sizeof(float));
+    float* spec   = (float*)malloc(2 * N * sizeof(float));
+    float* inSpec = (float*)malloc(2 * N * sizeof(float));
+    float* acc    = (float*)malloc(2 * N * sizeof(float));
+    HrtfFft fft;
+    if (!x || !coeffs || !outL || !outR || !spec || !inSpec || !acc || !fft.init(N)) {
+        out.println("BENCH:KERNELS memoire insuffisante");
+        free(x); free(coeffs); free(outL); free(outR); free(spec); free(inSpec); free(acc);
+        return;
+    }
+    fillNoise(x, taps - 1 + BENCH_BLOCK);
+    fillNoise(coeffs, 2 * taps);
+    fillNoise(spec, 2 * N);
+    fillNoise(inSpec, 2 * N);
+
+    // FFT aller + retour d'un bloc overlap-save, commune à tous les jeux de noyaux
+    uint32_t fftBest = 0xFFFFFFFF;
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        uint32_t t0 = hrtfCycles();
+        fft.forward(acc);
+        fft.inverse(acc);
+        uint32_t dt = hrtfCycles() - t0;
+        if (dt < fftBest) fftBest = dt;
+        fillNoise(acc, 2 * N);
+    }
+
+    out.print("BENCH:KERNELS taps=");
+    out.print(taps);
+    out.print(" block=");
+    out.println(BENCH_BLOCK);
+    for (int k = 0; k < hrtfKernelSetCount(); k++) {
+        const HrtfKernelSet& ks = hrtfKernelSet(k);
+
+        uint32_t firBest = 0xFFFFFFFF;
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            uint32_t t0 = hrtfCycles();
+            ks.firStereo(x + taps - 1, coeffs, taps, outL, outR, BENCH_BLOCK, 1.0f);
+            uint32_t dt = hrtfCycles() - t0;
+            if (dt < firBest) firBest = dt;
+        }
+
+        uint32_t macBest = 0xFFFFFFFF;
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            uint32_t t0 = hrtfCycles();
+            ks.complexMac(acc, inSpec, spec, N);
+            uint32_t dt = hrtfCycles() - t0;
+            if (dt < macBest) macBest = dt;
+        }
+
+        // Cycles par échantillon de sortie (les deux oreilles comprises)
+        out.print("  ");
+        out.print(ks.name);
+        out.print(&ks == &hrtfKernels() ? " (actif)" : "");
+        out.print(" : direct=");
+        out.print((float)firBest / BENCH_BLOCK, 2);
+        out.print(" cyc/ech, fft=");
+        out.print((float)(fftBest + macBest) / BENCH_BLOCK, 2);
+        out.print(" cyc/ech (dont cmac=");
+        out.print((float)macBest / BENCH_BLOCK, 2);
+        out.println(")");
+    }
+
+    free(x); free(coeffs); free(outL); free(outR); free(spec); free(inSpec); free(acc);
+}
+
+// Une sinusoïde basse fréquence tourne de stepDeg degrés à chaque bloc. En régime établi
+// la sortie est une sinusoïde pure dont la dérivée troisième est quasi nulle : l'énergie
+// de cette dérivée mesure donc les discontinuités, rapportée à l'énergie de la sortie.
+static float switchingArtefactDb(HrtfVoice& voice, HrtfConvolutionMode conv,
+                                 HrtfSwitchMode mode, int stepDeg) {
+    const int B = voice.getBlockSize();
+    const int blocks = 100;
+    const int warmup = 8;  // le temps que la HRIR remplisse l'historique
+    float* in   = (float*)malloc(B * sizeof(float));
+    float* outL = (float*)malloc(B * sizeof(float));
+    float* outR = (float*)malloc(B * sizeof(float));
+    if (!in || !outL || !outR) {
+        free(in); free(outL); free(outR);
+        return 0.0f;
+    }
+
+    voice.setSwitchMode(mode);
+    voice.setConvolutionMode(conv);  // remet l'historique à zéro
+
+    const float w = 2.0f * 3.14159265f * 500.0f / 44100.0f;
+    float prevL[3] = {0, 0, 0}, prevR[3] = {0, 0, 0};
+    double signal = 0.0, artefact = 0.0;
+    for (int b = 0; b < blocks; b++) {
+        for (int n = 0; n < B; n++) {
+            in[n] = 0.5f * sinf(w * (float)(b * B + n));
+        }
+        SelectedHrir sel = voice.select(b * stepDeg, 0);
+        voice.processBlock(in, outL, outR, sel, 0.5f);
+        for (int n = 0; n < B; n++) {
+            // Différence d'ordre 3 : y[n] - 3y[n-1] + 3y[n-2] - y[n-3]
+            float d3L = outL[n] - 3.0f * prevL[0] + 3.0f * prevL[1] - prevL[2];
+            float d3R = outR[n] - 3.0f * prevR[0] + 3.0f * prevR[1] - prevR[2];
+            prevL[2] = prevL[1]; prevL[1] = prevL[0]; prevL[0] = outL[n];
+            prevR[2] = prevR[1]; prevR[1] = prevR[0]; prevR[0] = outR[n];
+            if (b >= warmup) {
+                signal += (double)outL[n] * outL[n] + (double)outR[n] * outR[n];
+                artefact += (double)d3L * d3L + (double)d3R * d3R;
+            }
+        }
+    }
+    free(in); free(outL); free(outR);
+    if (signal <= 0.0 || artefact <= 0.0) {
+        return -200.0f;
+    }
+    return (float)(10.0 * log10(artefact / signal));
+}
+
+void hrtfBenchmarkSwitching(const HrtfBank& bank, Print& out) {
+    if (bank.getHrirCount() == 0) {
+        out.println("BENCH:SWITCH aucune HRIR chargee");
+        return;
+    }
+    HrtfVoice* voice = new HrtfVoice();
+    if (!voice || !voice->init(bank)) {
+        out.println("BENCH:SWITCH memoire insuffisante");
+        delete voice;
+        return;
+    }
+    const int step = 5;
+
+    out.print("BENCH:SWITCH pas=");
+    out.print(step);
+    out.println(" deg/bloc, energie des artefacts / energie de sortie");
+    for (int c = 0; c < 2; c++) {
+        const HrtfConvolutionMode conv = (c == 0) ? HRTF_CONV_DIRECT : HRTF_CONV_FFT;
+        voice->setConvolutionMode(conv);
+        if (voice->getConvolutionMode() != conv) {
+            continue;  // FFT indisponible
+        }
+        float fixedDb = switchingArtefactDb(*voice, conv, HRTF_SWITCH_HARD, 0);
+        float hardDb  = switchingArtefactDb(*voice, conv, HRTF_SWITCH_HARD, step);
+        float fadeDb  = switchingArtefactDb(*voice, conv, HRTF_SWITCH_CROSSFADE, step);
+        out.print("  ");
+        out.print(conv == HRTF_CONV_FFT ? "fft" : "direct");
+        out.print(" : fixe=");
+        out.print(fixedDb, 1);
+        out.print(" dB, brusque=");
+        out.print(hardDb, 1);
+        out.print(" dB, fondu=");
+        out.print(fadeDb, 1);
+        out.println(" dB");
+    }
+    delete voice;
+}
+
+void hrtfBenchmarkMixer(const HrtfBank& bank, Print& out) {
+    if (bank.getHrirCount() == 0) {
+        out.println("BENCH:MIXER aucune HRIR chargee");
+        return;
+    }
+    const int B = bank.getBlockSize();
+    float* in   = (float*)malloc((size_t)HrtfMixer::MAX_SOURCES * B * sizeof(float));
+    float* outL = (float*)malloc(B * sizeof(float));
+    float* outR = (float*)malloc(B * sizeof(float));
+    HrtfMixer* mixer = new HrtfMixer();
+    HrtfVoice* voice = new HrtfVoice();
+    if (!in || !outL || !outR || !mixer || !voice || !voice->init(bank)) {
+        out.println("BENCH:MIXER memoire insuffisante");
+        free(in); free(outL); free(outR);
+        delete mixer;
+        delete voice;
+        return;
+    }
+    fillNoise(in, HrtfMixer::MAX_SOURCES * B);
+    const float* inputs[HrtfMixer::MAX_SOURCES];
+    for (int s = 0; s < HrtfMixer::MAX_SOURCES; s++) {
+        inputs[s] = in + (size_t)s * B;
+    }
+
+    // Référence : une voix complète (FFT, produits et IFFT) par source
+    uint32_t voiceBest = 0xFFFFFFFF;
+    SelectedHrir sel = voice->select(30, 0);
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        uint32_t t0 = hrtfCycles();
+        voice->processBlock(inputs[0], outL, outR, sel, 0.5f);
+        uint32_t dt = hrtfCycles() - t0;
+        if (dt < voiceBest) voiceBest = dt;
+    }
+
+    out.print("BENCH:MIXER block=");
+    out.print(B);
+    out.print(" voix seule=");
+    out.print((float)voiceBest / B, 2);
+    out.println(" cyc/ech");
+    for (int count = 1; count <= HrtfMixer::MAX_SOURCES; count <<= 1) {
+        if (!mixer->init(bank, count)) {
+            out.println("  memoire insuffisante");
+            break;
+        }
+        for (int s = 0; s < count; s++) {
+            mixer->setSource(s, s * 360 / count, 0, 1.0f / count);
+        }
+        uint32_t best = 0xFFFFFFFF;
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            uint32_t t0 = hrtfCycles();
+            mixer->process(inputs, outL, outR);
+            uint32_t dt = hrtfCycles() - t0;
+            if (dt < best) best = dt;
+        }
+        out.print("  ");
+        out.print(count);
+        out.print(" sources : ");
+        out.print((float)best / B, 2);
+        out.print(" cyc/ech (");
+        out.print((float)best / B / count, 2);
+        out.print(" par source), voix separees ~");
+        out.print((float)voiceBest * count / B, 2);
+        out.println(" cyc/ech");
+    }
+
+    free(in); free(outL); free(outR);
+    delete mixer;
+    delete voice;
+}
+
+void hrtfBenchmarkAmbisonics(const HrtfBank& bank, Print& out) {
+    if (bank.getHrirCount() == 0) {
+        out.println("BENCH:AMBI aucune HRIR chargee");
+        return;
+    }
+    const int B = bank.getBlockSize();
+    const int maxSources = HrtfAmbisonicMixer::MAX_SOURCES;
+    float* in   = (float*)malloc((size_t)maxSources * B * sizeof(float));
+    float* outL = (float*)malloc(B * sizeof(float));
+    float* outR = (float*)malloc(B * sizeof(float));
+    HrtfAmbisonicMixer* mixer = new HrtfAmbisonicMixer();
+    if (!in || !outL || !outR || !mixer) {
+        out.println("BENCH:AMBI memoire insuffisante");
+        free(in); free(outL); free(outR);
+        delete mixer;
+        return;
+    }
+    fillNoise(in, maxSources * B);
+    const float* inputs[HrtfAmbisonicMixer::MAX_SOURCES];
+    for (int s = 0; s < maxSources; s++) {
+        inputs[s] = in + (size_t)s * B;
+    }
+
+    out.print("BENCH:AMBI block=");
+    out.println(B);
+    for (int order = 1; order <= HRTF_AMBI_MAX_ORDER; order++) {
+        out.print("  ordre ");
+        out.print(order);
+        out.print(" (");
+        out.print(hrtfAmbisonicChannels(order));
+        out.print(" canaux) :");
+        for (int count = 1; count <= maxSources; count <<= 1) {
+            if (!mixer->init(bank, order, count)) {
+                out.print(" memoire insuffisante");
+                break;
+            }
+            for (int s = 0; s < count; s++) {
+                mixer->setSource(s, s * 360 / count, 0, 1.0f / count);
+            }
+            // La scène tourne à chaque bloc, comme en mode automatique
+            uint32_t best = 0xFFFFFFFF;
+            for (int r = 0; r < BENCH_REPEAT; r++) {
+                mixer->setRotation((float)r);
+                uint32_t t0 = hrtfCycles();
+                mixer->process(inputs, nullptr, 0, outL, outR);
+                uint32_t dt = hrtfCycles() - t0;
+                if (dt < best) best = dt;
+            }
+            out.print(" ");
+            out.print(count);
+            out.print("src=");
+            out.print((float)best / B, 1);
+        }
+        out.println(" cyc/ech");
+    }
+
+    free(in); free(outL); free(outR);
+    delete mixer;
+}
+
+// Une ligne de BENCH:INTERP : la direction change à chaque répétition pour que le mélange
+// soit refait (pas de réutilisation des poids du bloc précédent)
+static void interpolationCost(const HrtfBank& bank, HrtfVoice& voice, const char* label,
+                              Print& out) {
+    const int B = bank.getBlockSize();
+    const int repeat = 4 * BENCH_REPEAT;
+
+    // Recherche seule : directions quelconques, puis source lente (triangle précédent en hint).
+    // Son coût dépend du nombre de triangles parcourus : moyenne plutôt que minimum.
+    uint32_t coldTotal = 0;
+    uint32_t warmTotal = 0;
+    int hint = -1;
+    for (int r = 0; r < repeat; r++) {
+        const float az = fmodf(r * 137.5f, 360.0f);
+        const float el = -40.0f + fmodf(r * 61.8f, 120.0f);
+        uint32_t t0 = hrtfCycles();
+        HrirInterpolation cold = bank.getInterpolation(az, el);
+        coldTotal += hrtfCycles() - t0;
+
+        t0 = hrtfCycles();
+        HrirInterpolation warm = bank.getInterpolation(0.7f * r, 10.0f + 0.3f * r, hint);
+        warmTotal += hrtfCycles() - t0;
+        hint = warm.triangle;
+        (void)cold;
+    }
+
+    // Mélange complet (recherche comprise) dans chaque mode de convolution
+    uint32_t blendBest[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+    for (int c = 0; c < 2; c++) {
+        const HrtfConvolutionMode conv = (c == 0) ? HRTF_CONV_DIRECT : HRTF_CONV_FFT;
+        voice.setConvolutionMode(conv);
+        if (voice.getConvolutionMode() != conv) {
+            continue;
+        }
+        for (int r = 0; r < repeat; r++) {
+            // Directions entre deux mesures : jamais sur un sommet (pas de mélange à faire)
+            uint32_t t0 = hrtfCycles();
+            SelectedHrir sel = voice.interpolate(1.3f + 0.7f * r, 11.1f + 0.3f * r);
+            uint32_t dt = hrtfCycles() - t0;
+            if (dt < blendBest[c]) blendBest[c] = dt;
+            (void)sel;
+        }
+    }
+
+    out.print("  ");
+    out.print(label);
+    out.print(" ");
+    out.print(bank.getHrirCount());
+    out.print(" mesures, ");
+    out.print(bank.getTriangleCount());
+    out.print(" triangles : recherche=");
+    out.print(coldTotal / repeat);
+    out.print(" (suivi ");
+    out.print(warmTotal / repeat);
+    out.print(") cyc/bloc, interp direct=");
+    out.print((float)blendBest[0] / B, 2);
+    out.print(" fft=");
+    out.print((float)blendBest[1] / B, 2);
+    out.println(" cyc/ech");
+}
+
+void hrtfBenchmarkInterpolation(const HrtfBank& bank, Print& out) {
+    HrtfVoice* voice = new HrtfVoice();
+    if (!voice) {
+        out.println("BENCH:INTERP memoire insuffisante");
+        return;
+    }
+    voice->setInterpolation(true);
+    out.print("BENCH:INTERP block=");
+    out.println(bank.getBlockSize());
+    if (bank.getHrirCount() > 0 && voice->init(bank)) {
+        interpolationCost(bank, *voice, "banque chargee,", out);
+    }
+
+    // Banques synthétiques : directions en spirale de Fibonacci sur la sphère entière
+    float left[MAX_HRIR_LENGTH];
+    float right[MAX_HRIR_LENGTH];
+    fillNoise(left, MAX_HRIR_LENGTH);
+    fillNoise(right, MAX_HRIR_LENGTH);
+    for (int count = 16; count <= 128; count <<= 1) {
+        HrtfBank* synthetic = new HrtfBank();
+        if (!synthetic) {
+            out.println("  memoire insuffisante");
+            break;
+        }
+        synthetic->init(bank.getSampleRate(), bank.getBlockSize());
+        for (int i = 0; i < count; i++) {
+            const float z = 1.0f - (2.0f * i + 1.0f) / count;
+            const float el = asinf(z) * 180.0f / 3.14159265f;
+            const float az = fmodf(i * 137.50776f, 360.0f);
+            synthetic->addHrir((int)roundf(az), (int)roundf(el), left, right, 0, 0,
+                               MAX_HRIR_LENGTH);
+        }
+        if (voice->init(*synthetic)) {
+            interpolationCost(*synthetic, *voice, "sphere,", out);
+        } else {
+            out.println("  memoire insuffisante");
+        }
+        delete synthetic;
+    }
+    delete voice;
+}
+
+void hrtfBenchmarkCompact(const HrtfBank& bank, const char* filename, Print& out) {
+    // Banque temporaire aux réglages de la banque chargée (phase minimale comprise)
+    HrtfBank* compactBank = new HrtfBank();
+    HrtfVoice* voice = new HrtfVoice();
+    float* coeffs = (float*)malloc(2 * MAX_HRIR_LENGTH * sizeof(float));
+    if (!compactBank || !voice || !coeffs) {
+        out.println("BENCH:COMPACT memoire insuffisante");
+        delete compactBank;
+        delete voice;
+        free(coeffs);
+        return;
+    }
+    compactBank->init(bank.getSampleRate(), bank.getBlockSize());
+    compactBank->setMinimumPhase(bank.getMinimumPhaseLength());
+    compactBank->setCompactStorage(true);
+    if (!compactBank->loadFromBin(filename) || compactBank->getHrirCount() == 0 ||
+        !voice->init(*compactBank)) {
+        out.print("BENCH:COMPACT echec du chargement de ");
+        out.println(filename);
+        delete voice;
+        delete compactBank;
+        free(coeffs);
+        return;
+    }
+
+    const int count = compactBank->getHrirCount();
+    size_t taps = 0;
+    for (int i = 0; i < count; i++) {
+        taps += compactBank->getHrirAt(i).length;
+    }
+    // Une mesure résidente : le slot (coefficients float) et ses spectres
+    const size_t resident = sizeof(float) * (2 * MAX_HRIR_LENGTH + compactBank->getSpectrumSize());
+    out.print("BENCH:COMPACT ");
+    out.print(filename);
+    out.print(" : ");
+    out.print(count);
+    out.print(" mesures, ");
+    out.print((float)taps / count, 1);
+    out.print(" taps/mesure, ");
+    out.print((float)compactBank->getCompactBytes() / count, 1);
+    out.print(" octets/mesure (+");
+    out.print((float)compactBank->getIndexBytes() / count, 1);
+    out.print(" recherche) contre ");
+    out.print((unsigned long)resident);
+    out.print(" en float, erreur ");
+    out.print(compactBank->getCompactErrorDb(), 1);
+    out.println(" dB");
+
+    // Décodage seul, puis sélection complète par une voix : direction nouvelle à chaque appel
+    // (décodage, et FFT en mode FFT) ou inchangée (sélection mémorisée). Moyennes.
+    const int repeat = 4 * BENCH_REPEAT;
+    uint32_t decodeTotal = 0;
+    for (int r = 0; r < repeat; r++) {
+        SelectedHrir sel = compactBank->getHrirAt((r * 97) % count);
+        uint32_t t0 = hrtfCycles();
+        compactBank->decodeHrir(sel, coeffs, nullptr);
+        decodeTotal += hrtfCycles() - t0;
+    }
+    out.print("  decodage=");
+    out.print(decodeTotal / repeat);
+    out.print(" cyc");
+    for (int c = 0; c < 2; c++) {
+        const HrtfConvolutionMode conv = (c == 0) ? HRTF_CONV_DIRECT : HRTF_CONV_FFT;
+        voice->setConvolutionMode(conv);
+        if (voice->getConvolutionMode() != conv) {
+            continue;
+        }
+        uint32_t missTotal = 0;
+        uint32_t hitTotal = 0;
+        for (int r = 0; r < repeat; r++) {
+            const int az = (r * 37) % 360;
+            const int el = -40 + (r * 23) % 120;
+            uint32_t t0 = hrtfCycles();
+            voice->select(az, el);
+            missTotal += hrtfCycles() - t0;
+            t0 = hrtfCycles();
+            voice->select(az, el);
+            hitTotal += hrtfCycles() - t0;
+        }
+        out.print(c == 0 ? ", select direct=" : ", select fft=");
+        out.print(missTotal / repeat);
+        out.print(" (inchangee ");
+        out.print(hitTotal / repeat);
+        out.print(")");
+    }
+    out.println(" cyc/bloc");
+
+    delete voice;
+    delete compactBank;
+    free(coeffs);
+}
+
+void hrtfBenchmarkPca(const HrtfBank& bank, const char* pcaFile, const char* referenceFile,
+                      Print& out) {
+    HrtfBank* pcaBank = new HrtfBank();
+    HrtfBank* reference = new HrtfBank();
+    float* coeffs = (float*)malloc(2 * MAX_HRIR_LENGTH * sizeof(float));
+    float* refCoeffs = (float*)malloc(2 * MAX_HRIR_LENGTH * sizeof(float));
+    if (!pcaBank || !reference || !coeffs || !refCoeffs) {
+        out.println("BENCH:PCA memoire insuffisante");
+        delete pcaBank;
+        delete reference;
+        free(coeffs);
+        free(refCoeffs);
+        return;
+    }
+    pcaBank->init(bank.getSampleRate(), bank.getBlockSize());
+    reference->init(bank.getSampleRate(), bank.getBlockSize());
+    bool ok = pcaBank->loadFromBin(pcaFile) && pcaBank->getPcaStoredComponents() > 0;
+    if (ok) {
+        // Référence dans la représentation de la base (phase minimale du fichier PCA)
+        reference->setMinimumPhase(pcaBank->getMinimumPhaseLength());
+        reference->setCompactStorage(true);
+        ok = reference->loadFromBin(referenceFile) &&
+             reference->getHrirCount() == pcaBank->getHrirCount();
+    }
+    if (!ok) {
+        out.print("BENCH:PCA echec du chargement de ");
+        out.print(pcaFile);
+        out.print(" ou ");
+        out.println(referenceFile);
+        delete pcaBank;
+        delete reference;
+        free(coeffs);
+        free(refCoeffs);
+        return;
+    }
+
+    const int count = pcaBank->getHrirCount();
+    const int stored = pcaBank->getPcaStoredComponents();
+    out.print("BENCH:PCA ");
+    out.print(pcaFile);
+    out.print(" : ");
+    out.print(count);
+    out.print(" mesures, K=");
+    out.print(stored);
+    out.print(", ");
+    out.print((unsigned long)pcaBank->getPcaLength());
+    out.print(" taps, ");
+    out.print((float)pcaBank->getCompactBytes() / count, 1);
+    out.print(" octets/mesure (base comprise), phase minimale ");
+    out.println((unsigned long)pcaBank->getMinimumPhaseLength());
+
+    // Erreur de reconstruction sur toutes les mesures et coût moyen de la reconstruction
+    for (int k = 1; k <= stored; k = (k < 4) ? 2 * k : k + 4) {
+        pcaBank->setPcaComponents(k);
+        double signal = 0.0;
+        double error = 0.0;
+        uint32_t total = 0;
+        for (int i = 0; i < count; i++) {
+            const SelectedHrir sel = pcaBank->getHrirAt(i);
+            uint32_t t0 = hrtfCycles();
+            pcaBank->decodeHrir(sel, coeffs, nullptr);
+            total += hrtfCycles() - t0;
+            reference->decodeHrir(reference->getHrirAt(i), refCoeffs, nullptr);
+            for (int t = 0; t < 2 * MAX_HRIR_LENGTH; t++) {
+                const float d = coeffs[t] - refCoeffs[t];
+                signal += refCoeffs[t] * refCoeffs[t];
+                error += d * d;
+            }
+        }
+        out.print("  K=");
+        out.print(k);
+        out.print(" : erreur ");
+        out.print(signal > 0.0 ? 10.0f * log10f((float)(error / signal)) : 0.0f, 1);
+        out.print(" dB, reconstruction ");
+        out.print(total / count);
+        out.println(" cyc");
+    }
+    pcaBank->setPcaComponents(stored);
+    delete reference;
+    free(coeffs);
+    free(refCoeffs);
+
+    // Rendu : K + 1 convolutions partagées contre une voix par source (filtres reconstruits à
+    // la sélection), sources fixes réparties en azimut
+    const int B = pcaBank->getBlockSize();
+    const int maxSources = HrtfPcaMixer::MAX_SOURCES;
+    float* in   = (float*)malloc((size_t)maxSources * B * sizeof(float));
+    float* outL = (float*)malloc(B * sizeof(float));
+    float* outR = (float*)malloc(B * sizeof(float));
+    HrtfPcaMixer* pcaMixer = new HrtfPcaMixer();
+    HrtfMixer* mixer = new HrtfMixer();
+    if (!in || !outL || !outR || !pcaMixer || !mixer) {
+        out.println("  memoire insuffisante");
+        free(in); free(outL); free(outR);
+        delete pcaMixer;
+        delete mixer;
+        delete pcaBank;
+        return;
+    }
+    fillNoise(in, maxSources * B);
+    const float* inputs[HrtfPcaMixer::MAX_SOURCES];
+    for (int s = 0; s < maxSources; s++) {
+        inputs[s] = in + (size_t)s * B;
+    }
+    for (int sources = 1; sources <= maxSources; sources <<= 1) {
+        if (!pcaMixer->init(*pcaBank, sources)) {
+            out.println("  memoire insuffisante");
+            break;
+        }
+        for (int s = 0; s < sources; s++) {
+            pcaMixer->setSource(s, s * 360 / sources, 0, 1.0f / sources);
+        }
+        uint32_t best = 0xFFFFFFFF;
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            uint32_t t0 = hrtfCycles();
+            pcaMixer->process(inputs, outL, outR);
+            uint32_t dt = hrtfCycles() - t0;
+            if (dt < best) best = dt;
+        }
+        // Déplacement d'une source : interpolation et mélange des poids
+        uint32_t t0 = hrtfCycles();
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            pcaMixer->setSource(0, r * 7, 10, 1.0f / sources);
+        }
+        const uint32_t move = (hrtfCycles() - t0) / BENCH_REPEAT;
+
+        out.print("  ");
+        out.print(sources);
+        out.print(" sources : PCA ");
+        out.print((float)best / B, 2);
+        out.print(" cyc/ech (");
+        out.print(pcaMixer->getFilterCount());
+        out.print(" filtres, setSource ");
+        out.print(move);
+        out.print(" cyc)");
+        if (sources <= HrtfMixer::MAX_SOURCES && mixer->init(*pcaBank, sources)) {
+            for (int s = 0; s < sources; s++) {
+                mixer->setSource(s, s * 360 / sources, 0, 1.0f / sources);
+            }
+            best = 0xFFFFFFFF;
+            for (int r = 0; r < BENCH_REPEAT; r++) {
+                t0 = hrtfCycles();
+                mixer->process(inputs, outL, outR);
+                uint32_t dt = hrtfCycles() - t0;
+                if (dt < best) best = dt;
+            }
+            out.print(", voix ");
+            out.print((float)best / B, 2);
+            out.print(" cyc/ech");
+        }
+        out.println();
+    }
+
+    free(in); free(outL); free(outR);
+    delete pcaMixer;
+    delete mixer;
+    delete pcaBank;
+}
+
+void hrtfBenchmarkSymmetric(const HrtfBank& bank, const char* filename, Print& out) {
+    HrtfBank* banks[2] = { new HrtfBank(), new HrtfBank() };
+    float* coeffs = (float*)malloc(4 * MAX_HRIR_LENGTH * sizeof(float));
+    if (!banks[0] || !banks[1] || !coeffs) {
+        out.println("BENCH:SYM memoire insuffisante");
+        delete banks[0];
+        delete banks[1];
+        free(coeffs);
+        return;
+    }
+    uint32_t loadTime[2] = { 0, 0 };
+    for (int b = 0; b < 2; b++) {
+        banks[b]->init(bank.getSampleRate(), bank.getBlockSize());
+        banks[b]->setMinimumPhase(bank.getMinimumPhaseLength());
+        banks[b]->setCompactStorage(true);
+        banks[b]->setSymmetricStorage(b == 1);
+        const uint32_t t0 = micros();
+        if (!banks[b]->loadFromBin(filename) || banks[b]->getHrirCount() == 0) {
+            out.print("BENCH:SYM echec du chargement de ");
+            out.println(filename);
+            delete banks[0];
+            delete banks[1];
+            free(coeffs);
+            return;
+        }
+        loadTime[b] = micros() - t0;
+    }
+
+    out.print("BENCH:SYM ");
+    out.print(filename);
+    out.print(" : ");
+    out.print(banks[0]->getHrirCount());
+    out.print(" mesures, deux oreilles ");
+    out.print(loadTime[0] / 1000.0f, 1);
+    out.print(" ms ");
+    out.print((unsigned long)banks[0]->getCompactBytes());
+    out.print(" octets, symetrique ");
+    out.print(loadTime[1] / 1000.0f, 1);
+    out.print(" ms ");
+    out.print((unsigned long)banks[1]->getCompactBytes());
+    out.print(" octets, ecart des miroirs ");
+    out.print(banks[1]->getSymmetryErrorDeg(), 1);
+    out.println(" deg");
+
+    // Énergie de l'écart par oreille (la gauche ne diffère que par la normalisation des paires)
+    // et de l'ITD, sur toutes les mesures
+    float* full = coeffs;
+    float* mirrored = coeffs + 2 * MAX_HRIR_LENGTH;
+    float energy[2] = { 0.0f, 0.0f };
+    float error[2] = { 0.0f, 0.0f };
+    float itdError = 0.0f;
+    for (int i = 0; i < banks[0]->getHrirCount(); i++) {
+        const SelectedHrir a = banks[0]->decodeHrir(banks[0]->getHrirAt(i), full, nullptr);
+        const SelectedHrir b = banks[1]->decodeHrir(banks[1]->getHrirAt(i), mirrored, nullptr);
+        for (size_t k = 0; k < 2 * MAX_HRIR_LENGTH; k++) {
+            const float d = full[k] - mirrored[k];
+            energy[k & 1] += full[k] * full[k];
+            error[k & 1] += d * d;
+        }
+        const float itd = fabsf((a.itdLeft - a.itdRight) - (b.itdLeft - b.itdRight));
+        itdError = (itd > itdError) ? itd : itdError;
+    }
+    out.print("  erreur gauche ");
+    out.print(energy[0] > 0.0f && error[0] > 0.0f ? 10.0f * log10f(error[0] / energy[0]) : -200.0f, 1);
+    out.print(" dB, droite (miroir) ");
+    out.print(energy[1] > 0.0f && error[1] > 0.0f ? 10.0f * log10f(error[1] / energy[1]) : -200.0f, 1);
+    out.print(" dB, ecart ITD max ");
+    out.print(itdError, 2);
+    out.println(" ech");
+
+    delete banks[0];
+    delete banks[1];
+    free(coeffs);
+}
+
+void hrtfBenchmarkLoad(const HrtfBank& bank, const char* v1File, const char* v2File, Print& out) {
+    HrtfBank* banks[2] = { new HrtfBank(), new HrtfBank() };
+    const char* files[2] = { v1File, v2File };
+    if (!banks[0] || !banks[1]) {
+        out.println("BENCH:LOAD memoire insuffisante");
+        delete banks[0];
+        delete banks[1];
+        return;
+    }
+    uint32_t best[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+    for (int r = 0; r < 3; r++) {
+        for (int f = 0; f < 2; f++) {
+            banks[f]->init(bank.getSampleRate(), bank.getBlockSize());
+            banks[f]->setMinimumPhase(bank.getMinimumPhaseLength());
+            const uint32_t t0 = micros();
+            if (!banks[f]->loadFromBin(files[f])) {
+                best[f] = 0;
+                continue;
+            }
+            const uint32_t dt = micros() - t0;
+            if (dt < best[f]) best[f] = dt;
+        }
+    }
+    out.print("BENCH:LOAD ");
+    for (int f = 0; f < 2; f++) {
+        out.print(files[f]);
+        out.print(best[f] ? " : " : " : echec");
+        if (best[f]) {
+            out.print(banks[f]->getHrirCount());
+            out.print(" mesures en ");
+            out.print(best[f] / 1000.0f, 2);
+            out.print(" ms");
+        }
+        out.print(f == 0 ? ", " : "\n");
+    }
+
+    // Même contenu attendu : plus grand écart sur les coefficients et sur les spectres
+    const int count = (banks[0]->getHrirCount() < banks[1]->getHrirCount())
+                    ? banks[0]->getHrirCount() : banks[1]->getHrirCount();
+    float coeffDiff = 0.0f;
+    float spectrumDiff = 0.0f;
+    float spectrumPeak = 0.0f;
+    const size_t specSize = banks[0]->getSpectrumSize();
+    for (int i = 0; i < count; i++) {
+        const SelectedHrir a = banks[0]->getHrirAt(i);
+        const SelectedHrir b = banks[1]->getHrirAt(i);
+        if (!a.coeffs || !b.coeffs) {
+            continue;
+        }
+        for (size_t k = 0; k < 2 * MAX_HRIR_LENGTH; k++) {
+            coeffDiff = fmaxf(coeffDiff, fabsf(a.coeffs[k] - b.coeffs[k]));
+        }
+        for (size_t k = 0; a.spectrum && b.spectrum && k < specSize; k++) {
+            spectrumDiff = fmaxf(spectrumDiff, fabsf(a.spectrum[k] - b.spectrum[k]));
+            spectrumPeak = fmaxf(spectrumPeak, fabsf(a.spectrum[k]));
+        }
+    }
+    out.print("  ecart max coefficients ");
+    out.print(coeffDiff, 7);
+    out.print(", spectres ");
+    out.print(spectrumPeak > 0.0f ? spectrumDiff / spectrumPeak : 0.0f, 7);
+    out.println(" (relatif au pic)");
+
+    delete banks[0];
+    delete banks[1];
+}
+
+// Disposition de la banque résidente avant son rangement par champ : une structure par mesure,
+// description et coefficients ensemble (un peu plus d'1 Ko par mesure)
+struct BenchSlotAos {
+    int azimuth;
+    int elevation;
+    float direction[3];
+    float distance;
+    HrirData data;
+    const float* coeffs;
+    const float* spectrum;
+    size_t fullLength;
+    float* tailSpectrum;
+};
+
+// Lecture de tout le tampon : ce qui était en cache en est chassé
+static float evictCache(const float* buffer, size_t count) {
+    float acc = 0.0f;
+    for (size_t i = 0; i < count; i += 8) {
+        acc += buffer[i];
+    }
+    return acc;
+}
+
+void hrtfBenchmarkLayout(const HrtfBank& bank, Print& out) {
+    static const int MAX_MEASUREMENTS = 128;
+    static const int QUERIES = 16;
+    static const int SELECTIONS = 64;
+    static const int SOURCES = 8;
+    // Deux fois le cache de données du Cortex-M7 : relu avant chaque mesure, comme les
+    // convolutions des autres sources entre deux sélections
+    static const size_t EVICT_FLOATS = 16384;
+    const int count = (bank.getHrirCount() > MAX_MEASUREMENTS) ? MAX_MEASUREMENTS
+                                                               : bank.getHrirCount();
+    if (count == 0) {
+        out.println("BENCH:LAYOUT banque vide");
+        return;
+    }
+    const size_t stride = 2 * MAX_HRIR_LENGTH;
+    BenchSlotAos* aos = (BenchSlotAos*)malloc((size_t)count * sizeof(BenchSlotAos));
+    // Par champ : directions, description lue à la sélection, pool aligné sur 32 octets
+    float* direction = (float*)malloc((size_t)count * 3 * sizeof(float));
+    int16_t* azimuth = (int16_t*)malloc((size_t)count * sizeof(int16_t));
+    uint16_t* length = (uint16_t*)malloc((size_t)count * sizeof(uint16_t));
+    float* itd = (float*)malloc((size_t)count * 2 * sizeof(float));
+    float* distance = (float*)malloc((size_t)count * sizeof(float));
+    void* block = malloc((size_t)count * stride * sizeof(float) + 31);
+    float* x = (float*)malloc((MAX_HRIR_LENGTH - 1 + BENCH_BLOCK) * sizeof(float));
+    float* outL = (float*)malloc(BENCH_BLOCK * sizeof(float));
+    float* outR = (float*)malloc(BENCH_BLOCK * sizeof(float));
+    float* evict = (float*)malloc(EVICT_FLOATS * sizeof(float));
+    if (!aos || !direction || !azimuth || !length || !itd || !distance || !block || !x ||
+        !outL || !outR || !evict) {
+        out.println("BENCH:LAYOUT memoire insuffisante");
+        free(aos); free(direction); free(azimuth); free(length); free(itd); free(distance);
+        free(block); free(x); free(outL); free(outR); free(evict);
+        return;
+    }
+    float* pool = (float*)(((uintptr_t)block + 31) & ~(uintptr_t)31);
+
+    // Les mêmes mesures (décodées si la banque est compacte) dans les deux dispositions
+    for (int i = 0; i < count; i++) {
+        const SelectedHrir sel = bank.decodeHrir(bank.getHrirAt(i), pool + i * stride, nullptr);
+        const float az = sel.azimuth * 3.14159265f / 180.0f;
+        const float el = sel.elevation * 3.14159265f / 180.0f;
+        BenchSlotAos& s = aos[i];
+        s.azimuth = sel.azimuth;
+        s.elevation = sel.elevation;
+        s.direction[0] = direction[3 * i]     = cosf(el) * cosf(az);
+        s.direction[1] = direction[3 * i + 1] = cosf(el) * sinf(az);
+        s.direction[2] = direction[3 * i + 2] = sinf(el);
+        s.distance = distance[i] = sel.distance;
+        s.data.delayLeft = 0;
+        s.data.delayRight = 0;
+        s.data.length = length[i] = (uint16_t)sel.length;
+        s.data.itdLeft = itd[2 * i] = sel.itdLeft;
+        s.data.itdRight = itd[2 * i + 1] = sel.itdRight;
+        memcpy(s.data.coeffs, pool + i * stride, stride * sizeof(float));
+        s.coeffs = s.data.coeffs;
+        s.spectrum = nullptr;
+        s.fullLength = sel.length;
+        s.tailSpectrum = nullptr;
+        azimuth[i] = (int16_t)sel.azimuth;
+    }
+    fillNoise(x, MAX_HRIR_LENGTH - 1 + BENCH_BLOCK);
+    fillNoise(evict, EVICT_FLOATS);
+
+    // Recherche exhaustive de la mesure la plus proche de QUERIES directions (produits
+    // scalaires sur toutes les mesures), puis lecture de la description de SELECTIONS mesures
+    // dispersées, comme à la sélection ; enfin convolution directe d'un bloc pour SOURCES
+    // sources sur des mesures différentes. Cache vidé avant chaque mesure, meilleur de
+    // BENCH_REPEAT essais.
+    uint32_t scanBest[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+    uint32_t selectBest[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+    uint32_t convBest[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+    volatile float sink = 0.0f;
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        for (int layout = 0; layout < 2; layout++) {
+            sink = sink + evictCache(evict, EVICT_FLOATS);
+            uint32_t t0 = hrtfCycles();
+            int found = 0;
+            for (int q = 0; q < QUERIES; q++) {
+                const float a = q * 0.39f;
+                const float v[3] = { cosf(a) * 0.8f, sinf(a) * 0.8f, 0.6f };
+                float best = -2.0f;
+                for (int i = 0; i < count; i++) {
+                    const float* d = layout ? direction + 3 * i : aos[i].direction;
+                    const float dot = d[0] * v[0] + d[1] * v[1] + d[2] * v[2];
+                    if (dot > best) {
+                        best = dot;
+                        found = i;
+                    }
+                }
+            }
+            uint32_t dt = hrtfCycles() - t0;
+            scanBest[layout] = (dt < scanBest[layout]) ? dt : scanBest[layout];
+
+            sink = sink + evictCache(evict, EVICT_FLOATS);
+            t0 = hrtfCycles();
+            float acc = 0.0f;
+            for (int k = 0; k < SELECTIONS; k++) {
+                const int i = (found + k * 37) % count;
+                if (layout) {
+                    acc += azimuth[i] + length[i] + itd[2 * i] + itd[2 * i + 1] + distance[i];
+                } else {
+                    acc += aos[i].azimuth + aos[i].data.length + aos[i].data.itdLeft +
+                           aos[i].data.itdRight + aos[i].distance;
+                }
+            }
+            dt = hrtfCycles() - t0;
+            selectBest[layout] = (dt < selectBest[layout]) ? dt : selectBest[layout];
+            sink = sink + acc;
+
+            sink = sink + evictCache(evict, EVICT_FLOATS);
+            t0 = hrtfCycles();
+            for (int s = 0; s < SOURCES; s++) {
+                const int i = (r * SOURCES + s * 11) % count;
+                const float* c = layout ? pool + i * stride : aos[i].coeffs;
+                hrtfKernels().firStereo(x + MAX_HRIR_LENGTH - 1, c, MAX_HRIR_LENGTH, outL, outR,
+                                        BENCH_BLOCK, 1.0f);
+            }
+            dt = hrtfCycles() - t0;
+            convBest[layout] = (dt < convBest[layout]) ? dt : convBest[layout];
+        }
+    }
+
+    out.print("BENCH:LAYOUT ");
+    out.print(count);
+    out.print(" mesures, ");
+    out.print((unsigned long)sizeof(BenchSlotAos));
+    out.print(" octets/mesure par structure, ");
+    out.print((unsigned long)(sizeof(int16_t) + sizeof(uint16_t) + 6 * sizeof(float)));
+    out.print(" + ");
+    out.print((unsigned long)(stride * sizeof(float)));
+    out.println(" (pool) par champ");
+    const char* names[3] = { "  recherche ", ", selection ", ", convolution " };
+    const uint32_t* results[3] = { scanBest, selectBest, convBest };
+    for (int k = 0; k < 3; k++) {
+        out.print(names[k]);
+        out.print(results[k][0]);
+        out.print(" -> ");
+        out.print(results[k][1]);
+    }
+    out.println(" cyc (structures -> par champ)");
+
+    free(aos); free(direction); free(azimuth); free(length); free(itd); free(distance);
+    free(block); free(x); free(outL); free(outR); free(evict);
+}
+
+// Fichiers de test de hrtfBenchmarkStems : w<s>.wav (piste s seule) et s<n>.stm (pistes 0 à n-1)
+static const uint32_t STEM_BENCH_FRAMES = 44100;   // 1 s par piste
+static const uint32_t STEM_BENCH_BLOCK = 1024;     // trames par bloc, comme assets/makeStems.py
+static const uint32_t STEM_BENCH_DATA = 512;       // début des données du fichier de pistes
+static const uint32_t STEM_BENCH_WAV_READ = 4096;  // limite des lectures de MyStreamPlayer
+
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    putU16(p, (uint16_t)v);
+    putU16(p + 2, (uint16_t)(v >> 16));
+}
+
+// Bruit propre à chaque piste, identique dans son WAV et dans les fichiers de pistes
+static void fillStemNoise(int16_t* data, uint32_t n, uint32_t& seed) {
+    for (uint32_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (int16_t)(seed >> 18);
+    }
+}
+
+static bool benchFileReady(const char* path, uint32_t size) {
+    AudioNoInterrupts();
+    File f = SD.open(path, FILE_READ);
+    const bool ready = f && f.size() == size;
+    if (f) {
+        f.close();
+    }
+    AudioInterrupts();
+    return ready;
+}
+
+static bool writeBenchChunk(File& f, const void* data, uint32_t bytes) {
+    AudioNoInterrupts();
+    const bool ok = f.write((const uint8_t*)data, bytes) == bytes;
+    AudioInterrupts();
+    return ok;
+}
+
+static bool writeBenchWav(const char* path, int stem, int16_t* buffer) {
+    const uint32_t dataBytes = STEM_BENCH_FRAMES * 2;
+    if (benchFileReady(path, 44 + dataBytes)) {
+        return true;
+    }
+    uint8_t header[44];
+    memcpy(header, "RIFF", 4);
+    putU32(header + 4, 36 + dataBytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    putU32(header + 16, 16);
+    putU16(header + 20, 1);
+    putU16(header + 22, 1);
+    putU32(header + 24, 44100);
+    putU32(header + 28, 44100 * 2);
+    putU16(header + 32, 2);
+    putU16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    putU32(header + 40, dataBytes);
+
+    AudioNoInterrupts();
+    SD.remove(path);
+    File f = SD.open(path, FILE_WRITE);
+    AudioInterrupts();
+    bool ok = f && writeBenchChunk(f, header, sizeof(header));
+    uint32_t seed = 1000 + stem;
+    for (uint32_t done = 0; ok && done < STEM_BENCH_FRAMES; done += STEM_BENCH_BLOCK) {
+        const uint32_t n = (STEM_BENCH_FRAMES - done < STEM_BENCH_BLOCK)
+                         ? STEM_BENCH_FRAMES - done : STEM_BENCH_BLOCK;
+        fillStemNoise(buffer, n, seed);
+        ok = writeBenchChunk(f, buffer, n * 2);
+    }
+    AudioNoInterrupts();
+    if (f) {
+        f.close();
+    }
+    AudioInterrupts();
+    return ok;
+}
+
+// Format de SdStemReader : pistes réparties en cercle, gain unité
+static bool writeBenchStems(const char* path, int stems, int16_t* buffer) {
+    const uint32_t blocks = (STEM_BENCH_FRAMES + STEM_BENCH_BLOCK - 1) / STEM_BENCH_BLOCK;
+    if (benchFileReady(path, STEM_BENCH_DATA + blocks * stems * STEM_BENCH_BLOCK * 2)) {
+        return true;
+    }
+    uint8_t header[STEM_BENCH_DATA];
+    memset(header, 0, sizeof(header));
+    memcpy(header, "STEM", 4);
+    putU16(header + 4, 1);
+    putU16(header + 6, (uint16_t)stems);
+    putU32(header + 8, 44100);
+    putU32(header + 12, STEM_BENCH_FRAMES);
+    putU32(header + 16, STEM_BENCH_BLOCK);
+    putU32(header + 20, STEM_BENCH_DATA);
+    for (int s = 0; s < stems; s++) {
+        uint8_t* entry = header + SdStemReader::HEADER_BYTES + s * SdStemReader::STEM_ENTRY_BYTES;
+        const float gain = 1.0f;
+        uint32_t gainBits;
+        memcpy(&gainBits, &gain, sizeof(float));
+        putU16(entry, (uint16_t)(int16_t)(s * 360 / stems));
+        putU32(entry + 4, gainBits);
+        snprintf((char*)entry + 8, SdStemReader::NAME_BYTES, "stem%d", s);
+    }
+
+    AudioNoInterrupts();
+    SD.remove(path);
+    File f = SD.open(path, FILE_WRITE);
+    AudioInterrupts();
+    bool ok = f && writeBenchChunk(f, header, sizeof(header));
+    uint32_t seeds[SdStemReader::MAX_STEMS];
+    for (int s = 0; s < stems; s++) {
+        seeds[s] = 1000 + s;
+    }
+    for (uint32_t b = 0; ok && b < blocks; b++) {
+        const uint32_t n = (STEM_BENCH_FRAMES - b * STEM_BENCH_BLOCK < STEM_BENCH_BLOCK)
+                         ? STEM_BENCH_FRAMES - b * STEM_BENCH_BLOCK : STEM_BENCH_BLOCK;
+        for (int s = 0; ok && s < stems; s++) {
+            fillStemNoise(buffer, n, seeds[s]);
+            memset(buffer + n, 0, (STEM_BENCH_BLOCK - n) * 2);
+            ok = writeBenchChunk(f, buffer, STEM_BENCH_BLOCK * 2);
+        }
+    }
+    AudioNoInterrupts();
+    if (f) {
+        f.close();
+    }
+    AudioInterrupts();
+    return ok;
+}
+
+// Durée des seules lectures (audio suspendu pendant chacune, comme dans les lecteurs), en µs ;
+// 0 en cas d'échec
+static uint32_t readBenchStems(const char* path, int16_t* buffer) {
+    SdStemReader reader;
+    AudioNoInterrupts();
+    bool ok = reader.open(path);
+    AudioInterrupts();
+    uint32_t elapsed = 0;
+    while (ok && !reader.atEnd()) {
+        AudioNoInterrupts();
+        const uint32_t t0 = micros();
+        ok = reader.readSlice(buffer);
+        elapsed += micros() - t0;
+        AudioInterrupts();
+    }
+    AudioNoInterrupts();
+    reader.close();
+    AudioInterrupts();
+    return ok ? elapsed : 0;
+}
+
+static uint32_t readBenchWavs(int count, int16_t* buffer) {
+    SdWavReader* readers = new SdWavReader[count];
+    if (!readers) {
+        return 0;
+    }
+    bool ok = true;
+    AudioNoInterrupts();
+    for (int s = 0; s < count; s++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/stembench/w%d.wav", s);
+        ok = ok && readers[s].open(path);
+    }
+    AudioInterrupts();
+    // Un lecteur par fichier, servis à tour de rôle : chaque lecture reprend ailleurs sur la carte
+    uint32_t elapsed = 0;
+    bool pending = ok;
+    while (pending) {
+        pending = false;
+        for (int s = 0; s < count; s++) {
+            SdWavReader& r = readers[s];
+            if (r.positionFrames() >= r.lengthFrames()) {
+                continue;
+            }
+            const uint32_t frames = (STEM_BENCH_WAV_READ - r.bytePosition() % STEM_BENCH_WAV_READ + 1) / 2;
+            AudioNoInterrupts();
+            const uint32_t t0 = micros();
+            const int got = r.readFrames(buffer, (int)frames);
+            elapsed += micros() - t0;
+            AudioInterrupts();
+            if (got <= 0) {
+                ok = false;
+                break;
+            }
+            pending = true;
+        }
+    }
+    AudioNoInterrupts();
+    delete[] readers;
+    AudioInterrupts();
+    return ok ? elapsed : 0;
+}
+
+void hrtfBenchmarkStems(Print& out) {
+    const uint32_t bufferSamples = STEM_BENCH_WAV_READ / 2 + STEM_BENCH_BLOCK;
+    int16_t* buffer = (int16_t*)malloc(bufferSamples * sizeof(int16_t));
+    if (!buffer) {
+        out.println("BENCH:STEMS memoire insuffisante");
+        return;
+    }
+
+    AudioNoInterrupts();
+    if (!SD.exists("/stembench")) {
+        SD.mkdir("/stembench");
+    }
+    AudioInterrupts();
+    bool ok = true;
+    for (int n = 1; ok && n <= SdStemReader::MAX_STEMS; n++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/stembench/w%d.wav", n - 1);
+        ok = writeBenchWav(path, n - 1, buffer);
+        snprintf(path, sizeof(path), "/stembench/s%d.stm", n);
+        ok = ok && writeBenchStems(path, n, buffer);
+    }
+    if (!ok) {
+        out.println("BENCH:STEMS echec de l'ecriture des fichiers de test dans /stembench");
+        free(buffer);
+        return;
+    }
+
+    out.print("BENCH:STEMS ");
+    out.print(STEM_BENCH_FRAMES);
+    out.print(" trames par piste, blocs de ");
+    out.print(STEM_BENCH_BLOCK);
+    out.println(" trames ; temps de lecture sur la carte (meilleur de 3)");
+    for (int n = 1; n <= SdStemReader::MAX_STEMS; n++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/stembench/s%d.stm", n);
+        uint32_t best[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+        for (int r = 0; r < 3; r++) {
+            const uint32_t t[2] = { readBenchStems(path, buffer), readBenchWavs(n, buffer) };
+            for (int k = 0; k < 2; k++) {
+                best[k] = (t[k] && t[k] < best[k]) ? t[k] : best[k];
+            }
+        }
+        // Octets utiles (pistes) par seconde, et secondes d'audio lues par seconde
+        const float bytes = (float)n * STEM_BENCH_FRAMES * 2;
+        out.print("  ");
+        out.print(n);
+        out.print(n > 1 ? " pistes :" : " piste :");
+        for (int k = 0; k < 2; k++) {
+            out.print(k == 0 ? " conteneur " : ", WAV separes ");
+            if (best[k] == 0xFFFFFFFF) {
+                out.print("echec");
+                continue;
+            }
+            out.print(bytes / 1024.0f * 1e6f / best[k], 0);
+            out.print(" Ko/s (");
+            out.print(STEM_BENCH_FRAMES * 1e6f / (44100.0f * best[k]), 1);
+            out.print("x temps reel)");
+        }
+        if (best[0] != 0xFFFFFFFF && best[1] != 0xFFFFFFFF) {
+            out.print(", gain ");
+            out.print((float)best[1] / best[0], 2);
+            out.print("x");
+        }
+        out.println();
+    }
+    free(buffer);
+}
+
+// Signal de test de hrtfBenchmarkAdpcm : deux sinus et un bruit, différents par canal
+static int16_t adpcmTestSample(uint32_t n, int c) {
+    const float t = (float)n / 44100.0f;
+    const uint32_t h = (n * 2 + c) * 2654435761u;
+    const float noise = (float)(int32_t)h * (1.0f / 2147483648.0f);
+    const float v = 0.3f * sinf(2.0f * (float)M_PI * 220.0f * t + c) +
+                    0.2f * sinf(2.0f * (float)M_PI * 3150.0f * t) + 0.05f * noise;
+    return (int16_t)(v * 32767.0f);
+}
+
+void hrtfBenchmarkAdpcm(Print& out) {
+    static const uint32_t RATE = 44100;
+    static const uint32_t FRAMES = RATE;   // 1 s
+    static const int REPEAT = 3;
+    for (int channels = 1; channels <= ImaAdpcmDecoder::MAX_CHANNELS; channels++) {
+        // Taille de bloc habituelle des WAV IMA-ADPCM à 44,1 kHz (celle de encodeAdpcm.py)
+        const uint32_t blockAlign = 1024 * channels;
+        const uint32_t spb = ImaAdpcmDecoder::samplesPerBlock(channels, blockAlign);
+        const uint32_t blocks = (FRAMES + spb - 1) / spb;
+        const uint32_t outBlocks = (FRAMES + BENCH_BLOCK - 1) / BENCH_BLOCK;
+        uint8_t* encoded = (uint8_t*)malloc(blocks * blockAlign);
+        int16_t* pcm = (int16_t*)malloc(spb * channels * sizeof(int16_t));
+        int16_t* decoded = (int16_t*)malloc(2 * BENCH_BLOCK * sizeof(int16_t));
+        uint32_t* cost = (uint32_t*)malloc(outBlocks * sizeof(uint32_t));
+        if (!encoded || !pcm || !decoded || !cost) {
+            out.println("BENCH:ADPCM memoire insuffisante");
+            free(encoded); free(pcm); free(decoded); free(cost);
+            return;
+        }
+
+        int32_t stepIndex[ImaAdpcmDecoder::MAX_CHANNELS] = { 0, 0 };
+        for (uint32_t b = 0; b < blocks; b++) {
+            const uint32_t start = b * spb;
+            const uint32_t n = (FRAMES - start < spb) ? FRAMES - start : spb;
+            for (uint32_t i = 0; i < n; i++) {
+                for (int c = 0; c < channels; c++) {
+                    pcm[i * channels + c] = adpcmTestSample(start + i, c);
+                }
+            }
+            imaAdpcmEncodeBlock(pcm, n, channels, blockAlign, stepIndex, encoded + b * blockAlign);
+        }
+
+        // Décodage comme MyAdpcmPlayer::update : 128 trames, en changeant de bloc au besoin ;
+        // coût de chaque bloc audio, le plus petit sur quelques passages
+        for (uint32_t k = 0; k < outBlocks; k++) {
+            cost[k] = 0xFFFFFFFF;
+        }
+        double signal = 0.0;
+        double noise = 0.0;
+        ImaAdpcmDecoder decoder;
+        for (int r = 0; r < REPEAT; r++) {
+            decoder.begin(channels);
+            uint32_t next = 0;
+            for (uint32_t k = 0; k < outBlocks; k++) {
+                int16_t* dest[2] = { decoded, decoded + BENCH_BLOCK };
+                uint32_t done = 0;
+                const uint32_t t0 = hrtfCycles();
+                while (done < (uint32_t)BENCH_BLOCK) {
+                    if (decoder.remaining() == 0) {
+                        if (next == blocks) {
+                            break;
+                        }
+                        const uint32_t start = next * spb;
+                        decoder.startBlock(encoded + next * blockAlign,
+                                           (FRAMES - start < spb) ? FRAMES - start : spb);
+                        next++;
+                    }
+                    int16_t* d[2] = { dest[0] + done, dest[1] + done };
+                    done += decoder.decode(d, BENCH_BLOCK - done);
+                }
+                const uint32_t dt = hrtfCycles() - t0;
+                cost[k] = (dt < cost[k]) ? dt : cost[k];
+                for (uint32_t i = 0; r == 0 && i < done; i++) {
+                    for (int c = 0; c < channels; c++) {
+                        const float ref = adpcmTestSample(k * BENCH_BLOCK + i, c);
+                        const float err = dest[c][i] - ref;
+                        signal += ref * ref;
+                        noise += err * err;
+                    }
+                }
+            }
+        }
+        // Le dernier bloc audio est incomplet : écarté
+        uint32_t least = 0xFFFFFFFF;
+        uint32_t most = 0;
+        uint64_t total = 0;
+        for (uint32_t k = 0; k + 1 < outBlocks; k++) {
+            least = (cost[k] < least) ? cost[k] : least;
+            most = (cost[k] > most) ? cost[k] : most;
+            total += cost[k];
+        }
+        const float period = (float)F_CPU * BENCH_BLOCK / RATE;
+        const float pcmBytes = (float)RATE * 2 * channels;
+        const float adpcmBytes = (float)RATE * blockAlign / spb;
+
+        out.print("BENCH:ADPCM ");
+        out.print(channels == 1 ? "mono" : "stereo");
+        out.print(" blocs de ");
+        out.print(blockAlign);
+        out.print(" octets (");
+        out.print(spb);
+        out.print(" trames) : decodage de 128 trames ");
+        out.print(least);
+        out.print(" a ");
+        out.print(most);
+        out.print(" cyc, moyenne ");
+        out.print((float)total / (outBlocks - 1), 0);
+        out.print(" (");
+        out.print(100.0f * most / period, 2);
+        out.print(" % d'un bloc audio), RSB ");
+        out.print(noise > 0.0 ? 10.0f * log10f((float)(signal / noise)) : 200.0f, 1);
+        out.println(" dB");
+        out.print("  carte SD : ");
+        out.print(adpcmBytes, 0);
+        out.print(" octets par seconde d'audio, PCM 16 bits ");
+        out.print(pcmBytes, 0);
+        out.print(" (");
+        out.print(pcmBytes / adpcmBytes, 2);
+        out.println("x moins)");
+
+        free(encoded); free(pcm); free(decoded); free(cost);
+    }
+}
+
+// Sinus de hrtfBenchmarkResampler (-6 dB), identique sur les deux canaux
+static const int SRC_BENCH_CHUNK = 1024;   // trames lues par morceau, comme MyStreamPlayer
+static const int SRC_BENCH_CHUNKS = 8;
+static const uint32_t SRC_BENCH_SKIP = 64; // début du signal (filtre encore sur des zéros)
+
+static float srcTestSample(uint32_t n, double rate, double freq) {
+    return 16383.0f * (float)sin(2.0 * M_PI * freq * (double)n / rate);
+}
+
+// Passage de SRC_BENCH_CHUNKS morceaux d'un sinus à freq dans src : cycles de process par
+// trame de sortie ; erreur face au sinus attendu à la sortie (si error) ou énergie de sortie,
+// sur counted trames
+static float srcBenchmarkPass(HrtfResampler& src, double inRate, double outRate, double freq,
+                              int16_t* in, int16_t* outFrames, int outCapacity,
+                              double* signal, double* error, uint32_t* counted) {
+    const int channels = src.getChannels();
+    src.reset();
+    uint32_t cycles = 0;
+    uint32_t produced = 0;
+    for (int chunk = 0; chunk < SRC_BENCH_CHUNKS; chunk++) {
+        for (int i = 0; i < SRC_BENCH_CHUNK; i++) {
+            const float v = srcTestSample(chunk * SRC_BENCH_CHUNK + i, inRate, freq);
+            for (int c = 0; c < channels; c++) {
+                in[i * channels + c] = (int16_t)lroundf(v);
+            }
+        }
+        int offset = 0;
+        while (offset < SRC_BENCH_CHUNK) {
+            int consumed = 0;
+            const uint32_t t0 = hrtfCycles();
+            const int n = src.process(in + offset * channels, SRC_BENCH_CHUNK - offset, consumed,
+                                      outFrames, outCapacity);
+            cycles += hrtfCycles() - t0;
+            offset += consumed;
+            for (int i = 0; signal && i < n; i++) {
+                const uint32_t m = produced + i;
+                if (m < SRC_BENCH_SKIP) {
+                    continue;
+                }
+                const float y = outFrames[i * channels];
+                (*counted)++;
+                if (error) {
+                    const float ref = srcTestSample(m, outRate, freq);
+                    *signal += ref * ref;
+                    *error += (y - ref) * (y - ref);
+                } else {
+                    *signal += y * y;
+                }
+            }
+            produced += n;
+        }
+    }
+    return (produced > 0) ? (float)cycles / produced : 0.0f;
+}
+
+void hrtfBenchmarkResampler(Print& out) {
+    static const double RATES[] = { 22050.0, 44100.0, 48000.0, 96000.0 };
+    static const int OUT_CAPACITY = 4 * SRC_BENCH_CHUNK;
+    static const int REPEAT = 3;
+    const double engine = AUDIO_SAMPLE_RATE_EXACT;
+    int16_t* in = (int16_t*)malloc(2 * SRC_BENCH_CHUNK * sizeof(int16_t));
+    int16_t* outFrames = (int16_t*)malloc(2 * OUT_CAPACITY * sizeof(int16_t));
+    HrtfResampler* src = new HrtfResampler();
+    if (!in || !outFrames || !src) {
+        out.println("BENCH:SRC memoire insuffisante");
+        free(in); free(outFrames); delete src;
+        return;
+    }
+
+    for (size_t r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++) {
+        for (int q = HRTF_SRC_LOW; q <= HRTF_SRC_HIGH; q++) {
+            float cost[2] = { 0.0f, 0.0f };
+            double signal = 0.0;
+            double error = 0.0;
+            uint32_t counted = 0;
+            bool ok = true;
+            for (int channels = 1; channels <= 2 && ok; channels++) {
+                ok = src->init(RATES[r], engine, channels, (HrtfResampleQuality)q);
+                for (int k = 0; k < REPEAT && ok; k++) {
+                    // Erreur mesurée au premier passage seulement (sortie identique ensuite)
+                    const bool measure = (channels == 1 && k == 0);
+                    const float c = srcBenchmarkPass(*src, RATES[r], engine, 1000.0, in, outFrames,
+                                                     OUT_CAPACITY, measure ? &signal : nullptr,
+                                                     measure ? &error : nullptr, &counted);
+                    cost[channels - 1] = (k == 0 || c < cost[channels - 1]) ? c : cost[channels - 1];
+                }
+            }
+            if (!ok) {
+                out.println("BENCH:SRC memoire insuffisante");
+                break;
+            }
+
+            out.print("BENCH:SRC ");
+            out.print(RATES[r], 0);
+            out.print(" -> ");
+            out.print(engine, 1);
+            out.print(" Hz qualite ");
+            out.print(q);
+            out.print(" (");
+            out.print(src->getTaps());
+            out.print(" taps, table de ");
+            out.print((uint32_t)src->getTableBytes());
+            out.print(" octets) : mono ");
+            out.print(cost[0], 1);
+            out.print(" cyc/ech, stereo ");
+            out.print(cost[1], 1);
+            out.print(" cyc/ech, RSB 1 kHz ");
+            out.print(error > 0.0 ? 10.0f * log10f((float)(signal / error)) : 200.0f, 1);
+            out.print(" dB");
+            if (RATES[r] > engine) {
+                // Sinus entre les deux fréquences de Nyquist : replié dans la bande s'il passe
+                const double alias = 0.25 * (RATES[r] + engine);
+                double energy = 0.0;
+                uint32_t frames = 0;
+                src->init(RATES[r], engine, 1, (HrtfResampleQuality)q);
+                srcBenchmarkPass(*src, RATES[r], engine, alias, in, outFrames, OUT_CAPACITY,
+                                 &energy, nullptr, &frames);
+                // Énergie du même sinus non atténué
+                const double reference = 0.5 * 16383.0 * 16383.0 * frames;
+                out.print(", sinus a ");
+                out.print(alias, 0);
+                out.print(" Hz attenue de ");
+                out.print(energy > 0.0 ? -10.0f * log10f((float)(energy / reference)) : 200.0f, 1);
+                out.print(" dB");
+            }
+            out.println();
+        }
+    }
+    free(in);
+    free(outFrames);
+    delete src;
+}
+
+// Parcours de l'ancien démarrage : tout l'arbre (listFiles affichait noms et tailles), puis la
+// racine seule pour la liste des fichiers lus. Retourne les fichiers de la liste.
+static uint32_t libraryWalk(File dir, bool recursive, bool filter) {
+    uint32_t files = 0;
+    while (true) {
+        File entry = dir.openNextFile();
+        if (!entry) {
+            break;
+        }
+        volatile uint32_t size = 0;
+        if (entry.isDirectory()) {
+            if (recursive) {
+                libraryWalk(entry, true, false);
+            }
+        } else {
+            size = (uint32_t)entry.size();
+            if (!filter || SdMediaLibrary::isMediaFile(entry.name())) {
+                files++;
+            }
+        }
+        (void)size;
+        entry.close();
+    }
+    return files;
+}
+
+void hrtfBenchmarkLibrary(Print& out) {
+    static const char* INDEX = "/libbench.idx";
+    static const int REPEAT = 3;
+    SdMediaLibrary* library = new SdMediaLibrary();
+    if (!library) {
+        out.println("BENCH:LIBRARY memoire insuffisante");
+        return;
+    }
+    uint32_t walk = 0xFFFFFFFF;
+    uint32_t probe = 0xFFFFFFFF;
+    uint32_t rebuild = 0xFFFFFFFF;
+    uint32_t current = 0xFFFFFFFF;
+    uint32_t files = 0;
+    for (int r = 0; r < REPEAT; r++) {
+        AudioNoInterrupts();
+        uint32_t t0 = micros();
+        File root = SD.open("/");
+        libraryWalk(root, true, false);
+        root.close();
+        root = SD.open("/");
+        files = libraryWalk(root, false, true);
+        root.close();
+        uint32_t dt = micros() - t0;
+        walk = (dt < walk) ? dt : walk;
+
+        // En-tête de chaque fichier analysé comme au changement de morceau (playTrack)
+        t0 = micros();
+        root = SD.open("/");
+        while (true) {
+            File entry = root.openNextFile();
+            if (!entry) {
+                break;
+            }
+            const String name = entry.name();
+            const bool media = !entry.isDirectory() && SdMediaLibrary::isMediaFile(name.c_str());
+            entry.close();
+            if (media && (name.endsWith(".stm") || name.endsWith(".STM"))) {
+                SdStemReader reader;
+                reader.open(name);
+            } else if (media) {
+                SdWavReader reader;
+                reader.open(name);
+            }
+        }
+        root.close();
+        dt = micros() - t0;
+        probe = (dt < probe) ? dt : probe;
+
+        SD.remove(INDEX);
+        t0 = micros();
+        library->begin(INDEX);
+        dt = micros() - t0;
+        rebuild = (dt < rebuild) ? dt : rebuild;
+
+        t0 = micros();
+        library->begin(INDEX);
+        dt = micros() - t0;
+        current = (dt < current) ? dt : current;
+        AudioInterrupts();
+    }
+    const bool consistent = library->count() == (int)files && library->getParsedCount() == 0 &&
+                            !library->wasRewritten();
+    AudioNoInterrupts();
+    SD.remove(INDEX);
+    AudioInterrupts();
+
+    out.print("BENCH:LIBRARY ");
+    out.print(files);
+    out.print(" fichiers : avant, deux parcours de la carte ");
+    out.print(walk / 1000.0f, 2);
+    out.print(" ms et en-tetes relus ");
+    out.print(files > 0 ? probe / 1000.0f / files : 0.0f, 2);
+    out.print(" ms par changement de morceau (");
+    out.print(probe / 1000.0f, 2);
+    out.println(" ms pour tous)");
+    out.print("  apres : index reconstruit ");
+    out.print(rebuild / 1000.0f, 2);
+    out.print(" ms, index a jour ");
+    out.print(current / 1000.0f, 2);
+    out.print(" ms (");
+    out.print(library->count());
+    out.print(" entrees, ");
+    out.print(consistent ? "aucun en-tete relu" : "incoherent");
+    out.println("), en-tetes servis depuis la RAM");
+    delete library;
+}
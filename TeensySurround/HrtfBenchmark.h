@@ -0,0 +1,92 @@
+#ifndef HRTF_BENCHMARK_H
+#define HRTF_BENCHMARK_H
+
+#include <Arduino.h>
+
+// Bancs d'essai lancés depuis le port série (commande BENCH:<nom>).
+// Les mesures sont faites au compteur de cycles et on garde le minimum sur
+// plusieurs répétitions pour écarter les interruptions audio.
+
+// Compteur de cycles CPU (DWT sur Teensy, TSC sur hôte x86)
+static inline uint32_t hrtfCycles() {
+#if defined(ARM_DWT_CYCCNT)
+    return ARM_DWT_CYCCNT;
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__builtin_ia32_rdtsc();
+#else
+    return micros() * (F_CPU / 1000000);
+#endif
+}
+
+class HrtfBank;
+
+// Cycles par échantillon de sortie stéréo pour chaque jeu de HrtfKernels
+void hrtfBenchmarkKernels(Print& out);
+
+// Énergie des artefacts de changement de HRIR, commutation brusque contre fondu enchaîné.
+// Utilise la banque déjà chargée, avec une voix de test.
+void hrtfBenchmarkSwitching(const HrtfBank& bank, Print& out);
+
+// Coût de HrtfMixer de 1 à 16 sources (une IFFT commune) face à des voix rendues séparément
+void hrtfBenchmarkMixer(const HrtfBank& bank, Print& out);
+
+// Coût du bus ambisonique (ordre 1 à 3) de 1 à 32 sources : encodage, rotation et décodage
+void hrtfBenchmarkAmbisonics(const HrtfBank& bank, Print& out);
+
+// Coût par bloc de l'interpolation triangulée (recherche du triangle, mélange des spectres ou
+// des coefficients) selon le nombre de mesures : banque chargée puis banques synthétiques
+void hrtfBenchmarkInterpolation(const HrtfBank& bank, Print& out);
+
+// Banque compacte chargée depuis filename (ex : "/hrtf_nh2.bin") : octets par mesure face au
+// stockage float, erreur de stockage, cycles de décodage et de sélection par une voix
+void hrtfBenchmarkCompact(const HrtfBank& bank, const char* filename, Print& out);
+
+// Base PCA chargée depuis pcaFile (ex : "/hrtf_nh2_pca.bin") : erreur de reconstruction et
+// cycles de reconstruction selon le nombre de composantes K, mesures de referenceFile (le
+// fichier d'origine, à la même phase minimale) comme référence ; puis coût par bloc de
+// HrtfPcaMixer (K + 1 convolutions pour toutes les sources) face à HrtfMixer (une voix par source)
+void hrtfBenchmarkPca(const HrtfBank& bank, const char* pcaFile, const char* referenceFile,
+                      Print& out);
+
+// Temps de chargement (meilleur de quelques essais) d'un même jeu de mesures au format v1
+// (ex : "/hrtf_elev0.bin", lu mesure par mesure) et au format "HRB2" (ex : "/hrtf_elev0_v2.bin",
+// lu par sections), aux réglages de la banque ; écart entre les coefficients et les spectres
+void hrtfBenchmarkLoad(const HrtfBank& bank, const char* v1File, const char* v2File, Print& out);
+
+// Banque compacte de filename (ex : "/hrtf_nh2.bin") chargée avec ses deux oreilles puis en
+// stockage symétrique, aux réglages de la banque : temps de chargement, octets résidents, et
+// écart entre les oreilles droites mesurées et celles des mesures miroirs
+void hrtfBenchmarkSymmetric(const HrtfBank& bank, const char* filename, Print& out);
+
+// Disposition de la banque résidente : les mesures de la banque (au plus 128) rangées une
+// structure par mesure (description et coefficients ensemble) ou par champ (description en
+// tableaux, coefficients dans un pool contigu aligné) ; cycles de la recherche de la plus
+// proche mesure, de la lecture des descriptions à la sélection et de la convolution directe
+void hrtfBenchmarkLayout(const HrtfBank& bank, Print& out);
+
+// Débit de la carte SD pour 1 à 8 pistes mono lues depuis loop() : un fichier de pistes
+// séparées ".stm" lu d'une traite (tranche par tranche, comme MyStemPlayer) face au même nombre
+// de WAV mono lus à tour de rôle (lectures alignées de MyStreamPlayer). Les fichiers de test
+// (1 s par piste) sont écrits dans /stembench au premier lancement.
+void hrtfBenchmarkStems(Print& out);
+
+// IMA-ADPCM (MyAdpcmPlayer), mono et stéréo, sur 1 s d'un signal de test encodé en RAM :
+// cycles de décodage par bloc audio de 128 trames (plus petit et plus grand selon la position
+// dans les blocs du fichier), rapport signal sur bruit, et octets lus sur la carte SD par
+// seconde d'audio face au PCM 16 bits
+void hrtfBenchmarkAdpcm(Print& out);
+
+// Conversion de fréquence (HrtfResampler) de 22,05, 44,1, 48 et 96 kHz vers la fréquence du
+// moteur, à chaque qualité : cycles par trame de sortie en mono et en stéréo (morceaux de 1024
+// trames lues, comme MyStreamPlayer), rapport signal sur bruit d'un sinus à 1 kHz et, en
+// réduction de fréquence, atténuation d'un sinus au-dessus de la nouvelle fréquence de Nyquist
+void hrtfBenchmarkResampler(Print& out);
+
+// Démarrage sur les fichiers de la carte SD, avant et après l'index de la bibliothèque : les deux
+// parcours de la racine de l'ancien démarrage (liste affichée, puis fichiers WAV et .stm) et
+// l'analyse d'un en-tête à chaque changement de morceau, face à SdMediaLibrary::begin avec un
+// index à reconstruire puis à jour (index de test /libbench.idx). Audio suspendu pendant
+// chaque mesure ; meilleur de quelques essais.
+void hrtfBenchmarkLibrary(Print& out);
+
+#endif
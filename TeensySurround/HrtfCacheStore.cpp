@@ -0,0 +1,219 @@
+#include "HrtfCacheStore.h"
+#include "HrtfBank.h"
+#include "HrirBinReader.h"
+#include "HrtfMemory.h"
+#include <string.h>
+#include <stdlib.h>
+
+HrtfCacheStore::HrtfCacheStore()
+: cacheSlots(0), fileReader(nullptr), coeffs(nullptr), slotLength(nullptr),
+  measurement(nullptr), lastUse(nullptr), slotOf(nullptr), pinned(0), clock(1),
+  requestHead(0), requestTail(0), prefetchCount(0), hits(0), misses(0), loads(0), version(0)
+{
+}
+
+HrtfCacheStore::~HrtfCacheStore() {
+    delete fileReader;
+    hrtfRelease(coeffs);
+    free(slotLength);
+    free(measurement);
+    free((void*)lastUse);
+    free((void*)slotOf);
+}
+
+bool HrtfCacheStore::open(HrirBinReader& reader, const String& filename, int slots) {
+    const int count = (reader.count() > (uint32_t)MAX_SLOTS) ? MAX_SLOTS : (int)reader.count();
+    cacheSlots = (slots > count) ? count : slots;
+    fileReader = new HrirBinReader();
+    coeffs = (float*)hrtfAllocate((size_t)cacheSlots * 2 * MAX_HRIR_LENGTH * sizeof(float));
+    slotLength = (uint8_t*)malloc(cacheSlots * sizeof(uint8_t));
+    measurement = (int16_t*)malloc(cacheSlots * sizeof(int16_t));
+    lastUse = (volatile uint32_t*)malloc(cacheSlots * sizeof(uint32_t));
+    slotOf = (volatile uint16_t*)malloc(count * sizeof(uint16_t));
+    if (!fileReader || !coeffs || !slotLength || !measurement || !lastUse || !slotOf ||
+        !reserve(count) || !fileReader->open(filename, MAX_HRIR_LENGTH)) {
+        return false;
+    }
+    for (int s = 0; s < cacheSlots; s++) {
+        slotLength[s] = 0;
+        measurement[s] = -1;
+        lastUse[s] = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        slotOf[i] = NO_SLOT;
+    }
+
+    // La longueur (et l'ITD d'une conversion en phase minimale) ne sont connues qu'à la
+    // lecture du filtre
+    while (slotCount < count && reader.readAt(slotCount, false)) {
+        HrtfStoreSlot* m = append(reader.azimuth(), reader.elevation(), reader.distance());
+        if (!m) {
+            break;
+        }
+        m->itdLeft = reader.itdLeft();
+        m->itdRight = reader.itdRight();
+    }
+    return true;
+}
+
+int HrtfCacheStore::read(int index) {
+    int slot = -1;
+    uint32_t oldest = clock;
+    for (int s = pinned; s < cacheSlots; s++) {
+        if (measurement[s] < 0) {
+            slot = s;
+            break;
+        }
+        if (lastUse[s] < oldest) {
+            oldest = lastUse[s];
+            slot = s;
+        }
+    }
+    if (slot < 0) {
+        return -1;
+    }
+    // L'interruption audio ne doit plus trouver l'ancienne mesure avant qu'elle soit écrasée
+    if (measurement[slot] >= 0) {
+        __disable_irq();
+        slotOf[measurement[slot]] = NO_SLOT;
+        __enable_irq();
+        measurement[slot] = -1;
+    }
+    return fileReader->readAt(index) ? slot : -1;
+}
+
+void HrtfCacheStore::publish(int index, int slot, const HrirData& data) {
+    memcpy(coeffs + (size_t)slot * 2 * MAX_HRIR_LENGTH, data.coeffs, sizeof(data.coeffs));
+    slotLength[slot] = (uint8_t)data.length;
+    slots[index].itdLeft = data.itdLeft;
+    slots[index].itdRight = data.itdRight;
+    measurement[slot] = (int16_t)index;
+    lastUse[slot] = clock;
+
+    // Publication, une fois le filtre complet
+    __disable_irq();
+    slotOf[index] = (uint16_t)slot;
+    version++;
+    __enable_irq();
+    loads++;
+}
+
+int HrtfCacheStore::resident(int index) const {
+    if (index < 0 || index >= slotCount) {
+        return index;
+    }
+    const uint16_t slot = slotOf[index];
+    if (slot != NO_SLOT) {
+        lastUse[slot] = clock;
+        hits++;
+        return index;
+    }
+
+    // Absente : demandée à nextRequest (file pleine : prefetch la chargera de toute façon si
+    // la direction est suivie), et remplacée par la plus proche des mesures résidentes
+    misses++;
+    const uint8_t next = (uint8_t)((requestHead + 1) % REQUESTS);
+    if (next != requestTail) {
+        requests[requestHead] = (uint16_t)index;
+        requestHead = next;
+    }
+    const float* d = slots[index].direction;
+    int best = -1;
+    int bestSlot = -1;
+    float bestDot = -2.0f;
+    for (int s = 0; s < cacheSlots; s++) {
+        const int i = measurement[s];
+        if (i < 0 || slotOf[i] != s) {
+            continue;
+        }
+        const float* e = slots[i].direction;
+        const float dot = d[0] * e[0] + d[1] * e[1] + d[2] * e[2];
+        if (dot > bestDot) {
+            bestDot = dot;
+            best = i;
+            bestSlot = s;
+        }
+    }
+    if (bestSlot >= 0) {
+        lastUse[bestSlot] = clock;
+    }
+    return best;
+}
+
+int HrtfCacheStore::nextRequest() {
+    while (requestTail != requestHead) {
+        const int index = requests[requestTail];
+        requestTail = (uint8_t)((requestTail + 1) % REQUESTS);
+        if (slotOf[index] == NO_SLOT) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+bool HrtfCacheStore::touch(int index) {
+    const uint16_t slot = slotOf[index];
+    if (slot == NO_SLOT) {
+        return false;
+    }
+    lastUse[slot] = clock;
+    return true;
+}
+
+void HrtfCacheStore::prefetch(const float* azimuthsDeg, const float* elevationsDeg, int count) {
+    count = (count > MAX_PREFETCH) ? MAX_PREFETCH : count;
+    for (int p = 0; p < count; p++) {
+        prefetchAzimuth[p] = azimuthsDeg[p];
+        prefetchElevation[p] = elevationsDeg[p];
+    }
+    prefetchCount = count;
+    // Nouveau passage : seules les mesures utilisées depuis restent protégées de l'éviction
+    clock++;
+}
+
+void HrtfCacheStore::resetCounters() {
+    hits = 0;
+    misses = 0;
+    loads = 0;
+}
+
+int HrtfCacheStore::getResident() const {
+    int count = 0;
+    for (int s = 0; s < cacheSlots; s++) {
+        count += (measurement[s] >= 0) ? 1 : 0;
+    }
+    return count;
+}
+
+size_t HrtfCacheStore::length(int index) const {
+    const uint16_t slot = slotOf[index];
+    return (slot == NO_SLOT) ? 0 : slotLength[slot];
+}
+
+size_t HrtfCacheStore::mix(const int* indices, const float* weights, int count,
+                           float* out) const {
+    size_t length = 0;
+    for (int k = 0; k < count; k++) {
+        if (indices[k] < 0 || indices[k] >= slotCount) {
+            continue;
+        }
+        const uint16_t slot = slotOf[indices[k]];
+        if (slot == NO_SLOT) {
+            continue;
+        }
+        const float* c = coeffs + (size_t)slot * 2 * MAX_HRIR_LENGTH;
+        const size_t n = slotLength[slot];
+        for (size_t i = 0; i < 2 * n; i++) {
+            out[i] += weights[k] * c[i];
+        }
+        length = (n > length) ? n : length;
+    }
+    return length;
+}
+
+size_t HrtfCacheStore::bytes() const {
+    return HrtfStore::bytes() +
+           (size_t)cacheSlots * (2 * MAX_HRIR_LENGTH * sizeof(float) + sizeof(uint8_t) +
+                                 sizeof(int16_t) + sizeof(uint32_t)) +
+           (size_t)slotCount * sizeof(uint16_t);
+}
@@ -0,0 +1,93 @@
+#ifndef HRTF_CACHE_STORE_H
+#define HRTF_CACHE_STORE_H
+
+#include <Arduino.h>
+#include "HrtfStore.h"
+
+class HrirBinReader;
+struct HrirData;
+
+// Banque à la demande (HrtfBank::setCacheSize) : l'index de toutes les mesures du fichier,
+// et un cache LRU de filtres de 2*MAX_HRIR_LENGTH floats (hrtfAllocate) lus sur la carte SD.
+// slotOf[mesure] n'est renseigné qu'une fois le filtre écrit (publish), et effacé avant qu'il
+// soit écrasé (read) : l'interruption audio ne lit que des filtres complets. lastUse : valeur
+// de clock (un par appel à prefetch) au dernier usage ; les cacheSlots / 4 premiers
+// emplacements (pin) ne sont jamais évincés.
+class HrtfCacheStore : public HrtfStore {
+public:
+    static const int MAX_CACHE_SLOTS = 1024;
+
+    HrtfCacheStore();
+    virtual ~HrtfCacheStore();
+
+    // Index du fichier (direction, distance et ITD de chaque mesure, sans les taps) et cache
+    // de slots emplacements (au plus un par mesure), filename rouvert pour les lectures
+    // suivantes ; false si mémoire insuffisante ou fichier illisible
+    bool open(HrirBinReader& reader, const String& filename, int slots);
+    int getSlots() const { return cacheSlots; }
+    int getPinned() const { return pinned; }
+    // Emplacement suivant (rempli par le dernier read) gardé pour toujours
+    void pin() { pinned++; }
+    const HrirBinReader& reader() const { return *fileReader; }
+
+    // Hors interruption audio : emplacement libre, sinon le moins récemment utilisé parmi
+    // ceux qui ne l'ont pas été depuis le dernier prefetch, vidé puis la mesure index lue par
+    // reader() ; -1 si aucun emplacement ou lecture impossible
+    int read(int index);
+    // Filtre préparé (tête, phase minimale) de la mesure index écrit dans slot, puis publié
+    void publish(int index, int slot, const HrirData& data);
+
+    // Sur l'interruption audio : index si la mesure est résidente, sinon la plus proche des
+    // mesures résidentes (-1 si aucune), index étant demandé à nextRequest
+    int resident(int index) const;
+    // Mesure demandée par resident encore absente, -1 si aucune
+    int nextRequest();
+    // Mesure résidente marquée utilisée ; false si absente
+    bool touch(int index);
+
+    // Directions à venir (HrtfBank::prefetch), relues par HrtfBank::loadNext
+    void prefetch(const float* azimuthsDeg, const float* elevationsDeg, int count);
+    int getPrefetchCount() const { return prefetchCount; }
+    float getPrefetchAzimuth(int p) const { return prefetchAzimuth[p]; }
+    float getPrefetchElevation(int p) const { return prefetchElevation[p]; }
+
+    void resetCounters();
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+    uint32_t getLoads() const { return loads; }
+    int getResident() const;
+    uint32_t getVersion() const { return version; }
+
+    // Longueur nulle pour une mesure absente
+    virtual size_t length(int index) const;
+    // Filtre absent du cache : ignoré (HrtfBank ne rend que des mesures résidentes)
+    virtual size_t mix(const int* indices, const float* weights, int count, float* coeffs) const;
+    virtual size_t bytes() const;
+
+private:
+    static const uint16_t NO_SLOT = 0xFFFF;
+    static const int REQUESTS = 16;
+    static const int MAX_PREFETCH = 8;
+
+    int cacheSlots;
+    HrirBinReader* fileReader;
+    float* coeffs;
+    uint8_t* slotLength;         // taps de la tête de chaque emplacement
+    int16_t* measurement;        // mesure de chaque emplacement, -1 si libre
+    volatile uint32_t* lastUse;
+    volatile uint16_t* slotOf;
+    int pinned;
+    uint32_t clock;
+    mutable volatile uint16_t requests[REQUESTS];  // manquées par l'interruption
+    mutable volatile uint8_t requestHead;
+    volatile uint8_t requestTail;
+    float prefetchAzimuth[MAX_PREFETCH];
+    float prefetchElevation[MAX_PREFETCH];
+    int prefetchCount;
+    mutable volatile uint32_t hits;
+    mutable volatile uint32_t misses;
+    uint32_t loads;
+    volatile uint32_t version;
+};
+
+#endif
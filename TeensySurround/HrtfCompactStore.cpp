@@ -0,0 +1,232 @@
+#include "HrtfCompactStore.h"
+#include "HrtfBank.h"
+#include "HrtfMemory.h"
+#include <stdlib.h>
+#include <math.h>
+
+HrtfCompactStore::HrtfCompactStore(bool leftOnly)
+: leftOnly(leftOnly), codes(nullptr), codeCapacity(0), pages(nullptr), pageCount(0),
+  pageUsed(0), codeBytes(0), signalEnergy(0.0f), errorEnergy(0.0f)
+{
+}
+
+HrtfCompactStore::~HrtfCompactStore() {
+    for (int p = 0; p < pageCount; p++) {
+        hrtfRelease(pages[p]);
+    }
+    free(pages);
+    free(codes);
+}
+
+int16_t* HrtfCompactStore::allocateCodes(size_t count) {
+    // Pages de taille fixe remplies à la suite : pas d'en-tête d'allocation par mesure
+    const size_t bytes = count * sizeof(int16_t);
+    if (pageCount == 0 || pageUsed + bytes > PAGE_BYTES) {
+        if (pageCount % 16 == 0) {
+            uint8_t** grown = (uint8_t**)realloc(pages, (pageCount + 16) * sizeof(uint8_t*));
+            if (!grown) {
+                return nullptr;
+            }
+            pages = grown;
+        }
+        uint8_t* page = (uint8_t*)hrtfAllocate(PAGE_BYTES);
+        if (!page) {
+            return nullptr;
+        }
+        pages[pageCount++] = page;
+        pageUsed = 0;
+    }
+    int16_t* out = (int16_t*)(pages[pageCount - 1] + pageUsed);
+    pageUsed += bytes;
+    codeBytes += bytes;
+    return out;
+}
+
+bool HrtfCompactStore::add(float azimuthDeg, float elevationDeg, float distance,
+                           const HrirData& data) {
+    if (slotCount >= MAX_SLOTS) {
+        return false;
+    }
+    if (slotCount >= codeCapacity) {
+        const int grown = (slotCapacity > slotCount) ? slotCapacity : slotCount + 64;
+        CompactCodes* list = (CompactCodes*)realloc(codes, grown * sizeof(CompactCodes));
+        if (!list) {
+            return false;
+        }
+        codes = list;
+        codeCapacity = grown;
+    }
+
+    // Taps de début (retard de propagation) et de fin retirés tant qu'ils ne portent pas plus
+    // de 0.5e-6 de l'énergie de chaque côté (-60 dB au total)
+    const int ears = leftOnly ? 1 : 2;
+    const float* c = data.coeffs;
+    const size_t n = data.length;
+    float energy = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        for (int e = 0; e < ears; e++) {
+            energy += c[2 * i + e] * c[2 * i + e];
+        }
+    }
+    const float limit = 0.5e-6f * energy;
+    size_t first = 0;
+    float removed = 0.0f;
+    while (first < n) {
+        float e = c[2 * first] * c[2 * first];
+        e += (ears == 2) ? c[2 * first + 1] * c[2 * first + 1] : 0.0f;
+        if (removed + e > limit) {
+            break;
+        }
+        removed += e;
+        first++;
+    }
+    size_t last = n;
+    float error = removed;
+    removed = 0.0f;
+    while (last > first) {
+        float e = c[2 * last - 2] * c[2 * last - 2];
+        e += (ears == 2) ? c[2 * last - 1] * c[2 * last - 1] : 0.0f;
+        if (removed + e > limit) {
+            break;
+        }
+        removed += e;
+        last--;
+    }
+    error += removed;
+
+    // Quantification sur 16 bits, pas choisi pour que le plus grand tap gardé vaille 32767
+    float peak = 0.0f;
+    for (size_t i = first; i < last; i++) {
+        for (int e = 0; e < ears; e++) {
+            peak = (fabsf(c[2 * i + e]) > peak) ? fabsf(c[2 * i + e]) : peak;
+        }
+    }
+    CompactCodes& m = codes[slotCount];
+    m.start = (uint8_t)((peak > 0.0f) ? first : 0);
+    m.length = (uint8_t)((peak > 0.0f) ? last - first : 0);
+    m.scale = peak / 32767.0f;
+    m.codes = nullptr;
+    m.mirror = (uint16_t)slotCount;
+    if (m.length > 0) {
+        int16_t* out = allocateCodes((size_t)ears * m.length);
+        if (!out) {
+            return false;
+        }
+        const float inv = 1.0f / m.scale;
+        for (size_t i = 0; i < (size_t)m.length; i++) {
+            for (int e = 0; e < ears; e++) {
+                const float v = c[2 * (first + i) + e];
+                long q = lroundf(v * inv);
+                q = (q > 32767) ? 32767 : (q < -32767 ? -32767 : q);
+                out[ears * i + e] = (int16_t)q;
+                const float diff = v - (float)q * m.scale;
+                error += diff * diff;
+            }
+        }
+        m.codes = out;
+    }
+    HrtfStoreSlot* s = append(azimuthDeg, elevationDeg, distance);
+    if (!s) {
+        return false;
+    }
+    s->itdLeft = data.itdLeft;
+    s->itdRight = data.itdRight;
+    signalEnergy += energy;
+    errorEnergy += error;
+    return true;
+}
+
+void HrtfCompactStore::setMirror(int index, int mirror) {
+    codes[index].mirror = (uint16_t)mirror;
+}
+
+void HrtfCompactStore::normalizeMirrors(const float* measuredPeaks) {
+    // Une mesure et sa miroir sont ramenées au maximum de leurs deux gauches mesurées, qui est
+    // le maximum des deux oreilles de chacune. Sans ces maxima (mémoire insuffisante), celui des
+    // taps gardés.
+    float* peak = (float*)malloc((size_t)slotCount * sizeof(float));
+    for (int i = 0; peak && i < slotCount; i++) {
+        peak[i] = measuredPeaks ? measuredPeaks[i] : codes[i].scale * 32767.0f;
+    }
+    for (int i = 0; i < slotCount; i++) {
+        CompactCodes& m = codes[i];
+        // (sans mémoire, chaque mesure est ramenée à son propre maximum)
+        float p = peak ? peak[i] : m.scale * 32767.0f;
+        if (peak && peak[m.mirror] > p) {
+            p = peak[m.mirror];
+        }
+        if (p > 0.0f) {
+            m.scale /= p;
+        }
+    }
+    free(peak);
+}
+
+float HrtfCompactStore::errorDb() const {
+    if (signalEnergy <= 0.0f || errorEnergy <= 0.0f) {
+        return -200.0f;
+    }
+    return 10.0f * log10f(errorEnergy / signalEnergy);
+}
+
+size_t HrtfCompactStore::length(int index) const {
+    const CompactCodes& m = codes[index];
+    const size_t left = (size_t)m.start + m.length;
+    if (!leftOnly) {
+        return left;
+    }
+    const CompactCodes& r = codes[m.mirror];
+    const size_t right = (size_t)r.start + r.length;
+    return (left > right) ? left : right;
+}
+
+void HrtfCompactStore::itd(int index, float& left, float& right) const {
+    if (!leftOnly) {
+        HrtfStore::itd(index, left, right);
+        return;
+    }
+    // Instants d'arrivée de la gauche et de la droite (gauche de la mesure miroir)
+    const float itd = slots[index].itdLeft - slots[codes[index].mirror].itdLeft;
+    left = (itd > 0.0f) ? itd : 0.0f;
+    right = (itd < 0.0f) ? -itd : 0.0f;
+}
+
+size_t HrtfCompactStore::accumulate(int index, float weight, float* coeffs) const {
+    const CompactCodes& m = codes[index];
+    const float g = weight * m.scale;
+    float* out = coeffs + 2 * (size_t)m.start;
+    if (leftOnly) {
+        // Gauche : codes de la mesure ; droite : codes (gauches) de sa mesure miroir
+        for (int i = 0; i < m.length; i++) {
+            out[2 * i] += g * (float)m.codes[i];
+        }
+        const CompactCodes& r = codes[m.mirror];
+        const float gr = weight * r.scale;
+        float* outRight = coeffs + 2 * (size_t)r.start + 1;
+        for (int i = 0; i < r.length; i++) {
+            outRight[2 * i] += gr * (float)r.codes[i];
+        }
+        return length(index);
+    }
+    for (int i = 0; i < 2 * m.length; i++) {
+        out[i] += g * (float)m.codes[i];
+    }
+    return (size_t)m.start + m.length;
+}
+
+size_t HrtfCompactStore::mix(const int* indices, const float* weights, int count,
+                             float* coeffs) const {
+    size_t length = 0;
+    for (int k = 0; k < count; k++) {
+        if (indices[k] < 0 || indices[k] >= slotCount) {
+            continue;
+        }
+        const size_t len = accumulate(indices[k], weights[k], coeffs);
+        length = (len > length) ? len : length;
+    }
+    return length;
+}
+
+size_t HrtfCompactStore::bytes() const {
+    return HrtfStore::bytes() + codeBytes + (size_t)slotCount * sizeof(CompactCodes);
+}
@@ -0,0 +1,65 @@
+#ifndef HRTF_COMPACT_STORE_H
+#define HRTF_COMPACT_STORE_H
+
+#include "HrtfStore.h"
+
+struct HrirData;
+
+// Stockage compact (HrtfBank::setCompactStorage) : chaque mesure est gardée en int16 avec un
+// pas propre, sans les taps de début et de fin qui ne portent que 1e-6 de son énergie. Les
+// codes sont rangés à la suite dans des pages de PAGE_BYTES (hrtfAllocate, donc en PSRAM si
+// présente). Stockage symétrique (leftOnly) : oreille gauche seulement, l'oreille droite
+// d'une mesure étant la gauche de sa mesure miroir (setMirror).
+class HrtfCompactStore : public HrtfStore {
+public:
+    static const size_t PAGE_BYTES = 16384;
+
+    explicit HrtfCompactStore(bool leftOnly);
+    virtual ~HrtfCompactStore();
+
+    bool isLeftOnly() const { return leftOnly; }
+    // Mesure déjà préparée (tête, phase minimale) quantifiée à la suite ; false si mémoire
+    // insuffisante
+    bool add(float azimuthDeg, float elevationDeg, float distance, const HrirData& data);
+    // Stockage symétrique : mesure dont la gauche est la droite de index (index elle-même
+    // par défaut)
+    void setMirror(int index, int mirror);
+    // Stockage symétrique : oreilles gauches lues brutes, chaque paire de mesures miroirs
+    // ramenée au maximum de leurs deux gauches mesurées (measuredPeaks, un par mesure ; nul :
+    // maximum des taps gardés)
+    void normalizeMirrors(const float* measuredPeaks);
+    // Énergie de l'erreur de stockage (taps retirés et quantification) rapportée à celle des
+    // filtres, en dB
+    float errorDb() const;
+
+    virtual size_t length(int index) const;
+    virtual void itd(int index, float& left, float& right) const;
+    virtual size_t mix(const int* indices, const float* weights, int count, float* coeffs) const;
+    virtual size_t bytes() const;
+
+private:
+    // Taps [start, start + length) des deux oreilles (de la gauche en stockage symétrique,
+    // dont itdLeft de la description est alors l'instant d'arrivée)
+    struct CompactCodes {
+        const int16_t* codes;  // length paires gauche/droite, dans pages
+        float scale;           // valeur d'un pas de quantification
+        uint8_t start;
+        uint8_t length;
+        uint16_t mirror;
+    };
+
+    int16_t* allocateCodes(size_t count);
+    size_t accumulate(int index, float weight, float* coeffs) const;
+
+    bool leftOnly;
+    CompactCodes* codes;   // parallèle à slots
+    int codeCapacity;
+    uint8_t** pages;
+    int pageCount;
+    size_t pageUsed;
+    size_t codeBytes;
+    float signalEnergy;
+    float errorEnergy;
+};
+
+#endif
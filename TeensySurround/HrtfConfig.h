@@ -0,0 +1,113 @@
+#ifndef HRTF_CONFIG_H
+#define HRTF_CONFIG_H
+
+// Type d'échantillon du rendu, choisi à la compilation :
+//   0 : float (HrtfBank + HrtfVoice, convolution directe ou FFT, réponses longues)
+//   1 : virgule fixe (HrtfEngineQ15), coefficients Q15, accumulation 64 bits,
+//       de audio_block_t à audio_block_t sans conversion en float
+#ifndef HRTF_FIXED_POINT
+#define HRTF_FIXED_POINT 0
+#endif
+
+// HRIR converties au chargement en phase minimale + ITD fractionnaire (HrtfBank::setMinimumPhase),
+// tronquées à ce nombre de taps (32 ou 48 typiquement) ; 0 : HRIR mesurées telles quelles.
+// Sans effet en virgule fixe.
+#ifndef HRTF_MINIMUM_PHASE_LENGTH
+#define HRTF_MINIMUM_PHASE_LENGTH 0
+#endif
+
+// MyDsp interpole le filtre entre les mesures encadrant la direction (HrtfVoice::interpolate)
+// au lieu de prendre la plus proche. Sans effet en virgule fixe.
+#ifndef HRTF_INTERPOLATION
+#define HRTF_INTERPOLATION 1
+#endif
+
+// Fichier de HRIR chargé par les nœuds audio depuis la carte SD ("/hrtf_nh2_pca.bin" : base
+// PCA, filtres reconstruits par chaque voix à la sélection ; "/hrtf_elev0_v2.bin" : mêmes
+// mesures au format "HRB2", chargées plus vite)
+#ifndef HRTF_BANK_FILE
+#define HRTF_BANK_FILE "/hrtf_elev0.bin"
+#endif
+
+// Banque compilée dans le programme (HrtfFlashData.h, généré par assets/generateHrirHeader.py)
+// et lue en place en flash : ni carte SD ni copie en RAM pour démarrer le rendu. 0 : fichier
+// HRTF_BANK_FILE de la carte SD (stockage compact, cache, phase minimale au chargement).
+// Sans effet en virgule fixe.
+#ifndef HRTF_FLASH_BANK
+#define HRTF_FLASH_BANK 1
+#endif
+
+// Banque en stockage compact (HrtfBank::setCompactStorage) : int16, taps négligeables retirés,
+// toutes les mesures du fichier (les ~1550 directions de "/hrtf_nh2.bin" par exemple), décodées
+// par chaque voix à la sélection. Sans effet en virgule fixe.
+#ifndef HRTF_COMPACT_BANK
+#define HRTF_COMPACT_BANK 0
+#endif
+
+// Stockage symétrique (HrtfBank::setSymmetricStorage) : une oreille par direction, l'autre lue
+// sur la mesure miroir ; deux fois moins de mémoire et d'octets lus sur la carte SD pour un
+// fichier "HRIR". Sujet à vérifier avant (assets/checkSymmetry.py). Sans effet en virgule fixe,
+// ni avec la banque compilée en flash.
+#ifndef HRTF_SYMMETRIC_BANK
+#define HRTF_SYMMETRIC_BANK 0
+#endif
+
+// Banque à la demande (HrtfBank::setCacheSize) : nombre de filtres gardés en RAM, lus sur la
+// carte SD au premier usage et anticipés depuis loop() selon le mouvement de la source
+// (MyDsp::prefetch) ; 0 : banque chargée en entier. Fichiers "HRIR" et "HRB2" seulement.
+// Sans effet en virgule fixe.
+#ifndef HRTF_CACHE_SIZE
+#define HRTF_CACHE_SIZE 0
+#endif
+
+// Anticipation : directions que la source atteindra dans les HRTF_PREFETCH_HORIZON_MS ms à
+// venir, au rythme de ses derniers déplacements
+#ifndef HRTF_PREFETCH_HORIZON_MS
+#define HRTF_PREFETCH_HORIZON_MS 500
+#endif
+
+// Changement de sujet en arrière-plan (commande SUBJECT:, MyDsp::loadSubject) : durée visée
+// pour chaque étape du chargement faite depuis loop(), en microsecondes. Les étapes qui lisent
+// la carte SD suspendent l'audio : à garder bien en deçà d'un bloc (2,9 ms à 44,1 kHz).
+#ifndef HRTF_SWAP_CHUNK_US
+#define HRTF_SWAP_CHUNK_US 500
+#endif
+
+// Lecteur WAV (MyStreamPlayer) : trames stéréo lues d'avance en RAM depuis loop(), puissance
+// de 2. 8192 trames : 186 ms à 44,1 kHz pour 32 Ko.
+#ifndef HRTF_STREAM_BUFFER_FRAMES
+#define HRTF_STREAM_BUFFER_FRAMES 8192
+#endif
+
+// Lecteur de pistes séparées (MyStemPlayer, fichiers .stm) : trames lues d'avance par piste,
+// puissance de 2, au moins deux blocs du fichier. 4096 trames : 93 ms à 44,1 kHz pour 8 Ko par
+// piste (64 Ko pour 8 pistes).
+#ifndef HRTF_STEM_BUFFER_FRAMES
+#define HRTF_STEM_BUFFER_FRAMES 4096
+#endif
+
+// Lecteur IMA-ADPCM (MyAdpcmPlayer) : octets de blocs compressés lus d'avance en RAM depuis
+// loop(), au moins deux blocs du fichier. 16 Ko : 8 blocs stéréo de 2048 octets, 370 ms à
+// 44,1 kHz (le quadruple de ce que la même place contient en PCM).
+#ifndef HRTF_ADPCM_BUFFER_BYTES
+#define HRTF_ADPCM_BUFFER_BYTES 16384
+#endif
+
+// Conversion de fréquence (HrtfResampler) : les WAV lus par MyStreamPlayer et les banques de
+// HRIR de tous les formats ("HRIR", "HRIV", "HRB2", base PCA, cache à la demande) qui ne sont
+// pas à la fréquence du moteur y sont convertis au chargement, 44,1 kHz compris
+// (AUDIO_SAMPLE_RATE_EXACT vaut 44117,6 Hz). 1 : 8 taps, 2 : 16 taps, 3 : 32 taps par
+// échantillon (voir BENCH:SRC) ; 0 : aucune conversion, fichiers lus à leur propre fréquence
+// comme avant.
+#ifndef HRTF_RESAMPLE_QUALITY
+#define HRTF_RESAMPLE_QUALITY 2
+#endif
+
+// Index de la bibliothèque de la carte SD (SdMediaLibrary) : fichiers WAV et .stm de la racine
+// avec leurs en-têtes déjà analysés, relu au démarrage et mis à jour seulement pour les
+// fichiers ajoutés, modifiés ou retirés
+#ifndef HRTF_LIBRARY_FILE
+#define HRTF_LIBRARY_FILE "/library.idx"
+#endif
+
+#endif
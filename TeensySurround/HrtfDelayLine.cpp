@@ -0,0 +1,52 @@
+#include "HrtfDelayLine.h"
+#include <string.h>
+
+HrtfDelayLine::HrtfDelayLine() {
+    reset();
+}
+
+void HrtfDelayLine::reset() {
+    memset(buffer, 0, sizeof(buffer));
+    pos = 0;
+    current = 0.0f;
+    started = false;
+}
+
+void HrtfDelayLine::process(float* data, int count, float delay) {
+    if (delay < 0.0f) {
+        delay = 0.0f;
+    } else if (delay > (float)MAX_DELAY) {
+        delay = (float)MAX_DELAY;
+    }
+    if (!started) {
+        current = delay;
+        started = true;
+    }
+    const unsigned mask = SIZE - 1;
+    const float step = (count > 0) ? (delay - current) / count : 0.0f;
+    float d = current;
+    for (int n = 0; n < count; n++) {
+        buffer[pos & mask] = data[n];
+        d += step;
+        float y;
+        if (d < 1.0f) {
+            // x[t] et x[t-1]
+            y = (1.0f - d) * data[n] + d * buffer[(pos - 1) & mask];
+        } else {
+            // Lagrange sur x[t-m], ..., x[t-m-3] avec m = floor(d) - 1 et 1 <= f < 2
+            int m = (int)d - 1;
+            float f = d - (float)m;
+            float fm1 = f - 1.0f, fm2 = f - 2.0f, fm3 = f - 3.0f;
+            float h0 = -fm1 * fm2 * fm3 * (1.0f / 6.0f);
+            float h1 = f * fm2 * fm3 * 0.5f;
+            float h2 = -f * fm1 * fm3 * 0.5f;
+            float h3 = f * fm1 * fm2 * (1.0f / 6.0f);
+            unsigned i = pos - (unsigned)m;
+            y = h0 * buffer[i & mask] + h1 * buffer[(i - 1) & mask]
+              + h2 * buffer[(i - 2) & mask] + h3 * buffer[(i - 3) & mask];
+        }
+        data[n] = y;
+        pos++;
+    }
+    current = delay;
+}
@@ -0,0 +1,26 @@
+#ifndef HRTF_DELAY_LINE_H
+#define HRTF_DELAY_LINE_H
+
+// Retard fractionnaire d'une oreille (ITD des HRIR à phase minimale).
+// Interpolation de Lagrange d'ordre 3 (linéaire en dessous d'un échantillon, où le retard
+// nul reste exact). Le retard glisse linéairement sur le bloc : l'ITD varie continûment
+// quand la source tourne, sans saut d'échantillon.
+class HrtfDelayLine {
+public:
+    static const int SIZE = 64;                 // puissance de 2
+    static const int MAX_DELAY = SIZE - 4;      // en échantillons (~1.4 ms à 44.1 kHz)
+
+    HrtfDelayLine();
+    void reset();
+
+    // Retarde data en place ; delay en échantillons, atteint à la fin du bloc
+    void process(float* data, int count, float delay);
+
+private:
+    float buffer[SIZE];
+    unsigned pos;       // prochaine écriture
+    float current;      // retard à la fin du bloc précédent
+    bool started;       // faux après reset : le premier bloc prend directement le retard demandé
+};
+
+#endif
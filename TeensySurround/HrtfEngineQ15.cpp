@@ -0,0 +1,183 @@
+#include "HrtfEngineQ15.h"
+#include "HrirBinReader.h"
+#include "HrtfKernels.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(HRTF_KERNEL_CMSIS)
+#include <arm_math.h>
+#endif
+
+// acc += lo(x)*lo(h) + hi(x)*hi(h)
+static inline int64_t smlald(uint32_t x, uint32_t h, int64_t acc) {
+#if defined(HRTF_KERNEL_CMSIS)
+    return (int64_t)__SMLALD(x, h, (uint64_t)acc);
+#else
+    return acc + (int32_t)(int16_t)(x & 0xFFFF) * (int16_t)(h & 0xFFFF)
+               + (int32_t)(int16_t)(x >> 16) * (int16_t)(h >> 16);
+#endif
+}
+
+static inline int32_t saturate32(int64_t v) {
+    if (v > 2147483647LL) return 2147483647;
+    if (v < -2147483648LL) return -2147483647 - 1;
+    return (int32_t)v;
+}
+
+static inline int16_t saturate16(int32_t v) {
+#if defined(HRTF_KERNEL_CMSIS)
+    return (int16_t)__SSAT(v, 16);
+#else
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+#endif
+}
+
+static inline uint16_t toQ15(float v) {
+    float q = roundf(v * 32767.0f);
+    if (q > 32767.0f) q = 32767.0f;
+    if (q < -32768.0f) q = -32768.0f;
+    return (uint16_t)(int16_t)q;
+}
+
+HrtfEngineQ15::HrtfEngineQ15()
+: hrirCount(0), lastAzimuth(-1), sampleRate(44100), blockSize(128), history(nullptr)
+{
+    memset(azimuthIndex, 0, sizeof(azimuthIndex));
+    lastSelection.coeffs = nullptr;
+    lastSelection.length = 0;
+    lastSelection.distance = 0.0f;
+    for (int i = 0; i < MAX_HRIR_SLOTS; i++) {
+        hrirSlots[i].azimuth = 0;
+        hrirSlots[i].distance = 0.0f;
+        hrirSlots[i].length = 0;
+        memset(hrirSlots[i].coeffs, 0, sizeof(hrirSlots[i].coeffs));
+    }
+}
+
+HrtfEngineQ15::~HrtfEngineQ15() {
+    free(history);
+}
+
+void HrtfEngineQ15::init(int sRate, int bSize) {
+    sampleRate = sRate;
+    blockSize  = bSize;
+    hrirCount  = 0;
+    lastAzimuth = -1;
+    free(history);
+    history = (int16_t*)calloc(MAX_HRIR_LENGTH + blockSize, sizeof(int16_t));
+}
+
+bool HrtfEngineQ15::loadFromBin(const String &filename) {
+    HrirBinReader reader;
+    if (!reader.open(filename, MAX_HRIR_LENGTH)) {
+        return false;
+    }
+
+    sampleRate = reader.sampleRate();
+    hrirCount = 0;
+    while (hrirCount < MAX_HRIR_SLOTS && reader.next()) {
+        // Seule la tête est conservée : les réponses longues ne sont pas gérées en virgule fixe
+        const size_t len = (reader.length() > MAX_HRIR_LENGTH) ? MAX_HRIR_LENGTH : reader.length();
+        HrirSlotQ15& slot = hrirSlots[hrirCount];
+        slot.azimuth = (int)roundf(reader.azimuth());
+        slot.distance = reader.distance();
+        slot.length = len;
+        for (int p = 0; p < MAX_HRIR_LENGTH / 2; p++) {
+            size_t k0 = 2 * p, k1 = 2 * p + 1;
+            uint16_t l0 = (k0 < len) ? toQ15(reader.left()[k0])  : 0;
+            uint16_t l1 = (k1 < len) ? toQ15(reader.left()[k1])  : 0;
+            uint16_t r0 = (k0 < len) ? toQ15(reader.right()[k0]) : 0;
+            uint16_t r1 = (k1 < len) ? toQ15(reader.right()[k1]) : 0;
+            slot.coeffs[2 * p]     = ((uint32_t)l0 << 16) | l1;
+            slot.coeffs[2 * p + 1] = ((uint32_t)r0 << 16) | r1;
+        }
+        hrirCount++;
+    }
+    reader.close();
+
+    // Table des azimuts : même critère que le parcours linéaire (premier slot à égalité)
+    for (int a = 0; a < 360; a++) {
+        int bestIndex = 0;
+        int bestDiff = 361;
+        for (int i = 0; i < hrirCount; i++) {
+            int diff = abs(a - (hrirSlots[i].azimuth % 360 + 360) % 360);
+            if (diff > 180) {
+                diff = 360 - diff;
+            }
+            if (diff < bestDiff) {
+                bestDiff = diff;
+                bestIndex = i;
+            }
+        }
+        azimuthIndex[a] = (uint8_t)bestIndex;
+    }
+    lastAzimuth = -1;
+
+    Serial.print("loadFromBin (Q15) OK, hrirCount=");
+    Serial.println(hrirCount);
+    return true;
+}
+
+SelectedHrirQ15 HrtfEngineQ15::getHrir(int azimuthDeg) {
+    SelectedHrirQ15 sel;
+    sel.coeffs = nullptr;
+    sel.length = 0;
+    sel.distance = 0.0f;
+    if (hrirCount == 0) {
+        return sel;
+    }
+    const int az = (azimuthDeg % 360 + 360) % 360;
+    if (az == lastAzimuth) {
+        return lastSelection;
+    }
+
+    const int bestIndex = azimuthIndex[az];
+    sel.coeffs = hrirSlots[bestIndex].coeffs;
+    sel.length = hrirSlots[bestIndex].length;
+    sel.distance = hrirSlots[bestIndex].distance;
+    lastAzimuth = az;
+    lastSelection = sel;
+    return sel;
+}
+
+void HrtfEngineQ15::processBlock(const int16_t* in, int16_t* outLeft, int16_t* outRight,
+                                 const SelectedHrirQ15& selHrir, float gain) {
+    const int H = MAX_HRIR_LENGTH;
+    if (!history || !selHrir.coeffs) {
+        memset(outLeft, 0, blockSize * sizeof(int16_t));
+        memset(outRight, 0, blockSize * sizeof(int16_t));
+        return;
+    }
+
+    // Gain global et atténuation de distance en Q16.16
+    float distanceFactor = 1.0f;
+    if (selHrir.distance > 1.0f) {
+        distanceFactor = 1.0f / (selHrir.distance * selHrir.distance);
+    }
+    const int32_t gainQ16 = (int32_t)(gain * distanceFactor * 65536.0f);
+
+    memcpy(history + H, in, blockSize * sizeof(int16_t));
+    const int16_t* x = history + H;
+    const int pairs = (int)(selHrir.length + 1) / 2;
+    const uint32_t* c = selHrir.coeffs;
+
+    for (int n = 0; n < blockSize; n++) {
+        int64_t accL = 0, accR = 0;
+        // Mot (x[n-2p-1], x[n-2p]) : poids faible = échantillon le plus ancien
+        const int16_t* xp = x + n - 1;
+        for (int p = 0; p < pairs; p++) {
+            uint32_t xw;
+            memcpy(&xw, xp - 2 * p, sizeof(xw));
+            accL = smlald(xw, c[2 * p], accL);
+            accR = smlald(xw, c[2 * p + 1], accR);
+        }
+        // Gain appliqué sur l'accumulateur 64 bits (Q30 * Q16.16 -> Q46), puis retour en Q15 saturé :
+        // une saturation avant le gain écrêterait à 1.0 un signal que le gain ramène dans la plage
+        outLeft[n]  = saturate16(saturate32((accL * gainQ16) >> 31));
+        outRight[n] = saturate16(saturate32((accR * gainQ16) >> 31));
+    }
+    memmove(history, history + blockSize, H * sizeof(int16_t));
+}
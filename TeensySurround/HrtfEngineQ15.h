@@ -0,0 +1,66 @@
+#ifndef HRTF_ENGINE_Q15_H
+#define HRTF_ENGINE_Q15_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "HrtfVoice.h"
+
+// HRIR sélectionnée en virgule fixe : coeffs[2p] / coeffs[2p+1] contiennent les taps
+// 2p et 2p+1 de l'oreille gauche / droite, empaquetés en Q15 (tap 2p+1 dans les 16 bits
+// de poids faible) pour un double MAC SMLALD par mot.
+struct SelectedHrirQ15 {
+    const uint32_t* coeffs;
+    size_t length;
+    float distance;
+};
+
+// Variante virgule fixe de ProjectHrtfEngine (HRTF_FIXED_POINT = 1, voir HrtfConfig.h).
+// Les échantillons int16 de audio_block_t sont convolués directement avec des
+// coefficients Q15, accumulés sur 64 bits, mis à l'échelle par le gain puis ramenés
+// en Q15 avec saturation.
+// La banque occupe deux fois moins de mémoire que la banque float.
+class HrtfEngineQ15 {
+public:
+    HrtfEngineQ15();
+    ~HrtfEngineQ15();
+
+    void init(int sRate, int bSize);
+    bool loadFromBin(const String &filename);
+    // Mesure la plus proche en azimut, en temps constant
+    SelectedHrirQ15 getHrir(int azimuthDeg);
+
+    void processBlock(const int16_t* in, int16_t* outLeft, int16_t* outRight,
+                      const SelectedHrirQ15& selHrir, float gain = 1.0f);
+
+    // Seule la forme directe existe en virgule fixe
+    void setConvolutionMode(HrtfConvolutionMode mode) { (void)mode; }
+    HrtfConvolutionMode getConvolutionMode() const { return HRTF_CONV_DIRECT; }
+    // Pas de fondu enchaîné en virgule fixe : la HRIR change d'un bloc à l'autre
+    void setSwitchMode(HrtfSwitchMode mode) { (void)mode; }
+    HrtfSwitchMode getSwitchMode() const { return HRTF_SWITCH_HARD; }
+
+private:
+    static const int MAX_HRIR_SLOTS = 128;
+    struct HrirSlotQ15 {
+        int azimuth;
+        float distance;
+        size_t length;
+        uint32_t coeffs[MAX_HRIR_LENGTH];  // MAX_HRIR_LENGTH/2 paires par oreille
+    };
+
+    HrirSlotQ15 hrirSlots[MAX_HRIR_SLOTS];
+    int hrirCount;
+
+    // Mesure la plus proche pour chaque degré d'azimut (construite au chargement)
+    // et dernière sélection, rendue telle quelle si l'angle n'a pas changé
+    uint8_t azimuthIndex[360];
+    int lastAzimuth;
+    SelectedHrirQ15 lastSelection;
+    int sampleRate;
+    int blockSize;
+
+    // [MAX_HRIR_LENGTH échantillons passés | bloc courant]
+    int16_t* history;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "HrtfFft.h"
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(HRTF_KERNEL_CMSIS)
+#include <arm_const_structs.h>
+
+static const arm_cfft_instance_f32* cmsisInstance(int n) {
+    switch (n) {
+        case 16:   return &arm_cfft_sR_f32_len16;
+        case 32:   return &arm_cfft_sR_f32_len32;
+        case 64:   return &arm_cfft_sR_f32_len64;
+        case 128:  return &arm_cfft_sR_f32_len128;
+        case 256:  return &arm_cfft_sR_f32_len256;
+        case 512:  return &arm_cfft_sR_f32_len512;
+        case 1024: return &arm_cfft_sR_f32_len1024;
+        case 2048: return &arm_cfft_sR_f32_len2048;
+        case 4096: return &arm_cfft_sR_f32_len4096;
+        default:   return nullptr;
+    }
+}
+#endif
+
+HrtfFft::HrtfFft()
+: n(0), invNorm(1.0f), twiddles(nullptr), bitrev(nullptr)
+{
+#if defined(HRTF_KERNEL_CMSIS)
+    cmsis = nullptr;
+#endif
+}
+
+HrtfFft::~HrtfFft() {
+    free(twiddles);
+    free(bitrev);
+}
+
+bool HrtfFft::init(int size) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    if (size == n) {
+        return true;
+    }
+#if defined(HRTF_KERNEL_CMSIS)
+    // arm_cfft_f32 normalise déjà la transformée inverse et n'a besoin d'aucune table en RAM
+    cmsis = cmsisInstance(size);
+    if (cmsis) {
+        n = size;
+        invNorm = 1.0f;
+        return true;
+    }
+#endif
+    free(twiddles);
+    free(bitrev);
+    n = 0;
+    twiddles = (float*)malloc(size * sizeof(float));
+    bitrev = (uint16_t*)malloc(size * sizeof(uint16_t));
+    if (!twiddles || !bitrev) {
+        free(twiddles);
+        free(bitrev);
+        twiddles = nullptr;
+        bitrev = nullptr;
+        return false;
+    }
+
+    // Twiddles e^{-2iπk/n} pour k < n/2
+    for (int k = 0; k < size / 2; k++) {
+        double a = -2.0 * M_PI * k / size;
+        twiddles[2 * k]     = (float)cos(a);
+        twiddles[2 * k + 1] = (float)sin(a);
+    }
+
+    // Table de permutation bit-reverse
+    int bits = 0;
+    while ((1 << bits) < size) {
+        bits++;
+    }
+    for (int i = 0; i < size; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) {
+                r |= 1 << (bits - 1 - b);
+            }
+        }
+        bitrev[i] = (uint16_t)r;
+    }
+    n = size;
+    invNorm = 1.0f / size;
+    return true;
+}
+
+void HrtfFft::forward(float* data) const {
+#if defined(HRTF_KERNEL_CMSIS)
+    if (cmsis) {
+        arm_cfft_f32(cmsis, data, 0, 1);
+        return;
+    }
+#endif
+    transform(data, 1.0f);
+}
+
+void HrtfFft::inverse(float* data) const {
+#if defined(HRTF_KERNEL_CMSIS)
+    if (cmsis) {
+        arm_cfft_f32(cmsis, data, 1, 1);
+        return;
+    }
+#endif
+    transform(data, -1.0f);
+}
+
+void HrtfFft::transform(float* data, float sign) const {
+    // Réordonnancement bit-reverse
+    for (int i = 0; i < n; i++) {
+        int j = bitrev[i];
+        if (j > i) {
+            float tr = data[2 * i], ti = data[2 * i + 1];
+            data[2 * i]     = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j]     = tr;
+            data[2 * j + 1] = ti;
+        }
+    }
+
+    // Papillons radix-2 (décimation temporelle)
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len >> 1;
+        const int step = n / len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                const float wr = twiddles[2 * k * step];
+                const float wi = sign * twiddles[2 * k * step + 1];
+                float* a = data + 2 * (start + k);
+                float* b = data + 2 * (start + k + half);
+                const float tr = b[0] * wr - b[1] * wi;
+                const float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef HRTF_FFT_H
+#define HRTF_FFT_H
+
+#include <stdint.h>
+#include "HrtfKernels.h"
+
+#if defined(HRTF_KERNEL_CMSIS)
+#include <arm_math.h>
+#endif
+
+// FFT complexe en place (arm_cfft_f32 sur Teensy 4.x, radix-2 portable sinon).
+// Les données sont entrelacées : data[2*i] = partie réelle, data[2*i+1] = partie imaginaire.
+class HrtfFft {
+public:
+    HrtfFft();
+    ~HrtfFft();
+
+    // Prépare les tables (twiddles, bit-reverse) pour une taille n puissance de 2
+    bool init(int n);
+    int size() const { return n; }
+
+    void forward(float* data) const;
+    // Transformée inverse ; multiplier le résultat par inverseNorm() pour la normaliser
+    void inverse(float* data) const;
+    float inverseNorm() const { return invNorm; }
+
+private:
+    HrtfFft(const HrtfFft&);
+    HrtfFft& operator=(const HrtfFft&);
+
+    void transform(float* data, float sign) const;
+
+    int n;
+    float invNorm;
+    float* twiddles;     // cos/sin entrelacés, n/2 entrées
+    uint16_t* bitrev;    // permutation bit-reverse
+#if defined(HRTF_KERNEL_CMSIS)
+    const arm_cfft_instance_f32* cmsis;  // nul si la taille n'est pas couverte par CMSIS
+#endif
+};
+
+#endif
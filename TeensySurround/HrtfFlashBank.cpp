@@ -0,0 +1,15 @@
+#include "HrtfFlashBank.h"
+#include "HrtfConfig.h"
+
+#if HRTF_FLASH_BANK && !HRTF_FIXED_POINT
+// Seule unité de compilation qui inclut les tableaux générés (une seule copie en flash)
+#include "HrtfFlashData.h"
+
+const HrtfFlashBank* hrtfFlashBank() {
+    return &hrtfFlashData;
+}
+#else
+const HrtfFlashBank* hrtfFlashBank() {
+    return nullptr;
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef HRTF_FLASH_BANK_H
+#define HRTF_FLASH_BANK_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// Banque de HRIR compilée dans le programme (HrtfFlashData.h, généré par
+// assets/generateHrirHeader.py) et lue en place par HrtfBank::loadFromFlash : aucun fichier à
+// ouvrir au démarrage, aucun coefficient copié en RAM. Sur Teensy 4, les tableaux const sont
+// recopiés en RAM au démarrage : les données sont donc marquées PROGMEM pour rester en flash.
+
+// Description d'une mesure (filtres déjà normalisés, à phase minimale si minimumPhaseLength)
+struct HrtfFlashMeasurement {
+    float azimuth;
+    float elevation;
+    float distance;
+    float itdLeft;   // retard fractionnaire retiré du filtre (phase minimale), en échantillons
+    float itdRight;
+};
+
+struct HrtfFlashBank {
+    uint32_t sampleRate;
+    uint32_t count;               // mesures
+    uint32_t length;              // taps par oreille (au plus MAX_HRIR_LENGTH)
+    uint32_t stride;              // floats entre deux mesures de coeffs (multiple de 8 : 32 octets)
+    uint32_t minimumPhaseLength;  // 0 : HRIR mesurées
+    uint32_t spectrumBlock;       // découpage des spectres (0 : pas de spectres)
+    uint32_t spectrumFloats;      // floats par mesure de spectra
+    const HrtfFlashMeasurement* index;
+    const float* coeffs;          // count x stride floats, taps gauche/droite entrelacés
+    const float* spectra;         // count x spectrumFloats floats (HrtfBank::computeSpectrum), ou nul
+};
+
+// Banque compilée (HRTF_FLASH_BANK), nul sinon : les nœuds chargent alors HRTF_BANK_FILE
+const HrtfFlashBank* hrtfFlashBank();
+
+#endif
@@ -0,0 +1,283 @@
+#include "HrtfKernels.h"
+#include <string.h>
+
+#if defined(HRTF_KERNEL_CMSIS)
+#include <arm_math.h>
+#elif defined(HRTF_KERNEL_X86)
+#include <immintrin.h>
+#elif defined(HRTF_KERNEL_NEON)
+#include <arm_neon.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Référence scalaire
+// ---------------------------------------------------------------------------
+
+static void complexMacScalar(float* acc, const float* x, const float* h, int n) {
+    for (int k = 0; k < n; k++) {
+        const float xr = x[2 * k], xi = x[2 * k + 1];
+        const float hr = h[2 * k], hi = h[2 * k + 1];
+        acc[2 * k]     += xr * hr - xi * hi;
+        acc[2 * k + 1] += xr * hi + xi * hr;
+    }
+}
+
+static void firStereoScalar(const float* x, const float* coeffs, int taps,
+                            float* outLeft, float* outRight, int count, float scale) {
+    for (int n = 0; n < count; n++) {
+        const float* xp = x + n;
+        float l = 0.0f, r = 0.0f;
+        for (int k = 0; k < taps; k++) {
+            l += coeffs[2 * k]     * xp[-k];
+            r += coeffs[2 * k + 1] * xp[-k];
+        }
+        outLeft[n]  = l * scale;
+        outRight[n] = r * scale;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Cortex-M7 : CMSIS-DSP pour les produits complexes, FIR à 4 sorties par itération.
+// Chaque échantillon d'entrée n'est chargé qu'une fois par tap et circule dans les
+// registres ; les 8 accumulateurs permettent au M7 d'enchaîner deux MAC par cycle.
+// ---------------------------------------------------------------------------
+#if defined(HRTF_KERNEL_CMSIS)
+
+static void complexMacCmsis(float* acc, const float* x, const float* h, int n) {
+    float tmp[2 * 64];
+    while (n > 0) {
+        int chunk = (n > 64) ? 64 : n;
+        arm_cmplx_mult_cmplx_f32((float32_t*)x, (float32_t*)h, tmp, chunk);
+        arm_add_f32(acc, tmp, acc, 2 * chunk);
+        acc += 2 * chunk;
+        x += 2 * chunk;
+        h += 2 * chunk;
+        n -= chunk;
+    }
+}
+
+static void firStereoM7(const float* x, const float* coeffs, int taps,
+                        float* outLeft, float* outRight, int count, float scale) {
+    int n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const float* xp = x + n;
+        float l0 = 0.0f, l1 = 0.0f, l2 = 0.0f, l3 = 0.0f;
+        float r0 = 0.0f, r1 = 0.0f, r2 = 0.0f, r3 = 0.0f;
+        float x1 = xp[1], x2 = xp[2], x3 = xp[3];
+        const float* c = coeffs;
+        for (int k = 0; k < taps; k++) {
+            const float x0 = xp[-k];
+            const float hl = c[0], hr = c[1];
+            c += 2;
+            l0 += hl * x0; r0 += hr * x0;
+            l1 += hl * x1; r1 += hr * x1;
+            l2 += hl * x2; r2 += hr * x2;
+            l3 += hl * x3; r3 += hr * x3;
+            x3 = x2;
+            x2 = x1;
+            x1 = x0;
+        }
+        outLeft[n]      = l0 * scale; outRight[n]     = r0 * scale;
+        outLeft[n + 1]  = l1 * scale; outRight[n + 1] = r1 * scale;
+        outLeft[n + 2]  = l2 * scale; outRight[n + 2] = r2 * scale;
+        outLeft[n + 3]  = l3 * scale; outRight[n + 3] = r3 * scale;
+    }
+    if (n < count) {
+        firStereoScalar(x + n, coeffs, taps, outLeft + n, outRight + n, count - n, scale);
+    }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// x86 : SSE (toujours présent sur x86-64) et AVX2/FMA choisi au démarrage
+// ---------------------------------------------------------------------------
+#if defined(HRTF_KERNEL_X86)
+
+static void complexMacSse(float* acc, const float* x, const float* h, int n) {
+    const __m128 sign = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    int k = 0;
+    for (; k + 2 <= n; k += 2) {
+        __m128 a  = _mm_loadu_ps(x + 2 * k);                        // xr0 xi0 xr1 xi1
+        __m128 b  = _mm_loadu_ps(h + 2 * k);                        // hr0 hi0 hr1 hi1
+        __m128 br = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));  // hr0 hr0 hr1 hr1
+        __m128 bi = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));  // hi0 hi0 hi1 hi1
+        __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));  // xi0 xr0 xi1 xr1
+        __m128 p  = _mm_add_ps(_mm_mul_ps(a, br), _mm_mul_ps(_mm_mul_ps(as, bi), sign));
+        _mm_storeu_ps(acc + 2 * k, _mm_add_ps(_mm_loadu_ps(acc + 2 * k), p));
+    }
+    if (k < n) {
+        complexMacScalar(acc + 2 * k, x + 2 * k, h + 2 * k, n - k);
+    }
+}
+
+static void firStereoSse(const float* x, const float* coeffs, int taps,
+                         float* outLeft, float* outRight, int count, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    int n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m128 l = _mm_setzero_ps();
+        __m128 r = _mm_setzero_ps();
+        const float* xp = x + n;
+        for (int k = 0; k < taps; k++) {
+            __m128 xv = _mm_loadu_ps(xp - k);
+            l = _mm_add_ps(l, _mm_mul_ps(_mm_set1_ps(coeffs[2 * k]), xv));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(coeffs[2 * k + 1]), xv));
+        }
+        _mm_storeu_ps(outLeft + n, _mm_mul_ps(l, s));
+        _mm_storeu_ps(outRight + n, _mm_mul_ps(r, s));
+    }
+    if (n < count) {
+        firStereoScalar(x + n, coeffs, taps, outLeft + n, outRight + n, count - n, scale);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void complexMacAvx2(float* acc, const float* x, const float* h, int n) {
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256 a  = _mm256_loadu_ps(x + 2 * k);
+        __m256 b  = _mm256_loadu_ps(h + 2 * k);
+        __m256 br = _mm256_moveldup_ps(b);          // hr hr
+        __m256 bi = _mm256_movehdup_ps(b);          // hi hi
+        __m256 as = _mm256_permute_ps(a, 0xB1);     // xi xr
+        // pairs : xr*hr - xi*hi, impairs : xi*hr + xr*hi
+        __m256 p  = _mm256_fmaddsub_ps(a, br, _mm256_mul_ps(as, bi));
+        _mm256_storeu_ps(acc + 2 * k, _mm256_add_ps(_mm256_loadu_ps(acc + 2 * k), p));
+    }
+    if (k < n) {
+        complexMacSse(acc + 2 * k, x + 2 * k, h + 2 * k, n - k);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void firStereoAvx2(const float* x, const float* coeffs, int taps,
+                          float* outLeft, float* outRight, int count, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    int n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256 l = _mm256_setzero_ps();
+        __m256 r = _mm256_setzero_ps();
+        const float* xp = x + n;
+        for (int k = 0; k < taps; k++) {
+            __m256 xv = _mm256_loadu_ps(xp - k);
+            l = _mm256_fmadd_ps(_mm256_set1_ps(coeffs[2 * k]), xv, l);
+            r = _mm256_fmadd_ps(_mm256_set1_ps(coeffs[2 * k + 1]), xv, r);
+        }
+        _mm256_storeu_ps(outLeft + n, _mm256_mul_ps(l, s));
+        _mm256_storeu_ps(outRight + n, _mm256_mul_ps(r, s));
+    }
+    if (n < count) {
+        firStereoSse(x + n, coeffs, taps, outLeft + n, outRight + n, count - n, scale);
+    }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// NEON (hôte ARM)
+// ---------------------------------------------------------------------------
+#if defined(HRTF_KERNEL_NEON)
+
+static void complexMacNeon(float* acc, const float* x, const float* h, int n) {
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+        float32x4x2_t a = vld2q_f32(x + 2 * k);
+        float32x4x2_t b = vld2q_f32(h + 2 * k);
+        float32x4x2_t c = vld2q_f32(acc + 2 * k);
+        c.val[0] = vmlaq_f32(c.val[0], a.val[0], b.val[0]);
+        c.val[0] = vmlsq_f32(c.val[0], a.val[1], b.val[1]);
+        c.val[1] = vmlaq_f32(c.val[1], a.val[0], b.val[1]);
+        c.val[1] = vmlaq_f32(c.val[1], a.val[1], b.val[0]);
+        vst2q_f32(acc + 2 * k, c);
+    }
+    if (k < n) {
+        complexMacScalar(acc + 2 * k, x + 2 * k, h + 2 * k, n - k);
+    }
+}
+
+static void firStereoNeon(const float* x, const float* coeffs, int taps,
+                          float* outLeft, float* outRight, int count, float scale) {
+    int n = 0;
+    for (; n + 4 <= count; n += 4) {
+        float32x4_t l = vdupq_n_f32(0.0f);
+        float32x4_t r = vdupq_n_f32(0.0f);
+        const float* xp = x + n;
+        for (int k = 0; k < taps; k++) {
+            float32x4_t xv = vld1q_f32(xp - k);
+            l = vmlaq_n_f32(l, xv, coeffs[2 * k]);
+            r = vmlaq_n_f32(r, xv, coeffs[2 * k + 1]);
+        }
+        vst1q_f32(outLeft + n, vmulq_n_f32(l, scale));
+        vst1q_f32(outRight + n, vmulq_n_f32(r, scale));
+    }
+    if (n < count) {
+        firStereoScalar(x + n, coeffs, taps, outLeft + n, outRight + n, count - n, scale);
+    }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Table des jeux disponibles, du plus simple au plus rapide
+// ---------------------------------------------------------------------------
+
+static const HrtfKernelSet kernelSets[] = {
+    { "scalar", complexMacScalar, firStereoScalar },
+#if defined(HRTF_KERNEL_CMSIS)
+    { "cmsis-m7", complexMacCmsis, firStereoM7 },
+#elif defined(HRTF_KERNEL_X86)
+    { "sse", complexMacSse, firStereoSse },
+    { "avx2", complexMacAvx2, firStereoAvx2 },
+#elif defined(HRTF_KERNEL_NEON)
+    { "neon", complexMacNeon, firStereoNeon },
+#endif
+};
+
+static const int kernelSetCount = sizeof(kernelSets) / sizeof(kernelSets[0]);
+
+static const HrtfKernelSet* defaultKernels() {
+#if defined(HRTF_KERNEL_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &kernelSets[2];
+    }
+#endif
+    return &kernelSets[kernelSetCount - 1];
+}
+
+static const HrtfKernelSet* activeKernels = nullptr;
+
+const HrtfKernelSet& hrtfKernels() {
+    if (!activeKernels) {
+        activeKernels = defaultKernels();
+    }
+    return *activeKernels;
+}
+
+int hrtfKernelSetCount() {
+#if defined(HRTF_KERNEL_X86)
+    // AVX2 n'est proposé que si le CPU le supporte
+    if (defaultKernels() != &kernelSets[2]) {
+        return kernelSetCount - 1;
+    }
+#endif
+    return kernelSetCount;
+}
+
+const HrtfKernelSet& hrtfKernelSet(int index) {
+    if (index < 0 || index >= hrtfKernelSetCount()) {
+        return hrtfKernels();
+    }
+    return kernelSets[index];
+}
+
+bool hrtfSelectKernels(const char* name) {
+    for (int i = 0; i < hrtfKernelSetCount(); i++) {
+        if (strcmp(kernelSets[i].name, name) == 0) {
+            activeKernels = &kernelSets[i];
+            return true;
+        }
+    }
+    return false;
+}
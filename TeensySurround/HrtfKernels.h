@@ -0,0 +1,38 @@
+#ifndef HRTF_KERNELS_H
+#define HRTF_KERNELS_H
+
+#include <stddef.h>
+
+// Noyaux de calcul de la convolution HRTF.
+// Une implémentation scalaire de référence est toujours disponible ; la version
+// vectorielle est choisie à la compilation selon la cible :
+//   - Teensy 4.x (Cortex-M7) : CMSIS-DSP + boucle FIR déroulée pour le double issue du M7
+//   - hôte x86 : SSE et AVX2/FMA, choisis au démarrage selon le CPU
+//   - hôte ARM : NEON
+#if defined(__IMXRT1062__)
+#define HRTF_KERNEL_CMSIS 1
+#elif defined(__x86_64__) || defined(__i386__)
+#define HRTF_KERNEL_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HRTF_KERNEL_NEON 1
+#endif
+
+struct HrtfKernelSet {
+    const char* name;
+    // acc[k] += x[k] * h[k] sur n valeurs complexes entrelacées
+    void (*complexMac)(float* acc, const float* x, const float* h, int n);
+    // Convolution directe des deux oreilles en une passe.
+    // coeffs : taps gauche/droite entrelacés ; x[n - k] doit être valide pour k < taps.
+    void (*firStereo)(const float* x, const float* coeffs, int taps,
+                      float* outLeft, float* outRight, int count, float scale);
+};
+
+// Jeu de noyaux actif (le plus rapide disponible par défaut)
+const HrtfKernelSet& hrtfKernels();
+
+// Énumération et sélection, pour le banc d'essai et la comparaison
+int hrtfKernelSetCount();
+const HrtfKernelSet& hrtfKernelSet(int index);
+bool hrtfSelectKernels(const char* name);
+
+#endif
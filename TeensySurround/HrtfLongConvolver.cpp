@@ -0,0 +1,303 @@
+#include "HrtfLongConvolver.h"
+#include "HrtfMemory.h"
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+
+HrtfLongConvolver::HrtfLongConvolver()
+: blockSize(128), headLength(0), levelCount(0),
+  history(nullptr), historySize(0), historyPos(0)
+{
+    for (int k = 0; k < MAX_LEVELS; k++) {
+        levels[k].partitions = 0;
+        levels[k].fdl = nullptr;
+        levels[k].acc = nullptr;
+        levels[k].out = nullptr;
+    }
+}
+
+HrtfLongConvolver::~HrtfLongConvolver() {
+    for (int k = 0; k < MAX_LEVELS; k++) {
+        hrtfRelease(levels[k].fdl);
+        hrtfRelease(levels[k].acc);
+        hrtfRelease(levels[k].out);
+    }
+    hrtfRelease(history);
+}
+
+void HrtfLongConvolver::init(int bSize, size_t head) {
+    blockSize = bSize;
+    headLength = head;
+    // Le découpage change : l'état existant n'est plus valide
+    for (int k = 0; k < MAX_LEVELS; k++) {
+        hrtfRelease(levels[k].fdl);
+        hrtfRelease(levels[k].acc);
+        hrtfRelease(levels[k].out);
+        levels[k].fdl = nullptr;
+        levels[k].acc = nullptr;
+        levels[k].out = nullptr;
+        levels[k].partitions = 0;
+    }
+    levelCount = 0;
+    hrtfRelease(history);
+    history = nullptr;
+    historySize = 0;
+    historyPos = 0;
+}
+
+int HrtfLongConvolver::levelSize(int k) const {
+    int cap = (blockSize > MAX_PARTITION_SIZE) ? blockSize : MAX_PARTITION_SIZE;
+    int size = blockSize;
+    for (int j = 0; j < k && size < cap; j++) {
+        size <<= 1;
+    }
+    return (size > cap) ? cap : size;
+}
+
+bool HrtfLongConvolver::isLastLevel(int k) const {
+    int cap = (blockSize > MAX_PARTITION_SIZE) ? blockSize : MAX_PARTITION_SIZE;
+    return k == MAX_LEVELS - 1 || levelSize(k) >= cap;
+}
+
+size_t HrtfLongConvolver::levelOffset(int k) const {
+    size_t offset = headLength;
+    for (int j = 0; j < k; j++) {
+        offset += (size_t)PARTITIONS_PER_LEVEL * levelSize(j);
+    }
+    return offset;
+}
+
+int HrtfLongConvolver::partitionsFor(int k, size_t length) const {
+    size_t offset = levelOffset(k);
+    if (length <= offset) {
+        return 0;
+    }
+    size_t M = levelSize(k);
+    size_t parts = (length - offset + M - 1) / M;
+    if (!isLastLevel(k) && parts > (size_t)PARTITIONS_PER_LEVEL) {
+        parts = PARTITIONS_PER_LEVEL;
+    }
+    return (int)parts;
+}
+
+size_t HrtfLongConvolver::spectrumSize(size_t length) const {
+    size_t total = 0;
+    for (int k = 0; k < MAX_LEVELS; k++) {
+        int parts = partitionsFor(k, length);
+        if (parts == 0) {
+            break;
+        }
+        total += (size_t)parts * 4 * levelSize(k);
+        if (isLastLevel(k)) {
+            break;
+        }
+    }
+    return total;
+}
+
+bool HrtfLongConvolver::reserve(size_t maxLength) {
+    size_t historyNeeded = 0;
+    size_t specOffset = 0;
+    int count = 0;
+    for (int k = 0; k < MAX_LEVELS; k++) {
+        int parts = partitionsFor(k, maxLength);
+        if (parts == 0) {
+            break;
+        }
+        Level& lvl = levels[k];
+        const int M = levelSize(k);
+        if (lvl.partitions < parts) {
+            hrtfRelease(lvl.fdl);
+            hrtfRelease(lvl.acc);
+            hrtfRelease(lvl.out);
+            lvl.partitions = 0;
+            lvl.fdl = (float*)hrtfAllocate((size_t)parts * 4 * M * sizeof(float));
+            lvl.acc = (float*)hrtfAllocate((size_t)4 * M * sizeof(float));
+            lvl.out = (float*)hrtfAllocate((size_t)2 * M * sizeof(float));
+            if (!lvl.fdl || !lvl.acc || !lvl.out || !lvl.fft.init(2 * M)) {
+                return false;
+            }
+            lvl.partitions = parts;
+        }
+        lvl.size = M;
+        lvl.offset = levelOffset(k);
+        lvl.delay = lvl.offset - (M - blockSize);
+        lvl.specOffset = specOffset;
+        specOffset += (size_t)PARTITIONS_PER_LEVEL * 4 * M;
+
+        size_t span = lvl.delay + 2 * M + blockSize;
+        if (span > historyNeeded) {
+            historyNeeded = span;
+        }
+        count = k + 1;
+        if (isLastLevel(k)) {
+            break;
+        }
+    }
+    if (count > levelCount) {
+        levelCount = count;
+    }
+
+    size_t size = 1;
+    while (size < historyNeeded) {
+        size <<= 1;
+    }
+    if (size > historySize) {
+        hrtfRelease(history);
+        historySize = 0;
+        history = (float*)hrtfAllocate(size * sizeof(float));
+        if (!history) {
+            levelCount = 0;
+            return false;
+        }
+        historySize = size;
+    }
+    reset();
+    return true;
+}
+
+void HrtfLongConvolver::reset() {
+    if (history) {
+        memset(history, 0, historySize * sizeof(float));
+    }
+    historyPos = 0;
+    for (int k = 0; k < levelCount; k++) {
+        Level& lvl = levels[k];
+        memset(lvl.fdl, 0, (size_t)lvl.partitions * 4 * lvl.size * sizeof(float));
+        memset(lvl.acc, 0, (size_t)4 * lvl.size * sizeof(float));
+        memset(lvl.out, 0, (size_t)2 * lvl.size * sizeof(float));
+        lvl.fdlPos = 0;
+        lvl.phase = 0;
+        lvl.nextPartition = 1;
+        lvl.accUsed = false;
+    }
+}
+
+void HrtfLongConvolver::computeSpectrum(const float* left, const float* right, size_t length,
+                                        float* spectrum) {
+    size_t pos = 0;
+    for (int k = 0; k < MAX_LEVELS; k++) {
+        int parts = partitionsFor(k, length);
+        if (parts == 0) {
+            break;
+        }
+        const int M = levelSize(k);
+        HrtfFft fft;
+        if (!fft.init(2 * M)) {
+            return;
+        }
+        size_t offset = levelOffset(k);
+        for (int p = 0; p < parts; p++) {
+            // Partition de M taps complétée par M zéros, gauche + j*droite
+            float* spec = spectrum + pos;
+            memset(spec, 0, (size_t)4 * M * sizeof(float));
+            for (int i = 0; i < M; i++) {
+                size_t idx = offset + (size_t)p * M + i;
+                if (idx < length) {
+                    spec[2 * i]     = left[idx];
+                    spec[2 * i + 1] = right[idx];
+                }
+            }
+            fft.forward(spec);
+            pos += (size_t)4 * M;
+        }
+        if (isLastLevel(k)) {
+            break;
+        }
+    }
+}
+
+void HrtfLongConvolver::runLevel(Level& lvl, const float* spectrum, int parts) {
+    const int M = lvl.size;
+    const int N = 2 * M;
+    const size_t mask = historySize - 1;
+
+    // Segment d'entrée x[T - delay - 2M, T - delay), T = instant courant
+    size_t start = (historyPos + historySize - ((lvl.delay + N) & mask)) & mask;
+    lvl.fdlPos = (lvl.fdlPos == 0) ? lvl.partitions - 1 : lvl.fdlPos - 1;
+    float* X = lvl.fdl + (size_t)lvl.fdlPos * 2 * N;
+    for (int i = 0; i < N; i++) {
+        X[2 * i]     = history[(start + i) & mask];
+        X[2 * i + 1] = 0.0f;
+    }
+    lvl.fft.forward(X);
+
+    if (parts > 0) {
+        hrtfKernels().complexMac(lvl.acc, X, spectrum, N);
+        lvl.accUsed = true;
+    }
+    if (lvl.accUsed) {
+        lvl.fft.inverse(lvl.acc);
+        const float norm = lvl.fft.inverseNorm();
+        for (int i = 0; i < 2 * M; i++) {
+            lvl.out[i] = lvl.acc[2 * M + i] * norm;
+        }
+        memset(lvl.acc, 0, (size_t)2 * N * sizeof(float));
+        lvl.accUsed = false;
+    } else {
+        memset(lvl.out, 0, (size_t)2 * M * sizeof(float));
+    }
+    lvl.nextPartition = 1;
+}
+
+void HrtfLongConvolver::preAccumulate(Level& lvl, const float* spectrum, int parts) {
+    // Les partitions p >= 1 du prochain passage n'utilisent que des spectres déjà connus :
+    // elles sont réparties sur les blocs de la période pour lisser la charge.
+    if (parts <= 1) {
+        return;
+    }
+    const int N = 2 * lvl.size;
+    const int period = lvl.size / blockSize;
+    int target = 1 + ((parts - 1) * (lvl.phase + 1) + period - 1) / period;
+    if (target > parts) {
+        target = parts;
+    }
+    for (int p = lvl.nextPartition; p < target; p++) {
+        int slot = lvl.fdlPos + p - 1;
+        if (slot >= lvl.partitions) {
+            slot -= lvl.partitions;
+        }
+        hrtfKernels().complexMac(lvl.acc, lvl.fdl + (size_t)slot * 2 * N,
+                                 spectrum + (size_t)p * 2 * N, N);
+        lvl.accUsed = true;
+    }
+    if (target > lvl.nextPartition) {
+        lvl.nextPartition = target;
+    }
+}
+
+void HrtfLongConvolver::process(const float* in, const float* spectrum, size_t length,
+                                float* outLeft, float* outRight, float scale) {
+    if (levelCount == 0) {
+        return;
+    }
+    const size_t mask = historySize - 1;
+    for (int n = 0; n < blockSize; n++) {
+        history[(historyPos + n) & mask] = in[n];
+    }
+    historyPos = (historyPos + blockSize) & mask;
+
+    for (int k = 0; k < levelCount; k++) {
+        Level& lvl = levels[k];
+        int parts = spectrum ? partitionsFor(k, length) : 0;
+        if (parts > lvl.partitions) {
+            parts = lvl.partitions;
+        }
+        const float* spec = (parts > 0) ? spectrum + lvl.specOffset : nullptr;
+
+        if (lvl.phase == 0) {
+            runLevel(lvl, spec, parts);
+        }
+        const float* o = lvl.out + (size_t)2 * lvl.phase * blockSize;
+        for (int n = 0; n < blockSize; n++) {
+            outLeft[n]  += o[2 * n] * scale;
+            outRight[n] += o[2 * n + 1] * scale;
+        }
+        preAccumulate(lvl, spec, parts);
+
+        lvl.phase++;
+        if (lvl.phase * blockSize >= lvl.size) {
+            lvl.phase = 0;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef HRTF_LONG_CONVOLVER_H
+#define HRTF_LONG_CONVOLVER_H
+
+#include <stddef.h>
+#include "HrtfFft.h"
+
+// Convolution partitionnée non uniforme pour la queue des réponses longues (BRIR).
+// La tête (les headLength premiers taps) reste traitée par HrtfVoice sans latence ;
+// la queue est découpée en niveaux de partitions de plus en plus grandes :
+//   taille blockSize, 2*blockSize, ... jusqu'à MAX_PARTITION_SIZE.
+// Chaque niveau respecte offset >= taille - blockSize : son entrée est simplement
+// retardée de offset - (taille - blockSize) et sa sortie arrive à temps, sans latence ajoutée.
+// Les niveaux non plafonnés ont PARTITIONS_PER_LEVEL partitions, le dernier autant que
+// nécessaire. Le découpage d'une réponse courte est donc un préfixe de celui d'une réponse
+// longue : les slots d'une même banque peuvent avoir des longueurs différentes.
+class HrtfLongConvolver {
+public:
+    static const int MAX_LEVELS = 8;
+    static const int MAX_PARTITION_SIZE = 2048;
+    static const int PARTITIONS_PER_LEVEL = 2;
+
+    HrtfLongConvolver();
+    ~HrtfLongConvolver();
+
+    void init(int blockSize, size_t headLength);
+
+    // Taille (en floats) des spectres de queue d'une réponse de 'length' taps (0 si pas de queue)
+    size_t spectrumSize(size_t length) const;
+
+    // Alloue l'état pour des réponses jusqu'à maxLength taps (hors interruption audio)
+    bool reserve(size_t maxLength);
+    bool active() const { return levelCount > 0; }
+
+    // Spectres des partitions de queue ; left/right contiennent la réponse complète
+    void computeSpectrum(const float* left, const float* right, size_t length,
+                         float* spectrum);
+
+    // Ajoute la contribution de la queue à outLeft/outRight. spectrum peut être nul :
+    // l'historique est tout de même mis à jour pour une sélection ultérieure.
+    void process(const float* in, const float* spectrum, size_t length,
+                 float* outLeft, float* outRight, float scale);
+
+    void reset();
+
+private:
+    HrtfLongConvolver(const HrtfLongConvolver&);
+    HrtfLongConvolver& operator=(const HrtfLongConvolver&);
+
+    struct Level {
+        int size;           // taille M d'une partition (multiple de blockSize)
+        int partitions;     // partitions allouées
+        size_t offset;      // premier tap couvert
+        size_t delay;       // retard d'entrée = offset - (M - blockSize)
+        size_t specOffset;  // position du niveau dans le spectre d'un slot (en floats)
+        HrtfFft fft;        // FFT de taille 2M
+        float* fdl;         // spectres d'entrée passés (partitions * 2M complexes)
+        float* acc;         // 2M complexes : partitions >= 1 accumulées à l'avance
+        float* out;         // M complexes (gauche + j*droite), lus par tranches de blockSize
+        int fdlPos;
+        int phase;          // bloc courant dans la période M / blockSize
+        int nextPartition;  // prochaine partition à pré-accumuler
+        bool accUsed;       // acc contient au moins un produit
+    };
+
+    int levelSize(int k) const;
+    bool isLastLevel(int k) const;
+    size_t levelOffset(int k) const;
+    int partitionsFor(int k, size_t length) const;
+    void runLevel(Level& lvl, const float* spectrum, int parts);
+    void preAccumulate(Level& lvl, const float* spectrum, int parts);
+
+    int blockSize;
+    size_t headLength;
+    Level levels[MAX_LEVELS];
+    int levelCount;
+
+    float* history;       // tampon circulaire de l'entrée
+    size_t historySize;   // puissance de 2
+    size_t historyPos;    // index du prochain échantillon écrit
+};
+
+#endif
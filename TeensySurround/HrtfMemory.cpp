@@ -0,0 +1,25 @@
+#include "HrtfMemory.h"
+#include <Arduino.h>
+#include <stdlib.h>
+
+#if defined(ARDUINO_TEENSY41)
+extern "C" void* extmem_malloc(size_t size);
+extern "C" void extmem_free(void* ptr);
+#endif
+
+void* hrtfAllocate(size_t bytes) {
+#if defined(ARDUINO_TEENSY41)
+    // extmem_malloc retombe sur malloc si aucune PSRAM n'est soudée
+    return extmem_malloc(bytes);
+#else
+    return malloc(bytes);
+#endif
+}
+
+void hrtfRelease(void* ptr) {
+#if defined(ARDUINO_TEENSY41)
+    extmem_free(ptr);
+#else
+    free(ptr);
+#endif
+}
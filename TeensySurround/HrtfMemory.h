@@ -0,0 +1,12 @@
+#ifndef HRTF_MEMORY_H
+#define HRTF_MEMORY_H
+
+#include <stddef.h>
+
+// Allocation des gros buffers du rendu (queues des BRIR, pages de la banque compacte, poids
+// PCA, cache de HRIR) : PSRAM si présente sur Teensy 4.1, RAM sinon. Libérés par hrtfRelease
+// (nul accepté).
+void* hrtfAllocate(size_t bytes);
+void hrtfRelease(void* ptr);
+
+#endif
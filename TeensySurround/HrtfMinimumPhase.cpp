@@ -0,0 +1,96 @@
+#include "HrtfMinimumPhase.h"
+#include "HrtfFft.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Taille de FFT du cepstre : assez grande devant la réponse pour limiter le repliement
+static const int MINIMUM_PHASE_FFT_SIZE = 1024;
+
+bool hrtfMinimumPhase(const float* in, size_t length, float* out, size_t outLength) {
+    const int N = MINIMUM_PHASE_FFT_SIZE;
+    if (length > (size_t)N / 2) {
+        length = N / 2;
+    }
+    HrtfFft fft;
+    float* work = (float*)malloc(2 * N * sizeof(float));
+    if (!work || !fft.init(N)) {
+        free(work);
+        return false;
+    }
+
+    // log |H| (plancher à -180 dB pour les zéros du spectre)
+    memset(work, 0, 2 * N * sizeof(float));
+    for (size_t i = 0; i < length; i++) {
+        work[2 * i] = in[i];
+    }
+    fft.forward(work);
+    for (int k = 0; k < N; k++) {
+        float mag2 = work[2 * k] * work[2 * k] + work[2 * k + 1] * work[2 * k + 1];
+        work[2 * k]     = 0.5f * logf(mag2 > 1e-18f ? mag2 : 1e-18f);
+        work[2 * k + 1] = 0.0f;
+    }
+
+    // Cepstre réel, replié sur les quéfrences positives : c[0], 2c[n], c[N/2], 0
+    fft.inverse(work);
+    const float norm = fft.inverseNorm();
+    for (int n = 0; n < N; n++) {
+        float c = work[2 * n] * norm;
+        if (n > 0 && n < N / 2) {
+            c *= 2.0f;
+        } else if (n > N / 2) {
+            c = 0.0f;
+        }
+        work[2 * n]     = c;
+        work[2 * n + 1] = 0.0f;
+    }
+
+    // Spectre à phase minimale exp(FFT(c)), puis retour dans le temps
+    fft.forward(work);
+    for (int k = 0; k < N; k++) {
+        float a = expf(work[2 * k]);
+        float phi = work[2 * k + 1];
+        work[2 * k]     = a * cosf(phi);
+        work[2 * k + 1] = a * sinf(phi);
+    }
+    fft.inverse(work);
+
+    // Troncature avec une demi-fenêtre de Hann sur le dernier quart pour éviter une coupure nette
+    const size_t fade = (outLength >= 4) ? outLength / 4 : 0;
+    for (size_t i = 0; i < outLength; i++) {
+        float v = (i < (size_t)N) ? work[2 * i] * norm : 0.0f;
+        if (fade > 0 && i >= outLength - fade) {
+            float t = (float)(i - (outLength - fade) + 1) / (float)(fade + 1);
+            v *= 0.5f + 0.5f * cosf(3.14159265f * t);
+        }
+        out[i] = v;
+    }
+    free(work);
+    return true;
+}
+
+float hrtfOnset(const float* h, size_t length, size_t stride, float threshold) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        float a = fabsf(h[i * stride]);
+        if (a > peak) {
+            peak = a;
+        }
+    }
+    if (peak <= 0.0f) {
+        return 0.0f;
+    }
+    const float level = threshold * peak;
+    float prev = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        float a = fabsf(h[i * stride]);
+        if (a >= level) {
+            if (i == 0) {
+                return 0.0f;
+            }
+            return (float)(i - 1) + (level - prev) / (a - prev);
+        }
+        prev = a;
+    }
+    return 0.0f;
+}
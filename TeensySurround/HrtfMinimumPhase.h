@@ -0,0 +1,18 @@
+#ifndef HRTF_MINIMUM_PHASE_H
+#define HRTF_MINIMUM_PHASE_H
+
+#include <stddef.h>
+
+// Décomposition d'une HRIR en filtre à phase minimale + retard pur (au chargement).
+// La phase minimale concentre l'énergie dans les premiers taps : la réponse peut être
+// tronquée à 32 ou 48 taps, le retard interaural étant appliqué à part (HrtfDelayLine).
+
+// Réponse à phase minimale de même module que in (cepstre réel replié), tronquée à
+// outLength taps avec une demi-fenêtre de Hann sur le dernier quart. false si mémoire insuffisante.
+bool hrtfMinimumPhase(const float* in, size_t length, float* out, size_t outLength);
+
+// Instant d'arrivée (en échantillons, fractionnaire) : premier passage de |h| au-dessus
+// de threshold * max|h|, interpolé linéairement entre les deux échantillons encadrants.
+float hrtfOnset(const float* h, size_t length, size_t stride, float threshold = 0.2f);
+
+#endif
@@ -0,0 +1,128 @@
+#include "HrtfMixer.h"
+#include <string.h>
+#include <stdlib.h>
+
+HrtfMixer::HrtfMixer()
+: bank(nullptr), sourceCount(0), blockSize(0), interpolation(false), fftSize(0),
+  spectrumAcc(nullptr), voiceLeft(nullptr), voiceRight(nullptr), silence(nullptr)
+{
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        sources[i].azimuth = 0;
+        sources[i].elevation = 0;
+        sources[i].gain = 1.0f;
+    }
+}
+
+HrtfMixer::~HrtfMixer() {
+    free(spectrumAcc);
+    free(voiceLeft);
+    free(voiceRight);
+    free(silence);
+}
+
+bool HrtfMixer::init(const HrtfBank& b, int count) {
+    bank = &b;
+    sourceCount = (count < 0) ? 0 : (count > MAX_SOURCES ? MAX_SOURCES : count);
+    blockSize = b.getBlockSize();
+
+    bool ok = true;
+    for (int i = 0; i < sourceCount; i++) {
+        voices[i].setInterpolation(interpolation);
+        ok = voices[i].init(b) && ok;
+    }
+
+    free(spectrumAcc);
+    free(voiceLeft);
+    free(voiceRight);
+    free(silence);
+    spectrumAcc = nullptr;
+    fftSize = 0;
+    voiceLeft  = (float*)malloc(blockSize * sizeof(float));
+    voiceRight = (float*)malloc(blockSize * sizeof(float));
+    silence    = (float*)calloc(blockSize, sizeof(float));
+    if (!voiceLeft || !voiceRight || !silence) {
+        return false;
+    }
+    // Sans IFFT commune, chaque voix est rendue avec processBlock
+    if (b.getFftSize() > 0 && fft.init(b.getFftSize())) {
+        spectrumAcc = (float*)malloc(2 * b.getFftSize() * sizeof(float));
+        if (spectrumAcc) {
+            fftSize = b.getFftSize();
+        }
+    }
+    return ok;
+}
+
+void HrtfMixer::setSource(int index, int azimuthDeg, int elevationDeg, float gain) {
+    if (index < 0 || index >= MAX_SOURCES) {
+        return;
+    }
+    // Normaliser l'azimut dans [0,359]
+    azimuthDeg = (azimuthDeg % 360 + 360) % 360;
+    sources[index].azimuth = azimuthDeg;
+    sources[index].elevation = elevationDeg;
+    sources[index].gain = gain;
+}
+
+void HrtfMixer::setConvolutionMode(HrtfConvolutionMode mode) {
+    for (int i = 0; i < sourceCount; i++) {
+        voices[i].setConvolutionMode(mode);
+    }
+}
+
+void HrtfMixer::setSwitchMode(HrtfSwitchMode mode) {
+    for (int i = 0; i < sourceCount; i++) {
+        voices[i].setSwitchMode(mode);
+    }
+}
+
+bool HrtfMixer::setInterpolation(bool enabled) {
+    interpolation = enabled;
+    bool ok = true;
+    for (int i = 0; i < sourceCount; i++) {
+        ok = voices[i].setInterpolation(enabled) && ok;
+    }
+    return ok;
+}
+
+void HrtfMixer::process(const float* const* inputs, float* outLeft, float* outRight) {
+    const int B = blockSize;
+    memset(outLeft, 0, B * sizeof(float));
+    memset(outRight, 0, B * sizeof(float));
+    if (!bank || !silence) {
+        return;
+    }
+    if (spectrumAcc) {
+        memset(spectrumAcc, 0, 2 * fftSize * sizeof(float));
+    }
+
+    bool spectral = false;
+    for (int i = 0; i < sourceCount; i++) {
+        // Une source muette fait tout de même avancer son historique
+        const float* in = inputs[i] ? inputs[i] : silence;
+        const Source& src = sources[i];
+        SelectedHrir sel = interpolation
+            ? voices[i].interpolate((float)src.azimuth, (float)src.elevation)
+            : voices[i].select(src.azimuth, src.elevation);
+        if (spectrumAcc &&
+            voices[i].accumulateBlock(in, spectrumAcc, outLeft, outRight, sel, src.gain)) {
+            spectral = true;
+            continue;
+        }
+        voices[i].processBlock(in, voiceLeft, voiceRight, sel, src.gain);
+        for (int n = 0; n < B; n++) {
+            outLeft[n]  += voiceLeft[n];
+            outRight[n] += voiceRight[n];
+        }
+    }
+
+    // Une seule IFFT pour toutes les sources ; overlap-save : les B derniers échantillons
+    if (spectral) {
+        fft.inverse(spectrumAcc);
+        const float s = fft.inverseNorm();
+        for (int n = 0; n < B; n++) {
+            outLeft[n]  += spectrumAcc[2 * (B + n)] * s;
+            outRight[n] += spectrumAcc[2 * (B + n) + 1] * s;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef HRTF_MIXER_H
+#define HRTF_MIXER_H
+
+#include <stddef.h>
+#include "HrtfBank.h"
+#include "HrtfVoice.h"
+#include "HrtfFft.h"
+
+// Rendu de plusieurs sources mono vers une seule paire binaurale.
+// Chaque source a sa voix (FFT d'entrée, ligne à retard, fondu) mais les spectres de sortie
+// sont sommés avant une unique IFFT (gauche + j*droite) : le coût de la transformée inverse
+// ne dépend pas du nombre de sources. Les voix hors mode FFT sont rendues séparément.
+class HrtfMixer {
+public:
+    static const int MAX_SOURCES = 16;
+
+    HrtfMixer();
+    ~HrtfMixer();
+
+    // Alloue sourceCount voix sur la banque (hors interruption audio)
+    bool init(const HrtfBank& bank, int sourceCount);
+    int getSourceCount() const { return sourceCount; }
+
+    // Position et gain d'une source (azimut/élévation en degrés)
+    void setSource(int index, int azimuthDeg, int elevationDeg, float gain);
+    int getAzimuth(int index) const { return sources[index].azimuth; }
+    int getElevation(int index) const { return sources[index].elevation; }
+    float getGain(int index) const { return sources[index].gain; }
+
+    // inputs[i] : bloc de la source i, ou nul pour une source muette
+    void process(const float* const* inputs, float* outLeft, float* outRight);
+
+    // Appliqués à toutes les voix
+    void setConvolutionMode(HrtfConvolutionMode mode);
+    void setSwitchMode(HrtfSwitchMode mode);
+    // Filtres interpolés entre les mesures voisines (alloue les buffers : hors interruption)
+    bool setInterpolation(bool enabled);
+    bool getInterpolation() const { return interpolation; }
+
+private:
+    HrtfMixer(const HrtfMixer&);
+    HrtfMixer& operator=(const HrtfMixer&);
+
+    struct Source {
+        int azimuth;
+        int elevation;
+        float gain;
+    };
+
+    const HrtfBank* bank;
+    int sourceCount;
+    int blockSize;
+    bool interpolation;
+    Source sources[MAX_SOURCES];
+    HrtfVoice voices[MAX_SOURCES];
+
+    HrtfFft fft;          // IFFT commune
+    int fftSize;
+    float* spectrumAcc;   // somme des spectres de sortie (fftSize complexes)
+    float* voiceLeft;     // sortie d'une voix rendue séparément
+    float* voiceRight;
+    float* silence;       // entrée des sources muettes
+};
+
+#endif
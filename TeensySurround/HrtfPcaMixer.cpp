@@ -0,0 +1,252 @@
+#include "HrtfPcaMixer.h"
+#include "HrtfKernels.h"
+#include <string.h>
+#include <stdlib.h>
+
+HrtfPcaMixer::HrtfPcaMixer()
+: bank(nullptr), sourceCount(0), blockSize(0), filterCount(0), withItd(false),
+  fftSize(0), partitionCount(0), filters(nullptr), bus(nullptr), fdl(nullptr), fdlPos(0),
+  mirror(nullptr), spectrumAcc(nullptr), earLeft(nullptr), earRight(nullptr)
+{
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        sources[i].azimuth = 0;
+        sources[i].elevation = 0;
+        sources[i].gain = 1.0f;
+        sources[i].hint = -1;
+        memset(sources[i].target, 0, sizeof(sources[i].target));
+        memset(sources[i].current, 0, sizeof(sources[i].current));
+        sources[i].itdLeft = 0.0f;
+        sources[i].itdRight = 0.0f;
+    }
+}
+
+HrtfPcaMixer::~HrtfPcaMixer() {
+    release();
+}
+
+void HrtfPcaMixer::release() {
+    free(filters);
+    free(bus);
+    free(fdl);
+    free(mirror);
+    free(spectrumAcc);
+    free(earLeft);
+    free(earRight);
+    filters = nullptr;
+    bus = nullptr;
+    fdl = nullptr;
+    mirror = nullptr;
+    spectrumAcc = nullptr;
+    earLeft = nullptr;
+    earRight = nullptr;
+    filterCount = 0;
+}
+
+bool HrtfPcaMixer::init(const HrtfBank& b, int count) {
+    bank = &b;
+    sourceCount = (count < 0) ? 0 : (count > MAX_SOURCES ? MAX_SOURCES : count);
+    blockSize = b.getBlockSize();
+    release();
+    if (b.getPcaLength() == 0 || b.getFftSize() == 0 || !fft.init(b.getFftSize())) {
+        return false;
+    }
+    fftSize = b.getFftSize();
+    partitionCount = b.getPartitionCount();
+    withItd = b.getMinimumPhaseLength() > 0;
+    const int K = (b.getPcaComponents() > MAX_COMPONENTS) ? MAX_COMPONENTS : b.getPcaComponents();
+    const int F = K + 1;
+    const size_t spec = 2 * (size_t)fftSize;
+
+    filters = (float*)malloc((size_t)F * partitionCount * 2 * spec * sizeof(float));
+    bus = (float*)calloc((size_t)F * spec, sizeof(float));
+    fdl = (float*)calloc((size_t)F * partitionCount * spec, sizeof(float));
+    mirror = (float*)malloc(spec * sizeof(float));
+    spectrumAcc = (float*)malloc(spec * sizeof(float));
+    earLeft = (float*)malloc(blockSize * sizeof(float));
+    earRight = (float*)malloc(blockSize * sizeof(float));
+    float* packed = (float*)malloc(b.getSpectrumSize() * sizeof(float));
+    if (!filters || !bus || !fdl || !mirror || !spectrumAcc || !earLeft || !earRight || !packed) {
+        free(packed);
+        release();
+        return false;
+    }
+
+    // Spectre S = HL + j*HR de chaque filtre de la base, séparé par symétrie hermitienne :
+    // HL[k] = (S[k] + conj(S[N-k]))/2, HR[k] = (S[k] - conj(S[N-k]))/2j
+    const int N = fftSize;
+    for (int c = 0; c < F; c++) {
+        b.computeSpectrum(b.getPcaBasis(c), b.getPcaLength(), packed);
+        for (int p = 0; p < partitionCount; p++) {
+            const float* S = packed + (size_t)p * spec;
+            float* A = filters + ((size_t)c * partitionCount + p) * 2 * spec;
+            float* D = A + spec;
+            for (int k = 0; k < N; k++) {
+                const int m = (N - k) & (N - 1);
+                const float hlRe = 0.5f * (S[2 * k] + S[2 * m]);
+                const float hlIm = 0.5f * (S[2 * k + 1] - S[2 * m + 1]);
+                const float hrRe = 0.5f * (S[2 * k + 1] + S[2 * m + 1]);
+                const float hrIm = -0.5f * (S[2 * k] - S[2 * m]);
+                A[2 * k]     = 0.5f * (hlRe + hrRe);
+                A[2 * k + 1] = 0.5f * (hlIm + hrIm);
+                D[2 * k]     = 0.5f * (hlRe - hrRe);
+                D[2 * k + 1] = 0.5f * (hlIm - hrIm);
+            }
+        }
+    }
+    free(packed);
+    filterCount = F;
+    fdlPos = 0;
+
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        sources[i].hint = -1;
+        setSource(i, sources[i].azimuth, sources[i].elevation, sources[i].gain);
+        memcpy(sources[i].current, sources[i].target, sizeof(sources[i].current));
+        sources[i].lineLeft.reset();
+        sources[i].lineRight.reset();
+    }
+    return true;
+}
+
+void HrtfPcaMixer::setSource(int index, int azimuthDeg, int elevationDeg, float gain) {
+    if (index < 0 || index >= MAX_SOURCES) {
+        return;
+    }
+    // Normaliser l'azimut dans [0,359]
+    azimuthDeg = (azimuthDeg % 360 + 360) % 360;
+    Source& src = sources[index];
+    src.azimuth = azimuthDeg;
+    src.elevation = elevationDeg;
+    src.gain = gain;
+    if (!bank || filterCount == 0) {
+        return;
+    }
+
+    // Poids des mesures encadrantes mélangés : le filtre obtenu est celui que reconstruirait
+    // HrtfVoice::interpolate, sans être jamais formé
+    const HrirInterpolation interp =
+        bank->getInterpolation((float)azimuthDeg, (float)elevationDeg, src.hint);
+    src.hint = interp.triangle;
+    float w[MAX_COMPONENTS + 1];
+    memset(w, 0, sizeof(w));
+    src.itdLeft = 0.0f;
+    src.itdRight = 0.0f;
+    float distance = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        const float* pw = bank->getPcaWeights(interp.slots[k]);
+        if (!pw || interp.weights[k] <= 0.0f) {
+            continue;
+        }
+        const float a = interp.weights[k];
+        w[0] += a;
+        for (int c = 1; c < filterCount; c++) {
+            w[c] += a * pw[c - 1];
+        }
+        const SelectedHrir m = bank->getHrirAt(interp.slots[k]);
+        src.itdLeft  += a * m.itdLeft;
+        src.itdRight += a * m.itdRight;
+        distance += a * m.distance;
+    }
+    // Même atténuation que HrtfVoice (inverse du carré au-delà d'un mètre)
+    const float g = (distance > 1.0f) ? gain / (distance * distance) : gain;
+    for (int c = 0; c < filterCount; c++) {
+        src.target[c] = w[c] * g;
+    }
+}
+
+void HrtfPcaMixer::mixSource(int index, const float* in) {
+    Source& src = sources[index];
+    const int B = blockSize;
+    const float* left = in;
+    const float* right = in;
+    if (withItd) {
+        memcpy(earLeft, in, B * sizeof(float));
+        memcpy(earRight, in, B * sizeof(float));
+        src.lineLeft.process(earLeft, B, src.itdLeft);
+        src.lineRight.process(earRight, B, src.itdRight);
+        left = earLeft;
+        right = earRight;
+    }
+
+    // Bloc courant de chaque bus (seconde moitié), poids interpolés si la position a changé
+    const float inv = 1.0f / B;
+    for (int c = 0; c < filterCount; c++) {
+        float* dst = bus + (size_t)c * 2 * fftSize + 2 * B;
+        const float g0 = src.current[c];
+        const float g1 = src.target[c];
+        if (g0 == g1) {
+            if (g1 != 0.0f) {
+                for (int n = 0; n < B; n++) {
+                    dst[2 * n]     += g1 * left[n];
+                    dst[2 * n + 1] += g1 * right[n];
+                }
+            }
+        } else {
+            const float dg = (g1 - g0) * inv;
+            for (int n = 0; n < B; n++) {
+                const float g = g0 + dg * (n + 1);
+                dst[2 * n]     += g * left[n];
+                dst[2 * n + 1] += g * right[n];
+            }
+        }
+        src.current[c] = g1;
+    }
+}
+
+void HrtfPcaMixer::process(const float* const* inputs, float* outLeft, float* outRight) {
+    const int B = blockSize;
+    const int N = fftSize;
+    const size_t spec = 2 * (size_t)N;
+    if (filterCount == 0) {
+        memset(outLeft, 0, B * sizeof(float));
+        memset(outRight, 0, B * sizeof(float));
+        return;
+    }
+
+    // Fenêtre glissante de chaque bus [bloc précédent | bloc courant]
+    for (int c = 0; c < filterCount; c++) {
+        float* z = bus + (size_t)c * spec;
+        memmove(z, z + 2 * B, 2 * B * sizeof(float));
+        memset(z + 2 * B, 0, 2 * B * sizeof(float));
+    }
+    for (int i = 0; i < sourceCount; i++) {
+        const float* in = inputs ? inputs[i] : nullptr;
+        if (!in) {
+            memcpy(sources[i].current, sources[i].target, sizeof(sources[i].current));
+            continue;
+        }
+        mixSource(i, in);
+    }
+
+    // Une FFT par bus, produits avec les partitions de son filtre, une seule IFFT
+    fdlPos = (fdlPos == 0) ? partitionCount - 1 : fdlPos - 1;
+    memset(spectrumAcc, 0, spec * sizeof(float));
+    for (int c = 0; c < filterCount; c++) {
+        float* Z = fdl + ((size_t)c * partitionCount + fdlPos) * spec;
+        memcpy(Z, bus + (size_t)c * spec, spec * sizeof(float));
+        fft.forward(Z);
+        for (int p = 0; p < partitionCount; p++) {
+            int slot = fdlPos + p;
+            if (slot >= partitionCount) {
+                slot -= partitionCount;
+            }
+            const float* Xp = fdl + ((size_t)c * partitionCount + slot) * spec;
+            const float* A = filters + ((size_t)c * partitionCount + p) * 2 * spec;
+            const float* D = A + spec;
+            for (int k = 0; k < N; k++) {
+                const int m = (N - k) & (N - 1);
+                mirror[2 * k]     = Xp[2 * m];
+                mirror[2 * k + 1] = -Xp[2 * m + 1];
+            }
+            hrtfKernels().complexMac(spectrumAcc, Xp, A, N);
+            hrtfKernels().complexMac(spectrumAcc, mirror, D, N);
+        }
+    }
+    fft.inverse(spectrumAcc);
+
+    // Overlap-save : seuls les B derniers échantillons sont valides
+    const float s = fft.inverseNorm();
+    for (int n = 0; n < B; n++) {
+        outLeft[n]  = spectrumAcc[2 * (B + n)] * s;
+        outRight[n] = spectrumAcc[2 * (B + n) + 1] * s;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef HRTF_PCA_MIXER_H
+#define HRTF_PCA_MIXER_H
+
+#include <stddef.h>
+#include "HrtfBank.h"
+#include "HrtfFft.h"
+#include "HrtfDelayLine.h"
+
+// Rendu de sources mono par la base PCA de la banque (fichier "HRIP", HrtfBank::getPcaBasis).
+// Chaque source n'est qu'un jeu de poids (ceux des mesures encadrant sa direction, interpolés) ;
+// les K + 1 filtres de la base (moyenne et composantes) sont convolués une fois par bloc sur
+// des bus qui somment toutes les sources pondérées : le coût de convolution est celui de K + 1
+// voix quel que soit le nombre de sources, plus K + 1 produits par échantillon et par source.
+// L'ITD des bases à phase minimale est appliqué à chaque source avant les bus : chaque bus a
+// donc une oreille gauche et une droite, empaquetées (gauche + j*droite) dans une seule FFT.
+// Convolution FFT uniquement ; les queues des réponses longues n'existent pas dans une base.
+class HrtfPcaMixer {
+public:
+    static const int MAX_SOURCES = 32;
+    static const int MAX_COMPONENTS = 32;
+
+    HrtfPcaMixer();
+    ~HrtfPcaMixer();
+
+    // Spectres de la base et bus pour les getPcaComponents() composantes utilisées par la
+    // banque (hors interruption audio). false si la banque n'a pas de base ou pas de FFT.
+    bool init(const HrtfBank& bank, int sourceCount);
+    int getSourceCount() const { return sourceCount; }
+    // Filtres convolués par bloc : moyenne comprise (0 si init a échoué)
+    int getFilterCount() const { return filterCount; }
+
+    // Position et gain d'une source (azimut/élévation en degrés) ; les poids glissent sur le
+    // bloc suivant
+    void setSource(int index, int azimuthDeg, int elevationDeg, float gain);
+    int getAzimuth(int index) const { return sources[index].azimuth; }
+    int getElevation(int index) const { return sources[index].elevation; }
+    float getGain(int index) const { return sources[index].gain; }
+
+    // inputs[i] : bloc de la source i (nul = muette)
+    void process(const float* const* inputs, float* outLeft, float* outRight);
+
+private:
+    HrtfPcaMixer(const HrtfPcaMixer&);
+    HrtfPcaMixer& operator=(const HrtfPcaMixer&);
+
+    void release();
+    void mixSource(int index, const float* in);
+
+    struct Source {
+        int azimuth;
+        int elevation;
+        float gain;
+        int hint;                              // triangle de la dernière interpolation
+        float target[MAX_COMPONENTS + 1];      // poids demandés (moyenne en tête), gain compris
+        float current[MAX_COMPONENTS + 1];     // poids atteints à la fin du bloc précédent
+        float itdLeft;
+        float itdRight;
+        HrtfDelayLine lineLeft;
+        HrtfDelayLine lineRight;
+    };
+
+    const HrtfBank* bank;
+    int sourceCount;
+    int blockSize;
+    int filterCount;
+    bool withItd;
+    Source sources[MAX_SOURCES];
+
+    // Pour un bus Z = FFT(gauche + j*droite) et un filtre de spectre S = HL + j*HR (tel que
+    // calculé par la banque), la sortie gauche + j*droite a pour spectre
+    // Z[k]*A[k] + conj(Z[N-k])*D[k], avec A = (HL + HR)/2 et D = (HL - HR)/2 précalculés.
+    HrtfFft fft;
+    int fftSize;
+    int partitionCount;
+    float* filters;      // filterCount x partitionCount x (A, D), fftSize complexes chacun
+    float* bus;          // filterCount x [bloc précédent | bloc courant], gauche + j*droite
+    float* fdl;          // filterCount x partitionCount spectres des bus
+    int fdlPos;
+    float* mirror;       // conj(Z[N-k]) d'une partition
+    float* spectrumAcc;  // somme des produits, une seule IFFT
+    float* earLeft;      // entrée d'une source retardée de son ITD, par oreille
+    float* earRight;
+};
+
+#endif
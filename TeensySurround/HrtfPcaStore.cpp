@@ -0,0 +1,128 @@
+#include "HrtfPcaStore.h"
+#include "HrirBinReader.h"
+#include "HrtfResampler.h"
+#include "HrtfMemory.h"
+#include <string.h>
+#include <stdlib.h>
+
+HrtfPcaStore::HrtfPcaStore()
+: basis(nullptr), weights(nullptr), stride(0), components(0), filterLength(0)
+{
+}
+
+HrtfPcaStore::~HrtfPcaStore() {
+    free(basis);
+    hrtfRelease(weights);
+}
+
+bool HrtfPcaStore::load(HrirBinReader& reader) {
+    const int stored = (reader.components() > (uint32_t)MAX_COMPONENTS)
+                     ? MAX_COMPONENTS : (int)reader.components();
+    const size_t taps = reader.length();
+    const size_t basisFloats = (size_t)(reader.components() + 1) * 2 * taps;
+    basis = (float*)malloc(basisFloats * sizeof(float));
+    const int count = (reader.count() > (uint32_t)MAX_SLOTS) ? MAX_SLOTS : (int)reader.count();
+    weights = (float*)hrtfAllocate((size_t)count * stored * sizeof(float));
+    if (!basis || !weights || !reserve(count) || !reader.readBasis(basis)) {
+        return false;
+    }
+    // Composantes au-delà de MAX_COMPONENTS : lues avec la base, jamais utilisées
+    stride = stored;
+    components = stored;
+    filterLength = taps;
+
+    while (slotCount < count && reader.next()) {
+        HrtfStoreSlot* m = append(reader.azimuth(), reader.elevation(), reader.distance());
+        if (!m) {
+            break;
+        }
+        m->itdLeft = reader.itdLeft();
+        m->itdRight = reader.itdRight();
+        memcpy(weights + (size_t)(slotCount - 1) * stride, reader.weights(),
+               stride * sizeof(float));
+    }
+    return true;
+}
+
+bool HrtfPcaStore::convertRate(HrtfResampler& resampler, float ratio, size_t maxLength) {
+    size_t taps = resampler.outputLength((uint32_t)filterLength);
+    taps = (taps > maxLength) ? maxLength : taps;
+    float* converted = (float*)malloc((size_t)(stride + 1) * 2 * taps * sizeof(float));
+    float* in = (float*)malloc(filterLength * sizeof(float));
+    float* out = (float*)malloc(taps * sizeof(float));
+    if (!converted || !in || !out) {
+        free(converted);
+        free(in);
+        free(out);
+        return false;
+    }
+    // Moyenne et composantes utilisées, oreille par oreille
+    for (int c = 0; c <= stride; c++) {
+        const float* v = basis + (size_t)c * 2 * filterLength;
+        float* w = converted + (size_t)c * 2 * taps;
+        for (int ear = 0; ear < 2; ear++) {
+            for (size_t i = 0; i < filterLength; i++) {
+                in[i] = v[2 * i + ear];
+            }
+            resampler.convert(in, (int)filterLength, out, (int)taps);
+            for (size_t i = 0; i < taps; i++) {
+                w[2 * i + ear] = out[i];
+            }
+        }
+    }
+    free(in);
+    free(out);
+    free(basis);
+    basis = converted;
+    filterLength = taps;
+    for (int i = 0; i < slotCount; i++) {
+        slots[i].itdLeft *= ratio;
+        slots[i].itdRight *= ratio;
+    }
+    return true;
+}
+
+void HrtfPcaStore::setComponents(int count) {
+    count = (count < 0) ? 0 : count;
+    components = (count > stride) ? stride : count;
+}
+
+size_t HrtfPcaStore::length(int) const {
+    return filterLength;
+}
+
+size_t HrtfPcaStore::mix(const int* indices, const float* mixWeights, int count,
+                         float* coeffs) const {
+    float pca[MAX_COMPONENTS + 1];
+    memset(pca, 0, (components + 1) * sizeof(float));
+    bool used = false;
+    for (int k = 0; k < count; k++) {
+        const int index = indices[k];
+        if (index < 0 || index >= slotCount) {
+            continue;
+        }
+        const float* w = weights + (size_t)index * stride;
+        pca[0] += mixWeights[k];
+        for (int c = 0; c < components; c++) {
+            pca[c + 1] += mixWeights[k] * w[c];
+        }
+        used = true;
+    }
+    if (!used) {
+        return 0;
+    }
+    const size_t n = 2 * filterLength;
+    for (int c = 0; c <= components; c++) {
+        const float g = pca[c];
+        const float* v = basis + (size_t)c * n;
+        for (size_t i = 0; i < n; i++) {
+            coeffs[i] += g * v[i];
+        }
+    }
+    return filterLength;
+}
+
+size_t HrtfPcaStore::bytes() const {
+    return HrtfStore::bytes() + (size_t)(stride + 1) * 2 * filterLength * sizeof(float) +
+           (size_t)slotCount * stride * sizeof(float);
+}
@@ -0,0 +1,53 @@
+#ifndef HRTF_PCA_STORE_H
+#define HRTF_PCA_STORE_H
+
+#include "HrtfStore.h"
+
+class HrirBinReader;
+class HrtfResampler;
+
+// Base PCA (fichier "HRIP", voir HrtfBank::setPcaComponents) : chaque filtre est la moyenne
+// plus la somme pondérée de K composantes communes. Les poids (K floats par mesure) sont
+// alloués par hrtfAllocate ; la base reste en RAM interne, lue à chaque reconstruction.
+class HrtfPcaStore : public HrtfStore {
+public:
+    static const int MAX_COMPONENTS = 64;
+
+    HrtfPcaStore();
+    virtual ~HrtfPcaStore();
+
+    // Base et poids de toutes les mesures du fichier (au plus MAX_SLOTS) ; false si mémoire
+    // insuffisante
+    bool load(HrirBinReader& reader);
+    // Base convertie par resampler (au plus maxLength taps), ITD multipliées par ratio ; les
+    // filtres reconstruits étant linéaires en la base, les poids restent ceux du fichier.
+    // false si mémoire insuffisante (base du fichier gardée)
+    bool convertRate(HrtfResampler& resampler, float ratio, size_t maxLength);
+    // Composantes utilisées (au plus celles du fichier)
+    void setComponents(int count);
+    int getComponents() const { return components; }
+    int getStoredComponents() const { return stride; }
+    size_t getLength() const { return filterLength; }
+    // Filtre component de la base (0 : moyenne, 1..K : composantes), taps entrelacés
+    const float* getBasis(int component) const {
+        return basis + (size_t)component * 2 * filterLength;
+    }
+    // Poids de la mesure index (getStoredComponents() floats), nul hors de la base
+    const float* getWeights(int index) const {
+        return (index >= 0 && index < slotCount) ? weights + (size_t)index * stride : nullptr;
+    }
+
+    virtual size_t length(int index) const;
+    // Les poids des mesures sont mélangés, le filtre n'est reconstruit qu'une fois
+    virtual size_t mix(const int* indices, const float* weights, int count, float* coeffs) const;
+    virtual size_t bytes() const;
+
+private:
+    float* basis;      // (stride + 1) filtres de filterLength taps entrelacés, moyenne en tête
+    float* weights;
+    int stride;
+    int components;
+    size_t filterLength;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "HrtfResampler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Fonction de Bessel modifiée d'ordre 0 (fenêtre de Kaiser), calculée à l'initialisation
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++) {
+        const double r = x / (2.0 * k);
+        term *= r * r;
+        sum += term;
+        if (term < 1e-12 * sum) {
+            break;
+        }
+    }
+    return sum;
+}
+
+HrtfResampler::HrtfResampler()
+: coeffs(nullptr), taps(0), phases(0), phaseBits(0), channels(1), rateIn(0.0), rateOut(0.0),
+  quality(HRTF_SRC_MEDIUM), step(0), frac(0), need(0), writeIndex(0)
+{
+    memset(line, 0, sizeof(line));
+}
+
+HrtfResampler::~HrtfResampler() {
+    free(coeffs);
+}
+
+bool HrtfResampler::init(double inRate, double outRate, int ch, HrtfResampleQuality q) {
+    if (inRate <= 0.0 || outRate <= 0.0 || ch < 1 || ch > MAX_CHANNELS) {
+        return false;
+    }
+    channels = ch;
+    if (coeffs && inRate == rateIn && outRate == rateOut && q == quality) {
+        reset();
+        return true;
+    }
+    free(coeffs);
+    coeffs = nullptr;
+
+    // Taps, phases, paramètre de la fenêtre et bande passante (fraction de la plus basse des
+    // deux fréquences de Nyquist) de chaque qualité
+    double beta;
+    double rolloff;
+    switch (q) {
+    case HRTF_SRC_LOW:  taps = 8;  phaseBits = 5; beta = 5.0; rolloff = 0.80; break;
+    case HRTF_SRC_HIGH: taps = 32; phaseBits = 7; beta = 9.0; rolloff = 0.93; break;
+    default:            taps = 16; phaseBits = 6; beta = 7.0; rolloff = 0.88; break;
+    }
+    phases = 1 << phaseBits;
+    coeffs = (float*)malloc((size_t)(phases + 1) * taps * sizeof(float));
+    if (!coeffs) {
+        return false;
+    }
+    rateIn = inRate;
+    rateOut = outRate;
+    quality = q;
+
+    // Phase p : instant p / phases après la trame centrale ; le tap k multiplie la trame
+    // k - taps/2 + 1 par rapport à elle. Chaque phase est ramenée à un gain continu de 1.
+    const double fc = rolloff * ((outRate < inRate) ? outRate / inRate : 1.0);
+    const int half = taps / 2;
+    const double norm = 1.0 / besselI0(beta);
+    for (int p = 0; p <= phases; p++) {
+        float* c = coeffs + (size_t)p * taps;
+        double h[MAX_TAPS];
+        double sum = 0.0;
+        for (int k = 0; k < taps; k++) {
+            const double t = (double)(k - half + 1) - (double)p / phases;
+            const double x = t / half;
+            const double w = (fabs(x) < 1.0) ? besselI0(beta * sqrt(1.0 - x * x)) * norm : norm;
+            const double arg = M_PI * fc * t;
+            const double sinc = (fabs(arg) < 1e-9) ? 1.0 : sin(arg) / arg;
+            h[k] = fc * sinc * w;
+            sum += h[k];
+        }
+        for (int k = 0; k < taps; k++) {
+            c[k] = (float)(h[k] / sum);
+        }
+    }
+    step = (uint64_t)llround(inRate / outRate * 4294967296.0);
+    reset();
+    return true;
+}
+
+void HrtfResampler::reset() {
+    memset(line, 0, sizeof(line));
+    writeIndex = 0;
+    frac = 0;
+    // La première sortie (instant 0) attend les taps/2 trames qui suivent la première
+    need = taps / 2 + 1;
+}
+
+uint32_t HrtfResampler::outputLength(uint32_t inFrames) const {
+    if (rateIn <= 0.0) {
+        return inFrames;
+    }
+    return (uint32_t)ceil((double)inFrames * rateOut / rateIn - 1e-9);
+}
+
+inline void HrtfResampler::push(const int16_t* frame) {
+    for (int c = 0; c < channels; c++) {
+        const float v = frame ? (float)frame[c] : 0.0f;
+        line[c][writeIndex] = v;
+        line[c][writeIndex + taps] = v;
+    }
+    writeIndex = (writeIndex + 1 == taps) ? 0 : writeIndex + 1;
+}
+
+inline void HrtfResampler::pushValue(float value) {
+    line[0][writeIndex] = value;
+    line[0][writeIndex + taps] = value;
+    writeIndex = (writeIndex + 1 == taps) ? 0 : writeIndex + 1;
+}
+
+inline void HrtfResampler::interpolateCoeffs(float* c) const {
+    // Phase inférieure et position entre elle et la suivante
+    const uint32_t p = frac >> (32 - phaseBits);
+    const float a = (float)(uint32_t)(frac << phaseBits) * (1.0f / 4294967296.0f);
+    const float* c0 = coeffs + (size_t)p * taps;
+    const float* c1 = c0 + taps;
+    for (int k = 0; k < taps; k++) {
+        c[k] = c0[k] + a * (c1[k] - c0[k]);
+    }
+}
+
+inline void HrtfResampler::advance() {
+    const uint64_t next = (uint64_t)frac + step;
+    frac = (uint32_t)next;
+    need += (int)(next >> 32);
+}
+
+int HrtfResampler::process(const int16_t* in, int inFrames, int& consumed, int16_t* out,
+                           int maxOut) {
+    consumed = 0;
+    int produced = 0;
+    float c[MAX_TAPS];
+    while (produced < maxOut) {
+        while (need > 0) {
+            if (in && consumed >= inFrames) {
+                return produced;
+            }
+            push(in ? in + consumed * channels : nullptr);
+            consumed++;
+            need--;
+        }
+        interpolateCoeffs(c);
+        for (int ch = 0; ch < channels; ch++) {
+            const float* x = line[ch] + writeIndex;
+            float acc = 0.0f;
+            for (int k = 0; k < taps; k++) {
+                acc += c[k] * x[k];
+            }
+            long v = lroundf(acc);
+            v = (v > 32767) ? 32767 : (v < -32768 ? -32768 : v);
+            out[produced * channels + ch] = (int16_t)v;
+        }
+        produced++;
+        advance();
+    }
+    return produced;
+}
+
+void HrtfResampler::convert(const float* in, int inLength, float* out, int outLength) {
+    reset();
+    int consumed = 0;
+    float c[MAX_TAPS];
+    for (int m = 0; m < outLength; m++) {
+        while (need > 0) {
+            pushValue((consumed < inLength) ? in[consumed] : 0.0f);
+            consumed++;
+            need--;
+        }
+        interpolateCoeffs(c);
+        const float* x = line[0] + writeIndex;
+        float acc = 0.0f;
+        for (int k = 0; k < taps; k++) {
+            acc += c[k] * x[k];
+        }
+        out[m] = acc;
+        advance();
+    }
+    reset();
+}
@@ -0,0 +1,80 @@
+#ifndef HRTF_RESAMPLER_H
+#define HRTF_RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Qualité de conversion (HRTF_RESAMPLE_QUALITY) : taps par échantillon de sortie, phases de la
+// table, fenêtre de Kaiser et bande passante
+enum HrtfResampleQuality {
+    HRTF_SRC_LOW = 1,     // 8 taps, 32 phases
+    HRTF_SRC_MEDIUM = 2,  // 16 taps, 64 phases
+    HRTF_SRC_HIGH = 3     // 32 taps, 128 phases
+};
+
+// Conversion de fréquence d'échantillonnage d'un rapport quelconque : sinus cardinal fenêtré
+// (Kaiser) tabulé en phases régulières, les coefficients d'une position entre deux phases
+// interpolés linéairement (structure de Farrow du premier ordre). Le coût par échantillon de
+// sortie ne dépend pas du rapport : taps coefficients interpolés, puis taps produits par canal.
+// La coupure suit la plus basse des deux fréquences de Nyquist (anti-repliement en réduction).
+// Sortie alignée sur l'entrée : la trame de sortie m est à l'instant m * inRate / outRate du
+// signal d'entrée (zéros avant le début), sans retard de groupe à compenser.
+// Utilisé en flux par MyStreamPlayer (depuis loop(), jamais sur l'interruption) et en bloc
+// par HrtfBank pour amener les HRIR à la fréquence du moteur.
+class HrtfResampler {
+public:
+    static const int MAX_CHANNELS = 2;
+    static const int MAX_TAPS = 32;
+
+    HrtfResampler();
+    ~HrtfResampler();
+
+    // Tables pour inRate -> outRate (allocation : hors interruption ; rien n'est refait pour les
+    // mêmes réglages), historique vidé. false si mémoire insuffisante ou réglages invalides.
+    bool init(double inRate, double outRate, int channels, HrtfResampleQuality quality);
+    // Historique vidé et position ramenée au début du signal (tables gardées)
+    void reset();
+    bool isReady() const { return coeffs != nullptr; }
+    int getChannels() const { return channels; }
+    int getTaps() const { return taps; }
+    size_t getTableBytes() const { return (size_t)(phases + 1) * taps * sizeof(float); }
+
+    // Trames de sortie couvrant inFrames trames d'entrée (ceil(inFrames * outRate / inRate))
+    uint32_t outputLength(uint32_t inFrames) const;
+
+    // Flux int16 entrelacés (channels canaux) : consomme au plus inFrames trames de in
+    // (consumed), produit au plus maxOut trames dans out ; s'arrête dès que l'un des deux est
+    // épuisé. in nul : zéros à volonté (fin du signal, inFrames ignoré). Retourne les trames
+    // produites.
+    int process(const int16_t* in, int inFrames, int& consumed, int16_t* out, int maxOut);
+    // Signal float mono entier (une HRIR) : out reçoit outLength échantillons, l'entrée
+    // complétée par des zéros. Réinitialise l'historique avant et après.
+    void convert(const float* in, int inLength, float* out, int outLength);
+
+private:
+    HrtfResampler(const HrtfResampler&);
+    HrtfResampler& operator=(const HrtfResampler&);
+
+    void push(const int16_t* frame);
+    void pushValue(float value);
+    void interpolateCoeffs(float* c) const;
+    void advance();
+
+    float* coeffs;         // (phases + 1) x taps ; la phase p est à la fraction p / phases
+    int taps;
+    int phases;
+    int phaseBits;
+    int channels;
+    double rateIn;
+    double rateOut;
+    HrtfResampleQuality quality;
+    uint64_t step;         // inRate / outRate en virgule fixe 32.32
+    uint32_t frac;         // fraction de la position courante (sur 2^32)
+    int need;              // trames d'entrée à pousser avant la sortie suivante
+    int writeIndex;
+    // Historique en double (écrit à writeIndex et writeIndex + taps) : la fenêtre des taps
+    // dernières trames est toujours contiguë
+    float line[MAX_CHANNELS][2 * MAX_TAPS];
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "HrtfStore.h"
+#include "HrtfBank.h"
+#include <stdlib.h>
+#include <math.h>
+
+HrtfStore::HrtfStore()
+: slots(nullptr), slotCount(0), slotCapacity(0)
+{
+}
+
+HrtfStore::~HrtfStore() {
+    free(slots);
+}
+
+bool HrtfStore::reserve(int count) {
+    count = (count > MAX_SLOTS) ? MAX_SLOTS : count;
+    if (count <= slotCapacity) {
+        return true;
+    }
+    HrtfStoreSlot* list = (HrtfStoreSlot*)realloc(slots, count * sizeof(HrtfStoreSlot));
+    if (!list) {
+        return false;
+    }
+    slots = list;
+    slotCapacity = count;
+    return true;
+}
+
+HrtfStoreSlot* HrtfStore::append(float azimuthDeg, float elevationDeg, float distance) {
+    // Agrandi par 64 mesures (une banque construite mesure par mesure)
+    if (slotCount >= slotCapacity && !reserve(slotCapacity + 64)) {
+        return nullptr;
+    }
+    if (slotCount >= slotCapacity) {
+        return nullptr;
+    }
+    HrtfStoreSlot& m = slots[slotCount++];
+    HrtfBank::directionVector(azimuthDeg, elevationDeg, m.direction);
+    m.azimuth = (int16_t)roundf(azimuthDeg);
+    m.elevation = (int16_t)roundf(elevationDeg);
+    m.distance = distance;
+    m.itdLeft = 0.0f;
+    m.itdRight = 0.0f;
+    return &m;
+}
+
+void HrtfStore::itd(int index, float& left, float& right) const {
+    left = slots[index].itdLeft;
+    right = slots[index].itdRight;
+}
+
+size_t HrtfStore::bytes() const {
+    return (size_t)slotCount * sizeof(HrtfStoreSlot);
+}
@@ -0,0 +1,60 @@
+#ifndef HRTF_STORE_H
+#define HRTF_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Description d'une mesure d'une banque à décoder, commune à tous les stockages : la
+// recherche (triangulation, grille) et la sélection ne lisent que celle-ci
+struct HrtfStoreSlot {
+    float direction[3];  // vecteur unitaire (HrtfBank::directionVector)
+    int16_t azimuth;
+    int16_t elevation;
+    float distance;
+    float itdLeft;       // retard fractionnaire retiré (phase minimale), en échantillons
+    float itdRight;
+};
+
+// Stockage des filtres d'une banque qui n'est pas résidente (HrtfBank::isCompact) : la banque
+// garde la recherche et la sélection, le stockage les filtres de ses mesures et leur
+// décodage. Un stockage par format (HrtfCompactStore, HrtfPcaStore, HrtfCacheStore), chacun
+// avec ses seules données.
+class HrtfStore {
+public:
+    // Indices sur 16 bits, triangles compris
+    static const int MAX_SLOTS = 16384;
+
+    HrtfStore();
+    virtual ~HrtfStore();
+
+    int count() const { return slotCount; }
+    const HrtfStoreSlot& slot(int index) const { return slots[index]; }
+    // Descriptions réservées pour count mesures (une banque lue d'un fichier)
+    bool reserve(int count);
+
+    // Taps de la tête de la mesure index (les deux oreilles)
+    virtual size_t length(int index) const = 0;
+    // ITD de la mesure index : celui de sa description, sauf stockage symétrique
+    virtual void itd(int index, float& left, float& right) const;
+    // coeffs (2*MAX_HRIR_LENGTH floats, remis à zéro par l'appelant) += somme des weights[k] *
+    // filtre de la mesure indices[k] (ignorée hors du stockage) ; retourne la longueur du
+    // mélange en taps. Appelé sur l'interruption audio.
+    virtual size_t mix(const int* indices, const float* weights, int count,
+                       float* coeffs) const = 0;
+    // Octets résidents : descriptions et filtres
+    virtual size_t bytes() const;
+
+protected:
+    // Description de la mesure suivante, nulle si plus de place
+    HrtfStoreSlot* append(float azimuthDeg, float elevationDeg, float distance);
+
+    HrtfStoreSlot* slots;
+    int slotCount;
+    int slotCapacity;
+
+private:
+    HrtfStore(const HrtfStore&);
+    HrtfStore& operator=(const HrtfStore&);
+};
+
+#endif
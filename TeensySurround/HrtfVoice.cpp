@@ -0,0 +1,556 @@
+#include "HrtfVoice.h"
+#include "HrtfKernels.h"
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+HrtfVoice::HrtfVoice()
+: bank(nullptr), bankGeneration(0), bankCacheVersion(0), blockSize(128), directHistory(nullptr),
+  convMode(HRTF_CONV_FFT), fftSize(0), partitionCount(0),
+  fftInput(nullptr), fdl(nullptr), fftWork(nullptr), fdlPos(0),
+  switchMode(HRTF_SWITCH_CROSSFADE), lastCoeffs(nullptr), lastLength(0),
+  lastSpectrum(nullptr), lastScale(0.0f),
+  fadeWindow(nullptr), fadeLeft(nullptr), fadeRight(nullptr), fftFade(nullptr),
+  tailCapacity(0),
+  interpolationEnabled(false), blendCoeffs(nullptr), blendSpectrum(nullptr), blendIndex(0),
+  blendValid(false), blendMode(HRTF_CONV_FFT), interpolationHint(-1),
+  selectionKind(SELECTION_NONE), selectionAzimuth(0.0f), selectionElevation(0.0f),
+  selectionMode(HRTF_CONV_FFT)
+{
+}
+
+HrtfVoice::~HrtfVoice() {
+    free(directHistory);
+    free(fftInput);
+    free(fdl);
+    free(fftWork);
+    free(fadeWindow);
+    free(fadeLeft);
+    free(fadeRight);
+    free(fftFade);
+    free(blendCoeffs);
+    free(blendSpectrum);
+}
+
+bool HrtfVoice::init(const HrtfBank& b) {
+    bank = &b;
+    bankGeneration = b.getGeneration();
+    blockSize = b.getBlockSize();
+
+    free(directHistory);
+    directHistory = (float*)malloc((MAX_HRIR_LENGTH - 1 + blockSize) * sizeof(float));
+
+    // Fenêtre de fondu : c'est la moitié utile (n = B..2B-1) de 0.5 + 0.5*cos(2*pi*n/2B),
+    // qui s'écrit avec trois raies spectrales (voir crossfadeSpectrum)
+    free(fadeWindow);
+    free(fadeLeft);
+    free(fadeRight);
+    fadeWindow = (float*)malloc(blockSize * sizeof(float));
+    fadeLeft   = (float*)malloc(blockSize * sizeof(float));
+    fadeRight  = (float*)malloc(blockSize * sizeof(float));
+    if (fadeWindow) {
+        for (int n = 0; n < blockSize; n++) {
+            fadeWindow[n] = 0.5f - 0.5f * cosf(3.14159265f * n / blockSize);
+        }
+    }
+
+    free(fftInput);
+    free(fdl);
+    free(fftWork);
+    free(fftFade);
+    fftInput = nullptr;
+    fdl = nullptr;
+    fftWork = nullptr;
+    fftFade = nullptr;
+    fftSize = 0;
+    partitionCount = 0;
+
+    // Overlap-save : même découpage que les spectres précalculés de la banque
+    const int parts = b.getPartitionCount();
+    if (b.getFftSize() > 0 && fft.init(b.getFftSize())) {
+        fftInput = (float*)malloc(2 * blockSize * sizeof(float));
+        fdl      = (float*)malloc(parts * 4 * blockSize * sizeof(float));
+        fftWork  = (float*)malloc(4 * blockSize * sizeof(float));
+        fftFade  = (float*)malloc(4 * blockSize * sizeof(float));
+        if (fftInput && fdl && fftWork && fftFade) {
+            fftSize = b.getFftSize();
+            partitionCount = parts;
+        }
+    }
+    if (fftSize == 0) {
+        Serial.println("Convolution FFT indisponible, retour au mode direct");
+        convMode = HRTF_CONV_DIRECT;
+    }
+
+    // Queue des réponses longues : dimensionnée sur la plus longue réponse de la banque
+    tail.init(blockSize, MAX_HRIR_LENGTH);
+    tailCapacity = b.getMaxTailLength();
+    if (b.getMaxTailLength() > 0 && !tail.reserve(b.getMaxTailLength())) {
+        Serial.println("Mémoire insuffisante pour la convolution des queues");
+        tail.init(blockSize, MAX_HRIR_LENGTH);
+        tailCapacity = 0;
+    }
+    // Banque compacte : les mesures sont décodées dans les buffers du mélange
+    bool blendOk = true;
+    if (interpolationEnabled || b.isCompact()) {
+        blendOk = allocateBlend();
+    }
+    reset();
+    return directHistory && fadeWindow && fadeLeft && fadeRight && blendOk;
+}
+
+bool HrtfVoice::compatibleBank(const HrtfBank& b) const {
+    // Mêmes spectres (les lignes à retard de la voix gardent leur découpage), queues comprises
+    return bank && b.getBlockSize() == blockSize &&
+           (fftSize == 0 || (b.getFftSize() == fftSize &&
+                             b.getPartitionCount() == partitionCount)) &&
+           b.getMaxTailLength() <= tailCapacity;
+}
+
+bool HrtfVoice::prepareBank(const HrtfBank& b) {
+    if (!compatibleBank(b)) {
+        return false;
+    }
+    // Les buffers du mélange ont la taille des spectres, la même pour les deux banques
+    return !b.isCompact() || blendCoeffs || allocateBlend();
+}
+
+bool HrtfVoice::setBank(const HrtfBank& b) {
+    if (!compatibleBank(b) || (b.isCompact() && !blendCoeffs)) {
+        return false;
+    }
+    // lastCoeffs et lastSpectrum sont gardés : le prochain bloc passe de l'ancien filtre au
+    // nouveau (les filtres décodés alternent entre les deux buffers du mélange)
+    bank = &b;
+    bankGeneration = b.getGeneration();
+    bankCacheVersion = b.getCacheVersion();
+    blendValid = false;
+    interpolationHint = -1;
+    selectionKind = SELECTION_NONE;
+    return true;
+}
+
+bool HrtfVoice::setInterpolation(bool enabled) {
+    interpolationEnabled = enabled;
+    selectionKind = SELECTION_NONE;
+    // Les buffers du mélange servent aussi au décodage d'une banque compacte
+    if (!enabled && !(bank && bank->isCompact())) {
+        free(blendCoeffs);
+        free(blendSpectrum);
+        blendCoeffs = nullptr;
+        blendSpectrum = nullptr;
+        blendValid = false;
+        return true;
+    }
+    return (bank && !blendCoeffs) ? allocateBlend() : true;
+}
+
+bool HrtfVoice::allocateBlend() {
+    free(blendCoeffs);
+    free(blendSpectrum);
+    blendSpectrum = nullptr;
+    blendValid = false;
+    selectionKind = SELECTION_NONE;
+    blendCoeffs = (float*)malloc(2 * 2 * MAX_HRIR_LENGTH * sizeof(float));
+    if (blendCoeffs && fftSize > 0) {
+        blendSpectrum = (float*)malloc(2 * bank->getSpectrumSize() * sizeof(float));
+    }
+    if (!blendCoeffs || (fftSize > 0 && !blendSpectrum)) {
+        Serial.println("Mémoire insuffisante pour l'interpolation ou le décodage des HRIR");
+        free(blendCoeffs);
+        free(blendSpectrum);
+        blendCoeffs = nullptr;
+        blendSpectrum = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void HrtfVoice::reset() {
+    tail.reset();
+    itdLineLeft.reset();
+    itdLineRight.reset();
+    if (directHistory) {
+        memset(directHistory, 0, (MAX_HRIR_LENGTH - 1 + blockSize) * sizeof(float));
+    }
+    if (fftInput) {
+        memset(fftInput, 0, fftSize * sizeof(float));
+    }
+    if (fdl) {
+        memset(fdl, 0, partitionCount * 2 * fftSize * sizeof(float));
+    }
+    fdlPos = 0;
+    lastCoeffs = nullptr;
+    lastLength = 0;
+    lastSpectrum = nullptr;
+    lastScale = 0.0f;
+}
+
+void HrtfVoice::setConvolutionMode(HrtfConvolutionMode mode) {
+    if (mode == HRTF_CONV_FFT && fftSize == 0) {
+        return;
+    }
+    convMode = mode;
+    reset();
+}
+
+float HrtfVoice::distanceGain(const SelectedHrir& selHrir) {
+    // Calcul du facteur d'atténuation basé sur la distance (loi inverse du carré)
+    // Si la distance est inférieure ou égale à 1, on ne modifie pas.
+    float distanceFactor = 1.0f;
+    if (selHrir.distance > 1.0f) {
+         distanceFactor = 1.0f / (selHrir.distance * selHrir.distance);
+    }
+    return distanceFactor;
+}
+
+void HrtfVoice::checkBankGeneration() {
+    // Banque rechargée : les spectres du bloc précédent ont pu être déplacés
+    if (bank && bank->getGeneration() != bankGeneration) {
+        bankGeneration = bank->getGeneration();
+        lastSpectrum = nullptr;
+        blendValid = false;
+        interpolationHint = -1;
+        selectionKind = SELECTION_NONE;
+    }
+    // Banque à la demande : la mesure servie à la place d'une absente peut être remplacée,
+    // sélection refaite (le fondu enchaîné reste possible, les spectres n'ont pas bougé)
+    if (bank && bank->getCacheVersion() != bankCacheVersion) {
+        bankCacheVersion = bank->getCacheVersion();
+        selectionKind = SELECTION_NONE;
+    }
+}
+
+// out = somme des w[k] * in[k] sur n valeurs (2 ou 3 mesures)
+static void weightedSum(float* out, const float* const* in, const float* w, int count, size_t n) {
+    const float* a = in[0];
+    const float* b = in[1];
+    const float wa = w[0], wb = w[1];
+    if (count == 2) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = wa * a[i] + wb * b[i];
+        }
+        return;
+    }
+    const float* c = in[2];
+    const float wc = w[2];
+    for (size_t i = 0; i < n; i++) {
+        out[i] = wa * a[i] + wb * b[i] + wc * c[i];
+    }
+}
+
+SelectedHrir HrtfVoice::select(int azimuthDeg, int elevationDeg) {
+    if (!bank) {
+        return SelectedHrir();
+    }
+    checkBankGeneration();
+    if (selectionKind == SELECTION_NEAREST && selectionMode == convMode &&
+        selectionAzimuth == (float)azimuthDeg && selectionElevation == (float)elevationDeg) {
+        return selection;
+    }
+    selection = bank->getHrir(azimuthDeg, elevationDeg);
+    if (bank->isCompact()) {
+        selection = decodeSelection(selection);
+    }
+    selectionKind = SELECTION_NEAREST;
+    selectionMode = convMode;
+    selectionAzimuth = (float)azimuthDeg;
+    selectionElevation = (float)elevationDeg;
+    return selection;
+}
+
+SelectedHrir HrtfVoice::interpolate(float azimuthDeg, float elevationDeg) {
+    if (!bank) {
+        return SelectedHrir();
+    }
+    checkBankGeneration();
+    // Direction inchangée : ni recherche du triangle ni mélange
+    if (selectionKind == SELECTION_INTERPOLATED && selectionMode == convMode &&
+        selectionAzimuth == azimuthDeg && selectionElevation == elevationDeg) {
+        return selection;
+    }
+    selection = interpolateDirection(azimuthDeg, elevationDeg);
+    selectionKind = SELECTION_INTERPOLATED;
+    selectionMode = convMode;
+    selectionAzimuth = azimuthDeg;
+    selectionElevation = elevationDeg;
+    return selection;
+}
+
+SelectedHrir HrtfVoice::decodeSelection(const SelectedHrir& sel) {
+    // Décodage dans le buffer du mélange qui n'est pas lu par le fondu en cours ; le spectre
+    // (une FFT par partition) n'est calculé qu'en mode FFT
+    if (!blendCoeffs) {
+        return sel;
+    }
+    blendIndex ^= 1;
+    blendValid = false;
+    float* spectrum = nullptr;
+    if (convMode == HRTF_CONV_FFT && blendSpectrum) {
+        spectrum = blendSpectrum + blendIndex * bank->getSpectrumSize();
+    }
+    return bank->decodeHrir(sel, blendCoeffs + blendIndex * 2 * MAX_HRIR_LENGTH, spectrum);
+}
+
+SelectedHrir HrtfVoice::interpolateDirection(float azimuthDeg, float elevationDeg) {
+    const HrirInterpolation interp =
+        bank->getInterpolation(azimuthDeg, elevationDeg, interpolationHint);
+    interpolationHint = interp.triangle;
+    int main = 0;
+    for (int k = 1; k < 3; k++) {
+        if (interp.weights[k] > interp.weights[main]) {
+            main = k;
+        }
+    }
+    // Direction sur une mesure (ou mélange indisponible) : filtre de la banque tel quel
+    if (!blendCoeffs || interp.weights[main] >= 0.999f) {
+        const SelectedHrir sel = bank->getHrirAt(interp.slots[main]);
+        return bank->isCompact() ? decodeSelection(sel) : sel;
+    }
+
+    // Mêmes mesures et mêmes poids qu'au bloc précédent : le mélange est réutilisé
+    if (blendValid && blendMode == convMode) {
+        bool same = true;
+        for (int k = 0; k < 3; k++) {
+            same = same && interp.slots[k] == blendWeights.slots[k] &&
+                   interp.weights[k] == blendWeights.weights[k];
+        }
+        if (same) {
+            return blendHrir;
+        }
+    }
+
+    // Retard, queue et direction de la mesure de plus fort poids ; le reste est pondéré
+    SelectedHrir parts[3];
+    float w[3];
+    int count = 0;
+    for (int k = 0; k < 3; k++) {
+        if (interp.slots[k] >= 0 && interp.weights[k] > 0.0f) {
+            parts[count] = bank->getHrirAt(interp.slots[k]);
+            w[count] = interp.weights[k];
+            count++;
+        }
+    }
+    SelectedHrir sel = bank->getHrirAt(interp.slots[main]);
+    sel.length = 0;
+    sel.distance = 0.0f;
+    sel.itdLeft = 0.0f;
+    sel.itdRight = 0.0f;
+    bool spectral = convMode == HRTF_CONV_FFT && blendSpectrum;
+    for (int k = 0; k < count; k++) {
+        sel.length = (parts[k].length > sel.length) ? parts[k].length : sel.length;
+        sel.distance += w[k] * parts[k].distance;
+        sel.itdLeft  += w[k] * parts[k].itdLeft;
+        sel.itdRight += w[k] * parts[k].itdRight;
+        spectral = spectral && parts[k].spectrum;
+    }
+
+    blendIndex ^= 1;
+    const float* sources[3];
+    if (bank->isCompact()) {
+        // Banque compacte : somme pondérée des codes int16 (ou des poids PCA), puis un seul
+        // spectre pour le mélange
+        float* coeffs = blendCoeffs + blendIndex * 2 * MAX_HRIR_LENGTH;
+        int indices[3];
+        for (int k = 0; k < count; k++) {
+            indices[k] = parts[k].index;
+        }
+        bank->mixHrirs(indices, w, count, coeffs);
+        sel.coeffs = coeffs;
+        sel.spectrum = nullptr;
+        if (convMode == HRTF_CONV_FFT && blendSpectrum) {
+            float* spectrum = blendSpectrum + blendIndex * bank->getSpectrumSize();
+            bank->computeSpectrum(coeffs, sel.length, spectrum);
+            sel.spectrum = spectrum;
+        }
+    } else if (spectral) {
+        const size_t size = bank->getSpectrumSize();
+        float* spectrum = blendSpectrum + blendIndex * size;
+        for (int k = 0; k < count; k++) {
+            sources[k] = parts[k].spectrum;
+        }
+        weightedSum(spectrum, sources, w, count, size);
+        sel.spectrum = spectrum;
+    } else {
+        float* coeffs = blendCoeffs + blendIndex * 2 * MAX_HRIR_LENGTH;
+        for (int k = 0; k < count; k++) {
+            sources[k] = parts[k].coeffs;
+        }
+        weightedSum(coeffs, sources, w, count, 2 * sel.length);
+        sel.coeffs = coeffs;
+        sel.spectrum = nullptr;
+    }
+
+    blendWeights = interp;
+    blendMode = convMode;
+    blendHrir = sel;
+    blendValid = true;
+    return sel;
+}
+
+void HrtfVoice::processBlock(const float* in, float* outLeft, float* outRight,
+                             const SelectedHrir& selHrir, float gain) {
+    const float scale = gain * distanceGain(selHrir);
+    checkBankGeneration();
+
+    if (convMode == HRTF_CONV_FFT && selHrir.spectrum) {
+        processBlockFft(in, outLeft, outRight, selHrir, scale);
+    } else {
+        processBlockDirect(in, outLeft, outRight, selHrir, scale);
+    }
+
+    // HRIR à phase minimale : le retard interaural retiré au chargement est rétabli ici
+    if (bank && bank->getMinimumPhaseLength() > 0) {
+        itdLineLeft.process(outLeft, blockSize, selHrir.itdLeft);
+        itdLineRight.process(outRight, blockSize, selHrir.itdRight);
+    }
+
+    // Queue des réponses longues (BRIR) : l'historique avance même sans queue sélectionnée
+    if (tail.active()) {
+        tail.process(in, selHrir.tailSpectrum, selHrir.fullLength,
+                     outLeft, outRight, scale);
+    }
+}
+
+bool HrtfVoice::accumulateBlock(const float* in, float* spectrumAcc,
+                                float* outLeft, float* outRight,
+                                const SelectedHrir& selHrir, float gain) {
+    if (convMode != HRTF_CONV_FFT || !selHrir.spectrum ||
+        (bank && bank->getMinimumPhaseLength() > 0)) {
+        return false;
+    }
+    const float scale = gain * distanceGain(selHrir);
+    checkBankGeneration();
+
+    const float g = convolveSpectrum(in, selHrir, scale);
+    for (int k = 0; k < 2 * fftSize; k++) {
+        spectrumAcc[k] += fftWork[k] * g;
+    }
+
+    // La queue reste propre à chaque voix (ses niveaux ont leurs propres FFT)
+    if (tail.active()) {
+        tail.process(in, selHrir.tailSpectrum, selHrir.fullLength,
+                     outLeft, outRight, scale);
+    }
+    return true;
+}
+
+void HrtfVoice::processBlockDirect(const float* in, float* outLeft, float* outRight,
+                                   const SelectedHrir& selHrir, float scale) {
+    const int H = MAX_HRIR_LENGTH - 1;
+    if (!directHistory || !selHrir.coeffs) {
+        memset(outLeft, 0, blockSize * sizeof(float));
+        memset(outRight, 0, blockSize * sizeof(float));
+        return;
+    }
+
+    // Le bloc courant suit les H derniers échantillons : x[n - k] est valide pour k <= H
+    memcpy(directHistory + H, in, blockSize * sizeof(float));
+    hrtfKernels().firStereo(directHistory + H, selHrir.coeffs, (int)selHrir.length,
+                            outLeft, outRight, blockSize, scale);
+
+    // Changement de HRIR : l'ancien filtre est appliqué au même bloc et on passe de l'un à l'autre
+    const bool fade = switchMode == HRTF_SWITCH_CROSSFADE && lastCoeffs && fadeWindow &&
+                      fadeLeft && fadeRight &&
+                      (lastCoeffs != selHrir.coeffs || lastScale != scale);
+    if (fade) {
+        hrtfKernels().firStereo(directHistory + H, lastCoeffs, (int)lastLength,
+                                fadeLeft, fadeRight, blockSize, lastScale);
+        for (int n = 0; n < blockSize; n++) {
+            outLeft[n]  = fadeLeft[n]  + fadeWindow[n] * (outLeft[n]  - fadeLeft[n]);
+            outRight[n] = fadeRight[n] + fadeWindow[n] * (outRight[n] - fadeRight[n]);
+        }
+    }
+    lastCoeffs = selHrir.coeffs;
+    lastLength = selHrir.length;
+    lastScale = scale;
+    memmove(directHistory, directHistory + blockSize, H * sizeof(float));
+}
+
+void HrtfVoice::processBlockFft(const float* in, float* outLeft, float* outRight,
+                                const SelectedHrir& selHrir, float scale) {
+    const int B = blockSize;
+    const float s = convolveSpectrum(in, selHrir, scale) * fft.inverseNorm();
+    fft.inverse(fftWork);
+
+    // Overlap-save : seuls les B derniers échantillons sont valides
+    for (int n = 0; n < B; n++) {
+        outLeft[n]  = fftWork[2 * (B + n)] * s;
+        outRight[n] = fftWork[2 * (B + n) + 1] * s;
+    }
+}
+
+float HrtfVoice::convolveSpectrum(const float* in, const SelectedHrir& selHrir, float scale) {
+    const int B = blockSize;
+    const int N = fftSize;
+
+    // Fenêtre d'entrée glissante [bloc précédent | bloc courant]
+    memmove(fftInput, fftInput + B, B * sizeof(float));
+    memcpy(fftInput + B, in, B * sizeof(float));
+
+    // Le spectre le plus récent prend la place du plus ancien dans la ligne à retard
+    fdlPos = (fdlPos == 0) ? partitionCount - 1 : fdlPos - 1;
+    float* X = fdl + (size_t)fdlPos * 2 * N;
+    for (int i = 0; i < N; i++) {
+        X[2 * i]     = fftInput[i];
+        X[2 * i + 1] = 0.0f;
+    }
+    fft.forward(X);
+
+    // Changement de HRIR : le spectre d'entrée est réutilisé avec l'ancien filtre,
+    // ce qui ne coûte qu'un produit complexe de plus par partition (une seule IFFT)
+    const bool fade = switchMode == HRTF_SWITCH_CROSSFADE && lastSpectrum &&
+                      (lastSpectrum != selHrir.spectrum || lastScale != scale);
+
+    // Somme des produits spectre d'entrée retardé de p blocs * partition p de la HRIR
+    memset(fftWork, 0, 2 * N * sizeof(float));
+    if (fade) {
+        memset(fftFade, 0, 2 * N * sizeof(float));
+    }
+    for (int p = 0; p < partitionCount; p++) {
+        int slot = fdlPos + p;
+        if (slot >= partitionCount) {
+            slot -= partitionCount;
+        }
+        const float* Xp = fdl + (size_t)slot * 2 * N;
+        hrtfKernels().complexMac(fftWork, Xp, selHrir.spectrum + (size_t)p * 2 * N, N);
+        if (fade) {
+            hrtfKernels().complexMac(fftFade, Xp, lastSpectrum + (size_t)p * 2 * N, N);
+        }
+    }
+    // Le fondu applique les gains lui-même, sinon ils restent à appliquer après l'IFFT
+    float remaining = scale;
+    if (fade) {
+        crossfadeSpectrum(fftWork, fftFade, scale, lastScale);
+        remaining = 1.0f;
+    }
+    lastSpectrum = selHrir.spectrum;
+    lastScale = scale;
+    return remaining;
+}
+
+void HrtfVoice::crossfadeSpectrum(float* spectrum, float* previous,
+                                  float scale, float previousScale) const {
+    // Sortie voulue : y = y_old + w * (y_new - y_old), avec w(n) = 0.5 + 0.5*cos(2*pi*n/N)
+    // qui monte de 0 à 1 sur la moitié valide de l'overlap-save.
+    // Un produit par w dans le temps est une convolution circulaire en fréquence par
+    // le noyau {0.25, 0.5, 0.25} sur les raies k-1, k, k+1, d'où
+    //   Y[k] = Y_new[k] - 0.5*D[k] + 0.25*(D[k-1] + D[k+1]),  D = Y_new - Y_old
+    // Le gain de chaque filtre est appliqué ici ; previous sert de tampon pour D.
+    const int N = fftSize;
+    float* D = previous;
+    for (int k = 0; k < 2 * N; k += 2) {
+        const float newRe = spectrum[k] * scale, newIm = spectrum[k + 1] * scale;
+        D[k]     = newRe - D[k] * previousScale;
+        D[k + 1] = newIm - D[k + 1] * previousScale;
+        spectrum[k]     = newRe;
+        spectrum[k + 1] = newIm;
+    }
+    for (int k = 0; k < N; k++) {
+        const int km = (k == 0) ? N - 1 : k - 1;
+        const int kp = (k == N - 1) ? 0 : k + 1;
+        spectrum[2 * k]     += -0.5f * D[2 * k]     + 0.25f * (D[2 * km]     + D[2 * kp]);
+        spectrum[2 * k + 1] += -0.5f * D[2 * k + 1] + 0.25f * (D[2 * km + 1] + D[2 * kp + 1]);
+    }
+}
@@ -0,0 +1,165 @@
+#ifndef HRTF_VOICE_H
+#define HRTF_VOICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "HrtfBank.h"
+#include "HrtfFft.h"
+#include "HrtfLongConvolver.h"
+#include "HrtfDelayLine.h"
+
+// Noyau de convolution utilisé par processBlock
+enum HrtfConvolutionMode {
+    HRTF_CONV_DIRECT,  // convolution temporelle directe (HrtfKernels::firStereo)
+    HRTF_CONV_FFT      // overlap-save partitionné uniformément
+};
+
+// Passage d'une HRIR à une autre entre deux blocs
+enum HrtfSwitchMode {
+    HRTF_SWITCH_HARD,      // le nouveau filtre s'applique d'un coup (bruit de « zipper » en rotation)
+    HRTF_SWITCH_CROSSFADE  // fondu enchaîné sur un bloc entre l'ancien et le nouveau filtre
+};
+
+// État de convolution d'une source : historique d'entrée, ligne à retard fréquentielle,
+// fondu et queue. Quelques Ko par voix ; les HRIR sont lues dans une HrtfBank partagée.
+class HrtfVoice {
+public:
+    HrtfVoice();
+    ~HrtfVoice();
+
+    // Alloue l'état pour la banque (taille de bloc, partitions, queues).
+    // À rappeler hors interruption audio après chaque rechargement de la banque.
+    bool init(const HrtfBank& bank);
+    // Changement de banque sans coupure (sujet chargé en arrière-plan, voir
+    // MyDsp::loadSubject). prepareBank, hors interruption audio, alloue ce que la nouvelle
+    // banque demande en plus (décodage d'une banque compacte) ; false si son découpage (bloc,
+    // FFT) ou ses queues dépassent ce que la voix a réservé : la rappeler alors avec init.
+    // setBank, entre deux blocs, passe ensuite à la nouvelle banque sans rien allouer : la
+    // sélection est refaite, et le filtre du dernier bloc, lu dans l'ancienne banque, sert au
+    // fondu enchaîné du bloc suivant (l'ancienne banque reste valide jusqu'à la fin de ce bloc).
+    bool prepareBank(const HrtfBank& bank);
+    bool setBank(const HrtfBank& bank);
+
+    // Convolution avec le noyau courant (naïf ou FFT) et gain
+    void processBlock(const float* in, float* outLeft, float* outRight,
+                      const SelectedHrir& selHrir, float gain = 1.0f);
+
+    // Variante pour un mélangeur multi-sources : le spectre de sortie de la tête (gain compris)
+    // est ajouté à spectrumAcc (fftSize complexes) au lieu d'être transformé ici, pour une seule
+    // IFFT commune à toutes les voix ; la queue éventuelle est ajoutée à outLeft/outRight.
+    // Retourne false sans rien traiter si la voix n'est pas en mode FFT, ou si la banque est à
+    // phase minimale (l'ITD s'applique après la transformée inverse) : utiliser processBlock.
+    bool accumulateBlock(const float* in, float* spectrumAcc,
+                         float* outLeft, float* outRight,
+                         const SelectedHrir& selHrir, float gain = 1.0f);
+
+    // Mesure la plus proche (HrtfBank::getHrir), mémorisée : tant que la direction ne change
+    // pas, la sélection du bloc précédent est rendue sans rien recalculer. Sur une banque
+    // compacte, la mesure est décodée (coefficients, et spectre en mode FFT) à chaque changement.
+    SelectedHrir select(int azimuthDeg, int elevationDeg);
+
+    // Filtre interpolé pour une direction quelconque en degrés fractionnaires, à passer ensuite
+    // à processBlock/accumulateBlock : somme pondérée des mesures encadrantes
+    // (HrtfBank::getInterpolation), sur les spectres en mode FFT (les coefficients retournés
+    // sont alors ceux de la mesure de plus fort poids) et sur les coefficients en mode direct.
+    // L'ITD des banques à phase minimale est interpolé lui aussi. Le mélange n'est refait que
+    // si les poids changent, et rien n'est recalculé si la direction est la même qu'au bloc
+    // précédent ; sans setInterpolation(true), la mesure de plus fort poids.
+    SelectedHrir interpolate(float azimuthDeg, float elevationDeg);
+
+    // Alloue ou libère les buffers du mélange (hors interruption audio)
+    bool setInterpolation(bool enabled);
+    bool getInterpolation() const { return interpolationEnabled; }
+
+    // Choix du noyau de convolution (l'historique est remis à zéro)
+    void setConvolutionMode(HrtfConvolutionMode mode);
+    HrtfConvolutionMode getConvolutionMode() const { return convMode; }
+
+    // Comportement lors d'un changement de HRIR (fondu enchaîné par défaut)
+    void setSwitchMode(HrtfSwitchMode mode) { switchMode = mode; }
+    HrtfSwitchMode getSwitchMode() const { return switchMode; }
+
+    int getBlockSize() const { return blockSize; }
+    int getFftSize() const { return fftSize; }
+
+    // Remise à zéro de l'historique (changement de source)
+    void reset();
+
+private:
+    HrtfVoice(const HrtfVoice&);
+    HrtfVoice& operator=(const HrtfVoice&);
+
+    static float distanceGain(const SelectedHrir& selHrir);
+    bool allocateBlend();
+    SelectedHrir interpolateDirection(float azimuthDeg, float elevationDeg);
+    SelectedHrir decodeSelection(const SelectedHrir& sel);
+    void checkBankGeneration();
+    bool compatibleBank(const HrtfBank& b) const;
+    // Spectre de sortie de la tête dans fftWork ; retourne le gain restant à appliquer
+    float convolveSpectrum(const float* in, const SelectedHrir& selHrir, float scale);
+    void processBlockDirect(const float* in, float* outLeft, float* outRight,
+                            const SelectedHrir& selHrir, float scale);
+    void processBlockFft(const float* in, float* outLeft, float* outRight,
+                         const SelectedHrir& selHrir, float scale);
+    void crossfadeSpectrum(float* spectrum, float* previous,
+                           float scale, float previousScale) const;
+
+    const HrtfBank* bank;
+    uint32_t bankGeneration;
+    uint32_t bankCacheVersion;
+    int blockSize;
+
+    // Forme directe : [MAX_HRIR_LENGTH - 1 échantillons passés | bloc courant]
+    float* directHistory;
+
+    // Convolution FFT (même découpage que les spectres de la banque)
+    HrtfConvolutionMode convMode;
+    HrtfFft fft;
+    int fftSize;
+    int partitionCount;
+    float* fftInput;      // [bloc précédent | bloc courant]
+    float* fdl;           // ligne à retard fréquentielle : partitionCount spectres d'entrée
+    float* fftWork;
+    int fdlPos;
+
+    // Fondu enchaîné : filtre du bloc précédent et fenêtre de montée sur un bloc
+    HrtfSwitchMode switchMode;
+    const float* lastCoeffs;
+    size_t lastLength;
+    const float* lastSpectrum;
+    float lastScale;
+    float* fadeWindow;    // 0.5 - 0.5*cos(pi*n/B), identique à la fenêtre appliquée en fréquence
+    float* fadeLeft;      // sortie de l'ancien filtre (forme directe)
+    float* fadeRight;
+    float* fftFade;       // produit avec l'ancien spectre (FFT)
+
+    // ITD des HRIR à phase minimale, appliqué en sortie sur chaque oreille
+    HrtfDelayLine itdLineLeft;
+    HrtfDelayLine itdLineRight;
+
+    // Queue des réponses plus longues que MAX_HRIR_LENGTH, réservée pour tailCapacity taps
+    HrtfLongConvolver tail;
+    size_t tailCapacity;
+
+    // Interpolation et décodage des banques compactes : deux jeux de buffers utilisés en
+    // alternance, pour que le filtre du bloc précédent reste lisible pendant le fondu
+    bool interpolationEnabled;
+    float* blendCoeffs;     // 2 x 2*MAX_HRIR_LENGTH
+    float* blendSpectrum;   // 2 x bank->getSpectrumSize() (nul sans FFT)
+    int blendIndex;
+    bool blendValid;        // blendHrir correspond à blendWeights dans le mode blendMode
+    HrirInterpolation blendWeights;
+    HrtfConvolutionMode blendMode;
+    SelectedHrir blendHrir;
+    int interpolationHint;  // triangle du dernier appel
+
+    // Dernière sélection (select ou interpolate) et la direction qui l'a produite
+    enum SelectionKind { SELECTION_NONE, SELECTION_NEAREST, SELECTION_INTERPOLATED };
+    SelectionKind selectionKind;
+    float selectionAzimuth;
+    float selectionElevation;
+    HrtfConvolutionMode selectionMode;
+    SelectedHrir selection;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "ImaAdpcm.h"
+#include <string.h>
+
+static const int16_t STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552,
+    1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+    7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+    24623, 27086, 29794, 32767
+};
+
+static const int8_t INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// Un quartet : nouveau prédicteur et index du pas (communs au codeur et au décodeur)
+static inline void applyNibble(int nibble, int32_t& predictor, int32_t& index) {
+    const int32_t step = STEP_TABLE[index];
+    int32_t diff = step >> 3;
+    if (nibble & 1) diff += step >> 2;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 4) diff += step;
+    predictor += (nibble & 8) ? -diff : diff;
+    predictor = (predictor > 32767) ? 32767 : (predictor < -32768 ? -32768 : predictor);
+    index += INDEX_TABLE[nibble];
+    index = (index < 0) ? 0 : (index > 88 ? 88 : index);
+}
+
+ImaAdpcmDecoder::ImaAdpcmDecoder()
+: block(nullptr), channels(1), blockFrames(0), position(0)
+{
+    memset(predictor, 0, sizeof(predictor));
+    memset(stepIndex, 0, sizeof(stepIndex));
+}
+
+uint32_t ImaAdpcmDecoder::samplesPerBlock(int channels, uint32_t blockAlign) {
+    if (channels < 1 || blockAlign <= 4u * channels) {
+        return 0;
+    }
+    return (blockAlign - 4 * channels) * 2 / channels + 1;
+}
+
+void ImaAdpcmDecoder::begin(int channelCount) {
+    channels = (channelCount > MAX_CHANNELS) ? MAX_CHANNELS : channelCount;
+    block = nullptr;
+    blockFrames = 0;
+    position = 0;
+}
+
+void ImaAdpcmDecoder::startBlock(const uint8_t* data, uint32_t frames) {
+    block = data;
+    blockFrames = frames;
+    position = 0;
+    for (int c = 0; c < channels; c++) {
+        const uint8_t* h = data + 4 * c;
+        predictor[c] = (int16_t)(h[0] | (h[1] << 8));
+        stepIndex[c] = (h[2] > 88) ? 88 : h[2];
+    }
+}
+
+int ImaAdpcmDecoder::decode(int16_t* const* out, int count) {
+    if ((uint32_t)count > remaining()) {
+        count = (int)remaining();
+    }
+    const uint8_t* data = block + 4 * channels;
+    for (int c = 0; c < channels; c++) {
+        int16_t* dst = out[c];
+        int32_t pred = predictor[c];
+        int32_t index = stepIndex[c];
+        uint32_t p = position;
+        int n = 0;
+        if (p == 0 && n < count) {
+            dst[n++] = (int16_t)pred;   // échantillon de l'en-tête
+            p++;
+        }
+        for (; n < count; n++, p++) {
+            // Groupes de 8 échantillons (4 octets) par canal
+            const uint32_t k = p - 1;
+            const uint8_t b = data[(k >> 3) * 4 * channels + 4 * c + ((k & 7) >> 1)];
+            applyNibble((k & 1) ? (b >> 4) : (b & 0x0F), pred, index);
+            dst[n] = (int16_t)pred;
+        }
+        predictor[c] = pred;
+        stepIndex[c] = index;
+    }
+    position += count;
+    return count;
+}
+
+void imaAdpcmEncodeBlock(const int16_t* frames, uint32_t count, int channels,
+                         uint32_t blockAlign, int32_t* stepIndex, uint8_t* block) {
+    const uint32_t spb = ImaAdpcmDecoder::samplesPerBlock(channels, blockAlign);
+    memset(block, 0, blockAlign);
+    uint8_t* data = block + 4 * channels;
+    for (int c = 0; c < channels; c++) {
+        int32_t pred = (count > 0) ? frames[c] : 0;
+        int32_t index = stepIndex[c];
+        block[4 * c] = (uint8_t)pred;
+        block[4 * c + 1] = (uint8_t)(pred >> 8);
+        block[4 * c + 2] = (uint8_t)index;
+        for (uint32_t k = 0; k + 1 < spb; k++) {
+            // Au-delà de la fin : le prédicteur est maintenu
+            const int32_t sample = (k + 1 < count) ? frames[(k + 1) * channels + c] : pred;
+            int32_t diff = sample - pred;
+            int nibble = 0;
+            if (diff < 0) {
+                nibble = 8;
+                diff = -diff;
+            }
+            int32_t step = STEP_TABLE[index];
+            if (diff >= step) { nibble |= 4; diff -= step; }
+            step >>= 1;
+            if (diff >= step) { nibble |= 2; diff -= step; }
+            step >>= 1;
+            if (diff >= step) { nibble |= 1; }
+            applyNibble(nibble, pred, index);
+            data[(k >> 3) * 4 * channels + 4 * c + ((k & 7) >> 1)] |=
+                (uint8_t)((k & 1) ? (nibble << 4) : nibble);
+        }
+        stepIndex[c] = index;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <stdint.h>
+
+// IMA-ADPCM des fichiers WAV (format 0x11, écrits par assets/encodeAdpcm.py) : 4 bits par
+// échantillon, en blocs indépendants de blockAlign octets. Chaque bloc commence, pour chaque
+// canal, par le premier échantillon (int16), l'index du pas et un octet nul ; suivent, en
+// stéréo, 4 octets (8 échantillons) du canal gauche puis 4 du droit, et ainsi de suite.
+// Le premier quartet d'un octet est celui de poids faible.
+class ImaAdpcmDecoder {
+public:
+    static const int MAX_CHANNELS = 2;
+
+    ImaAdpcmDecoder();
+
+    // Échantillons par bloc d'un fichier (même calcul que l'en-tête WAV)
+    static uint32_t samplesPerBlock(int channels, uint32_t blockAlign);
+
+    void begin(int channels);
+    // Bloc suivant : lit l'en-tête de chaque canal. frames : trames à en décoder (moins que
+    // samplesPerBlock pour le dernier bloc d'un fichier)
+    void startBlock(const uint8_t* block, uint32_t frames);
+    // Trames du bloc courant restant à décoder
+    uint32_t remaining() const { return blockFrames - position; }
+    // Décode au plus count trames du bloc courant, canal c dans out[c] ; coût borné par count.
+    // Retourne le nombre de trames décodées.
+    int decode(int16_t* const* out, int count);
+
+private:
+    const uint8_t* block;
+    int channels;
+    uint32_t blockFrames;
+    uint32_t position;      // trame suivante dans le bloc
+    int32_t predictor[MAX_CHANNELS];
+    int32_t stepIndex[MAX_CHANNELS];
+};
+
+// Encodage d'un bloc de frames trames (int16 entrelacés, frames <= samplesPerBlock) vers
+// blockAlign octets ; stepIndex[c] est repris d'un bloc au suivant (0 au départ). Mêmes
+// décisions que assets/encodeAdpcm.py ; utilisé par le banc d'essai.
+void imaAdpcmEncodeBlock(const int16_t* frames, uint32_t count, int channels,
+                         uint32_t blockAlign, int32_t* stepIndex, uint8_t* block);
+
+#endif
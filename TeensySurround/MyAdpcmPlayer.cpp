@@ -0,0 +1,194 @@
+#include "MyAdpcmPlayer.h"
+#include <Arduino.h>
+#include <Audio.h>
+#include <string.h>
+
+MyAdpcmPlayer::MyAdpcmPlayer()
+: AudioStream(0, nullptr), blockAlign(0), blockSamples(0), ringBlocks(0), channels(1),
+  rate(0), length(0), writeBlocks(0), readBlocks(0), decodedFrames(0), blockActive(false),
+  endOfData(false), playing(false), minFill(0), underruns(0), renderedFrames(0),
+  cardReads(0), cardBytes(0)
+{
+}
+
+bool MyAdpcmPlayer::play(const char* filename) {
+    stop();
+    AudioNoInterrupts();
+    bool ok = reader.open(filename);
+    AudioInterrupts();
+    if (ok && (!reader.isAdpcm() || reader.blockAlign() > RING_BYTES / 2)) {
+        Serial.print("Fichier IMA-ADPCM illisible par le lecteur : ");
+        Serial.println(filename);
+        reader.close();
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+    blockAlign = reader.blockAlign();
+    blockSamples = reader.samplesPerBlock();
+    ringBlocks = RING_BYTES / blockAlign;
+    channels = reader.channels();
+    rate = reader.sampleRate();
+    length = reader.lengthFrames();
+    decoder.begin(channels);
+    // Tampon rempli d'avance : la lecture démarre sans attendre loop()
+    while (fillChunk()) {
+    }
+    resetStats();
+    playing = true;
+    return true;
+}
+
+void MyAdpcmPlayer::stop() {
+    AudioNoInterrupts();
+    playing = false;
+    reader.close();
+    writeBlocks = 0;
+    readBlocks = 0;
+    decodedFrames = 0;
+    blockActive = false;
+    endOfData = false;
+    decoder.begin(channels);
+    AudioInterrupts();
+}
+
+void MyAdpcmPlayer::service() {
+    // Quelques lectures par passage : loop() traite aussi les commandes
+    for (int i = 0; i < 4 && playing && fillChunk(); i++) {
+    }
+}
+
+bool MyAdpcmPlayer::fillChunk() {
+    if (!reader.isOpen()) {
+        return false;
+    }
+    // Le bloc en cours de décodage garde sa place jusqu'à la fin
+    const uint32_t free = ringBlocks - (writeBlocks - readBlocks);
+    if (free == 0) {
+        return false;
+    }
+    const uint32_t pos = writeBlocks % ringBlocks;
+    uint32_t count = READ_BYTES / blockAlign;
+    count = (count < 1) ? 1 : count;
+    count = (count > free) ? free : count;
+    count = (count > ringBlocks - pos) ? ringBlocks - pos : count;
+
+    AudioNoInterrupts();
+    const int got = reader.readBlocks(ring + pos * blockAlign, (int)count);
+    AudioInterrupts();
+    if (got <= 0) {
+        // Tout le fichier est dans le tampon
+        reader.close();
+        __disable_irq();
+        endOfData = true;
+        __enable_irq();
+        return false;
+    }
+    cardReads++;
+    cardBytes += got * blockAlign;
+    // Blocs visibles par l'interruption une fois écrits
+    __disable_irq();
+    writeBlocks += got;
+    __enable_irq();
+    return true;
+}
+
+uint32_t MyAdpcmPlayer::getBufferFill() const {
+    __disable_irq();
+    uint32_t frames = (writeBlocks - readBlocks) * blockSamples;
+    if (blockActive) {
+        frames -= blockSamples - decoder.remaining();
+    }
+    __enable_irq();
+    return frames;
+}
+
+uint32_t MyAdpcmPlayer::positionMillis() const {
+    if (rate == 0 || !playing) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)decodedFrames * 1000 / rate);
+}
+
+uint32_t MyAdpcmPlayer::lengthMillis() const {
+    if (rate == 0 || !playing) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)length * 1000 / rate);
+}
+
+void MyAdpcmPlayer::resetStats() {
+    const uint32_t fill = getBufferFill();
+    __disable_irq();
+    minFill = fill;
+    underruns = 0;
+    renderedFrames = 0;
+    __enable_irq();
+    cardReads = 0;
+    cardBytes = 0;
+}
+
+void MyAdpcmPlayer::update() {
+    if (!playing) {
+        return;
+    }
+    audio_block_t* outBlock[2];
+    outBlock[0] = allocate();
+    if (!outBlock[0]) {
+        return;
+    }
+    outBlock[1] = allocate();
+    if (!outBlock[1]) {
+        release(outBlock[0]);
+        return;
+    }
+
+    uint32_t available = (writeBlocks - readBlocks) * blockSamples;
+    if (blockActive) {
+        available -= blockSamples - decoder.remaining();
+    }
+    minFill = (available < minFill) ? available : minFill;
+
+    // Blocs déjà en RAM seulement ; le manque est complété par du silence
+    uint32_t done = 0;
+    while (done < AUDIO_BLOCK_SAMPLES) {
+        if (decoder.remaining() == 0) {
+            if (blockActive) {
+                readBlocks++;       // place libérée pour loop()
+                blockActive = false;
+            }
+            const uint32_t start = readBlocks * blockSamples;
+            if (writeBlocks == readBlocks || start >= length) {
+                break;
+            }
+            const uint32_t frames = (length - start < blockSamples) ? length - start : blockSamples;
+            decoder.startBlock(ring + (readBlocks % ringBlocks) * blockAlign, frames);
+            blockActive = true;
+        }
+        int16_t* dest[2] = { outBlock[0]->data + done, outBlock[1]->data + done };
+        done += decoder.decode(dest, AUDIO_BLOCK_SAMPLES - done);
+    }
+    if (channels == 1) {
+        memcpy(outBlock[1]->data, outBlock[0]->data, done * sizeof(int16_t));
+    }
+    for (uint32_t i = done; i < AUDIO_BLOCK_SAMPLES; i++) {
+        outBlock[0]->data[i] = 0;
+        outBlock[1]->data[i] = 0;
+    }
+    decodedFrames += done;
+    renderedFrames += done;
+
+    if (done < AUDIO_BLOCK_SAMPLES) {
+        if (endOfData || decodedFrames >= length) {
+            playing = false;
+        } else {
+            underruns++;
+        }
+    }
+
+    transmit(outBlock[0], 0);
+    transmit(outBlock[1], 1);
+    release(outBlock[0]);
+    release(outBlock[1]);
+}
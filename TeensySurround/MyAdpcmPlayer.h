@@ -0,0 +1,79 @@
+#ifndef MY_ADPCM_PLAYER_H
+#define MY_ADPCM_PLAYER_H
+
+#include "HrtfConfig.h"
+#include "ImaAdpcm.h"
+#include "SdWavReader.h"
+#include <AudioStream.h>
+
+// Lecteur de WAV IMA-ADPCM mono ou stéréo (4 bits par échantillon, assets/encodeAdpcm.py) :
+// quatre fois moins d'octets lus sur la carte SD et de place sur la carte qu'en PCM 16 bits.
+// Comme MyStreamPlayer, les blocs compressés sont lus depuis loop() (service), dans un tampon
+// de HRTF_ADPCM_BUFFER_BYTES octets gardé compressé ; l'interruption audio décode 128 trames
+// par update, pour un coût borné quelle que soit la taille des blocs du fichier.
+// Sorties 0 et 1 : gauche et droite (un fichier mono sort sur les deux).
+class MyAdpcmPlayer : public AudioStream {
+public:
+    MyAdpcmPlayer();
+    virtual void update();
+
+    static bool canPlay(const SdWavReader& reader) { return reader.isAdpcm(); }
+
+    // Le début du fichier est lu ici ; false si le fichier est illisible ou si ses blocs
+    // dépassent la moitié du tampon
+    bool play(const char* filename);
+    void stop();
+    // À appeler depuis loop() : quelques lectures pour remplir le tampon (audio suspendu pendant
+    // chacune, la carte SD étant partagée avec les lecteurs qui la lisent sur l'interruption)
+    void service();
+
+    bool isPlaying() const { return playing; }
+    uint32_t positionMillis() const;
+    uint32_t lengthMillis() const;
+
+    // Remplissage en trames (tampon compressé), minimum vu par l'interruption depuis resetStats,
+    // blocs rendus incomplets faute de données ; lectures et octets lus sur la carte, et trames
+    // rendues depuis resetStats (octets par seconde d'audio : cardBytes * rate / frames)
+    uint32_t getBufferFill() const;
+    uint32_t getBufferCapacity() const { return ringBlocks * blockSamples; }
+    uint32_t getMinFill() const { return minFill; }
+    uint32_t getUnderruns() const { return underruns; }
+    uint32_t getCardReads() const { return cardReads; }
+    uint32_t getCardBytes() const { return cardBytes; }
+    uint32_t getRenderedFrames() const { return renderedFrames; }
+    uint32_t getSampleRate() const { return rate; }
+    void resetStats();
+
+private:
+    MyAdpcmPlayer(const MyAdpcmPlayer&);
+    MyAdpcmPlayer& operator=(const MyAdpcmPlayer&);
+
+    static const uint32_t RING_BYTES = HRTF_ADPCM_BUFFER_BYTES;
+    // Octets lus au plus par lecture (en blocs entiers, au moins un)
+    static const uint32_t READ_BYTES = 4096;
+
+    bool fillChunk();
+
+    SdWavReader reader;
+    ImaAdpcmDecoder decoder;   // utilisé par l'interruption seulement
+    uint8_t ring[RING_BYTES];  // blocs compressés, ringBlocks places de blockAlign octets
+    uint32_t blockAlign;
+    uint32_t blockSamples;
+    uint32_t ringBlocks;
+    int channels;
+    uint32_t rate;
+    uint32_t length;
+    volatile uint32_t writeBlocks;    // blocs écrits depuis play (loop)
+    volatile uint32_t readBlocks;     // blocs entièrement décodés (interruption)
+    volatile uint32_t decodedFrames;  // trames rendues depuis play
+    bool blockActive;                 // un bloc du tampon est en cours de décodage
+    volatile bool endOfData;          // tout est écrit : fin de lecture quand le tampon est vide
+    volatile bool playing;
+    volatile uint32_t minFill;
+    volatile uint32_t underruns;
+    volatile uint32_t renderedFrames;
+    uint32_t cardReads;
+    uint32_t cardBytes;
+};
+
+#endif
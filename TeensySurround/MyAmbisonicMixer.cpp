@@ -0,0 +1,214 @@
+#include "MyAmbisonicMixer.h"
+#include "HrtfConfig.h"
+#include <Arduino.h>
+#include <Audio.h>
+#include <string.h>
+#include <math.h>
+
+#define MULT_16 32767
+
+static int clampInputCount(int count) {
+    if (count < 0) {
+        return 0;
+    }
+    return (count > MyAmbisonicMixer::MAX_INPUTS) ? MyAmbisonicMixer::MAX_INPUTS : count;
+}
+
+MyAmbisonicMixer::MyAmbisonicMixer(int count, int ord, HrtfBank* sharedBank)
+: AudioStream(clampInputCount(count), inputQueueArray),
+  sourceCount(clampInputCount(count)),
+  order(ord < 1 ? 1 : (ord > HRTF_AMBI_MAX_ORDER ? HRTF_AMBI_MAX_ORDER : ord)),
+  bank(sharedBank), playing(false), fuma(false), idleBlocks(0)
+{
+}
+
+void MyAmbisonicMixer::begin() {
+    if (!bank) {
+        bank = new HrtfBank();
+    }
+
+    // La banque partagée n'est chargée qu'une fois, par le premier nœud
+    if (bank->getHrirCount() == 0) {
+        bank->init(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
+        bank->setMinimumPhase(HRTF_MINIMUM_PHASE_LENGTH);
+        bank->setCompactStorage(HRTF_COMPACT_BANK);
+        bank->setSymmetricStorage(HRTF_SYMMETRIC_BANK);
+        bank->setCacheSize(HRTF_CACHE_SIZE);
+        // Banque compilée en flash (HRTF_FLASH_BANK), sinon fichier de la carte SD
+        const HrtfFlashBank* flash = hrtfFlashBank();
+        if (flash ? !bank->loadFromFlash(*flash) : !bank->loadFromBin(HRTF_BANK_FILE)) {
+            Serial.println(flash ? "Echec du loadFromFlash" : "Echec du loadFromBin");
+        }
+    }
+    AudioNoInterrupts();
+    if (!mixer.init(*bank, order, sourceCount)) {
+        Serial.println("Mémoire insuffisante pour le décodeur ambisonique");
+    }
+    AudioInterrupts();
+}
+
+int MyAmbisonicMixer::fileOrder(const SdWavReader& r) {
+    return fileOrder(r.channels(), r.isBFormat());
+}
+
+int MyAmbisonicMixer::fileOrder(int channels, bool bformat) {
+    // Le FuMa n'est converti qu'à l'ordre 1 (l'ordre des composantes diffère au-delà)
+    if (bformat) {
+        return (channels == 4) ? 1 : 0;
+    }
+    for (int n = 1; n <= HRTF_AMBI_MAX_ORDER; n++) {
+        if (channels == hrtfAmbisonicChannels(n)) {
+            return n;
+        }
+    }
+    return 0;
+}
+
+bool MyAmbisonicMixer::play(const char* filename) {
+    stop();
+    // Le fichier est ensuite lu dans update() : ouverture avec l'audio suspendu
+    AudioNoInterrupts();
+    bool ok = reader.open(filename);
+    if (ok && fileOrder(reader) == 0) {
+        Serial.print("Fichier non ambisonique : ");
+        Serial.println(filename);
+        reader.close();
+        ok = false;
+    }
+    if (ok) {
+        fuma = reader.isBFormat();
+        // 44100 Hz est lu à AUDIO_SAMPLE_RATE_EXACT comme par AudioPlaySdWav
+        if (fabsf((float)reader.sampleRate() - AUDIO_SAMPLE_RATE_EXACT) > 0.01f * AUDIO_SAMPLE_RATE_EXACT) {
+            Serial.print("Attention : fichier ambisonique à ");
+            Serial.print(reader.sampleRate());
+            Serial.println(" Hz, lu sans conversion");
+        }
+        playing = true;
+    }
+    AudioInterrupts();
+    return ok;
+}
+
+void MyAmbisonicMixer::stop() {
+    AudioNoInterrupts();
+    playing = false;
+    reader.close();
+    AudioInterrupts();
+}
+
+uint32_t MyAmbisonicMixer::positionMillis() const {
+    if (reader.sampleRate() == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)reader.positionFrames() * 1000 / reader.sampleRate());
+}
+
+uint32_t MyAmbisonicMixer::lengthMillis() const {
+    if (reader.sampleRate() == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)reader.lengthFrames() * 1000 / reader.sampleRate());
+}
+
+void MyAmbisonicMixer::setSource(int index, int azimuthDeg, int elevationDeg, float gain) {
+    if (index < 0 || index >= sourceCount) {
+        return;
+    }
+    __disable_irq();
+    mixer.setSource(index, azimuthDeg, elevationDeg, gain);
+    __enable_irq();
+}
+
+void MyAmbisonicMixer::setRotation(int yawDeg) {
+    __disable_irq();
+    mixer.setRotation((float)yawDeg);
+    __enable_irq();
+}
+
+void MyAmbisonicMixer::setConvolutionMode(HrtfConvolutionMode mode) {
+    __disable_irq();
+    mixer.setConvolutionMode(mode);
+    __enable_irq();
+}
+
+void MyAmbisonicMixer::update() {
+    // Entrées non connectées ou silencieuses : pointeur nul, la source est muette
+    const float* inputs[MAX_INPUTS];
+    bool active = false;
+    for (int s = 0; s < sourceCount; s++) {
+        audio_block_t* inBlock = receiveReadOnly(s);
+        inputs[s] = nullptr;
+        if (inBlock) {
+            for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                inFloat[s][i] = inBlock->data[i] / 32768.0f;
+            }
+            release(inBlock);
+            inputs[s] = inFloat[s];
+            active = true;
+        }
+    }
+
+    // Fichier : un bloc de toutes les composantes utiles, complété par du silence en fin
+    const int C = mixer.getChannelCount();
+    const float* bformat[HRTF_AMBI_MAX_CHANNELS];
+    int bformatChannels = 0;
+    if (playing) {
+        // Canal c du fichier -> composante ACN ; FuMa WXYZ -> ACN W Y Z X
+        static const int FUMA_TO_ACN[4] = { 0, 3, 1, 2 };
+        float* dst[HRTF_AMBI_MAX_CHANNELS];
+        bformatChannels = (reader.channels() < C) ? reader.channels() : C;
+        for (int c = 0; c < bformatChannels; c++) {
+            dst[c] = fileFloat[fuma ? FUMA_TO_ACN[c] : c];
+            bformat[c] = fileFloat[c];
+        }
+        int frames = reader.read(dst, bformatChannels, AUDIO_BLOCK_SAMPLES);
+        for (int c = 0; c < bformatChannels; c++) {
+            memset(fileFloat[c] + frames, 0, (AUDIO_BLOCK_SAMPLES - frames) * sizeof(float));
+        }
+        if (fuma) {
+            for (int i = 0; i < frames; i++) {
+                fileFloat[0][i] *= 1.4142136f;
+            }
+        }
+        if (frames < AUDIO_BLOCK_SAMPLES) {
+            playing = false;
+            reader.close();
+        }
+        active = true;
+    }
+
+    // Sans entrée, quelques blocs de plus pour vider les filtres, puis plus rien à rendre
+    if (active) {
+        idleBlocks = 0;
+    } else if (++idleBlocks > 2) {
+        idleBlocks = 3;
+        return;
+    }
+
+    audio_block_t* outBlock[2];
+    outBlock[0] = allocate();
+    if (!outBlock[0]) {
+        return;
+    }
+    outBlock[1] = allocate();
+    if (!outBlock[1]) {
+        release(outBlock[0]);
+        return;
+    }
+
+    mixer.process(inputs, bformatChannels ? bformat : nullptr, bformatChannels,
+                  outFloatLeft, outFloatRight);
+
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        float l = outFloatLeft[i] * MULT_16;
+        float r = outFloatRight[i] * MULT_16;
+        // Plusieurs sources peuvent dépasser la pleine échelle : saturation
+        outBlock[0]->data[i] = (int16_t)(l > 32767.0f ? 32767.0f : (l < -32768.0f ? -32768.0f : l));
+        outBlock[1]->data[i] = (int16_t)(r > 32767.0f ? 32767.0f : (r < -32768.0f ? -32768.0f : r));
+    }
+
+    transmit(outBlock[0], 0);
+    transmit(outBlock[1], 1);
+    release(outBlock[0]);
+    release(outBlock[1]);
+}
@@ -0,0 +1,63 @@
+#ifndef MY_AMBISONIC_MIXER_H
+#define MY_AMBISONIC_MIXER_H
+
+#include "HrtfBank.h"
+#include "HrtfAmbisonicMixer.h"
+#include "SdWavReader.h"
+#include <AudioStream.h>
+
+// Nœud audio de rendu ambisonique : N entrées mono encodées sur un bus d'ordre 1 à 3,
+// plus la lecture d'un fichier ambisonique de la carte SD (lu dans update(), comme
+// AudioPlaySdWav), décodés ensemble vers une sortie stéréo binaurale. Fichiers reconnus :
+//   AmbiX : 4, 9 ou 16 canaux (ordre 1 à 3), ACN/SN3D, tel quel
+//   FuMa  : B-format d'ordre 1 (sous-format B-format), converti à la lecture
+//           (W * sqrt(2), WXYZ -> ACN W Y Z X)
+// Un WAV PCM quelconque à 4, 9 ou 16 canaux est considéré comme de l'AmbiX.
+//   MyAmbisonicMixer ambi(0, 1, &bank);   // lecteur de fichiers seul, ordre 1
+//   ambi.play("/scene.wav");  ambi.setRotation(angle);
+class MyAmbisonicMixer : public AudioStream {
+public:
+    static const int MAX_INPUTS = 16;
+
+    MyAmbisonicMixer(int sourceCount, int order = 1, HrtfBank* sharedBank = nullptr);
+    void begin();
+    virtual void update();
+
+    // Ordre ambisonique d'un fichier ouvert, 0 s'il n'est pas ambisonique
+    static int fileOrder(const SdWavReader& reader);
+    // Même choix d'après les canaux et le sous-format (index de SdMediaLibrary)
+    static int fileOrder(int channels, bool bformat);
+
+    // Lecture d'un fichier ambisonique (composantes au-delà de l'ordre du bus ignorées)
+    bool play(const char* filename);
+    void stop();
+    bool isPlaying() const { return playing; }
+    uint32_t positionMillis() const;
+    uint32_t lengthMillis() const;
+
+    void setSource(int index, int azimuthDeg, int elevationDeg, float gain);
+    // Rotation de toute la scène (sources et fichier), en degrés
+    void setRotation(int yawDeg);
+    int getOrder() const { return order; }
+
+    void setConvolutionMode(HrtfConvolutionMode mode);
+
+private:
+    audio_block_t* inputQueueArray[MAX_INPUTS];
+    int sourceCount;
+    int order;
+    HrtfBank* bank;     // partagée, chargée par le premier begin()
+    HrtfAmbisonicMixer mixer;
+
+    SdWavReader reader;
+    volatile bool playing;
+    bool fuma;
+    int idleBlocks;     // blocs rendus depuis la dernière entrée, pour laisser sortir les queues
+
+    float inFloat[MAX_INPUTS][AUDIO_BLOCK_SAMPLES];
+    float fileFloat[HRTF_AMBI_MAX_CHANNELS][AUDIO_BLOCK_SAMPLES];
+    float outFloatLeft[AUDIO_BLOCK_SAMPLES];
+    float outFloatRight[AUDIO_BLOCK_SAMPLES];
+};
+
+#endif
@@ -7,19 +7,70 @@
 
 extern volatile bool manualMode;
 
-MyDsp::MyDsp() : AudioStream(1, inputQueueArray), currentAngle(0) {
+MyDsp::MyDsp(HrtfBank* sharedBank)
+: AudioStream(1, inputQueueArray), currentAngle(0),
+  subjectState(SUBJECT_NONE), subjectChunks(0), subjectMaxChunkUs(0), subjectStart(0),
+  subjectLatencyUs(0),
+  prefetchAngle(0), prefetchTime(0), prefetchRate(0.0f) {
+#if HRTF_FIXED_POINT
+    (void)sharedBank;
+#else
+    bank = sharedBank;
+    subjectBanks[0] = nullptr;
+    subjectBanks[1] = nullptr;
+    loadingBank = nullptr;
+    pendingBank = nullptr;
+#endif
 }
 
+#if !HRTF_FIXED_POINT
+void MyDsp::configureBank(HrtfBank& b) {
+    // Le taux d'échantillonnage et la taille du bloc sont définis par la Teensy Audio Library
+    b.init(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
+    b.setMinimumPhase(HRTF_MINIMUM_PHASE_LENGTH);
+    b.setCompactStorage(HRTF_COMPACT_BANK);
+    b.setSymmetricStorage(HRTF_SYMMETRIC_BANK);
+    b.setCacheSize(HRTF_CACHE_SIZE);
+}
+#endif
+
 void MyDsp::begin() {
+#if HRTF_FIXED_POINT
     // Initialiser le moteur HRTF (le taux d'échantillonnage et la taille du bloc sont définis par la Teensy Audio Library)
     hrtfEngine.init(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
     
     // Charger le fichier binaire contenant les HRIR depuis la carte SD
-    if (!hrtfEngine.loadFromBin("/hrtf_elev0.bin")) {
+    if (!hrtfEngine.loadFromBin(HRTF_BANK_FILE)) {
         Serial.println("Echec du loadFromBin");
     } else {
         Serial.println("OK => HRIR chargé depuis bin!");
     }
+#else
+    if (!bank) {
+        bank = new HrtfBank();
+    }
+
+    // La banque partagée n'est chargée qu'une fois, par le premier nœud
+    if (bank->getHrirCount() == 0) {
+        configureBank(*bank);
+
+        // Banque compilée en flash (HRTF_FLASH_BANK), sinon fichier binaire de la carte SD
+        const HrtfFlashBank* flash = hrtfFlashBank();
+        if (flash) {
+            if (!bank->loadFromFlash(*flash)) {
+                Serial.println("Echec du loadFromFlash");
+            } else {
+                Serial.println("OK => HRIR lues en flash!");
+            }
+        } else if (!bank->loadFromBin(HRTF_BANK_FILE)) {
+            Serial.println("Echec du loadFromBin");
+        } else {
+            Serial.println("OK => HRIR chargé depuis bin!");
+        }
+    }
+    voice.setInterpolation(HRTF_INTERPOLATION);
+    voice.init(*bank);
+#endif
 }
 
 void MyDsp::setAngle(int newAngle) {
@@ -36,8 +87,247 @@ int MyDsp::getAngle() const {
     return currentAngle;
 }
 
+void MyDsp::prefetch() {
+#if !HRTF_FIXED_POINT
+    if (!bank || !bank->isCached()) {
+        return;
+    }
+    // Vitesse angulaire : écart entre deux changements d'angle (mode auto : 1° toutes les
+    // 50 ms), remise à zéro après une seconde sans mouvement
+    const uint32_t now = millis();
+    const int angle = currentAngle;
+    if (angle != prefetchAngle) {
+        int delta = angle - prefetchAngle;
+        delta = (delta > 180) ? delta - 360 : (delta <= -180 ? delta + 360 : delta);
+        const uint32_t dt = now - prefetchTime;
+        prefetchRate = (dt > 0 && dt < 1000) ? (float)delta / dt : 0.0f;
+        // Saut de la commande manuelle : pas une vitesse
+        prefetchRate = (fabsf(prefetchRate) > 0.2f) ? 0.0f : prefetchRate;
+        prefetchAngle = angle;
+        prefetchTime = now;
+    } else if (now - prefetchTime > 1000) {
+        prefetchRate = 0.0f;
+    }
+
+    // Direction courante puis directions prévues sur l'horizon
+    const int steps = (prefetchRate != 0.0f) ? 6 : 1;
+    float azimuths[6];
+    float elevations[6];
+    for (int k = 0; k < steps; k++) {
+        azimuths[k] = angle + prefetchRate * HRTF_PREFETCH_HORIZON_MS * k / 5;
+        elevations[k] = 0.0f;
+    }
+    AudioNoInterrupts();
+    bank->prefetch(azimuths, elevations, steps);
+    AudioInterrupts();
+
+    // Quelques lectures par passage : la carte SD est partagée avec les lecteurs WAV
+    for (int i = 0; i < 4; i++) {
+        AudioNoInterrupts();
+        const bool more = bank->loadNext();
+        AudioInterrupts();
+        if (!more) {
+            break;
+        }
+    }
+#endif
+}
+
+bool MyDsp::loadSubject(const String& filename) {
+#if HRTF_FIXED_POINT
+    (void)filename;
+    Serial.println("SUBJECT indisponible en virgule fixe");
+    return false;
+#else
+    if (!bank || subjectState == SUBJECT_LOADING || subjectState == SUBJECT_PENDING) {
+        return false;
+    }
+    // Banque de réserve : celle des deux qui n'est pas en service (la banque du sujet
+    // précédent n'est plus lue depuis le bloc qui a suivi sa publication)
+    HrtfBank*& standby = (bank == subjectBanks[0]) ? subjectBanks[1] : subjectBanks[0];
+    if (!standby) {
+        standby = new HrtfBank();
+        if (!standby) {
+            return false;
+        }
+    }
+    const uint32_t start = micros();
+    configureBank(*standby);
+    AudioNoInterrupts();
+    const bool opened = standby->beginLoad(filename);
+    AudioInterrupts();
+    if (!opened) {
+        return false;
+    }
+    // L'ouverture du fichier compte comme la première étape
+    loadingBank = standby;
+    subjectFile = filename;
+    subjectChunks = 1;
+    subjectMaxChunkUs = micros() - start;
+    subjectStart = start;
+    subjectLatencyUs = 0;
+    subjectState = SUBJECT_LOADING;
+    return true;
+#endif
+}
+
+void MyDsp::serviceSubject() {
+#if !HRTF_FIXED_POINT
+    if (subjectState != SUBJECT_LOADING) {
+        return;
+    }
+    // Les calculs (phase minimale et conversion de fréquence exceptées, faites avec la lecture
+    // de chaque mesure) laissent passer l'audio
+    const bool reading = loadingBank->isLoadReadingCard();
+    const uint32_t start = micros();
+    if (reading) {
+        AudioNoInterrupts();
+    }
+    const bool more = loadingBank->loadStep(HRTF_SWAP_CHUNK_US);
+    if (reading) {
+        AudioInterrupts();
+    }
+    const uint32_t elapsed = micros() - start;
+    subjectChunks++;
+    subjectMaxChunkUs = (elapsed > subjectMaxChunkUs) ? elapsed : subjectMaxChunkUs;
+    if (more) {
+        return;
+    }
+
+    HrtfBank* const loaded = loadingBank;
+    loadingBank = nullptr;
+    if (!loaded->getLoadResult() || loaded->getHrirCount() == 0) {
+        subjectState = SUBJECT_FAILED;
+        Serial.print("Echec du chargement du sujet ");
+        Serial.println(subjectFile);
+        return;
+    }
+    // Publication par update() au prochain bloc ; si la voix ne peut pas passer à la nouvelle
+    // banque sans allouer (queues plus longues), elle est réinitialisée ici, sans fondu
+    AudioNoInterrupts();
+    const bool ready = voice.prepareBank(*loaded);
+    if (!ready) {
+        voice.init(*loaded);
+        bank = loaded;
+        subjectLatencyUs = micros() - subjectStart;
+        subjectState = SUBJECT_DONE;
+    }
+    AudioInterrupts();
+    if (!ready) {
+        Serial.println("Sujet publié sans fondu (voix réinitialisée)");
+        return;
+    }
+    subjectState = SUBJECT_PENDING;
+    pendingBank = loaded;
+#endif
+}
+
+void MyDsp::printSubject(Print& out) const {
+    static const char* const names[] = { "NONE", "LOADING", "PENDING", "DONE", "FAILED" };
+    const uint8_t state = subjectState;
+    const uint32_t latency = (state == SUBJECT_LOADING || state == SUBJECT_PENDING)
+                           ? micros() - subjectStart : subjectLatencyUs;
+    out.print("SUBJECT:");
+    out.print(names[state]);
+    out.print(",");
+    out.print(subjectFile);
+    out.print(",");
+    out.print(subjectChunks);
+    out.print(",");
+    out.print(subjectMaxChunkUs);
+    out.print(",");
+    out.println(latency / 1000.0f, 1);
+}
+
+#if !HRTF_FIXED_POINT
+void MyDsp::publishSubject(bool fade) {
+    HrtfBank* const loaded = pendingBank;
+    pendingBank = nullptr;
+    if (!voice.setBank(*loaded)) {
+        subjectState = SUBJECT_FAILED;
+        return;
+    }
+    // Pas de bloc à traiter : rien à fondre, le filtre de l'ancienne banque est oublié
+    if (!fade) {
+        voice.reset();
+    }
+    bank = loaded;
+    subjectLatencyUs = micros() - subjectStart;
+    subjectState = SUBJECT_DONE;
+}
+#endif
+
+void MyDsp::setConvolutionMode(HrtfConvolutionMode mode) {
+    __disable_irq();
+#if HRTF_FIXED_POINT
+    hrtfEngine.setConvolutionMode(mode);
+#else
+    voice.setConvolutionMode(mode);
+#endif
+    __enable_irq();
+}
+
+HrtfConvolutionMode MyDsp::getConvolutionMode() const {
+#if HRTF_FIXED_POINT
+    return hrtfEngine.getConvolutionMode();
+#else
+    return voice.getConvolutionMode();
+#endif
+}
+
+void MyDsp::setSwitchMode(HrtfSwitchMode mode) {
+    __disable_irq();
+#if HRTF_FIXED_POINT
+    hrtfEngine.setSwitchMode(mode);
+#else
+    voice.setSwitchMode(mode);
+#endif
+    __enable_irq();
+}
+
+HrtfSwitchMode MyDsp::getSwitchMode() const {
+#if HRTF_FIXED_POINT
+    return hrtfEngine.getSwitchMode();
+#else
+    return voice.getSwitchMode();
+#endif
+}
+
+void MyDsp::setInterpolation(bool enabled) {
+#if HRTF_FIXED_POINT
+    (void)enabled;
+#else
+    AudioNoInterrupts();
+    voice.setInterpolation(enabled);
+    AudioInterrupts();
+#endif
+}
+
+bool MyDsp::getInterpolation() const {
+#if HRTF_FIXED_POINT
+    return false;
+#else
+    return voice.getInterpolation();
+#endif
+}
+
+const HrtfBank* MyDsp::getBank() const {
+#if HRTF_FIXED_POINT
+    return nullptr;
+#else
+    return bank;
+#endif
+}
+
 void MyDsp::update() {
     audio_block_t* inBlock = receiveReadOnly(0);
+#if !HRTF_FIXED_POINT
+    // Sujet chargé en arrière-plan (serviceSubject) : publié entre deux blocs, la voix fond
+    // l'ancien filtre dans le nouveau sur le bloc qui suit
+    if (pendingBank) {
+        publishSubject(inBlock != nullptr);
+    }
+#endif
     if (!inBlock) {
         return;
     }
@@ -51,7 +341,13 @@ void MyDsp::update() {
             return;
         }
     }
-    
+
+#if HRTF_FIXED_POINT
+    // Rendu en virgule fixe : de audio_block_t à audio_block_t sans passage par le float
+    SelectedHrirQ15 sel = hrtfEngine.getHrir(currentAngle);
+    hrtfEngine.processBlock(inBlock->data, outBlock[0]->data, outBlock[1]->data, sel, 0.5f);
+    release(inBlock);
+#else
     // Conversion : le signal d'entrée est déjà mono via le mixeur, on le convertit en float
     float inMono[AUDIO_BLOCK_SAMPLES];
     float maxIn = 0.0f;
@@ -63,14 +359,21 @@ void MyDsp::update() {
     }
     release(inBlock);
 
-    // Sélection du HRIR en fonction de l'angle courant
-    SelectedHrir sel = hrtfEngine.getHrir(currentAngle);
+    // Sélection du HRIR en fonction de l'angle courant (interpolé entre les mesures voisines)
+    SelectedHrir sel;
+    if (!bank) {
+        sel = SelectedHrir();
+    } else if (voice.getInterpolation()) {
+        sel = voice.interpolate((float)currentAngle, 0.0f);
+    } else {
+        sel = voice.select(currentAngle, 0);
+    }
 
     // Calculer quelques indicateurs du HRIR (pour le canal gauche)
     float hrirMax = 0.0f;
     float hrirL1 = 0.0f;
-    for (int i = 0; i < sel.length; i++) {
-        float absVal = fabs(sel.left[i]);
+    for (size_t i = 0; i < sel.length; i++) {
+        float absVal = fabs(sel.coeffs[2 * i]);
         if (absVal > hrirMax) {
             hrirMax = absVal;
         }
@@ -80,8 +383,8 @@ void MyDsp::update() {
     // Choisir un gain
     float gain = 0.5f;
 
-    //Appel de la convolution avec overlap-add
-    hrtfEngine.processBlock(inMono, outFloatLeft, outFloatRight, sel, gain);
+    //Appel de la convolution (forme directe ou FFT overlap-save)
+    voice.processBlock(inMono, outFloatLeft, outFloatRight, sel, gain);
 
     // Calculer le niveau maximum des sorties
     float maxOutL = 0.0f, maxOutR = 0.0f;
@@ -96,6 +399,7 @@ void MyDsp::update() {
         outBlock[0]->data[i] = (int16_t)(outFloatLeft[i] * MULT_16);
         outBlock[1]->data[i] = (int16_t)(outFloatRight[i] * MULT_16);
     }
+#endif
 
     // Transmettre les blocs de sortie
     transmit(outBlock[0], 0);
@@ -154,16 +458,6 @@ void MyDsp::update() {
             Serial.print(" ");
         }
         Serial.println();
-
-        // Afficher quelques valeurs de l'overlap (canal gauche)
-        const float* ol = hrtfEngine.getOverlapLeft();
-        int olSize = hrtfEngine.getOverlapSize();
-        Serial.print("OverlapLeft[0..4]: ");
-        for (int i = 0; i < 5 && i < olSize; i++) {
-            Serial.print(ol[i], 4);
-            Serial.print(" ");
-        }
-        Serial.println();
     }
     */
 }
\ No newline at end of file
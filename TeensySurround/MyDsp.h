@@ -1,14 +1,21 @@
 #ifndef MY_DSP_H
 #define MY_DSP_H
 
-#include "ProjectHrtfEngine.h"
+#include "HrtfConfig.h"
+#include "HrtfBank.h"
+#include "HrtfVoice.h"
+#include "HrtfEngineQ15.h"
 #include <AudioStream.h>
 
 #define AUDIO_OUTPUTS 2
 
+// Nœud audio spatialisant une source mono.
+// Plusieurs nœuds peuvent partager une même banque de HRIR (une seule copie en RAM) :
+//   HrtfBank bank;  MyDsp source1(&bank), source2(&bank);
+// Sans banque fournie, le nœud alloue la sienne dans begin().
 class MyDsp : public AudioStream {
 public:
-    MyDsp();
+    explicit MyDsp(HrtfBank* sharedBank = nullptr);
     void begin();
     virtual void update();
 
@@ -16,15 +23,78 @@ public:
     void setAngle(int newAngle);
     int getAngle() const;
 
+    // Choix du noyau de convolution (FFT par défaut, direct pour comparaison)
+    void setConvolutionMode(HrtfConvolutionMode mode);
+    HrtfConvolutionMode getConvolutionMode() const;
+
+    // Changement de HRIR : commutation brusque ou fondu enchaîné sur un bloc
+    void setSwitchMode(HrtfSwitchMode mode);
+    HrtfSwitchMode getSwitchMode() const;
+
+    // Filtre interpolé entre les mesures voisines ou mesure la plus proche
+    void setInterpolation(bool enabled);
+    bool getInterpolation() const;
+
+    // Banque à la demande (HRTF_CACHE_SIZE), à appeler depuis loop() : extrapole le mouvement
+    // de l'angle et charge quelques mesures des directions à venir (audio suspendu pendant
+    // chaque lecture sur la carte SD)
+    void prefetch();
+
+    // Changement de sujet sans coupure : filename est chargé en arrière-plan dans une banque de
+    // réserve propre à ce nœud (mêmes réglages que la banque de démarrage, qui reste celle des
+    // autres nœuds), par étapes faites depuis loop() par serviceSubject, puis publié au début
+    // d'un bloc audio et fondu sur ce bloc. false si un changement est en cours ou si le
+    // fichier ne s'ouvre pas.
+    bool loadSubject(const String& filename);
+    // À appeler depuis loop() : une étape du chargement, d'environ HRTF_SWAP_CHUNK_US (audio
+    // suspendu seulement pendant les lectures sur la carte SD)
+    void serviceSubject();
+    // "SUBJECT:état,fichier,étapes,étape la plus longue (us),latence (ms)" du dernier
+    // changement ; latence de la commande à la publication sur l'interruption audio
+    void printSubject(Print& out) const;
+
+    // Banque de HRIR en service (sujet publié compris), pour les bancs d'essai du moteur
+    // flottant ; nulle en virgule fixe
+    const HrtfBank* getBank() const;
+
 private:
     audio_block_t* inputQueueArray[1];
-    ProjectHrtfEngine hrtfEngine;
+#if HRTF_FIXED_POINT
+    HrtfEngineQ15 hrtfEngine;
+#else
+    HrtfBank* bank;     // partagée, chargée par le premier begin() (ou sujet publié)
+    HrtfVoice voice;    // état de convolution propre à ce nœud
+
+    // Changement de sujet : deux banques allouées au premier changement, l'une en service
+    // (ou la banque partagée), l'autre en chargement ; pendingBank, chargée, attend update()
+    static void configureBank(HrtfBank& b);
+    void publishSubject(bool fade);
+    HrtfBank* subjectBanks[2];
+    HrtfBank* loadingBank;
+    HrtfBank* volatile pendingBank;
 
     // Buffers pour la sortie en float (utilisés par processBlock)
     float outFloatLeft[AUDIO_BLOCK_SAMPLES];
     float outFloatRight[AUDIO_BLOCK_SAMPLES];
+#endif
 
     int currentAngle;
+
+    // Dernier changement de sujet : état, étapes, plus longue étape, instant de la commande et
+    // latence jusqu'à la publication (micros)
+    enum SubjectState { SUBJECT_NONE, SUBJECT_LOADING, SUBJECT_PENDING, SUBJECT_DONE,
+                        SUBJECT_FAILED };
+    volatile uint8_t subjectState;
+    String subjectFile;
+    uint32_t subjectChunks;
+    uint32_t subjectMaxChunkUs;
+    uint32_t subjectStart;
+    volatile uint32_t subjectLatencyUs;
+
+    // Anticipation : dernier angle vu par prefetch, instant du changement, vitesse en degrés/ms
+    int prefetchAngle;
+    uint32_t prefetchTime;
+    float prefetchRate;
 };
 
 #endif
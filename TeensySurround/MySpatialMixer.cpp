@@ -0,0 +1,132 @@
+#include "MySpatialMixer.h"
+#include "HrtfConfig.h"
+#include <Arduino.h>
+#include <Audio.h>
+
+#define MULT_16 32767
+
+static int clampSourceCount(int count) {
+    if (count < 1) {
+        return 1;
+    }
+    return (count > HrtfMixer::MAX_SOURCES) ? HrtfMixer::MAX_SOURCES : count;
+}
+
+MySpatialMixer::MySpatialMixer(int count, HrtfBank* sharedBank)
+: AudioStream(clampSourceCount(count), inputQueueArray),
+  sourceCount(clampSourceCount(count)), bank(sharedBank), silentBlocks(0)
+{
+}
+
+void MySpatialMixer::begin() {
+    if (!bank) {
+        bank = new HrtfBank();
+    }
+
+    // La banque partagée n'est chargée qu'une fois, par le premier nœud
+    if (bank->getHrirCount() == 0) {
+        bank->init(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
+        bank->setMinimumPhase(HRTF_MINIMUM_PHASE_LENGTH);
+        bank->setCompactStorage(HRTF_COMPACT_BANK);
+        bank->setSymmetricStorage(HRTF_SYMMETRIC_BANK);
+        bank->setCacheSize(HRTF_CACHE_SIZE);
+        // Banque compilée en flash (HRTF_FLASH_BANK), sinon fichier de la carte SD
+        const HrtfFlashBank* flash = hrtfFlashBank();
+        if (flash ? !bank->loadFromFlash(*flash) : !bank->loadFromBin(HRTF_BANK_FILE)) {
+            Serial.println(flash ? "Echec du loadFromFlash" : "Echec du loadFromBin");
+        }
+    }
+    AudioNoInterrupts();
+    if (!mixer.init(*bank, sourceCount)) {
+        Serial.println("Mémoire insuffisante pour le mélangeur spatial");
+    }
+    AudioInterrupts();
+}
+
+void MySpatialMixer::setSource(int index, int azimuthDeg, int elevationDeg, float gain) {
+    __disable_irq();
+    mixer.setSource(index, azimuthDeg, elevationDeg, gain);
+    __enable_irq();
+}
+
+void MySpatialMixer::setAzimuth(int index, int azimuthDeg) {
+    if (index < 0 || index >= sourceCount) {
+        return;
+    }
+    __disable_irq();
+    mixer.setSource(index, azimuthDeg, mixer.getElevation(index), mixer.getGain(index));
+    __enable_irq();
+}
+
+int MySpatialMixer::getAzimuth(int index) const {
+    if (index < 0 || index >= sourceCount) {
+        return 0;
+    }
+    return mixer.getAzimuth(index);
+}
+
+void MySpatialMixer::setConvolutionMode(HrtfConvolutionMode mode) {
+    __disable_irq();
+    mixer.setConvolutionMode(mode);
+    __enable_irq();
+}
+
+void MySpatialMixer::setSwitchMode(HrtfSwitchMode mode) {
+    __disable_irq();
+    mixer.setSwitchMode(mode);
+    __enable_irq();
+}
+
+void MySpatialMixer::update() {
+    // Entrées non connectées ou silencieuses : pointeur nul, la source est muette
+    const float* inputs[HrtfMixer::MAX_SOURCES];
+    bool anyInput = false;
+    for (int s = 0; s < sourceCount; s++) {
+        audio_block_t* inBlock = receiveReadOnly(s);
+        inputs[s] = nullptr;
+        if (inBlock) {
+            for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                inFloat[s][i] = inBlock->data[i] / 32768.0f;
+            }
+            release(inBlock);
+            inputs[s] = inFloat[s];
+            anyInput = true;
+        }
+    }
+
+    // Toutes les entrées muettes depuis plus longtemps que les filtres : les queues sont
+    // éteintes, rien à rendre (lecteur de pistes à l'arrêt)
+    silentBlocks = anyInput ? 0 : silentBlocks + 1;
+    const int tailBlocks = bank
+        ? (int)((MAX_HRIR_LENGTH + bank->getMaxTailLength()) / AUDIO_BLOCK_SAMPLES) + 2 : 2;
+    if (silentBlocks > tailBlocks) {
+        silentBlocks = tailBlocks + 1;
+        return;
+    }
+
+    audio_block_t* outBlock[2];
+    outBlock[0] = allocate();
+    if (!outBlock[0]) {
+        return;
+    }
+    outBlock[1] = allocate();
+    if (!outBlock[1]) {
+        release(outBlock[0]);
+        return;
+    }
+
+    mixer.process(inputs, outFloatLeft, outFloatRight);
+
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        float l = outFloatLeft[i] * MULT_16;
+        float r = outFloatRight[i] * MULT_16;
+        // Plusieurs sources peuvent dépasser la pleine échelle : saturation
+        outBlock[0]->data[i] = (int16_t)(l > 32767.0f ? 32767.0f : (l < -32768.0f ? -32768.0f : l));
+        outBlock[1]->data[i] = (int16_t)(r > 32767.0f ? 32767.0f : (r < -32768.0f ? -32768.0f : r));
+    }
+
+    transmit(outBlock[0], 0);
+    transmit(outBlock[1], 1);
+    release(outBlock[0]);
+    release(outBlock[1]);
+}
@@ -0,0 +1,39 @@
+#ifndef MY_SPATIAL_MIXER_H
+#define MY_SPATIAL_MIXER_H
+
+#include "HrtfBank.h"
+#include "HrtfMixer.h"
+#include <AudioStream.h>
+
+// Nœud audio à N entrées mono (N <= HrtfMixer::MAX_SOURCES), chacune avec sa position et
+// son gain, rendues vers une seule sortie stéréo binaurale. Remplace le mixage en mono
+// devant MyDsp quand les sources doivent rester distinctes :
+//   MySpatialMixer spatial(4, &bank);
+//   AudioConnection c0(player1, 0, spatial, 0), c1(player2, 0, spatial, 1);
+// Sans aucune entrée pendant plus que la longueur des filtres, le nœud ne rend plus rien.
+class MySpatialMixer : public AudioStream {
+public:
+    explicit MySpatialMixer(int sourceCount, HrtfBank* sharedBank = nullptr);
+    void begin();
+    virtual void update();
+
+    void setSource(int index, int azimuthDeg, int elevationDeg, float gain);
+    void setAzimuth(int index, int azimuthDeg);
+    int getAzimuth(int index) const;
+
+    void setConvolutionMode(HrtfConvolutionMode mode);
+    void setSwitchMode(HrtfSwitchMode mode);
+
+private:
+    audio_block_t* inputQueueArray[HrtfMixer::MAX_SOURCES];
+    int sourceCount;
+    HrtfBank* bank;     // partagée, chargée par le premier begin()
+    HrtfMixer mixer;
+    int silentBlocks;   // blocs consécutifs sans aucune entrée
+
+    float inFloat[HrtfMixer::MAX_SOURCES][AUDIO_BLOCK_SAMPLES];
+    float outFloatLeft[AUDIO_BLOCK_SAMPLES];
+    float outFloatRight[AUDIO_BLOCK_SAMPLES];
+};
+
+#endif
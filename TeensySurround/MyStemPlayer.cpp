@@ -0,0 +1,145 @@
+#include "MyStemPlayer.h"
+#include <Arduino.h>
+#include <Audio.h>
+#include <string.h>
+
+MyStemPlayer::MyStemPlayer()
+: AudioStream(0, nullptr), stemCount(0), rate(0), length(0), writeCount(0), readCount(0),
+  endOfData(false), playing(false), minFill(RING_FRAMES), underruns(0), cardReads(0)
+{
+}
+
+bool MyStemPlayer::canPlay(const String& filename) {
+    return filename.endsWith(".stm") || filename.endsWith(".STM");
+}
+
+bool MyStemPlayer::play(const char* filename) {
+    stop();
+    AudioNoInterrupts();
+    bool ok = reader.open(filename);
+    AudioInterrupts();
+    if (ok && reader.blockFrames() > RING_FRAMES / 2) {
+        Serial.print("Blocs trop longs pour le tampon des pistes : ");
+        Serial.println(filename);
+        reader.close();
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+    stemCount = reader.stems();
+    rate = reader.sampleRate();
+    length = reader.lengthFrames();
+    // Tampon rempli d'avance : la lecture démarre sans attendre loop()
+    while (fillSlice()) {
+    }
+    playing = true;
+    return true;
+}
+
+void MyStemPlayer::stop() {
+    AudioNoInterrupts();
+    playing = false;
+    reader.close();
+    writeCount = 0;
+    readCount = 0;
+    endOfData = false;
+    AudioInterrupts();
+}
+
+void MyStemPlayer::service() {
+    // Au plus deux blocs par passage : loop() traite aussi les commandes
+    for (int i = 0; i < 2 * stemCount && playing && fillSlice(); i++) {
+    }
+}
+
+bool MyStemPlayer::fillSlice() {
+    if (!reader.isOpen()) {
+        return false;
+    }
+    const uint32_t block = reader.blockFrames();
+    const int stem = reader.nextStem();
+    if (stem == 0 && !reader.atEnd() && RING_FRAMES - (writeCount - readCount) < block) {
+        return false;
+    }
+
+    // Le tampon a une longueur multiple de celle des blocs : une tranche y est contiguë
+    const uint32_t pos = writeCount & (RING_FRAMES - 1);
+    AudioNoInterrupts();
+    const bool ok = reader.readSlice(ring[stem] + pos);
+    AudioInterrupts();
+    if (!ok) {
+        // Fin du fichier (ou fichier tronqué : le bloc incomplet est abandonné)
+        reader.close();
+        __disable_irq();
+        endOfData = true;
+        __enable_irq();
+        return false;
+    }
+    cardReads++;
+    if (reader.nextStem() == 0) {
+        // Dernière tranche du bloc : ses trames (hors remplissage de fin) deviennent visibles
+        const uint32_t start = reader.positionFrames() - block;
+        const uint32_t frames = (reader.lengthFrames() - start < block)
+                              ? reader.lengthFrames() - start : block;
+        __disable_irq();
+        writeCount += frames;
+        __enable_irq();
+    }
+    return true;
+}
+
+uint32_t MyStemPlayer::positionMillis() const {
+    if (rate == 0 || !playing) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)readCount * 1000 / rate);
+}
+
+uint32_t MyStemPlayer::lengthMillis() const {
+    if (rate == 0 || !playing) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)length * 1000 / rate);
+}
+
+void MyStemPlayer::resetStats() {
+    __disable_irq();
+    minFill = writeCount - readCount;
+    underruns = 0;
+    __enable_irq();
+    cardReads = 0;
+}
+
+void MyStemPlayer::update() {
+    if (!playing) {
+        return;
+    }
+
+    // Trames déjà en RAM seulement ; le manque est complété par du silence
+    const uint32_t available = writeCount - readCount;
+    minFill = (available < minFill) ? available : minFill;
+    const uint32_t frames = (available < AUDIO_BLOCK_SAMPLES) ? available : AUDIO_BLOCK_SAMPLES;
+    const uint32_t pos = readCount & (RING_FRAMES - 1);
+    const uint32_t first = (frames < RING_FRAMES - pos) ? frames : RING_FRAMES - pos;
+    for (int s = 0; s < stemCount; s++) {
+        audio_block_t* outBlock = allocate();
+        if (!outBlock) {
+            continue;
+        }
+        memcpy(outBlock->data, ring[s] + pos, first * sizeof(int16_t));
+        memcpy(outBlock->data + first, ring[s], (frames - first) * sizeof(int16_t));
+        memset(outBlock->data + frames, 0, (AUDIO_BLOCK_SAMPLES - frames) * sizeof(int16_t));
+        transmit(outBlock, s);
+        release(outBlock);
+    }
+    readCount += frames;
+
+    if (frames < AUDIO_BLOCK_SAMPLES) {
+        if (endOfData) {
+            playing = false;
+        } else {
+            underruns++;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef MY_STEM_PLAYER_H
+#define MY_STEM_PLAYER_H
+
+#include "HrtfConfig.h"
+#include "SdStemReader.h"
+#include <AudioStream.h>
+
+// Lecteur de fichiers de pistes séparées "STEM" (voir SdStemReader) : une seule lecture
+// séquentielle de la carte SD alimente jusqu'à MAX_STEMS sorties mono, la sortie s portant la
+// piste s, à relier aux entrées d'un MySpatialMixer qui place chaque piste :
+//   MyStemPlayer stems;
+//   MySpatialMixer spatial(MyStemPlayer::MAX_STEMS, &bank);
+//   AudioConnection c0(stems, 0, spatial, 0), c1(stems, 1, spatial, 1);
+// Comme MyStreamPlayer, les blocs du fichier sont lus depuis loop() (service), une tranche de
+// piste à la fois, dans un tampon de HRTF_STEM_BUFFER_FRAMES trames par piste ; l'interruption
+// audio ne lit que ce tampon. Les sorties au-delà du nombre de pistes ne transmettent rien.
+class MyStemPlayer : public AudioStream {
+public:
+    static const int MAX_STEMS = SdStemReader::MAX_STEMS;
+
+    MyStemPlayer();
+    virtual void update();
+
+    // Fichier de pistes séparées reconnu à son extension (.stm)
+    static bool canPlay(const String& filename);
+
+    // Le début du fichier est lu ici ; false si le fichier est illisible ou si ses blocs
+    // dépassent la moitié du tampon
+    bool play(const char* filename);
+    void stop();
+    // À appeler depuis loop() : quelques tranches pour remplir le tampon (audio suspendu pendant
+    // chacune, la carte SD étant partagée avec les lecteurs qui la lisent sur l'interruption)
+    void service();
+
+    bool isPlaying() const { return playing; }
+    uint32_t positionMillis() const;
+    uint32_t lengthMillis() const;
+
+    // Pistes du fichier lu (ou du dernier lu) : nombre, position par défaut, gain et nom
+    int stems() const { return stemCount; }
+    int stemAzimuth(int stem) const { return reader.stemAzimuth(stem); }
+    int stemElevation(int stem) const { return reader.stemElevation(stem); }
+    float stemGain(int stem) const { return reader.stemGain(stem); }
+    const char* stemName(int stem) const { return reader.stemName(stem); }
+
+    // Remplissage : trames d'avance et capacité du tampon, minimum vu par l'interruption depuis
+    // resetStats, blocs rendus incomplets faute de données, lectures sur la carte
+    uint32_t getBufferFill() const { return writeCount - readCount; }
+    uint32_t getBufferCapacity() const { return RING_FRAMES; }
+    uint32_t getMinFill() const { return minFill; }
+    uint32_t getUnderruns() const { return underruns; }
+    uint32_t getCardReads() const { return cardReads; }
+    void resetStats();
+
+private:
+    MyStemPlayer(const MyStemPlayer&);
+    MyStemPlayer& operator=(const MyStemPlayer&);
+
+    static const uint32_t RING_FRAMES = HRTF_STEM_BUFFER_FRAMES;
+
+    bool fillSlice();
+
+    SdStemReader reader;
+    // Une piste par ligne ; un bloc du fichier n'est entamé qu'avec sa place libre dans
+    // chaque ligne, et ses trames ne sont visibles qu'une fois toutes ses tranches lues
+    int16_t ring[MAX_STEMS][RING_FRAMES];
+    volatile int stemCount;
+    uint32_t rate;
+    uint32_t length;
+    volatile uint32_t writeCount;         // trames écrites depuis play (loop)
+    volatile uint32_t readCount;          // trames rendues (interruption)
+    volatile bool endOfData;              // tout est écrit : fin de lecture quand le tampon est vide
+    volatile bool playing;
+    volatile uint32_t minFill;
+    volatile uint32_t underruns;
+    uint32_t cardReads;
+};
+
+#endif
@@ -0,0 +1,302 @@
+#include "MyStreamPlayer.h"
+#include <Arduino.h>
+#include <Audio.h>
+#include <math.h>
+#include <string.h>
+
+MyStreamPlayer::MyStreamPlayer()
+: AudioStream(0, nullptr), resampling(false), srcOffset(0), srcPending(0), srcRemaining(0),
+  writeCount(0), readCount(0), endOfData(false),
+  trackHead(0), trackTail(0), playing(false), queueRefused(false), trackSerial(0),
+  minFill(RING_FRAMES), underruns(0), cardReads(0)
+{
+    memset(tracks, 0, sizeof(tracks));
+}
+
+bool MyStreamPlayer::play(const char* filename) {
+    stop();
+    if (!openNext(filename)) {
+        return false;
+    }
+    // Tampon rempli d'avance : la lecture démarre sans attendre loop()
+    while (fillChunk()) {
+    }
+    playing = true;
+    return true;
+}
+
+bool MyStreamPlayer::queue(const char* filename) {
+    if (!playing || hasQueued() || queueRefused) {
+        return false;
+    }
+    queuedName = filename;
+    __disable_irq();
+    endOfData = false;
+    __enable_irq();
+    return true;
+}
+
+bool MyStreamPlayer::hasQueued() const {
+    return queuedName.length() > 0 || (uint8_t)(trackTail - trackHead) > 1;
+}
+
+void MyStreamPlayer::stop() {
+    AudioNoInterrupts();
+    playing = false;
+    reader.close();
+    queuedName = "";
+    queueRefused = false;
+    writeCount = 0;
+    readCount = 0;
+    endOfData = false;
+    trackHead = 0;
+    trackTail = 0;
+    resampling = false;
+    srcPending = 0;
+    srcRemaining = 0;
+    AudioInterrupts();
+}
+
+void MyStreamPlayer::service() {
+    // Quelques lectures par passage : loop() traite aussi les commandes et le préchargement
+    for (int i = 0; i < 4 && playing && fillChunk(); i++) {
+    }
+}
+
+bool MyStreamPlayer::openNext(const char* filename) {
+    if ((uint8_t)(trackTail - trackHead) >= MAX_TRACKS) {
+        return false;
+    }
+    AudioNoInterrupts();
+    bool ok = reader.open(filename);
+    AudioInterrupts();
+    // Fichiers multicanaux et IMA-ADPCM : lecteurs ambisonique, surround et MyAdpcmPlayer
+    if (ok && (reader.channels() > 2 || reader.isAdpcm())) {
+        reader.close();
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+    Track& t = tracks[trackTail % MAX_TRACKS];
+    t.start = writeCount;
+    t.length = reader.lengthFrames();
+    t.rate = reader.sampleRate();
+    resampling = false;
+    srcPending = 0;
+    srcRemaining = 0;
+#if HRTF_RESAMPLE_QUALITY > 0
+    // Autre fréquence que celle du moteur : convertie à la lecture (tables refaites seulement
+    // si la fréquence change d'un fichier à l'autre)
+    if (fabs((double)reader.sampleRate() - AUDIO_SAMPLE_RATE_EXACT) > 0.5) {
+        resampling = resampler.init(reader.sampleRate(), AUDIO_SAMPLE_RATE_EXACT,
+                                    reader.channels(),
+                                    (HrtfResampleQuality)HRTF_RESAMPLE_QUALITY);
+        if (resampling) {
+            t.length = resampler.outputLength(t.length);
+            t.rate = (uint32_t)(AUDIO_SAMPLE_RATE_EXACT + 0.5f);
+            srcRemaining = t.length;
+        } else {
+            Serial.println("Mémoire insuffisante pour la conversion de fréquence : fichier lu à sa fréquence");
+        }
+    }
+#endif
+    __disable_irq();
+    trackTail++;
+    endOfData = false;
+    __enable_irq();
+    return true;
+}
+
+bool MyStreamPlayer::fillChunk() {
+    if (!reader.isOpen() ||
+        (reader.positionFrames() >= reader.lengthFrames() && srcRemaining == 0)) {
+        // Fichier entièrement dans le tampon : le suivant est lu à la suite
+        reader.close();
+        if (queuedName.length() > 0 && (uint8_t)(trackTail - trackHead) < MAX_TRACKS) {
+            const String name = queuedName;
+            queuedName = "";
+            if (openNext(name.c_str())) {
+                return true;
+            }
+            // Pas d'autre essai : la lecture s'arrête à la fin du fichier courant
+            queueRefused = true;
+        }
+        if (queuedName.length() == 0) {
+            __disable_irq();
+            endOfData = true;
+            __enable_irq();
+        }
+        return false;
+    }
+
+    const uint32_t used = writeCount - readCount;
+    if (RING_FRAMES - used < READ_BYTES / 4) {
+        return false;
+    }
+    // Jusqu'à la limite de READ_BYTES suivante du fichier (dépassée de moins d'une trame),
+    // dans la place contiguë du tampon
+    const uint32_t pos = writeCount & (RING_FRAMES - 1);
+    uint32_t space = RING_FRAMES - pos;
+    if (space > RING_FRAMES - used) {
+        space = RING_FRAMES - used;
+    }
+    if (resampling) {
+        return fillResampled(pos, space);
+    }
+    const uint32_t frameBytes = 2 * reader.channels();
+    const uint32_t toBoundary = READ_BYTES - reader.bytePosition() % READ_BYTES;
+    uint32_t frames = (toBoundary + frameBytes - 1) / frameBytes;
+    if (frames > space) {
+        frames = space;
+    }
+
+    int16_t* dest = ring + 2 * pos;
+    AudioNoInterrupts();
+    const int got = reader.readFrames((frameBytes == 4) ? dest : monoChunk, (int)frames);
+    AudioInterrupts();
+    cardReads++;
+    if (frameBytes == 2) {
+        for (int i = 0; i < got; i++) {
+            dest[2 * i] = monoChunk[i];
+            dest[2 * i + 1] = monoChunk[i];
+        }
+    }
+    // Trames visibles par l'interruption une fois écrites
+    __disable_irq();
+    writeCount += got;
+    __enable_irq();
+    return true;
+}
+
+bool MyStreamPlayer::fillResampled(uint32_t pos, uint32_t space) {
+    const int channels = reader.channels();
+    if (srcPending == 0 && reader.positionFrames() < reader.lengthFrames()) {
+        // Même lecture alignée que sans conversion, dans srcInput
+        const uint32_t frameBytes = 2 * channels;
+        const uint32_t toBoundary = READ_BYTES - reader.bytePosition() % READ_BYTES;
+        const uint32_t frames = (toBoundary + frameBytes - 1) / frameBytes;
+        AudioNoInterrupts();
+        const int got = reader.readFrames(srcInput, (int)frames);
+        AudioInterrupts();
+        cardReads++;
+        if (got <= 0) {
+            // Fichier tronqué : le suivant est lu à la suite
+            reader.close();
+            srcRemaining = 0;
+            return true;
+        }
+        srcOffset = 0;
+        srcPending = got;
+    }
+
+    // Conversion hors interruption, vers le tampon (ou monoChunk avant recopie sur deux canaux)
+    uint32_t maxOut = (srcRemaining < space) ? srcRemaining : space;
+    if (channels == 1 && maxOut > READ_BYTES / 2) {
+        maxOut = READ_BYTES / 2;
+    }
+    int16_t* dest = ring + 2 * pos;
+    int16_t* converted = (channels == 2) ? dest : monoChunk;
+    int consumed = 0;
+    int produced;
+    if (srcPending > 0) {
+        produced = resampler.process(srcInput + srcOffset * channels, srcPending, consumed,
+                                     converted, (int)maxOut);
+        srcOffset += consumed;
+        srcPending -= consumed;
+    } else {
+        // Fin du fichier : zéros jusqu'à la longueur convertie (dernières trames du filtre)
+        produced = resampler.process(nullptr, 0, consumed, converted, (int)maxOut);
+    }
+    srcRemaining -= produced;
+    if (channels == 1) {
+        for (int i = 0; i < produced; i++) {
+            dest[2 * i] = monoChunk[i];
+            dest[2 * i + 1] = monoChunk[i];
+        }
+    }
+    __disable_irq();
+    writeCount += produced;
+    __enable_irq();
+    return true;
+}
+
+uint32_t MyStreamPlayer::positionMillis() const {
+    __disable_irq();
+    const Track t = tracks[trackHead % MAX_TRACKS];
+    const uint32_t played = readCount - t.start;
+    __enable_irq();
+    if (t.rate == 0 || !playing) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)played * 1000 / t.rate);
+}
+
+uint32_t MyStreamPlayer::lengthMillis() const {
+    __disable_irq();
+    const Track t = tracks[trackHead % MAX_TRACKS];
+    __enable_irq();
+    if (t.rate == 0 || !playing) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)t.length * 1000 / t.rate);
+}
+
+void MyStreamPlayer::resetStats() {
+    __disable_irq();
+    minFill = writeCount - readCount;
+    underruns = 0;
+    __enable_irq();
+    cardReads = 0;
+}
+
+void MyStreamPlayer::update() {
+    if (!playing) {
+        return;
+    }
+    audio_block_t* outBlock[2];
+    outBlock[0] = allocate();
+    if (!outBlock[0]) {
+        return;
+    }
+    outBlock[1] = allocate();
+    if (!outBlock[1]) {
+        release(outBlock[0]);
+        return;
+    }
+
+    // Trames déjà en RAM seulement ; le manque est complété par du silence
+    const uint32_t available = writeCount - readCount;
+    minFill = (available < minFill) ? available : minFill;
+    const uint32_t frames = (available < AUDIO_BLOCK_SAMPLES) ? available : AUDIO_BLOCK_SAMPLES;
+    uint32_t pos = readCount & (RING_FRAMES - 1);
+    for (uint32_t i = 0; i < frames; i++) {
+        outBlock[0]->data[i] = ring[2 * pos];
+        outBlock[1]->data[i] = ring[2 * pos + 1];
+        pos = (pos + 1) & (RING_FRAMES - 1);
+    }
+    for (uint32_t i = frames; i < AUDIO_BLOCK_SAMPLES; i++) {
+        outBlock[0]->data[i] = 0;
+        outBlock[1]->data[i] = 0;
+    }
+    readCount += frames;
+
+    // Premières trames du fichier suivant rendues : il devient le fichier entendu
+    while ((uint8_t)(trackTail - trackHead) > 1 &&
+           (int32_t)(readCount - tracks[(uint8_t)(trackHead + 1) % MAX_TRACKS].start) > 0) {
+        trackHead++;
+        trackSerial++;
+    }
+    if (frames < AUDIO_BLOCK_SAMPLES) {
+        if (endOfData) {
+            playing = false;
+        } else {
+            underruns++;
+        }
+    }
+
+    transmit(outBlock[0], 0);
+    transmit(outBlock[1], 1);
+    release(outBlock[0]);
+    release(outBlock[1]);
+}
@@ -0,0 +1,101 @@
+#ifndef MY_STREAM_PLAYER_H
+#define MY_STREAM_PLAYER_H
+
+#include "HrtfConfig.h"
+#include "HrtfResampler.h"
+#include "SdWavReader.h"
+#include <AudioStream.h>
+
+// Lecteur de WAV mono ou stéréo (PCM 16 bits), à la place d'AudioPlaySdWav : les fichiers sont
+// lus depuis loop() (service) par morceaux alignés sur la carte SD, dans un tampon circulaire
+// de HRTF_STREAM_BUFFER_FRAMES trames stéréo, et l'interruption audio ne lit que ce tampon.
+// Le fichier mis en attente (queue) est ouvert et lu à la suite du courant dès que celui-ci
+// est entièrement dans le tampon : le passage de l'un à l'autre se fait à l'échantillon près.
+// Un fichier qui n'est pas à la fréquence du moteur (AUDIO_SAMPLE_RATE_EXACT, 44,1 kHz compris)
+// y est converti au moment de la lecture, depuis loop() (HrtfResampler, HRTF_RESAMPLE_QUALITY) :
+// le tampon et l'interruption ne voient que des trames à la fréquence du moteur.
+// Sorties 0 et 1 : gauche et droite (un fichier mono sort sur les deux).
+class MyStreamPlayer : public AudioStream {
+public:
+    MyStreamPlayer();
+    virtual void update();
+
+    // Lecture immédiate (file d'attente vidée) ; le début du fichier est lu ici
+    bool play(const char* filename);
+    // Fichier à enchaîner après le courant, ouvert plus tard par service ; false si rien n'est
+    // lu ou si un fichier suit déjà. Un fichier de plus de 2 canaux ou IMA-ADPCM n'est pas
+    // enchaîné : la lecture s'arrête à la fin du courant (voir playTrack), et plus rien n'est
+    // accepté jusqu'au prochain play.
+    bool queue(const char* filename);
+    // Un fichier suit celui qu'on entend (en attente ou déjà dans le tampon)
+    bool hasQueued() const;
+    void stop();
+    // À appeler depuis loop() : quelques lectures pour remplir le tampon (audio suspendu pendant
+    // chacune, la carte SD étant partagée avec les lecteurs qui la lisent sur l'interruption)
+    void service();
+
+    bool isPlaying() const { return playing; }
+    // Fichier entendu : position et durée
+    uint32_t positionMillis() const;
+    uint32_t lengthMillis() const;
+    // Incrémenté à chaque passage d'un fichier au suivant (sur l'interruption)
+    uint32_t getTrackSerial() const { return trackSerial; }
+
+    // Remplissage : trames d'avance et capacité du tampon, minimum vu par l'interruption depuis
+    // resetStats, blocs rendus incomplets faute de données, lectures sur la carte
+    uint32_t getBufferFill() const { return writeCount - readCount; }
+    uint32_t getBufferCapacity() const { return RING_FRAMES; }
+    uint32_t getMinFill() const { return minFill; }
+    uint32_t getUnderruns() const { return underruns; }
+    uint32_t getCardReads() const { return cardReads; }
+    void resetStats();
+
+private:
+    MyStreamPlayer(const MyStreamPlayer&);
+    MyStreamPlayer& operator=(const MyStreamPlayer&);
+
+    static const uint32_t RING_FRAMES = HRTF_STREAM_BUFFER_FRAMES;
+    // Une lecture s'arrête à la première limite de READ_BYTES du fichier : des secteurs entiers,
+    // sauf au début des données ; elle n'est faite qu'avec au moins READ_BYTES de place libre
+    static const uint32_t READ_BYTES = 4096;
+    static const int MAX_TRACKS = 4;
+
+    // Fichier dont les trames sont (ou ont été) écrites dans le tampon : première trame (valeur
+    // de writeCount), longueur et fréquence (celles du moteur pour un fichier converti)
+    struct Track {
+        uint32_t start;
+        uint32_t length;
+        uint32_t rate;
+    };
+
+    bool openNext(const char* filename);
+    bool fillChunk();
+    bool fillResampled(uint32_t pos, uint32_t space);
+
+    SdWavReader reader;        // fichier en cours de lecture sur la carte
+    String queuedName;         // fichier suivant, pas encore ouvert
+    int16_t ring[2 * RING_FRAMES];        // trames stéréo entrelacées
+    int16_t monoChunk[READ_BYTES / 2];
+    // Conversion de fréquence du fichier en cours de lecture : trames lues pas encore converties
+    // (srcPending à partir de srcOffset), trames converties restant à écrire
+    HrtfResampler resampler;
+    bool resampling;
+    int16_t srcInput[READ_BYTES / 2];
+    int srcOffset;
+    int srcPending;
+    uint32_t srcRemaining;
+    volatile uint32_t writeCount;         // trames écrites depuis play (loop)
+    volatile uint32_t readCount;          // trames rendues (interruption)
+    volatile bool endOfData;              // tout est écrit : fin de lecture quand le tampon est vide
+    Track tracks[MAX_TRACKS];
+    volatile uint8_t trackHead;           // fichier entendu
+    volatile uint8_t trackTail;           // après le dernier fichier ouvert
+    volatile bool playing;
+    bool queueRefused;                    // fichier en attente impossible à ouvrir
+    volatile uint32_t trackSerial;
+    volatile uint32_t minFill;
+    volatile uint32_t underruns;
+    uint32_t cardReads;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "MySurroundPlayer.h"
+#include "HrtfConfig.h"
+#include <Arduino.h>
+#include <Audio.h>
+#include <string.h>
+#include <math.h>
+
+#define MULT_16 32767
+
+// Bits du masque de canaux WAVE_FORMAT_EXTENSIBLE
+static const uint32_t SPEAKER_FRONT_LEFT            = 0x1;
+static const uint32_t SPEAKER_FRONT_RIGHT           = 0x2;
+static const uint32_t SPEAKER_FRONT_CENTER          = 0x4;
+static const uint32_t SPEAKER_LOW_FREQUENCY         = 0x8;
+static const uint32_t SPEAKER_BACK_LEFT             = 0x10;
+static const uint32_t SPEAKER_BACK_RIGHT            = 0x20;
+static const uint32_t SPEAKER_FRONT_LEFT_OF_CENTER  = 0x40;
+static const uint32_t SPEAKER_FRONT_RIGHT_OF_CENTER = 0x80;
+static const uint32_t SPEAKER_BACK_CENTER           = 0x100;
+static const uint32_t SPEAKER_SIDE_LEFT             = 0x200;
+static const uint32_t SPEAKER_SIDE_RIGHT            = 0x400;
+
+// Masques par défaut des WAV sans masque (ordre habituel des fichiers 5.1 et 7.1)
+static const uint32_t MASK_5_1 = 0x60F;   // FL FR FC LFE SL SR
+static const uint32_t MASK_7_1 = 0x63F;   // FL FR FC LFE BL BR SL SR
+
+static int countBits(uint32_t v) {
+    int n = 0;
+    while (v) {
+        v &= v - 1;
+        n++;
+    }
+    return n;
+}
+
+MySurroundPlayer::MySurroundPlayer(HrtfBank* sharedBank)
+: AudioStream(0, nullptr), bank(sharedBank), convMode(HRTF_CONV_FFT),
+  playing(false), gain(0.5f), lfeGain(0.5f), lfeChannel(-1), speakerCount(0)
+{
+    for (int c = 0; c < MAX_CHANNELS; c++) {
+        sourceIndex[c] = -1;
+        channelAzimuth[c] = 0;
+    }
+}
+
+void MySurroundPlayer::begin() {
+    if (!bank) {
+        bank = new HrtfBank();
+    }
+
+    // La banque partagée n'est chargée qu'une fois, par le premier nœud
+    if (bank->getHrirCount() == 0) {
+        bank->init(AUDIO_SAMPLE_RATE_EXACT, AUDIO_BLOCK_SAMPLES);
+        bank->setMinimumPhase(HRTF_MINIMUM_PHASE_LENGTH);
+        bank->setCompactStorage(HRTF_COMPACT_BANK);
+        bank->setSymmetricStorage(HRTF_SYMMETRIC_BANK);
+        bank->setCacheSize(HRTF_CACHE_SIZE);
+        // Banque compilée en flash (HRTF_FLASH_BANK), sinon fichier de la carte SD
+        const HrtfFlashBank* flash = hrtfFlashBank();
+        if (flash ? !bank->loadFromFlash(*flash) : !bank->loadFromBin(HRTF_BANK_FILE)) {
+            Serial.println(flash ? "Echec du loadFromFlash" : "Echec du loadFromBin");
+        }
+    }
+}
+
+bool MySurroundPlayer::canPlay(const SdWavReader& r) {
+    return canPlay(r.channels(), r.isBFormat());
+}
+
+bool MySurroundPlayer::assignChannels() {
+    const int C = reader.channels();
+    uint32_t mask = reader.channelMask();
+    if (mask == 0 || countBits(mask) != C) {
+        mask = (C == 8) ? MASK_7_1 : MASK_5_1;
+    }
+    // Avec des canaux latéraux, les canaux arrière passent à ±135°
+    const bool sides = (mask & (SPEAKER_SIDE_LEFT | SPEAKER_SIDE_RIGHT)) != 0;
+
+    lfeChannel = -1;
+    speakerCount = 0;
+    uint32_t bit = 1;
+    for (int c = 0; c < C; c++) {
+        while (bit && !(mask & bit)) {
+            bit <<= 1;
+        }
+        // Azimut trigonométrique (90° = gauche), comme les mesures de la banque
+        int az = 0;
+        bool speaker = true;
+        switch (bit) {
+            case SPEAKER_FRONT_LEFT:            az = 30; break;
+            case SPEAKER_FRONT_RIGHT:           az = 330; break;
+            case SPEAKER_FRONT_CENTER:          az = 0; break;
+            case SPEAKER_BACK_LEFT:             az = sides ? 135 : 110; break;
+            case SPEAKER_BACK_RIGHT:            az = sides ? 225 : 250; break;
+            case SPEAKER_FRONT_LEFT_OF_CENTER:  az = 15; break;
+            case SPEAKER_FRONT_RIGHT_OF_CENTER: az = 345; break;
+            case SPEAKER_BACK_CENTER:           az = 180; break;
+            case SPEAKER_SIDE_LEFT:             az = 110; break;
+            case SPEAKER_SIDE_RIGHT:            az = 250; break;
+            default:                            speaker = false; break;
+        }
+        sourceIndex[c] = -1;
+        if (bit == SPEAKER_LOW_FREQUENCY) {
+            lfeChannel = c;
+        } else if (speaker) {
+            channelAzimuth[c] = az;
+            sourceIndex[c] = speakerCount++;
+        }
+        bit <<= 1;
+    }
+
+    if (!mixer.init(*bank, speakerCount)) {
+        Serial.println("Mémoire insuffisante pour le surround virtuel");
+        return false;
+    }
+    mixer.setConvolutionMode(convMode);
+    for (int c = 0; c < C; c++) {
+        if (sourceIndex[c] >= 0) {
+            mixer.setSource(sourceIndex[c], channelAzimuth[c], 0, gain);
+        }
+    }
+    return true;
+}
+
+bool MySurroundPlayer::play(const char* filename) {
+    stop();
+    // Le fichier est ensuite lu dans update() : ouverture avec l'audio suspendu
+    AudioNoInterrupts();
+    bool ok = bank && reader.open(filename);
+    if (ok && !canPlay(reader)) {
+        Serial.print("Fichier non surround (6 ou 8 canaux attendus) : ");
+        Serial.println(filename);
+        reader.close();
+        ok = false;
+    }
+    if (ok && !assignChannels()) {
+        reader.close();
+        ok = false;
+    }
+    if (ok) {
+        // 44100 Hz est lu à AUDIO_SAMPLE_RATE_EXACT comme par AudioPlaySdWav
+        if (fabsf((float)reader.sampleRate() - AUDIO_SAMPLE_RATE_EXACT) > 0.01f * AUDIO_SAMPLE_RATE_EXACT) {
+            Serial.print("Attention : fichier surround à ");
+            Serial.print(reader.sampleRate());
+            Serial.println(" Hz, lu sans conversion");
+        }
+        playing = true;
+    }
+    AudioInterrupts();
+    return ok;
+}
+
+void MySurroundPlayer::stop() {
+    AudioNoInterrupts();
+    playing = false;
+    reader.close();
+    AudioInterrupts();
+}
+
+uint32_t MySurroundPlayer::positionMillis() const {
+    if (reader.sampleRate() == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)reader.positionFrames() * 1000 / reader.sampleRate());
+}
+
+uint32_t MySurroundPlayer::lengthMillis() const {
+    if (reader.sampleRate() == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)reader.lengthFrames() * 1000 / reader.sampleRate());
+}
+
+void MySurroundPlayer::setGain(float g) {
+    __disable_irq();
+    gain = g;
+    for (int c = 0; c < MAX_CHANNELS; c++) {
+        if (sourceIndex[c] >= 0) {
+            mixer.setSource(sourceIndex[c], channelAzimuth[c], 0, gain);
+        }
+    }
+    __enable_irq();
+}
+
+void MySurroundPlayer::setConvolutionMode(HrtfConvolutionMode mode) {
+    __disable_irq();
+    convMode = mode;
+    mixer.setConvolutionMode(mode);
+    __enable_irq();
+}
+
+void MySurroundPlayer::update() {
+    if (!playing) {
+        return;
+    }
+
+    float* dst[MAX_CHANNELS] = { nullptr };
+    const int C = (reader.channels() < MAX_CHANNELS) ? reader.channels() : MAX_CHANNELS;
+    for (int c = 0; c < C; c++) {
+        dst[c] = channelFloat[c];
+    }
+    int frames = reader.read(dst, C, AUDIO_BLOCK_SAMPLES);
+    for (int c = 0; c < C; c++) {
+        memset(channelFloat[c] + frames, 0, (AUDIO_BLOCK_SAMPLES - frames) * sizeof(float));
+    }
+    if (frames < AUDIO_BLOCK_SAMPLES) {
+        playing = false;
+        reader.close();
+    }
+
+    audio_block_t* outBlock[2];
+    outBlock[0] = allocate();
+    if (!outBlock[0]) {
+        return;
+    }
+    outBlock[1] = allocate();
+    if (!outBlock[1]) {
+        release(outBlock[0]);
+        return;
+    }
+
+    // Canaux positionnés : sources fixes du mélangeur, spectres sommés avant l'IFFT
+    const float* inputs[HrtfMixer::MAX_SOURCES];
+    for (int c = 0; c < C; c++) {
+        if (sourceIndex[c] >= 0) {
+            inputs[sourceIndex[c]] = channelFloat[c];
+        }
+    }
+    mixer.process(inputs, outFloatLeft, outFloatRight);
+
+    // LFE : basses fréquences sans information de direction, ajouté aux deux oreilles
+    if (lfeChannel >= 0) {
+        const float* lfe = channelFloat[lfeChannel];
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            outFloatLeft[i]  += lfe[i] * lfeGain;
+            outFloatRight[i] += lfe[i] * lfeGain;
+        }
+    }
+
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        float l = outFloatLeft[i] * MULT_16;
+        float r = outFloatRight[i] * MULT_16;
+        // La somme des canaux peut dépasser la pleine échelle : saturation
+        outBlock[0]->data[i] = (int16_t)(l > 32767.0f ? 32767.0f : (l < -32768.0f ? -32768.0f : l));
+        outBlock[1]->data[i] = (int16_t)(r > 32767.0f ? 32767.0f : (r < -32768.0f ? -32768.0f : r));
+    }
+
+    transmit(outBlock[0], 0);
+    transmit(outBlock[1], 1);
+    release(outBlock[0]);
+    release(outBlock[1]);
+}
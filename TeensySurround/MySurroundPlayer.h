@@ -0,0 +1,63 @@
+#ifndef MY_SURROUND_PLAYER_H
+#define MY_SURROUND_PLAYER_H
+
+#include "HrtfBank.h"
+#include "HrtfMixer.h"
+#include "SdWavReader.h"
+#include <AudioStream.h>
+
+// Nœud audio de surround virtuel : lit un WAV 5.1 ou 7.1 de la carte SD (lu dans update(),
+// comme AudioPlaySdWav) et rend chaque canal par la HRIR d'un haut-parleur virtuel fixe
+// (avant ±30°, centre 0°, surround ±110°, arrière ±135° en 7.1). Les canaux sont sommés en
+// fréquence par HrtfMixer (une seule IFFT pour les deux oreilles) ; le LFE n'est pas
+// convolué, il est ajouté tel quel aux deux oreilles.
+// Les canaux suivent le masque WAVE_FORMAT_EXTENSIBLE, sinon l'ordre WAV habituel :
+//   6 canaux : FL FR FC LFE SL SR        8 canaux : FL FR FC LFE BL BR SL SR
+class MySurroundPlayer : public AudioStream {
+public:
+    static const int MAX_CHANNELS = 8;
+
+    explicit MySurroundPlayer(HrtfBank* sharedBank = nullptr);
+    void begin();
+    virtual void update();
+
+    // Fichier 5.1/7.1 reconnu (6 ou 8 canaux, hors B-format)
+    static bool canPlay(const SdWavReader& reader);
+    static bool canPlay(int channels, bool bformat) {
+        return !bformat && (channels == 6 || channels == 8);
+    }
+
+    bool play(const char* filename);
+    void stop();
+    bool isPlaying() const { return playing; }
+    uint32_t positionMillis() const;
+    uint32_t lengthMillis() const;
+
+    // Gain des haut-parleurs virtuels et du LFE (0.5 par défaut, comme MyDsp)
+    void setGain(float gain);
+    void setLfeGain(float gain) { lfeGain = gain; }
+
+    void setConvolutionMode(HrtfConvolutionMode mode);
+
+private:
+    bool assignChannels();
+
+    HrtfBank* bank;     // partagée, chargée par le premier begin()
+    HrtfMixer mixer;    // une source par canal hors LFE
+    HrtfConvolutionMode convMode;
+
+    SdWavReader reader;
+    volatile bool playing;
+    float gain;
+    float lfeGain;
+    int lfeChannel;                   // -1 si le fichier n'a pas de LFE
+    int sourceIndex[MAX_CHANNELS];    // source du mélangeur de chaque canal (-1 : LFE ou ignoré)
+    int channelAzimuth[MAX_CHANNELS];
+    int speakerCount;
+
+    float channelFloat[MAX_CHANNELS][AUDIO_BLOCK_SAMPLES];
+    float outFloatLeft[AUDIO_BLOCK_SAMPLES];
+    float outFloatRight[AUDIO_BLOCK_SAMPLES];
+};
+
+#endif
@@ -3,31 +3,13 @@
 
 #include <Arduino.h>
 #include <stddef.h>
+#include "HrtfBank.h"
+#include "HrtfVoice.h"
 
-// Longueur maximale d'une HRIR
-static const int MAX_HRIR_LENGTH = 128;
-
-struct HrirData {
-    unsigned delayLeft;   // en échantillons
-    unsigned delayRight;  // en échantillons
-    float left[MAX_HRIR_LENGTH];
-    float right[MAX_HRIR_LENGTH];
-    size_t length;
-};
-
-struct SelectedHrir {
-    const float* left;
-    const float* right;
-    unsigned delayLeft;
-    unsigned delayRight;
-    size_t length;
-    float distance;  // Nouvelle donnée : distance en mètres (par exemple)
-};
-
+// Moteur HRTF d'une source : une banque et une voix.
+// Pour spatialiser plusieurs sources, partager une HrtfBank entre plusieurs HrtfVoice.
 class ProjectHrtfEngine {
 public:
-    ProjectHrtfEngine();
-
     // Initialisation : sampleRate, blockSize (ex : 44100, 128)
     void init(int sRate, int bSize);
     void addHrir(int azimuthDeg,
@@ -35,32 +17,30 @@ public:
                  unsigned delayLeft, unsigned delayRight,
                  size_t length);
     bool loadFromBin(const String &filename);
-    SelectedHrir getHrir(int azimuthDeg);
+    SelectedHrir getHrir(int azimuthDeg) const { return bank.getHrir(azimuthDeg); }
+    int getHrirCount() const { return bank.getHrirCount(); }
+    int getBlockSize() const { return bank.getBlockSize(); }
 
-    // Convolution naïve avec overlap-add et gain
+    // Convolution avec le noyau courant (naïf ou FFT) et gain
     void processBlock(const float* in, float* outLeft, float* outRight,
-                      const SelectedHrir& selHrir, float gain = 1.0f);
+                      const SelectedHrir& selHrir, float gain = 1.0f) {
+        voice.processBlock(in, outLeft, outRight, selHrir, gain);
+    }
 
-    const float* getOverlapLeft() const { return overlapLeft; }
-    int getOverlapSize() const { return overlapSize; }
+    // Choix du noyau de convolution (l'historique est remis à zéro)
+    void setConvolutionMode(HrtfConvolutionMode mode) { voice.setConvolutionMode(mode); }
+    HrtfConvolutionMode getConvolutionMode() const { return voice.getConvolutionMode(); }
 
-private:
-    static const int MAX_HRIR_SLOTS = 128;
-    struct HrirSlot {
-        int azimuth;
-        float distance; // Nouvelle donnée pour stocker la distance
-        HrirData data;
-    };
+    // Comportement lors d'un changement de HRIR (fondu enchaîné par défaut)
+    void setSwitchMode(HrtfSwitchMode mode) { voice.setSwitchMode(mode); }
+    HrtfSwitchMode getSwitchMode() const { return voice.getSwitchMode(); }
 
-    HrirSlot hrirSlots[MAX_HRIR_SLOTS];
-    int hrirCount;
-    int sampleRate;
-    int blockSize;
+    const HrtfBank& getBank() const { return bank; }
+    HrtfVoice& getVoice() { return voice; }
 
-    // Buffers pour overlap-add
-    float overlapLeft[MAX_HRIR_LENGTH];
-    float overlapRight[MAX_HRIR_LENGTH];
-    int overlapSize;
+private:
+    HrtfBank bank;
+    HrtfVoice voice;
 };
 
 #endif
@@ -0,0 +1,272 @@
+#include "SdMediaLibrary.h"
+#include "SdStemReader.h"
+#include "SdWavReader.h"
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(sizeof(SdMediaEntry) == 32, "entrées de l'index sur 32 octets");
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static bool endsWith(const char* s, const char* suffix) {
+    const size_t n = strlen(s);
+    const size_t k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+static bool isStemFile(const char* filename) {
+    return endsWith(filename, ".stm") || endsWith(filename, ".STM");
+}
+
+// Date et heure de modification aux champs d'une entrée de répertoire FAT (comparées seulement)
+static uint32_t fatStamp(const DateTimeFields& t) {
+    const uint32_t year = (t.year >= 80) ? t.year - 80u : 0u;   // année depuis 1980
+    return (year << 25) | ((uint32_t)(t.mon + 1) << 21) | ((uint32_t)t.mday << 16) |
+           ((uint32_t)t.hour << 11) | ((uint32_t)t.min << 5) | (uint32_t)(t.sec / 2);
+}
+
+SdMediaLibrary::SdMediaLibrary()
+: entries(nullptr), names(nullptr), entryCount(0), entryCapacity(0), nameBytes(0),
+  nameCapacity(0), parsedCount(0), removedCount(0), rewritten(false), scanMillis(0)
+{
+}
+
+SdMediaLibrary::~SdMediaLibrary() {
+    release();
+}
+
+void SdMediaLibrary::release() {
+    free(entries);
+    free(names);
+    entries = nullptr;
+    names = nullptr;
+    entryCount = 0;
+    entryCapacity = 0;
+    nameBytes = 0;
+    nameCapacity = 0;
+}
+
+bool SdMediaLibrary::isMediaFile(const char* filename) {
+    return endsWith(filename, ".wav") || endsWith(filename, ".WAV") || isStemFile(filename);
+}
+
+uint32_t SdMediaLibrary::lengthMillis(int index) const {
+    const SdMediaEntry& e = entries[index];
+    if (e.sampleRate == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)e.frames * 1000 / e.sampleRate);
+}
+
+bool SdMediaLibrary::begin(const char* indexFile) {
+    const uint32_t start = millis();
+    parsedCount = 0;
+    removedCount = 0;
+    rewritten = false;
+
+    // Index précédent : ses entrées sont reprises tant que le fichier n'a pas changé
+    release();
+    const bool indexed = loadIndex(indexFile);
+    SdMediaEntry* previous = entries;
+    char* previousNames = names;
+    const uint32_t previousCount = entryCount;
+    entries = nullptr;
+    names = nullptr;
+    release();
+
+    bool ok = true;
+    bool changed = !indexed;
+    uint32_t matched = 0;
+    uint32_t cursor = 0;   // l'ordre du répertoire change peu : l'entrée suivante est essayée d'abord
+    File root = SD.open("/");
+    while (root) {
+        File file = root.openNextFile();
+        if (!file) {
+            break;
+        }
+        if (!file.isDirectory() && isMediaFile(file.name())) {
+            SdMediaEntry e;
+            memset(&e, 0, sizeof(e));
+            e.size = (uint32_t)file.size();
+            DateTimeFields t;
+            if (file.getModifyTime(t)) {
+                e.modified = fatStamp(t);
+            }
+            int found = -1;
+            for (uint32_t k = 0; k < previousCount && found < 0; k++) {
+                const uint32_t i = (cursor + k) % previousCount;
+                if (strcmp(previousNames + previous[i].nameOffset, file.name()) == 0) {
+                    found = (int)i;
+                }
+            }
+            if (found >= 0) {
+                matched++;
+                cursor = (uint32_t)found + 1;
+            }
+            if (found >= 0 && previous[found].size == e.size &&
+                previous[found].modified == e.modified) {
+                e = previous[found];
+                changed = changed || (uint32_t)found != entryCount;
+            } else {
+                parseFile(file.name(), e);
+                parsedCount++;
+                changed = true;
+            }
+            if (!append(file.name(), e)) {
+                Serial.println("Mémoire insuffisante : bibliothèque tronquée");
+                ok = false;
+                file.close();
+                break;
+            }
+        }
+        file.close();
+    }
+    root.close();
+    free(previous);
+    free(previousNames);
+
+    removedCount = previousCount - matched;
+    if ((changed || removedCount > 0) && ok) {
+        rewritten = saveIndex(indexFile);
+        if (!rewritten) {
+            Serial.println("Index de la bibliothèque non écrit");
+        }
+    }
+    scanMillis = millis() - start;
+    return ok;
+}
+
+void SdMediaLibrary::parseFile(const char* filename, SdMediaEntry& e) {
+    e.format = FORMAT_UNREADABLE;
+    if (isStemFile(filename)) {
+        SdStemReader reader;
+        if (reader.open(filename)) {
+            e.format = FORMAT_STEMS;
+            e.channels = (uint8_t)reader.stems();
+            e.sampleRate = reader.sampleRate();
+            e.frames = reader.lengthFrames();
+            e.dataOffset = reader.dataOffset();
+            reader.close();
+        }
+        return;
+    }
+    SdWavReader reader;
+    if (reader.open(filename)) {
+        e.format = reader.isAdpcm() ? FORMAT_IMA_ADPCM : FORMAT_PCM;
+        e.channels = (uint8_t)reader.channels();
+        e.flags = reader.isBFormat() ? FLAG_BFORMAT : 0;
+        e.sampleRate = reader.sampleRate();
+        e.frames = reader.lengthFrames();
+        e.dataOffset = reader.dataOffset();
+        reader.close();
+    }
+}
+
+bool SdMediaLibrary::append(const char* filename, const SdMediaEntry& e) {
+    const uint32_t length = (uint32_t)strlen(filename) + 1;
+    if (entryCount == entryCapacity) {
+        const uint32_t capacity = (entryCapacity == 0) ? 16 : 2 * entryCapacity;
+        SdMediaEntry* grown = (SdMediaEntry*)realloc(entries, capacity * sizeof(SdMediaEntry));
+        if (!grown) {
+            return false;
+        }
+        entries = grown;
+        entryCapacity = capacity;
+    }
+    if (nameBytes + length > nameCapacity) {
+        uint32_t capacity = (nameCapacity == 0) ? 512 : 2 * nameCapacity;
+        capacity = (capacity < nameBytes + length) ? nameBytes + length : capacity;
+        char* grown = (char*)realloc(names, capacity);
+        if (!grown) {
+            return false;
+        }
+        names = grown;
+        nameCapacity = capacity;
+    }
+    memcpy(names + nameBytes, filename, length);
+    entries[entryCount] = e;
+    entries[entryCount].nameOffset = nameBytes;
+    entries[entryCount].reserved = 0;
+    entryCount++;
+    nameBytes += length;
+    return true;
+}
+
+bool SdMediaLibrary::loadIndex(const char* indexFile) {
+    if (!SD.exists(indexFile)) {
+        return false;
+    }
+    File f = SD.open(indexFile);
+    if (!f) {
+        return false;
+    }
+    uint8_t header[HEADER_BYTES];
+    bool ok = f.read(header, HEADER_BYTES) == (int)HEADER_BYTES &&
+              memcmp(header, "MLIB", 4) == 0 && getU16(header + 4) == VERSION &&
+              getU16(header + 6) == sizeof(SdMediaEntry);
+    const uint32_t count = ok ? getU32(header + 8) : 0;
+    const uint32_t bytes = ok ? getU32(header + 12) : 0;
+    // Taille exacte : un index écrit à moitié est reconstruit
+    ok = ok && (uint64_t)f.size() == HEADER_BYTES + (uint64_t)count * sizeof(SdMediaEntry) + bytes;
+    if (ok && count > 0) {
+        entries = (SdMediaEntry*)malloc(count * sizeof(SdMediaEntry));
+        names = (char*)malloc(bytes);
+        ok = entries && names && bytes > 0 &&
+             f.read(entries, count * sizeof(SdMediaEntry)) == (int)(count * sizeof(SdMediaEntry)) &&
+             f.read(names, bytes) == (int)bytes && names[bytes - 1] == '\0';
+        for (uint32_t i = 0; ok && i < count; i++) {
+            ok = entries[i].nameOffset < bytes;
+        }
+    }
+    f.close();
+    if (!ok) {
+        release();
+        return false;
+    }
+    entryCount = count;
+    entryCapacity = count;
+    nameBytes = bytes;
+    nameCapacity = bytes;
+    return true;
+}
+
+bool SdMediaLibrary::saveIndex(const char* indexFile) const {
+    SD.remove(indexFile);
+    File f = SD.open(indexFile, FILE_WRITE);
+    if (!f) {
+        return false;
+    }
+    uint8_t header[HEADER_BYTES];
+    memcpy(header, "MLIB", 4);
+    putU16(header + 4, VERSION);
+    putU16(header + 6, sizeof(SdMediaEntry));
+    putU32(header + 8, entryCount);
+    putU32(header + 12, nameBytes);
+    putU32(header + 16, 0);
+    const size_t tableBytes = entryCount * sizeof(SdMediaEntry);
+    const bool ok = f.write(header, HEADER_BYTES) == HEADER_BYTES &&
+                    (tableBytes == 0 || f.write(entries, tableBytes) == tableBytes) &&
+                    (nameBytes == 0 || f.write(names, nameBytes) == nameBytes);
+    f.close();
+    if (!ok) {
+        SD.remove(indexFile);
+    }
+    return ok;
+}
@@ -0,0 +1,91 @@
+#ifndef SD_MEDIA_LIBRARY_H
+#define SD_MEDIA_LIBRARY_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+// Fichier audio de la racine de la carte SD, en-tête déjà analysé (32 octets, tel quel dans
+// l'index)
+struct SdMediaEntry {
+    uint32_t size;         // octets
+    uint32_t modified;     // date et heure de modification (champs FAT), 0 si inconnues
+    uint32_t dataOffset;   // octet du début des données audio
+    uint32_t frames;       // longueur en trames
+    uint32_t sampleRate;
+    uint16_t format;       // SdMediaLibrary::FORMAT_*
+    uint8_t channels;      // canaux (pistes d'un .stm)
+    uint8_t flags;         // SdMediaLibrary::FLAG_*
+    uint32_t nameOffset;   // nom (terminé par un zéro) dans la table des noms
+    uint32_t reserved;
+};
+
+// Bibliothèque des fichiers WAV et de pistes séparées (.stm) de la racine de la carte SD, dans
+// l'ordre du répertoire, sans limite de nombre (tableaux alloués). L'index (HRTF_LIBRARY_FILE)
+// garde pour chaque fichier son nom, sa taille, sa date de modification et son en-tête analysé
+// (format, canaux, fréquence, longueur, début des données) :
+//   "MLIB", uint16 version (1), uint16 octets par entrée (32), uint32 nombre d'entrées,
+//   uint32 octets de noms, uint32 réservé, puis les entrées (SdMediaEntry) et les noms
+// begin parcourt le répertoire une fois : seuls les fichiers absents de l'index, ou dont la
+// taille ou la date a changé, sont ouverts et analysés, et l'index n'est réécrit que si la
+// liste a changé. La liste et les en-têtes sont ensuite servis depuis la RAM.
+class SdMediaLibrary {
+public:
+    static const uint16_t VERSION = 1;
+    static const uint32_t HEADER_BYTES = 20;
+
+    // Format des données (balise de format WAV, sauf pour un fichier de pistes)
+    static const uint16_t FORMAT_UNREADABLE = 0;   // en-tête illisible : listé, non jouable
+    static const uint16_t FORMAT_PCM = 1;
+    static const uint16_t FORMAT_IMA_ADPCM = 0x11;
+    static const uint16_t FORMAT_STEMS = 0x100;    // conteneur "STEM" (SdStemReader)
+    static const uint8_t FLAG_BFORMAT = 1;         // WAV B-format (ambisonie FuMa)
+
+    SdMediaLibrary();
+    ~SdMediaLibrary();
+
+    // Relit l'index, parcourt la racine de la carte et met l'index à jour au besoin. false si
+    // la mémoire manque (liste tronquée) ; un index absent ou illisible est reconstruit.
+    bool begin(const char* indexFile);
+
+    int count() const { return (int)entryCount; }
+    const SdMediaEntry& entry(int index) const { return entries[index]; }
+    const char* name(int index) const { return names + entries[index].nameOffset; }
+    uint32_t lengthMillis(int index) const;
+    // Mono ou stéréo PCM : lu par MyStreamPlayer (et enchaînable sans blanc)
+    bool isStreamable(int index) const {
+        return entries[index].format == FORMAT_PCM && entries[index].channels <= 2;
+    }
+
+    // Dernier begin : fichiers analysés (nouveaux ou modifiés), retirés de l'index, index
+    // réécrit, durée totale
+    uint32_t getParsedCount() const { return parsedCount; }
+    uint32_t getRemovedCount() const { return removedCount; }
+    bool wasRewritten() const { return rewritten; }
+    uint32_t getScanMillis() const { return scanMillis; }
+
+    // Fichier lu par la bibliothèque (.wav ou .stm)
+    static bool isMediaFile(const char* filename);
+
+private:
+    SdMediaLibrary(const SdMediaLibrary&);
+    SdMediaLibrary& operator=(const SdMediaLibrary&);
+
+    bool loadIndex(const char* indexFile);
+    bool saveIndex(const char* indexFile) const;
+    bool append(const char* filename, const SdMediaEntry& e);
+    static void parseFile(const char* filename, SdMediaEntry& e);
+    void release();
+
+    SdMediaEntry* entries;
+    char* names;
+    uint32_t entryCount;
+    uint32_t entryCapacity;
+    uint32_t nameBytes;
+    uint32_t nameCapacity;
+    uint32_t parsedCount;
+    uint32_t removedCount;
+    bool rewritten;
+    uint32_t scanMillis;
+};
+
+#endif
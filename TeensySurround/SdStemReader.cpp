@@ -0,0 +1,98 @@
+#include "SdStemReader.h"
+#include <string.h>
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+SdStemReader::SdStemReader()
+: opened(false), stemCount(0), rate(0), frameCount(0), blockSize(0), dataStart(0),
+  blockIndex(0), sliceIndex(0)
+{
+    memset(stemInfo, 0, sizeof(stemInfo));
+}
+
+SdStemReader::~SdStemReader() {
+    close();
+}
+
+bool SdStemReader::open(const String& filename) {
+    close();
+    f = SD.open(filename.c_str(), FILE_READ);
+    if (!f) {
+        Serial.print("Impossible d'ouvrir le fichier ");
+        Serial.println(filename);
+        return false;
+    }
+    if (!parseHeader()) {
+        f.close();
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+void SdStemReader::close() {
+    if (f) {
+        f.close();
+    }
+    opened = false;
+    blockIndex = 0;
+    sliceIndex = 0;
+}
+
+bool SdStemReader::parseHeader() {
+    uint8_t header[HEADER_BYTES];
+    if (f.read(header, HEADER_BYTES) < (int)HEADER_BYTES || memcmp(header, "STEM", 4) != 0 ||
+        getU16(header + 4) != 1) {
+        return false;
+    }
+    stemCount = getU16(header + 6);
+    rate = getU32(header + 8);
+    frameCount = getU32(header + 12);
+    blockSize = getU32(header + 16);
+    const uint32_t dataOffset = getU32(header + 20);
+    if (stemCount < 1 || stemCount > MAX_STEMS || rate == 0 ||
+        blockSize < MIN_BLOCK_FRAMES || (blockSize & (blockSize - 1)) != 0 ||
+        dataOffset < HEADER_BYTES + stemCount * STEM_ENTRY_BYTES) {
+        return false;
+    }
+
+    for (int s = 0; s < stemCount; s++) {
+        uint8_t entry[STEM_ENTRY_BYTES];
+        if (f.read(entry, STEM_ENTRY_BYTES) < (int)STEM_ENTRY_BYTES) {
+            return false;
+        }
+        StemInfo& info = stemInfo[s];
+        info.azimuth = (int16_t)getU16(entry);
+        info.elevation = (int16_t)getU16(entry + 2);
+        const uint32_t gainBits = getU32(entry + 4);
+        memcpy(&info.gain, &gainBits, sizeof(float));
+        memcpy(info.name, entry + 8, NAME_BYTES);
+        info.name[NAME_BYTES] = '\0';
+    }
+    blockIndex = 0;
+    sliceIndex = 0;
+    dataStart = dataOffset;
+    return f.seek(dataOffset);
+}
+
+bool SdStemReader::readSlice(int16_t* dest) {
+    if (!opened || atEnd()) {
+        return false;
+    }
+    const int bytes = (int)(blockSize * sizeof(int16_t));
+    if (f.read(dest, bytes) < bytes) {
+        frameCount = positionFrames();  // fichier tronqué : fin au dernier bloc complet
+        return false;
+    }
+    if (++sliceIndex == stemCount) {
+        sliceIndex = 0;
+        blockIndex++;
+    }
+    return true;
+}
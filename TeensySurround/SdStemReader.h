@@ -0,0 +1,78 @@
+#ifndef SD_STEM_READER_H
+#define SD_STEM_READER_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+// Lecture séquentielle d'un fichier de pistes séparées "STEM" (.stm, écrit par
+// assets/makeStems.py) : N pistes mono PCM 16 bits entrelacées par grands blocs, pour jouer
+// plusieurs sources d'un même morceau (voix, batterie, basse...) d'une seule lecture continue
+// au lieu d'un fichier par source. En-tête (petit-boutiste) :
+//   "STEM", uint16 version (1), uint16 stemCount, uint32 sampleRate, uint32 frameCount,
+//   uint32 blockFrames, uint32 dataOffset,
+//   puis par piste : int16 azimut, int16 élévation (degrés), float gain, char nom[16]
+// Les données commencent à dataOffset (multiple de 512) : blocs successifs de blockFrames
+// trames, chacun formé des tranches de blockFrames échantillons des pistes 0 à N-1. Le dernier
+// bloc est complété par des zéros ; blockFrames est une puissance de 2 d'au moins 256
+// (tranches faites de secteurs entiers).
+class SdStemReader {
+public:
+    static const int MAX_STEMS = 8;
+    static const int NAME_BYTES = 16;
+    static const uint32_t HEADER_BYTES = 24;
+    static const uint32_t STEM_ENTRY_BYTES = 8 + NAME_BYTES;
+    static const uint32_t MIN_BLOCK_FRAMES = 256;
+
+    SdStemReader();
+    ~SdStemReader();
+
+    bool open(const String& filename);
+    void close();
+    bool isOpen() const { return opened; }
+
+    int stems() const { return stemCount; }
+    uint32_t sampleRate() const { return rate; }
+    uint32_t lengthFrames() const { return frameCount; }
+    uint32_t blockFrames() const { return blockSize; }
+    // Octet du fichier où commencent les blocs
+    uint32_t dataOffset() const { return dataStart; }
+    // Position par défaut et gain de chaque piste, et son nom (terminé par un zéro)
+    int stemAzimuth(int stem) const { return stemInfo[stem].azimuth; }
+    int stemElevation(int stem) const { return stemInfo[stem].elevation; }
+    float stemGain(int stem) const { return stemInfo[stem].gain; }
+    const char* stemName(int stem) const { return stemInfo[stem].name; }
+
+    // Piste de la prochaine tranche et trames des blocs entièrement lus
+    int nextStem() const { return sliceIndex; }
+    uint32_t positionFrames() const { return blockIndex * blockSize; }
+    bool atEnd() const { return positionFrames() >= frameCount; }
+    // Lit la tranche suivante (blockFrames échantillons de la piste nextStem()) dans dest.
+    // Retourne false en fin de fichier ou si le fichier est tronqué.
+    bool readSlice(int16_t* dest);
+
+private:
+    SdStemReader(const SdStemReader&);
+    SdStemReader& operator=(const SdStemReader&);
+
+    bool parseHeader();
+
+    struct StemInfo {
+        int16_t azimuth;
+        int16_t elevation;
+        float gain;
+        char name[NAME_BYTES + 1];
+    };
+
+    File f;
+    bool opened;
+    int stemCount;
+    uint32_t rate;
+    uint32_t frameCount;
+    uint32_t blockSize;
+    uint32_t dataStart;
+    uint32_t blockIndex;    // bloc en cours de lecture
+    int sliceIndex;         // tranche suivante dans ce bloc
+    StemInfo stemInfo[MAX_STEMS];
+};
+
+#endif
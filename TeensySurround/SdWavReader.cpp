@@ -0,0 +1,238 @@
+#include "SdWavReader.h"
+#include <string.h>
+
+// Sous-formats de WAVE_FORMAT_EXTENSIBLE (GUID en ordre des octets du fichier)
+static const uint8_t GUID_PCM[16] = {
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+static const uint8_t GUID_BFORMAT_PCM[16] = {
+    0x01, 0x00, 0x00, 0x00, 0x21, 0x07, 0xD3, 0x11,
+    0x86, 0x44, 0xC8, 0xC1, 0xCA, 0x00, 0x00, 0x00
+};
+
+SdWavReader::SdWavReader()
+: opened(false), bformat(false), adpcm(false), fileChannels(0), mask(0),
+  rate(0), frameCount(0), frameIndex(0), dataStart(0), dataBytes(0), align(0), blockSamples(0),
+  blockCount(0), blockIndex(0)
+{
+}
+
+SdWavReader::~SdWavReader() {
+    close();
+}
+
+bool SdWavReader::readU16(uint16_t& val) {
+    byte tmp[2];
+    if (f.read(tmp, 2) < 2) {
+        return false;
+    }
+    val = (uint16_t)(tmp[0] | (tmp[1] << 8));
+    return true;
+}
+
+bool SdWavReader::readU32(uint32_t& val) {
+    byte tmp[4];
+    if (f.read(tmp, 4) < 4) {
+        return false;
+    }
+    val = (uint32_t)(tmp[0] | (tmp[1] << 8) | (tmp[2] << 16) | (tmp[3] << 24));
+    return true;
+}
+
+bool SdWavReader::open(const String& filename) {
+    close();
+    f = SD.open(filename.c_str(), FILE_READ);
+    if (!f) {
+        Serial.print("Impossible d'ouvrir le fichier ");
+        Serial.println(filename);
+        return false;
+    }
+    if (!parseHeader()) {
+        f.close();
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+void SdWavReader::close() {
+    if (f) {
+        f.close();
+    }
+    opened = false;
+    frameIndex = 0;
+    blockIndex = 0;
+}
+
+bool SdWavReader::parseHeader() {
+    char tag[4];
+    uint32_t size;
+    if (f.read(tag, 4) < 4 || strncmp(tag, "RIFF", 4) != 0 || !readU32(size) ||
+        f.read(tag, 4) < 4 || strncmp(tag, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    // Parcours des chunks jusqu'à "data" ; "fmt " doit le précéder
+    bool haveFormat = false;
+    uint32_t factFrames = 0;
+    while (f.read(tag, 4) == 4 && readU32(size)) {
+        if (strncmp(tag, "fmt ", 4) == 0) {
+            uint16_t format, channelCount, blockAlign, bits;
+            uint32_t byteRate;
+            if (size < 16 || !readU16(format) || !readU16(channelCount) || !readU32(rate) ||
+                !readU32(byteRate) || !readU16(blockAlign) || !readU16(bits)) {
+                return false;
+            }
+            uint32_t consumed = 16;
+            bformat = false;
+            adpcm = false;
+            mask = 0;
+            if (format == 0x11) {
+                // IMA-ADPCM : 4 bits, mono ou stéréo ; échantillons par bloc dans l'extension
+                uint16_t extSize, samples;
+                if (bits != 4 || channelCount > ImaAdpcmDecoder::MAX_CHANNELS || size < 20 ||
+                    !readU16(extSize) || !readU16(samples) ||
+                    samples != ImaAdpcmDecoder::samplesPerBlock(channelCount, blockAlign)) {
+                    return false;
+                }
+                consumed = 20;
+                adpcm = true;
+                align = blockAlign;
+                blockSamples = samples;
+            } else if (format == 0xFFFE && size >= 40) {
+                uint16_t extSize, validBits;
+                uint8_t guid[16];
+                if (!readU16(extSize) || !readU16(validBits) || !readU32(mask) ||
+                    f.read(guid, 16) < 16) {
+                    return false;
+                }
+                consumed = 40;
+                if (memcmp(guid, GUID_BFORMAT_PCM, 16) == 0) {
+                    bformat = true;
+                } else if (memcmp(guid, GUID_PCM, 16) != 0) {
+                    return false;
+                }
+            } else if (format != 1) {
+                return false;
+            }
+            if (bits != 16 && !adpcm) {
+                return false;
+            }
+            if (channelCount == 0 || channelCount > MAX_CHANNELS) {
+                return false;
+            }
+            fileChannels = channelCount;
+            haveFormat = true;
+            if (size > consumed) {
+                f.seek(f.position() + (size - consumed) + (size & 1));
+            }
+        } else if (strncmp(tag, "data", 4) == 0) {
+            if (!haveFormat) {
+                return false;
+            }
+            frameCount = size / (2 * fileChannels);
+            if (adpcm) {
+                // Dernier bloc éventuellement incomplet ; longueur exacte donnée par "fact"
+                blockCount = (size + align - 1) / align;
+                const uint32_t whole = size / align;
+                const uint32_t rest = size - whole * align;
+                frameCount = whole * blockSamples +
+                             ImaAdpcmDecoder::samplesPerBlock(fileChannels, rest);
+                if (factFrames > 0 && factFrames < frameCount) {
+                    frameCount = factFrames;
+                }
+                dataBytes = size;
+            }
+            frameIndex = 0;
+            blockIndex = 0;
+            dataStart = f.position();
+            return true;
+        } else if (strncmp(tag, "fact", 4) == 0 && size >= 4) {
+            if (!readU32(factFrames)) {
+                return false;
+            }
+            f.seek(f.position() + (size - 4) + (size & 1));
+        } else {
+            // Chunks ignorés (LIST, bext...), alignés sur 2 octets
+            f.seek(f.position() + size + (size & 1));
+        }
+    }
+    return false;
+}
+
+int SdWavReader::read(float* const* out, int outChannels, int count) {
+    if (!opened || adpcm) {
+        return 0;
+    }
+    const int C = fileChannels;
+    const float norm = 1.0f / 32768.0f;
+    int done = 0;
+    while (done < count && frameIndex < frameCount) {
+        int frames = count - done;
+        if (frames > CHUNK_FRAMES) {
+            frames = CHUNK_FRAMES;
+        }
+        if ((uint32_t)frames > frameCount - frameIndex) {
+            frames = (int)(frameCount - frameIndex);
+        }
+        int got = f.read(chunk, frames * C * sizeof(int16_t));
+        frames = (got > 0) ? got / (C * (int)sizeof(int16_t)) : 0;
+        if (frames == 0) {
+            frameCount = frameIndex;  // fichier tronqué : fin de lecture
+            break;
+        }
+        for (int c = 0; c < outChannels && c < C; c++) {
+            if (!out[c]) {
+                continue;
+            }
+            float* dst = out[c] + done;
+            for (int n = 0; n < frames; n++) {
+                dst[n] = chunk[n * C + c] * norm;
+            }
+        }
+        done += frames;
+        frameIndex += frames;
+    }
+    return done;
+}
+
+int SdWavReader::readFrames(int16_t* dest, int count) {
+    if (!opened || adpcm) {
+        return 0;
+    }
+    const int frameBytes = 2 * fileChannels;
+    if ((uint32_t)count > frameCount - frameIndex) {
+        count = (int)(frameCount - frameIndex);
+    }
+    const int got = (count > 0) ? f.read(dest, count * frameBytes) : 0;
+    const int frames = (got > 0) ? got / frameBytes : 0;
+    if (frames < count) {
+        frameCount = frameIndex + frames;  // fichier tronqué : fin de lecture
+    }
+    frameIndex += frames;
+    return frames;
+}
+
+int SdWavReader::readBlocks(uint8_t* dest, int count) {
+    if (!opened || !adpcm) {
+        return 0;
+    }
+    if ((uint32_t)count > blockCount - blockIndex) {
+        count = (int)(blockCount - blockIndex);
+    }
+    const uint32_t offset = blockIndex * align;
+    const uint32_t bytes = (count * align < dataBytes - offset) ? count * align : dataBytes - offset;
+    const int got = (count > 0) ? f.read(dest, bytes) : 0;
+    if (got < (int)bytes) {
+        // Fichier tronqué : fin au dernier bloc complet
+        count = (got > 0) ? got / (int)align : 0;
+        blockCount = blockIndex + count;
+        frameCount = (blockCount * blockSamples < frameCount) ? blockCount * blockSamples : frameCount;
+    } else if (bytes < count * align) {
+        memset(dest + bytes, 0, count * align - bytes);   // dernier bloc incomplet
+    }
+    blockIndex += count;
+    frameIndex = (blockIndex * blockSamples < frameCount) ? blockIndex * blockSamples : frameCount;
+    return count;
+}
@@ -0,0 +1,82 @@
+#ifndef SD_WAV_READER_H
+#define SD_WAV_READER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "ImaAdpcm.h"
+
+// Lecture séquentielle d'un fichier WAV sur la carte SD (PCM 16 bits, jusqu'à MAX_CHANNELS
+// canaux) : fichiers multicanaux des lecteurs ambisonique et surround, mono et stéréo de
+// MyStreamPlayer (readFrames). Les fichiers IMA-ADPCM mono ou stéréo (isAdpcm) ne sont lus que
+// par blocs compressés (readBlocks, pour MyAdpcmPlayer) : read et readFrames n'en lisent rien.
+// WAVE_FORMAT_EXTENSIBLE est reconnu avec le sous-format PCM (masque de canaux) ou
+// B-format (ambisonie FuMa) ; l'interprétation des canaux est laissée au nœud de rendu.
+class SdWavReader {
+public:
+    static const int MAX_CHANNELS = 16;
+
+    SdWavReader();
+    ~SdWavReader();
+
+    bool open(const String& filename);
+    void close();
+    bool isOpen() const { return opened; }
+
+    int channels() const { return fileChannels; }
+    uint32_t sampleRate() const { return rate; }
+    // Masque de canaux WAVE_FORMAT_EXTENSIBLE (0 si absent)
+    uint32_t channelMask() const { return mask; }
+    // Sous-format B-format : ambisonie FuMa (W X Y Z...)
+    bool isBFormat() const { return bformat; }
+    // IMA-ADPCM : octets et trames par bloc (le dernier bloc peut être plus court)
+    bool isAdpcm() const { return adpcm; }
+    uint32_t blockAlign() const { return align; }
+    uint32_t samplesPerBlock() const { return blockSamples; }
+    uint32_t lengthFrames() const { return frameCount; }
+    uint32_t positionFrames() const { return frameIndex; }
+    // Octet du fichier où commence le chunk "data"
+    uint32_t dataOffset() const { return dataStart; }
+
+    // Lit au plus count trames : le canal c du fichier est converti en float dans out[c]
+    // pour c < outChannels (out[c] nul : canal ignoré). Retourne le nombre de trames lues.
+    int read(float* const* out, int outChannels, int count);
+    // Lit au plus count trames telles qu'elles sont dans le fichier (int16 entrelacés), sans
+    // conversion. Retourne le nombre de trames lues.
+    int readFrames(int16_t* dest, int count);
+    // Octet du fichier où commence la trame suivante (lectures alignées sur les secteurs)
+    uint32_t bytePosition() const {
+        return dataStart + (adpcm ? blockIndex * align : frameIndex * 2 * fileChannels);
+    }
+    // IMA-ADPCM : lit au plus count blocs de blockAlign octets (le dernier complété par des
+    // zéros). Retourne le nombre de blocs lus.
+    int readBlocks(uint8_t* dest, int count);
+
+private:
+    SdWavReader(const SdWavReader&);
+    SdWavReader& operator=(const SdWavReader&);
+
+    bool parseHeader();
+    bool readU16(uint16_t& val);
+    bool readU32(uint32_t& val);
+
+    static const int CHUNK_FRAMES = 32;
+
+    File f;
+    bool opened;
+    bool bformat;
+    bool adpcm;
+    int fileChannels;
+    uint32_t mask;
+    uint32_t rate;
+    uint32_t frameCount;
+    uint32_t frameIndex;
+    uint32_t dataStart;     // octet du début du chunk "data"
+    uint32_t dataBytes;
+    uint32_t align;         // IMA-ADPCM : octets par bloc
+    uint32_t blockSamples;
+    uint32_t blockCount;
+    uint32_t blockIndex;    // bloc suivant
+    int16_t chunk[CHUNK_FRAMES * MAX_CHANNELS];
+};
+
+#endif
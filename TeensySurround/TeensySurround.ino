@@ -1,30 +1,61 @@
 #include <Arduino.h>
 #include <Audio.h>
 #include "MyDsp.h"
+#include "MyAmbisonicMixer.h"
+#include "MySurroundPlayer.h"
+#include "MyStreamPlayer.h"
+#include "MyAdpcmPlayer.h"
+#include "MyStemPlayer.h"
+#include "MySpatialMixer.h"
+#include "SdMediaLibrary.h"
+#include "HrtfBenchmark.h"
 #include <SPI.h>
 #include <SD.h>
 
-#define MAX_FILES 50
-
-// Tableaux et variables pour stocker la liste des fichiers WAV
-String wavFiles[MAX_FILES];
-int fileCount = 0;
+// Fichiers WAV (et de pistes séparées .stm) de la carte SD, en-têtes compris (index sur la carte)
+SdMediaLibrary library;
 int currentFileIndex = 0;
 bool paused = false;  // Indique si la lecture est "en pause" (simulation par mise en sourdine)
 
 // Déclaration des objets audio
-AudioPlaySdWav playWav1;         // Lecteur de fichiers WAV sur SD
-AudioMixer4 mixer;               // Mixeur pour combiner les deux canaux en mono
+MyStreamPlayer playWav1;         // Lecteur de fichiers WAV sur SD, lus d'avance depuis loop()
+MyAdpcmPlayer adpcmPlayer;       // Lecteur de WAV IMA-ADPCM, décodés sur l'interruption audio
+AudioMixer4 mixer;               // Mixeur pour combiner en mono les canaux des deux lecteurs
 AudioOutputI2S audioOutput;       // Sortie audio I2S (utilisée avec l'Audio Shield)
-MyDsp myDsp;                     // Notre classe de traitement HRTF
+HrtfBank hrtfBank;               // HRIR partagées par les deux moteurs de rendu
+MyDsp myDsp(&hrtfBank);          // Notre classe de traitement HRTF
+MyAmbisonicMixer ambiPlayer(0, 1, &hrtfBank);  // Lecteur de fichiers ambisoniques (ordre 1)
+MySurroundPlayer surroundPlayer(&hrtfBank);    // Lecteur de fichiers 5.1/7.1 (surround virtuel)
+MyStemPlayer stemPlayer;         // Lecteur de pistes séparées (.stm), une piste par sortie
+MySpatialMixer stemMixer(MyStemPlayer::MAX_STEMS, &hrtfBank);  // Place chaque piste
+AudioMixer4 outMixL;             // Somme des deux moteurs, canal gauche
+AudioMixer4 outMixR;             // Somme des deux moteurs, canal droit
 AudioControlSGTL5000 audioShield;
 
 // Connexions audio
 AudioConnection patchCord1(playWav1, 0, mixer, 0);
 AudioConnection patchCord2(playWav1, 1, mixer, 1);
+AudioConnection patchCord22(adpcmPlayer, 0, mixer, 2);
+AudioConnection patchCord23(adpcmPlayer, 1, mixer, 3);
 AudioConnection patchCord3(mixer, 0, myDsp, 0);
-AudioConnection patchCord4(myDsp, 0, audioOutput, 0);
-AudioConnection patchCord5(myDsp, 1, audioOutput, 1);
+AudioConnection patchCord4(myDsp, 0, outMixL, 0);
+AudioConnection patchCord5(myDsp, 1, outMixR, 0);
+AudioConnection patchCord6(ambiPlayer, 0, outMixL, 1);
+AudioConnection patchCord7(ambiPlayer, 1, outMixR, 1);
+AudioConnection patchCord8(surroundPlayer, 0, outMixL, 2);
+AudioConnection patchCord9(surroundPlayer, 1, outMixR, 2);
+AudioConnection patchCord10(outMixL, 0, audioOutput, 0);
+AudioConnection patchCord11(outMixR, 0, audioOutput, 1);
+AudioConnection patchCord12(stemPlayer, 0, stemMixer, 0);
+AudioConnection patchCord13(stemPlayer, 1, stemMixer, 1);
+AudioConnection patchCord14(stemPlayer, 2, stemMixer, 2);
+AudioConnection patchCord15(stemPlayer, 3, stemMixer, 3);
+AudioConnection patchCord16(stemPlayer, 4, stemMixer, 4);
+AudioConnection patchCord17(stemPlayer, 5, stemMixer, 5);
+AudioConnection patchCord18(stemPlayer, 6, stemMixer, 6);
+AudioConnection patchCord19(stemPlayer, 7, stemMixer, 7);
+AudioConnection patchCord20(stemMixer, 0, outMixL, 3);
+AudioConnection patchCord21(stemMixer, 1, outMixR, 3);
 
 // Variables pour le contrôle de l'angle via le port série
 volatile bool manualMode = false;     // false = mode auto, true = mode manuel
@@ -32,45 +63,76 @@ String serialCommand = "";
 
 // --- Fonctions utilitaires ---
 
-// Parcourt la racine de la carte SD et stocke tous les fichiers .wav dans wavFiles[]
-void loadWavFileList() {
-  fileCount = 0;
-  File root = SD.open("/");
-  while (true) {
-    File entry = root.openNextFile();
-    if (!entry) break; // Plus de fichiers
-    if (!entry.isDirectory()) {
-      String fname = entry.name();
-      if (fname.endsWith(".wav") || fname.endsWith(".WAV")) {
-        if (fileCount < MAX_FILES) {
-          wavFiles[fileCount] = fname;
-          fileCount++;
-        }
+// Lance la lecture d'un fichier de la bibliothèque selon son en-tête (déjà dans l'index) : WAV
+// ambisoniques (4, 9 ou 16 canaux) vers le décodeur binaural, 5.1/7.1 vers le surround virtuel,
+// mono/stéréo vers MyStreamPlayer et MyDsp (IMA-ADPCM vers son décodeur, puis MyDsp), pistes
+// séparées (.stm) vers le mélangeur spatial, chacune à sa position par défaut
+bool playTrack(int index) {
+  playWav1.stop();
+  ambiPlayer.stop();
+  surroundPlayer.stop();
+  stemPlayer.stop();
+  adpcmPlayer.stop();
+  const SdMediaEntry& entry = library.entry(index);
+  const char* name = library.name(index);
+  if (entry.format == SdMediaLibrary::FORMAT_STEMS) {
+    if (!stemPlayer.play(name)) {
+      return false;
+    }
+    for (int s = 0; s < MyStemPlayer::MAX_STEMS; s++) {
+      if (s < stemPlayer.stems()) {
+        stemMixer.setSource(s, stemPlayer.stemAzimuth(s), stemPlayer.stemElevation(s),
+                            stemPlayer.stemGain(s));
+      } else {
+        stemMixer.setSource(s, 0, 0, 0.0f);
       }
     }
-    entry.close();
+    return true;
+  }
+  const bool bformat = (entry.flags & SdMediaLibrary::FLAG_BFORMAT) != 0;
+  if (entry.format == SdMediaLibrary::FORMAT_IMA_ADPCM) {
+    return adpcmPlayer.play(name);
+  }
+  if (MyAmbisonicMixer::fileOrder(entry.channels, bformat) > 0) {
+    return ambiPlayer.play(name);
   }
-  root.close();
+  if (MySurroundPlayer::canPlay(entry.channels, bformat)) {
+    return surroundPlayer.play(name);
+  }
+  return playWav1.play(name);
 }
 
-// Affiche la liste des fichiers sur le moniteur série
-void listFiles(File dir, int numTabs) {
-  while (true) {
-    File entry = dir.openNextFile();
-    if (!entry) break;
-    for (int i = 0; i < numTabs; i++) {
-      Serial.print("\t");
-    }
-    Serial.print(entry.name());
-    if (entry.isDirectory()) {
-      Serial.println("/");
-      listFiles(entry, numTabs + 1);
-    } else {
-      Serial.print("\t\t");
-      Serial.println(entry.size(), DEC);
+// Bancs d'essai qui mesurent la banque de HRIR du moteur flottant (MyDsp::getBank)
+bool benchUsesBank(const String& bench) {
+  static const char* const names[] = { "SWITCH", "MIXER", "AMBI", "INTERP", "COMPACT", "PCA",
+                                       "LOAD", "SYM", "LAYOUT" };
+  for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (bench.equalsIgnoreCase(names[i])) {
+      return true;
     }
-    entry.close();
   }
+  return false;
+}
+
+bool trackPlaying() {
+  return playWav1.isPlaying() || ambiPlayer.isPlaying() || surroundPlayer.isPlaying() ||
+         stemPlayer.isPlaying() || adpcmPlayer.isPlaying();
+}
+
+unsigned long trackPositionMillis() {
+  if (ambiPlayer.isPlaying()) return ambiPlayer.positionMillis();
+  if (surroundPlayer.isPlaying()) return surroundPlayer.positionMillis();
+  if (stemPlayer.isPlaying()) return stemPlayer.positionMillis();
+  if (adpcmPlayer.isPlaying()) return adpcmPlayer.positionMillis();
+  return playWav1.positionMillis();
+}
+
+unsigned long trackLengthMillis() {
+  if (ambiPlayer.isPlaying()) return ambiPlayer.lengthMillis();
+  if (surroundPlayer.isPlaying()) return surroundPlayer.lengthMillis();
+  if (stemPlayer.isPlaying()) return stemPlayer.lengthMillis();
+  if (adpcmPlayer.isPlaying()) return adpcmPlayer.lengthMillis();
+  return playWav1.lengthMillis();
 }
 
 // --- Traitement des commandes série ---
@@ -108,38 +170,216 @@ void processSerialCommand(String cmd) {
     Serial.print("GET_ANGLE:");
     Serial.println(currentAngle);
   }
+  else if (cmd.startsWith("CONV:")) {
+    String conv = cmd.substring(5);  // "CONV:" fait 5 caractères
+    conv.trim();
+    if (conv.equalsIgnoreCase("FFT")) {
+      myDsp.setConvolutionMode(HRTF_CONV_FFT);
+      ambiPlayer.setConvolutionMode(HRTF_CONV_FFT);
+      surroundPlayer.setConvolutionMode(HRTF_CONV_FFT);
+      stemMixer.setConvolutionMode(HRTF_CONV_FFT);
+    } else if (conv.equalsIgnoreCase("DIRECT")) {
+      myDsp.setConvolutionMode(HRTF_CONV_DIRECT);
+      ambiPlayer.setConvolutionMode(HRTF_CONV_DIRECT);
+      surroundPlayer.setConvolutionMode(HRTF_CONV_DIRECT);
+      stemMixer.setConvolutionMode(HRTF_CONV_DIRECT);
+    } else {
+      Serial.println("Convolution inconnue");
+      return;
+    }
+    Serial.print("CONV:");
+    Serial.println(myDsp.getConvolutionMode() == HRTF_CONV_FFT ? "FFT" : "DIRECT");
+  }
+  else if (cmd.startsWith("SWITCH:")) {
+    String sw = cmd.substring(7);  // "SWITCH:" fait 7 caractères
+    sw.trim();
+    if (sw.equalsIgnoreCase("XFADE")) {
+      myDsp.setSwitchMode(HRTF_SWITCH_CROSSFADE);
+    } else if (sw.equalsIgnoreCase("HARD")) {
+      myDsp.setSwitchMode(HRTF_SWITCH_HARD);
+    } else {
+      Serial.println("Commutation inconnue");
+      return;
+    }
+    Serial.print("SWITCH:");
+    Serial.println(myDsp.getSwitchMode() == HRTF_SWITCH_CROSSFADE ? "XFADE" : "HARD");
+  }
+  else if (cmd.startsWith("INTERP:")) {
+    String interp = cmd.substring(7);  // "INTERP:" fait 7 caractères
+    interp.trim();
+    if (interp.equalsIgnoreCase("ON")) {
+      myDsp.setInterpolation(true);
+    } else if (interp.equalsIgnoreCase("OFF")) {
+      myDsp.setInterpolation(false);
+    } else {
+      Serial.println("Interpolation inconnue");
+      return;
+    }
+    Serial.print("INTERP:");
+    Serial.println(myDsp.getInterpolation() ? "ON" : "OFF");
+  }
+  else if (cmd.startsWith("KERNEL:")) {
+    String name = cmd.substring(7);  // "KERNEL:" fait 7 caractères
+    name.trim();
+    AudioNoInterrupts();
+    bool ok = hrtfSelectKernels(name.c_str());
+    AudioInterrupts();
+    if (!ok) {
+      Serial.println("Noyau inconnu");
+      return;
+    }
+    Serial.print("KERNEL:");
+    Serial.println(hrtfKernels().name);
+  }
+  else if (cmd.startsWith("BENCH:")) {
+    String bench = cmd.substring(6);  // "BENCH:" fait 6 caractères
+    bench.trim();
+    // Bancs d'essai du moteur flottant : sur la banque de HRIR en service, absente en virgule fixe
+    const HrtfBank* bank = myDsp.getBank();
+    if (!bank && benchUsesBank(bench)) {
+      Serial.print("BENCH:");
+      Serial.print(bench);
+      Serial.println(" indisponible en virgule fixe");
+    } else if (bench.equalsIgnoreCase("KERNELS")) {
+      hrtfBenchmarkKernels(Serial);
+    } else if (bench.equalsIgnoreCase("SWITCH")) {
+      hrtfBenchmarkSwitching(*bank, Serial);
+    } else if (bench.equalsIgnoreCase("MIXER")) {
+      hrtfBenchmarkMixer(*bank, Serial);
+    } else if (bench.equalsIgnoreCase("AMBI")) {
+      hrtfBenchmarkAmbisonics(*bank, Serial);
+    } else if (bench.equalsIgnoreCase("INTERP")) {
+      hrtfBenchmarkInterpolation(*bank, Serial);
+    } else if (bench.equalsIgnoreCase("COMPACT")) {
+      hrtfBenchmarkCompact(*bank, "/hrtf_nh2.bin", Serial);
+    } else if (bench.equalsIgnoreCase("PCA")) {
+      hrtfBenchmarkPca(*bank, "/hrtf_nh2_pca.bin", "/hrtf_nh2.bin", Serial);
+    } else if (bench.equalsIgnoreCase("LOAD")) {
+      hrtfBenchmarkLoad(*bank, "/hrtf_elev0.bin", "/hrtf_elev0_v2.bin", Serial);
+    } else if (bench.equalsIgnoreCase("SYM")) {
+      hrtfBenchmarkSymmetric(*bank, "/hrtf_nh2.bin", Serial);
+    } else if (bench.equalsIgnoreCase("LAYOUT")) {
+      hrtfBenchmarkLayout(*bank, Serial);
+    } else if (bench.equalsIgnoreCase("STEMS")) {
+      hrtfBenchmarkStems(Serial);
+    } else if (bench.equalsIgnoreCase("ADPCM")) {
+      hrtfBenchmarkAdpcm(Serial);
+    } else if (bench.equalsIgnoreCase("SRC")) {
+      hrtfBenchmarkResampler(Serial);
+    } else if (bench.equalsIgnoreCase("LIBRARY")) {
+      hrtfBenchmarkLibrary(Serial);
+    } else {
+      Serial.println("Banc d'essai inconnu");
+    }
+  }
+  else if (cmd.equalsIgnoreCase("GET_CACHE")) {
+    // Banque à la demande en service (celle d'un sujet publié par SUBJECT: compris) : trouvées,
+    // absentes (remplacées), lues sur la carte, résidentes/places
+    const HrtfBank* bank = myDsp.getBank();
+    if (!bank) {
+      Serial.println("CACHE: indisponible en virgule fixe");
+      return;
+    }
+    Serial.print("CACHE:");
+    Serial.print(bank->getCacheHits());
+    Serial.print(",");
+    Serial.print(bank->getCacheMisses());
+    Serial.print(",");
+    Serial.print(bank->getCacheLoads());
+    Serial.print(",");
+    Serial.print(bank->getCacheResident());
+    Serial.print("/");
+    Serial.println(bank->getCacheSize());
+  }
+  else if (cmd.startsWith("SUBJECT:")) {
+    // Sujet chargé en arrière-plan depuis loop(), puis publié sans coupure (GET_SUBJECT)
+    String file = cmd.substring(8);  // "SUBJECT:" fait 8 caractères
+    if (!myDsp.loadSubject(file)) {
+      Serial.print("Erreur: changement de sujet impossible ");
+      Serial.println(file);
+    } else {
+      myDsp.printSubject(Serial);
+    }
+  }
+  else if (cmd.equalsIgnoreCase("GET_SUBJECT")) {
+    myDsp.printSubject(Serial);
+  }
+  else if (cmd.equalsIgnoreCase("GET_STREAM")) {
+    // Lecteur WAV : trames d'avance/capacité, minimum depuis la dernière demande, blocs
+    // incomplets, lectures sur la carte
+    Serial.print("STREAM:");
+    Serial.print(playWav1.getBufferFill());
+    Serial.print("/");
+    Serial.print(playWav1.getBufferCapacity());
+    Serial.print(",");
+    Serial.print(playWav1.getMinFill());
+    Serial.print(",");
+    Serial.print(playWav1.getUnderruns());
+    Serial.print(",");
+    Serial.println(playWav1.getCardReads());
+    playWav1.resetStats();
+    // Lecteur de pistes séparées, mêmes champs (trames par piste)
+    Serial.print("STEMS:");
+    Serial.print(stemPlayer.getBufferFill());
+    Serial.print("/");
+    Serial.print(stemPlayer.getBufferCapacity());
+    Serial.print(",");
+    Serial.print(stemPlayer.getMinFill());
+    Serial.print(",");
+    Serial.print(stemPlayer.getUnderruns());
+    Serial.print(",");
+    Serial.println(stemPlayer.getCardReads());
+    stemPlayer.resetStats();
+    // Lecteur IMA-ADPCM, mêmes champs puis octets lus sur la carte par seconde d'audio rendue
+    Serial.print("ADPCM:");
+    Serial.print(adpcmPlayer.getBufferFill());
+    Serial.print("/");
+    Serial.print(adpcmPlayer.getBufferCapacity());
+    Serial.print(",");
+    Serial.print(adpcmPlayer.getMinFill());
+    Serial.print(",");
+    Serial.print(adpcmPlayer.getUnderruns());
+    Serial.print(",");
+    Serial.print(adpcmPlayer.getCardReads());
+    Serial.print(",");
+    const uint32_t rendered = adpcmPlayer.getRenderedFrames();
+    Serial.println(rendered > 0
+                   ? (uint32_t)((uint64_t)adpcmPlayer.getCardBytes() * adpcmPlayer.getSampleRate() / rendered)
+                   : 0);
+    adpcmPlayer.resetStats();
+  }
   else if (cmd.equalsIgnoreCase("PREV")) {
-    if (fileCount > 0) {
-      currentFileIndex = (currentFileIndex - 1 + fileCount) % fileCount;
-      if (!playWav1.play(wavFiles[currentFileIndex].c_str())) {
+    if (library.count() > 0) {
+      currentFileIndex = (currentFileIndex - 1 + library.count()) % library.count();
+      if (!playTrack(currentFileIndex)) {
         Serial.print("Erreur: impossible de lire le fichier ");
-        Serial.println(wavFiles[currentFileIndex]);
+        Serial.println(library.name(currentFileIndex));
       } else {
         Serial.print("TRACK:");
-        Serial.println(wavFiles[currentFileIndex]);
+        Serial.println(library.name(currentFileIndex));
         paused = false;
       }
     }
   }
   else if (cmd.equalsIgnoreCase("NEXT")) {
-    if (fileCount > 0) {
-      currentFileIndex = (currentFileIndex + 1) % fileCount;
-      if (!playWav1.play(wavFiles[currentFileIndex].c_str())) {
+    if (library.count() > 0) {
+      currentFileIndex = (currentFileIndex + 1) % library.count();
+      if (!playTrack(currentFileIndex)) {
         Serial.print("Erreur: impossible de lire le fichier ");
-        Serial.println(wavFiles[currentFileIndex]);
+        Serial.println(library.name(currentFileIndex));
       } else {
         Serial.print("TRACK:");
-        Serial.println(wavFiles[currentFileIndex]);
+        Serial.println(library.name(currentFileIndex));
         paused = false;
       }
     }
   }
   else if (cmd.equalsIgnoreCase("PAUSE")) {
-    if (!paused && playWav1.isPlaying()) {
+    if (!paused && trackPlaying()) {
       audioShield.volume(0.0);  // Mise en sourdine
       paused = true;
       Serial.print("TRACK:");
-      Serial.print(wavFiles[currentFileIndex]);
+      Serial.print(library.name(currentFileIndex));
       Serial.println(" PAUSED");
     }
   }
@@ -148,7 +388,7 @@ void processSerialCommand(String cmd) {
       audioShield.volume(0.4);  // Restaurer le volume (valeur ajustable)
       paused = false;
       Serial.print("TRACK:");
-      Serial.println(wavFiles[currentFileIndex]);
+      Serial.println(library.name(currentFileIndex));
     }
   }
   else if (cmd.startsWith("VOLUME:")) {
@@ -163,24 +403,26 @@ void processSerialCommand(String cmd) {
     Serial.println(volPercent);
   }
   else if (cmd.equalsIgnoreCase("GET_FILELIST")) {
-    // Envoyer la liste des fichiers WAV
-    for (int i = 0; i < fileCount; i++) {
-        String entry = "FILE:" + String(i) + "|" + wavFiles[i];
-        Serial.println(entry);
+    // Envoyer la liste des fichiers WAV, depuis la bibliothèque (sans relire la carte)
+    for (int i = 0; i < library.count(); i++) {
+        Serial.print("FILE:");
+        Serial.print(i);
+        Serial.print("|");
+        Serial.println(library.name(i));
     }
     Serial.println("FILELIST_END");
   }
   else if (cmd.startsWith("PLAY_INDEX:")) {
     String idxStr = cmd.substring(11); // "PLAY_INDEX:" a 11 caractères
     int idx = idxStr.toInt();
-    if (idx >= 0 && idx < fileCount) {
+    if (idx >= 0 && idx < library.count()) {
         currentFileIndex = idx;
-        if (!playWav1.play(wavFiles[currentFileIndex].c_str())) {
+        if (!playTrack(currentFileIndex)) {
             Serial.print("Erreur: impossible de lire le fichier ");
-            Serial.println(wavFiles[currentFileIndex]);
+            Serial.println(library.name(currentFileIndex));
         } else {
             Serial.print("TRACK:");
-            Serial.println(wavFiles[currentFileIndex]);
+            Serial.println(library.name(currentFileIndex));
             paused = false;
         }
     }
@@ -211,55 +453,78 @@ void setup() {
     }
     delay(100);
   }
+  const uint32_t bootStart = millis();
 
-  AudioMemory(16);
+  AudioMemory(32);  // dont un bloc par piste du lecteur de pistes séparées
 
   audioShield.enable();
   audioShield.volume(0.4);
   Serial.print("Configuration audio - Sample Rate: ");
   Serial.println(AUDIO_SAMPLE_RATE_EXACT);
 
-  if (!SD.begin()) {
+  // Avec la banque compilée en flash, le rendu démarre même sans carte SD (aucun fichier WAV)
+  const bool sdReady = SD.begin();
+  if (!sdReady) {
     Serial.println("Erreur: impossible d'initialiser la carte SD !");
-    while (1) {
+    while (!hrtfFlashBank()) {
       Serial.println("Unable to access the SD card");
       delay(500);
     }
-  }
-  Serial.println("Carte SD initialisée avec succès.");
-
-  File root = SD.open("/");
-  listFiles(root, 0);
-  root.close();
+  } else {
+    Serial.println("Carte SD initialisée avec succès.");
 
-  loadWavFileList();
+    // Un seul parcours de la racine ; seuls les fichiers nouveaux ou modifiés sont analysés
+    library.begin(HRTF_LIBRARY_FILE);
+    Serial.print("Bibliothèque : ");
+    Serial.print(library.getScanMillis());
+    Serial.print(" ms (");
+    Serial.print(library.getParsedCount());
+    Serial.print(" fichiers analysés, ");
+    Serial.print(library.getRemovedCount());
+    Serial.print(" retirés, index ");
+    Serial.print(library.wasRewritten() ? "réécrit" : "à jour");
+    Serial.println(")");
+  }
   Serial.print("Nombre de fichiers WAV trouvés: ");
-  Serial.println(fileCount);
-  for (int i = 0; i < fileCount; i++) {
+  Serial.println(library.count());
+  for (int i = 0; i < library.count(); i++) {
     Serial.print(i);
     Serial.print(": ");
-    Serial.println(wavFiles[i]);
+    Serial.print(library.name(i));
+    Serial.print("\t");
+    Serial.print(library.entry(i).size);
+    Serial.print(" octets, ");
+    Serial.print(library.lengthMillis(i));
+    Serial.println(" ms");
   }
 
   mixer.gain(0, 0.5);
   mixer.gain(1, 0.5);
+  mixer.gain(2, 0.5);
+  mixer.gain(3, 0.5);
 
   myDsp.begin();
+  ambiPlayer.begin();
+  surroundPlayer.begin();
+  stemMixer.begin();
 
   // Démarrer la lecture du premier fichier WAV s'il y en a
-  if (fileCount > 0) {
+  if (library.count() > 0) {
     currentFileIndex = 0;
-    if (!playWav1.play(wavFiles[currentFileIndex].c_str())) {
+    if (!playTrack(currentFileIndex)) {
       Serial.print("Erreur: impossible de lire le fichier ");
-      Serial.println(wavFiles[currentFileIndex]);
+      Serial.println(library.name(currentFileIndex));
     } else {
       Serial.print("TRACK:");
-      Serial.println(wavFiles[currentFileIndex]);
+      Serial.println(library.name(currentFileIndex));
       paused = false;
     }
   } else {
     Serial.println("Aucun fichier WAV trouvé.");
   }
+  Serial.print("Démarrage : ");
+  Serial.print(millis() - bootStart);
+  Serial.println(" ms");
   delay(25);
 }
 
@@ -268,6 +533,34 @@ void loop() {
   static unsigned long lastProgressTime = 0;
   unsigned long currentTime = millis();
 
+  // La scène ambisonique suit l'angle du moteur HRTF (rotation du bus, sans recherche de HRIR)
+  ambiPlayer.setRotation(myDsp.getAngle());
+
+  // Banque à la demande : mesures manquées par l'audio et directions à venir
+  myDsp.prefetch();
+  // Changement de sujet en cours : une étape du chargement
+  myDsp.serviceSubject();
+
+  // Lecteur WAV : tampon rempli d'avance, et fichier suivant de la liste mis en attente pour
+  // être enchaîné sans blanc (un fichier multicanal, IMA-ADPCM ou de pistes est lancé à la fin
+  // du courant, plus bas)
+  static uint32_t trackSerial = 0;
+  playWav1.service();
+  stemPlayer.service();
+  adpcmPlayer.service();
+  if (playWav1.getTrackSerial() != trackSerial) {
+    trackSerial = playWav1.getTrackSerial();
+    if (library.count() > 0) {
+      currentFileIndex = (currentFileIndex + 1) % library.count();
+      Serial.print("TRACK:");
+      Serial.println(library.name(currentFileIndex));
+    }
+  }
+  if (playWav1.isPlaying() && !playWav1.hasQueued() && library.count() > 0 &&
+      library.isStreamable((currentFileIndex + 1) % library.count())) {
+    playWav1.queue(library.name((currentFileIndex + 1) % library.count()));
+  }
+
   // Traitement non bloquant des commandes série
   while (Serial.available()) {
     char c = Serial.read();
@@ -281,16 +574,16 @@ void loop() {
 
   // Vérifier l'état de la lecture toutes les secondes
   if (currentTime - lastStatusTime >= 1000) {
-    if (!paused && !playWav1.isPlaying()) {
+    if (!paused && !trackPlaying()) {
       Serial.println("Lecture terminée ou en pause. Passage au fichier suivant...");
-      if (fileCount > 0) {
-        currentFileIndex = (currentFileIndex + 1) % fileCount;
-        if (!playWav1.play(wavFiles[currentFileIndex].c_str())) {
+      if (library.count() > 0) {
+        currentFileIndex = (currentFileIndex + 1) % library.count();
+        if (!playTrack(currentFileIndex)) {
           Serial.print("Erreur: impossible de lire le fichier ");
-          Serial.println(wavFiles[currentFileIndex]);
+          Serial.println(library.name(currentFileIndex));
         } else {
           Serial.print("TRACK:");
-          Serial.println(wavFiles[currentFileIndex]);
+          Serial.println(library.name(currentFileIndex));
           paused = false;
         }
       }
@@ -299,9 +592,9 @@ void loop() {
   }
 
   // Envoyer la progression de la lecture toutes les 500 ms
-  if (!paused && playWav1.isPlaying() && (currentTime - lastProgressTime >= 500)) {
-    unsigned long pos = playWav1.positionMillis();
-    unsigned long len = playWav1.lengthMillis();
+  if (!paused && trackPlaying() && (currentTime - lastProgressTime >= 500)) {
+    unsigned long pos = trackPositionMillis();
+    unsigned long len = trackLengthMillis();
     if (len > 0) {
       int progress = (int)((pos * 100UL) / len);
       Serial.print("PROGRESS:");
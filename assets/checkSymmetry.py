@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# checkSymmetry.py
+
+import sys
+import numpy as np
+from extractPcaToBin import read_hrir_bin, onset
+from generateHrirHeader import read_sofa
+
+# Acceptance thresholds for the symmetric bank (95th percentile over all measurements)
+MAX_SPECTRAL_DB = 4.0   # log-spectral distance between left(az) and right(-az)
+MAX_ITD_US = 30.0       # |ITD(az) + ITD(-az)|
+MAX_ILD_DB = 2.0        # |ILD(az) + ILD(-az)|
+MAX_GRID_DEG = 1.0      # distance from the mirrored direction to the measurement used for it
+# Band of the spectral comparison (Hz) and FFT size
+BAND = (200.0, 16000.0)
+FFT_SIZE = 512
+WORST_SHOWN = 8
+
+def unit_vectors(positions):
+    az = np.radians(positions[:, 0])
+    el = np.radians(positions[:, 1])
+    return np.stack([np.cos(el) * np.cos(az), np.cos(el) * np.sin(az), np.sin(el)], axis=1)
+
+def main():
+    """
+    Measures how symmetric a subject is before it is used with the symmetric bank storage
+    (HrtfBank::setSymmetricStorage, HRTF_SYMMETRIC_BANK), which keeps only the left ear of each
+    direction and renders the right ear at azimuth a with the left ear measured at -a.
+
+    For every measurement, the mirror measurement is the nearest one to (-az, el), as in the
+    engine. The script compares the right ear with the mirror's left ear (log-spectral distance
+    in dB over BAND), and checks that the ITD and ILD change sign between the two directions.
+    It prints the statistics, the worst directions and a verdict; the exit status is 1 when
+    the subject is rejected.
+    """
+    input_file = sys.argv[1] if len(sys.argv) > 1 else "assets/hrtf_nh2.sofa"  # .sofa or "HRIR" .bin
+
+    if input_file.endswith(".sofa"):
+        sampleRate, positions, left, right = read_sofa(input_file, None)
+    else:
+        sampleRate, positions, left, right = read_hrir_bin(input_file)
+    M, N = left.shape
+    print(f"File: {input_file}\n"
+          f"Sample Rate: {sampleRate}\n"
+          f"Measurements: M={M}, HRIR Size={N}")
+
+    # Mirror of each measurement: nearest direction to (-az, el)
+    v = unit_vectors(positions)
+    mirrored = v * np.array([1.0, -1.0, 1.0])
+    dots = mirrored @ v.T
+    mirror = np.argmax(dots, axis=1)
+    grid = np.degrees(np.arccos(np.clip(dots[np.arange(M), mirror], -1.0, 1.0)))
+
+    # Right ear against the mirror's left ear, magnitude in dB over the band
+    freqs = np.fft.rfftfreq(FFT_SIZE, 1.0 / sampleRate)
+    band = (freqs >= BAND[0]) & (freqs <= min(BAND[1], sampleRate / 2))
+    eps = 1e-12
+    L = 20.0 * np.log10(np.abs(np.fft.rfft(left, FFT_SIZE, axis=1))[:, band] + eps)
+    R = 20.0 * np.log10(np.abs(np.fft.rfft(right, FFT_SIZE, axis=1))[:, band] + eps)
+    spectral = np.sqrt(np.mean((R - L[mirror]) ** 2, axis=1))
+
+    # ITD and ILD must change sign between a direction and its mirror
+    itd = np.array([onset(left[m]) - onset(right[m]) for m in range(M)]) / sampleRate * 1e6
+    ild = 10.0 * np.log10(((left ** 2).sum(axis=1) + eps) / ((right ** 2).sum(axis=1) + eps))
+    itdError = np.abs(itd + itd[mirror])
+    ildError = np.abs(ild + ild[mirror])
+
+    rows = [("spectral distance (dB)", spectral, MAX_SPECTRAL_DB),
+            ("ITD mismatch (us)", itdError, MAX_ITD_US),
+            ("ILD mismatch (dB)", ildError, MAX_ILD_DB),
+            ("mirror grid error (deg)", grid, MAX_GRID_DEG)]
+    print(f"{'':26s} {'median':>8s} {'p95':>8s} {'max':>8s} {'limit':>8s}")
+    accepted = True
+    for name, values, limit in rows:
+        p95 = np.percentile(values, 95)
+        ok = p95 <= limit
+        accepted = accepted and ok
+        print(f"{name:26s} {np.median(values):8.2f} {p95:8.2f} {values.max():8.2f} "
+              f"{limit:8.2f} {'ok' if ok else 'TOO HIGH'}")
+
+    print("Least symmetric directions (az, el, spectral dB, ITD us, ILD dB):")
+    for m in np.argsort(spectral)[::-1][:WORST_SHOWN]:
+        print(f"  {positions[m, 0]:7.1f} {positions[m, 1]:6.1f}  {spectral[m]:6.2f} "
+              f"{itdError[m]:7.1f} {ildError[m]:6.2f}")
+
+    if accepted:
+        print("Subject accepted for the symmetric bank (HRTF_SYMMETRIC_BANK).")
+    else:
+        print("Subject rejected: keep both ears (HRTF_SYMMETRIC_BANK 0).")
+    sys.exit(0 if accepted else 1)
+
+if __name__ == "__main__":
+    main()
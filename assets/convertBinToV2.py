@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# convertBinToV2.py
+
+import struct
+import zlib
+import numpy as np
+from extractPcaToBin import ENGINE_SAMPLE_RATE, read_hrir_bin, resample_hrirs, minimum_phase, onset
+
+# Longest head the engine convolves directly (MAX_HRIR_LENGTH in HrtfBank.h)
+MAX_HRIR_LENGTH = 128
+# Header: 12 uint32, then sectionCount x (tag, offset, bytes, crc32)
+HEADER_BYTES = 48
+SECTION_ENTRY_BYTES = 16
+ALIGN = 32
+
+def align(n):
+    return (n + ALIGN - 1) // ALIGN * ALIGN
+
+def spectra(left, right, block):
+    """
+    Same layout as HrtfBank::computeSpectrum: partitions of `block` taps, left + j*right,
+    zero padded to 2*block points, forward FFT without scaling (interleaved re/im floats).
+    """
+    N = 2 * block
+    P = (MAX_HRIR_LENGTH + block - 1) // block
+    out = np.zeros((left.shape[0], P, 2 * N), dtype=np.float32)
+    for p in range(P):
+        x = np.zeros((left.shape[0], N), dtype=np.complex128)
+        seg = slice(p * block, min((p + 1) * block, left.shape[1]))
+        n = seg.stop - seg.start
+        if n > 0:
+            x[:, :n] = left[:, seg] + 1j * right[:, seg]
+        X = np.fft.fft(x, axis=1)
+        out[:, p, 0::2] = X.real
+        out[:, p, 1::2] = X.imag
+    return out.reshape(left.shape[0], -1)
+
+def main():
+    """
+    Converts a binary "HRIR" file into the sectioned "HRB2" format loaded in bulk by the engine.
+
+    The taps are truncated to MAX_HRIR_LENGTH and normalised like HrirBinReader does (optionally
+    converted to minimum phase + fractional ITD like HrtfBank::setMinimumPhase), then written
+    interleaved left/right with a stride padded to 32 bytes. Each section starts on a 32 byte
+    boundary and carries a CRC-32; the spectra for a given block size can be stored as well so
+    that the bank does not compute them at load time.
+    """
+    input_bin = "assets/hrtf_elev0.bin"      # Input binary file ("HRIR" format)
+    output_bin = "assets/hrtf_elev0_v2.bin"  # Output binary file
+
+    # Sample rate of the written HRIRs (None: the input file's own, converted at load time)
+    TARGET_SAMPLE_RATE = ENGINE_SAMPLE_RATE
+    # Minimum phase length in taps (0: measured HRIRs)
+    MIN_PHASE_LEN = 0
+    # Block size of the precomputed spectra (0: none, computed by the engine)
+    SPECTRUM_BLOCK = 128
+
+    sampleRate, positions, left, right = read_hrir_bin(input_bin)
+    sampleRate, left, right = resample_hrirs(sampleRate, left, right, TARGET_SAMPLE_RATE)
+    M = left.shape[0]
+    hrirLen = min(left.shape[1], MAX_HRIR_LENGTH)
+    left = left[:, :hrirLen]
+    right = right[:, :hrirLen]
+    print(f"File: {input_bin}\n"
+          f"Sample Rate: {sampleRate}\n"
+          f"Measurements: M={M}, HRIR Size={hrirLen}")
+
+    # Normalisation: largest absolute tap of both ears brought to 1
+    peak = np.maximum(np.abs(left).max(axis=1), np.abs(right).max(axis=1))
+    peak[peak == 0.0] = 1.0
+    left = left / peak[:, None]
+    right = right / peak[:, None]
+
+    itd = np.zeros((M, 2))
+    if MIN_PHASE_LEN > 0:
+        outLen = min(MIN_PHASE_LEN, hrirLen)
+        print(f"Minimum phase, {outLen} taps.")
+        minLeft = np.zeros((M, outLen))
+        minRight = np.zeros((M, outLen))
+        for m in range(M):
+            delay = onset(left[m]) - onset(right[m])
+            itd[m] = (max(delay, 0.0), max(-delay, 0.0))
+            minLeft[m] = minimum_phase(left[m], outLen)
+            minRight[m] = minimum_phase(right[m], outLen)
+        left, right, hrirLen = minLeft, minRight, outLen
+
+    # Interleaved taps, one 32 byte aligned block per measurement
+    stride = align(2 * hrirLen * 4) // 4
+    coef = np.zeros((M, stride), dtype=np.float32)
+    coef[:, 0:2 * hrirLen:2] = left
+    coef[:, 1:2 * hrirLen:2] = right
+
+    meta = bytearray()
+    for m in range(M):
+        meta += struct.pack("<fffffIII", positions[m, 0], positions[m, 1], positions[m, 2],
+                            itd[m, 0], itd[m, 1], hrirLen, 0, 0)
+
+    sections = [(b"META", bytes(meta)), (b"COEF", coef.tobytes(order='C'))]
+    spectrumFloats = 0
+    if SPECTRUM_BLOCK > 0:
+        spec = spectra(coef[:, 0:2 * hrirLen:2].astype(np.float64),
+                       coef[:, 1:2 * hrirLen:2].astype(np.float64), SPECTRUM_BLOCK)
+        spectrumFloats = spec.shape[1]
+        sections.append((b"SPEC", spec.tobytes(order='C')))
+
+    # Section table: every section starts on a 32 byte boundary
+    headerBytes = align(HEADER_BYTES + SECTION_ENTRY_BYTES * len(sections))
+    table = bytearray()
+    offset = headerBytes
+    for tag, data in sections:
+        table += tag + struct.pack("<III", offset, len(data), zlib.crc32(data))
+        offset = align(offset + len(data))
+
+    header = b"HRB2" + struct.pack("<10I", 2, headerBytes, int(sampleRate), M, hrirLen, stride,
+                                   MIN_PHASE_LEN, SPECTRUM_BLOCK, spectrumFloats, len(sections))
+    header += struct.pack("<I", zlib.crc32(header + table))
+
+    with open(output_bin, "wb") as f:
+        f.write(header)
+        f.write(table)
+        for tag, data in sections:
+            f.write(b"\0" * (align(f.tell()) - f.tell()))
+            f.write(data)
+
+    print(f"Binary file generated: {output_bin}")
+    print("Format: [ 'HRB2', version, headerBytes, sampleRate, M, hrirLen, stride, minPhaseLen,"
+          " spectrumBlock, spectrumFloats, sectionCount, headerCrc (uint32),"
+          " sectionCount x (tag, offset, bytes, crc32),"
+          " 'META': M x (az, el, dist, itdLeft, itdRight (floats), length, 0, 0 (uint32)),"
+          " 'COEF': M x stride floats (left/right interleaved),"
+          " 'SPEC': M x spectrumFloats floats (optional) ]")
+
+if __name__ == "__main__":
+    main()
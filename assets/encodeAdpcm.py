@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# encodeAdpcm.py
+
+import struct
+import sys
+import numpy as np
+import soundfile as sf
+
+# IMA-ADPCM tables (same as TeensySurround/ImaAdpcm.cpp)
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552,
+    1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+    7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+    24623, 27086, 29794, 32767
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+WAVE_FORMAT_IMA_ADPCM = 0x11
+
+def block_align(channels, sampleRate):
+    """ Usual block size: 256 bytes per channel at 11025 Hz, doubled with each rate doubling """
+    return 256 * channels * max(1, sampleRate // 11025)
+
+def samples_per_block(channels, blockAlign):
+    return (blockAlign - 4 * channels) * 2 // channels + 1
+
+def encode_channel(samples, count, index):
+    """
+    Encodes one channel of a block: samples[0] goes to the header, samples[1:] to nibbles
+    (past `count`, the predictor is held). Returns the header, the nibbles and the step index
+    carried over to the next block.
+    """
+    predictor = int(samples[0]) if count > 0 else 0
+    header = struct.pack("<hBB", predictor, index, 0)
+    nibbles = np.zeros(len(samples) - 1, dtype=np.uint8)
+    for k in range(1, len(samples)):
+        sample = int(samples[k]) if k < count else predictor
+        step = STEP_TABLE[index]
+        diff = sample - predictor
+        nibble = 0
+        if diff < 0:
+            nibble = 8
+            diff = -diff
+        if diff >= step:
+            nibble |= 4
+            diff -= step
+        if diff >= step >> 1:
+            nibble |= 2
+            diff -= step >> 1
+        if diff >= step >> 2:
+            nibble |= 1
+        # Decoder update, so that both sides track the same predictor
+        delta = step >> 3
+        if nibble & 1:
+            delta += step >> 2
+        if nibble & 2:
+            delta += step >> 1
+        if nibble & 4:
+            delta += step
+        predictor += -delta if nibble & 8 else delta
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + INDEX_TABLE[nibble]))
+        nibbles[k - 1] = nibble
+    return header, nibbles, index
+
+def main():
+    """
+    Encodes a 16 bit mono or stereo WAV file into IMA-ADPCM (WAVE_FORMAT_IMA_ADPCM, 4 bits per
+    sample), played by MyAdpcmPlayer: a quarter of the SD card bandwidth and space of PCM.
+
+    Usage: encodeAdpcm.py input.wav output.wav
+
+    Blocks use the usual size (1024 bytes per channel at 44.1 kHz). Each block starts with the
+    first sample and the step index of every channel; in stereo the nibbles are interleaved by
+    groups of 8 samples (4 bytes) per channel, low nibble first. The step index is carried over
+    from one block to the next. A "fact" chunk holds the exact length in frames.
+    """
+    if len(sys.argv) < 3:
+        print(main.__doc__)
+        sys.exit(1)
+    input_file, output_file = sys.argv[1], sys.argv[2]
+
+    data, sampleRate = sf.read(input_file, dtype="int16", always_2d=True)
+    frames, channels = data.shape
+    if channels > 2:
+        sys.exit(f"{input_file}: {channels} channels, IMA-ADPCM files are mono or stereo")
+    align = block_align(channels, sampleRate)
+    spb = samples_per_block(channels, align)
+    blocks = (frames + spb - 1) // spb
+    print(f"{input_file}: {frames} frames, {channels} channel(s) at {sampleRate} Hz, "
+          f"{blocks} blocks of {align} bytes ({spb} frames)")
+
+    indices = [0] * channels
+    body = bytearray()
+    for b in range(blocks):
+        start = b * spb
+        count = min(spb, frames - start)
+        chunk = np.zeros((spb, channels), dtype=np.int16)
+        chunk[:count] = data[start:start + count]
+        headers = []
+        nibbles = []
+        for c in range(channels):
+            header, nib, indices[c] = encode_channel(chunk[:, c], count, indices[c])
+            headers.append(header)
+            nibbles.append(nib)
+        # Groups of 8 nibbles (4 bytes) per channel, low nibble first
+        groups = (spb - 1) // 8
+        packed = [(n[0::2] | (n[1::2] << 4)).reshape(groups, 4) for n in nibbles]
+        body += b"".join(headers)
+        body += np.stack(packed, axis=1).tobytes()
+
+    byteRate = sampleRate * align // spb
+    fmt = struct.pack("<HHIIHHHH", WAVE_FORMAT_IMA_ADPCM, channels, sampleRate, byteRate,
+                      align, 4, 2, spb)
+    chunks = (b"fmt " + struct.pack("<I", len(fmt)) + fmt +
+              b"fact" + struct.pack("<II", 4, frames) +
+              b"data" + struct.pack("<I", len(body)) + bytes(body))
+    with open(output_file, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", 4 + len(chunks)) + b"WAVE" + chunks)
+    pcmBytes = frames * channels * 2
+    print(f"Wrote {output_file}: {len(body)} bytes of data ({pcmBytes / len(body):.2f}x smaller)")
+
+if __name__ == "__main__":
+    main()
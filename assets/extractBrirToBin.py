@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+import struct
+import numpy as np
+import pysofaconventions as pysofa
+from scipy.signal import resample_poly
+
+def main():
+    """
+    Converts a SOFA file containing long impulse responses (BRIR, room responses) into a
+    variable-length binary file ("HRIV") readable by ProjectHrtfEngine::loadFromBin.
+
+    Unlike extractSofaToBin.py, responses are not truncated to a common length: each
+    measurement carries its own length, trimmed after the last sample above a threshold.
+    The first 128 taps are rendered without latency, the tail through HrtfLongConvolver.
+    """
+    sofa_filename = "assets/brir.sofa"  # Input SOFA file
+    output_bin = "assets/brir.bin"  # Output binary file
+    TARGET_SAMPLE_RATE = 44100  # Target sample rate (Hz)
+    MAX_LEN = 44100  # Upper bound on the response length (1 s)
+    TAIL_THRESHOLD_DB = -60.0  # Trailing samples below this level (re. peak) are dropped
+    elev_tol = 1.0  # Tolerance in degrees, None to keep every elevation
+
+    sofa = pysofa.SOFAFile(sofa_filename, 'r')
+    source_sample_rate = int(sofa.getSamplingRate())
+    IR_data = sofa.getDataIR()
+    M, R, N = IR_data.shape
+    source_positions = sofa.getVariableValue("SourcePosition")
+
+    selected_indices = [m for m in range(M)
+                        if elev_tol is None or abs(source_positions[m, 1]) <= elev_tol]
+    selected_indices.sort(key=lambda m: source_positions[m, 0])  # Sort by azimuth
+
+    with open(output_bin, "wb") as f:
+        # Header: magic, sample rate, number of measurements (no common length)
+        f.write(b"HRIV")
+        f.write(struct.pack("<I", TARGET_SAMPLE_RATE))
+        f.write(struct.pack("<I", len(selected_indices)))
+
+        for m in selected_indices:
+            az, el, dist = source_positions[m]
+            left = resample_poly(IR_data[m, 0, :], TARGET_SAMPLE_RATE, source_sample_rate)
+            right = resample_poly(IR_data[m, 1, :], TARGET_SAMPLE_RATE, source_sample_rate)
+
+            # Trim the trailing silence, then fade out the last 5 ms
+            peak = max(np.max(np.abs(left)), np.max(np.abs(right)))
+            threshold = peak * 10 ** (TAIL_THRESHOLD_DB / 20)
+            above = np.nonzero((np.abs(left) > threshold) | (np.abs(right) > threshold))[0]
+            length = min(int(above[-1]) + 1 if len(above) else 1, MAX_LEN)
+            fade = min(length, int(0.005 * TARGET_SAMPLE_RATE))
+            window = np.ones(length)
+            window[length - fade:] = np.hanning(2 * fade)[fade:]
+            left = left[:length] * window
+            right = right[:length] * window
+
+            # Per-measurement record: az, el, dist, length, left, right
+            f.write(struct.pack("<fff", az, el, dist))
+            f.write(struct.pack("<I", length))
+            f.write(np.array(left, dtype=np.float32).tobytes())
+            f.write(np.array(right, dtype=np.float32).tobytes())
+            print(f"az={az:7.2f} el={el:6.2f} length={length} samples")
+
+    print(f"Binary file '{output_bin}' generated at {TARGET_SAMPLE_RATE} Hz!")
+    print("Format: [ 'HRIV', sampleRate (uint32), M (uint32),"
+          " for each M: (az, el, dist) (3 floats), length (uint32),"
+          " left (length floats), right (length floats) ]")
+
+if __name__ == "__main__":
+    main()
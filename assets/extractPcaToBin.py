@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+# extractPcaToBin.py
+
+import struct
+from fractions import Fraction
+import numpy as np
+
+# Rate of the Teensy 4 audio engine (AUDIO_SAMPLE_RATE_EXACT = 750000 / 17 = 44117.647 Hz)
+ENGINE_SAMPLE_RATE = Fraction(750000, 17)
+
+def read_hrir_bin(filename):
+    """
+    Reads a "HRIR" binary file (see extractSofaToBin.py).
+    Returns (sampleRate, positions (M x 3), left (M x N), right (M x N)).
+    """
+    with open(filename, "rb") as f:
+        data = f.read()
+    if data[:4] != b"HRIR":
+        raise ValueError(f"{filename}: magic != 'HRIR'")
+    sampleRate, hrirLen, M = struct.unpack_from("<III", data, 4)
+    offset = 16
+    positions = np.zeros((M, 3))
+    left = np.zeros((M, hrirLen))
+    right = np.zeros((M, hrirLen))
+    for m in range(M):
+        positions[m] = struct.unpack_from("<fff", data, offset)
+        offset += 12
+        left[m] = np.frombuffer(data, "<f4", hrirLen, offset)
+        offset += 4 * hrirLen
+        right[m] = np.frombuffer(data, "<f4", hrirLen, offset)
+        offset += 4 * hrirLen
+    return sampleRate, positions, left, right
+
+def resample_hrirs(sampleRate, left, right, target_rate):
+    """
+    Brings the HRIRs to target_rate (None: the file's own rate) with a polyphase filter whose
+    up/down factors are the exact ratio of the two rates: 125/136 from 48 kHz and 2500/2499 from
+    44.1 kHz to ENGINE_SAMPLE_RATE. The engine converts any other rate when it loads the file;
+    writing the file at its rate only saves that step.
+    Returns (sampleRate, left, right), sampleRate truncated to an integer like the rate given to
+    HrtfBank::init (44117), so that the engine sees the file at its own rate.
+    """
+    if target_rate is None or sampleRate == int(target_rate):
+        return sampleRate, left, right
+    from scipy.signal import resample_poly
+    ratio = Fraction(target_rate) / sampleRate
+    print(f"Resampled from {sampleRate} Hz to {float(target_rate):.3f} Hz "
+          f"(x {ratio.numerator}/{ratio.denominator}).")
+    return (int(target_rate), resample_poly(left, ratio.numerator, ratio.denominator, axis=1),
+            resample_poly(right, ratio.numerator, ratio.denominator, axis=1))
+
+def minimum_phase(h, out_len, fft_size=1024):
+    """
+    Same conversion as hrtfMinimumPhase (HrtfMinimumPhase.cpp): folded real cepstrum,
+    truncation to out_len taps with a half Hann window over the last quarter.
+    """
+    H = np.fft.fft(h, fft_size)
+    log_mag = 0.5 * np.log(np.maximum(np.abs(H) ** 2, 1e-18))
+    c = np.fft.ifft(log_mag).real
+    c[1:fft_size // 2] *= 2.0
+    c[fft_size // 2 + 1:] = 0.0
+    out = np.fft.ifft(np.exp(np.fft.fft(c))).real[:out_len].copy()
+    fade = out_len // 4 if out_len >= 4 else 0
+    for i in range(out_len - fade, out_len):
+        t = (i - (out_len - fade) + 1) / (fade + 1)
+        out[i] *= 0.5 + 0.5 * np.cos(np.pi * t)
+    return out
+
+def onset(h, threshold=0.2):
+    """
+    Same arrival time as hrtfOnset: first crossing of threshold * max|h|, linearly interpolated.
+    """
+    a = np.abs(h)
+    peak = a.max()
+    if peak <= 0.0:
+        return 0.0
+    level = threshold * peak
+    i = int(np.argmax(a >= level))
+    if i == 0:
+        return 0.0
+    return (i - 1) + (level - a[i - 1]) / (a[i] - a[i - 1])
+
+def main():
+    """
+    Converts a binary HRIR file into a principal component ("HRIP") file.
+
+    Every HRIR pair is normalised like HrirBinReader does, optionally converted to minimum
+    phase + fractional ITD like HrtfBank::setMinimumPhase, then approximated by the mean
+    filter plus a weighted sum of the K principal components (left and right taps together).
+    The reconstruction error is printed for several values of K.
+    """
+    input_bin = "assets/hrtf_nh2.bin"     # Input binary file ("HRIR" format)
+    output_bin = "assets/hrtf_nh2_pca.bin"  # Output binary file
+
+    # Sample rate of the written HRIRs (None: the input file's own, converted at load time)
+    TARGET_SAMPLE_RATE = ENGINE_SAMPLE_RATE
+    # Number of components written to the file (the engine may use fewer)
+    COMPONENTS = 16
+    # Minimum phase length in taps (0: measured HRIRs, ITD kept inside the components)
+    MIN_PHASE_LEN = 48
+
+    sampleRate, positions, left, right = read_hrir_bin(input_bin)
+    sampleRate, left, right = resample_hrirs(sampleRate, left, right, TARGET_SAMPLE_RATE)
+    M, N = left.shape
+    print(f"File: {input_bin}\n"
+          f"Sample Rate: {sampleRate}\n"
+          f"Measurements: M={M}, HRIR Size={N}")
+
+    # Normalisation: largest absolute tap of both ears brought to 1
+    peak = np.maximum(np.abs(left).max(axis=1), np.abs(right).max(axis=1))
+    peak[peak == 0.0] = 1.0
+    left = left / peak[:, None]
+    right = right / peak[:, None]
+
+    itd = np.zeros((M, 2))
+    if MIN_PHASE_LEN > 0:
+        hrirLen = min(MIN_PHASE_LEN, N)
+        print(f"Minimum phase, {hrirLen} taps.")
+        minLeft = np.zeros((M, hrirLen))
+        minRight = np.zeros((M, hrirLen))
+        for m in range(M):
+            delay = onset(left[m]) - onset(right[m])
+            itd[m] = (max(delay, 0.0), max(-delay, 0.0))
+            minLeft[m] = minimum_phase(left[m], hrirLen)
+            minRight[m] = minimum_phase(right[m], hrirLen)
+        left, right = minLeft, minRight
+    else:
+        hrirLen = N
+
+    # Principal components of the left/right taps, around the mean filter
+    X = np.concatenate([left, right], axis=1)
+    mean = X.mean(axis=0)
+    U, S, Vt = np.linalg.svd(X - mean, full_matrices=False)
+    K = min(COMPONENTS, Vt.shape[0])
+    weights = (X - mean) @ Vt[:K].T
+
+    # Reconstruction error (energy of the difference over energy of the filters) versus K
+    energy = (X ** 2).sum()
+    print("Reconstruction error versus K:")
+    for k in [1, 2, 4, 8, 12, 16, 24, 32]:
+        if k > Vt.shape[0]:
+            break
+        R = (X - mean) - ((X - mean) @ Vt[:k].T) @ Vt[:k]
+        print(f"  K={k:2d} : {10.0 * np.log10((R ** 2).sum() / energy):6.1f} dB")
+    print(f"Written: K={K}, {K * 4} bytes of weights per measurement "
+          f"instead of {2 * hrirLen * 4} bytes of coefficients.")
+
+    with open(output_bin, "wb") as f:
+        # 1) Header: magic, sample rate, taps per ear, K, M, minimum phase length (0: none)
+        f.write(b"HRIP")
+        f.write(struct.pack("<IIIII", int(sampleRate), hrirLen, K, M, MIN_PHASE_LEN))
+
+        # 2) Mean filter then the K components: left taps, then right taps
+        for v in [mean] + [Vt[k] for k in range(K)]:
+            f.write(np.array(v, dtype=np.float32).tobytes(order='C'))
+
+        # 3) For each measurement: az, el, dist, itdLeft, itdRight (samples), K weights
+        for m in range(M):
+            f.write(struct.pack("<fffff", positions[m, 0], positions[m, 1], positions[m, 2],
+                                itd[m, 0], itd[m, 1]))
+            f.write(np.array(weights[m], dtype=np.float32).tobytes(order='C'))
+
+    print(f"Binary file generated: {output_bin}")
+    print("Format: [ 'HRIP', sampleRate, hrirLen, K, M, minPhaseLen (uint32),"
+          " (K + 1) x (left (hrirLen floats), right (hrirLen floats)),"
+          " for each M: (az, el, dist, itdLeft, itdRight) (5 floats), K weights (floats) ]")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# generateHrirHeader.py
+
+import os
+import numpy as np
+from extractPcaToBin import ENGINE_SAMPLE_RATE, read_hrir_bin, resample_hrirs, minimum_phase, onset
+from convertBinToV2 import MAX_HRIR_LENGTH, ALIGN, align, spectra
+
+# Measurements read in place by HrtfBank::loadFromFlash (MAX_HRIR_SLOTS in HrtfBank.h)
+MAX_HRIR_SLOTS = 128
+VALUES_PER_LINE = 8
+
+def read_sofa(filename):
+    """
+    Reads the HRIRs of a .sofa file, like extractSofaToBin.py.
+    Returns (sampleRate, positions (M x 3), left (M x N), right (M x N)).
+    """
+    import pysofaconventions as pysofa
+    sofa = pysofa.SOFAFile(filename, 'r')
+    ir = np.asarray(sofa.getDataIR(), dtype=np.float64)
+    positions = np.asarray(sofa.getVariableValue("SourcePosition"), dtype=np.float64)
+    return int(sofa.getSamplingRate()), positions, ir[:, 0, :], ir[:, 1, :]
+
+def c_array(name, ctype, values, alignment=None):
+    """
+    One PROGMEM constexpr array, VALUES_PER_LINE shortest round-trip float32 literals per line.
+    """
+    attr = f"alignas({alignment}) " if alignment else ""
+    lines = [f"{attr}static constexpr {ctype} {name}[{len(values)}] PROGMEM = {{"]
+    text = [np.format_float_scientific(np.float32(v), unique=True, trim='-') + "f"
+            if v != 0.0 else "0.0f" for v in values]
+    for i in range(0, len(text), VALUES_PER_LINE):
+        lines.append("    " + ", ".join(text[i:i + VALUES_PER_LINE]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+def main():
+    """
+    Compiles an HRIR dataset into a C++ header (TeensySurround/HrtfFlashData.h) read in place
+    from program flash by HrtfBank::loadFromFlash: the device renders without opening the SD
+    card and without copying any coefficient into RAM.
+
+    The taps are truncated to MAX_HRIR_LENGTH and normalised like HrirBinReader does (optionally
+    converted to minimum phase + fractional ITD like HrtfBank::setMinimumPhase), then written
+    interleaved left/right with a 32 byte aligned stride, next to an index of the measurement
+    directions. The spectra for a given block size can be compiled as well; with another block
+    size the engine computes them in RAM at load time.
+    """
+    input_file = "assets/hrtf_elev0.bin"                 # "HRIR" binary file or .sofa file
+    output_h = "TeensySurround/HrtfFlashData.h"          # Generated header
+
+    # Sample rate of the compiled HRIRs: a compiled bank is read in place, never converted by the
+    # engine (None: the input file's own)
+    TARGET_SAMPLE_RATE = ENGINE_SAMPLE_RATE
+    # Minimum phase length in taps (0: measured HRIRs)
+    MIN_PHASE_LEN = 0
+    # Block size of the compiled spectra (0: none, computed by the engine in RAM)
+    SPECTRUM_BLOCK = 128
+
+    if input_file.endswith(".sofa"):
+        sampleRate, positions, left, right = read_sofa(input_file)
+    else:
+        sampleRate, positions, left, right = read_hrir_bin(input_file)
+    sampleRate, left, right = resample_hrirs(sampleRate, left, right, TARGET_SAMPLE_RATE)
+    M = left.shape[0]
+    if M > MAX_HRIR_SLOTS:
+        raise ValueError(f"{input_file}: {M} measurements, at most {MAX_HRIR_SLOTS} can be "
+                         "read in place (larger datasets: compact bank from the SD card)")
+    hrirLen = min(left.shape[1], MAX_HRIR_LENGTH)
+    left = left[:, :hrirLen]
+    right = right[:, :hrirLen]
+    print(f"File: {input_file}\n"
+          f"Sample Rate: {sampleRate}\n"
+          f"Measurements: M={M}, HRIR Size={hrirLen}")
+
+    # Normalisation: largest absolute tap of both ears brought to 1
+    peak = np.maximum(np.abs(left).max(axis=1), np.abs(right).max(axis=1))
+    peak[peak == 0.0] = 1.0
+    left = left / peak[:, None]
+    right = right / peak[:, None]
+
+    itd = np.zeros((M, 2))
+    if MIN_PHASE_LEN > 0:
+        outLen = min(MIN_PHASE_LEN, hrirLen)
+        print(f"Minimum phase, {outLen} taps.")
+        minLeft = np.zeros((M, outLen))
+        minRight = np.zeros((M, outLen))
+        for m in range(M):
+            delay = onset(left[m]) - onset(right[m])
+            itd[m] = (max(delay, 0.0), max(-delay, 0.0))
+            minLeft[m] = minimum_phase(left[m], outLen)
+            minRight[m] = minimum_phase(right[m], outLen)
+        left, right, hrirLen = minLeft, minRight, outLen
+
+    # Interleaved taps, one 32 byte aligned block per measurement
+    stride = align(2 * hrirLen * 4) // 4
+    coef = np.zeros((M, stride), dtype=np.float32)
+    coef[:, 0:2 * hrirLen:2] = left
+    coef[:, 1:2 * hrirLen:2] = right
+
+    spectrumFloats = 0
+    spec = None
+    if SPECTRUM_BLOCK > 0:
+        spec = spectra(coef[:, 0:2 * hrirLen:2].astype(np.float64),
+                       coef[:, 1:2 * hrirLen:2].astype(np.float64), SPECTRUM_BLOCK)
+        spectrumFloats = spec.shape[1]
+
+    index = ["static constexpr HrtfFlashMeasurement hrtfFlashIndex[%d] PROGMEM = {" % M]
+    for m in range(M):
+        values = [positions[m, 0], positions[m, 1], positions[m, 2], itd[m, 0], itd[m, 1]]
+        index.append("    { " + ", ".join(
+            np.format_float_positional(np.float32(v), unique=True, trim='0') + "f"
+            for v in values) + " },")
+    index.append("};")
+
+    parts = [
+        f"// Généré par assets/generateHrirHeader.py depuis {os.path.basename(input_file)} :",
+        "// ne pas modifier. Inclus par HrtfFlashBank.cpp seulement.",
+        "#ifndef HRTF_FLASH_DATA_H",
+        "#define HRTF_FLASH_DATA_H",
+        "",
+        '#include "HrtfFlashBank.h"',
+        "",
+        "\n".join(index),
+        "",
+        c_array("hrtfFlashCoeffs", "float", coef.reshape(-1), ALIGN),
+        "",
+    ]
+    if spec is not None:
+        parts += [c_array("hrtfFlashSpectra", "float", spec.reshape(-1), ALIGN), ""]
+    parts += [
+        "static constexpr HrtfFlashBank hrtfFlashData = {",
+        f"    {int(sampleRate)}, {M}, {hrirLen}, {stride}, {MIN_PHASE_LEN}, {SPECTRUM_BLOCK}, "
+        f"{spectrumFloats},",
+        "    hrtfFlashIndex, hrtfFlashCoeffs, " +
+        ("hrtfFlashSpectra" if spec is not None else "nullptr"),
+        "};",
+        "",
+        "#endif",
+        "",
+    ]
+    with open(output_h, "w", encoding="utf-8") as f:
+        f.write("\n".join(parts))
+
+    flashBytes = M * (20 + 4 * stride + 4 * spectrumFloats)
+    print(f"Header generated: {output_h} ({flashBytes} bytes of flash, "
+          f"{M * 4 * stride} of coefficients, {M * 4 * spectrumFloats} of spectra)")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# makeStems.py
+
+import struct
+import sys
+import numpy as np
+import soundfile as sf
+
+# Container layout read by SdStemReader (TeensySurround/SdStemReader.h)
+VERSION = 1
+MAX_STEMS = 8
+HEADER_BYTES = 24
+NAME_BYTES = 16
+STEM_ENTRY_BYTES = 8 + NAME_BYTES
+SECTOR = 512
+# Frames per stem in each interleaved block: a power of 2, at least 256 (whole sectors per
+# slice) and at most half of HRTF_STEM_BUFFER_FRAMES (4096 by default)
+BLOCK_FRAMES = 1024
+
+def parse_stem(arg):
+    """ "file.wav[:azimuth[:elevation[:gain]]]" -> (file, azimuth, elevation, gain) """
+    parts = arg.split(":")
+    values = [float(p) for p in parts[1:]] + [0.0, 0.0, 1.0][len(parts) - 1:]
+    return parts[0], int(round(values[0])), int(round(values[1])), values[2]
+
+def main():
+    """
+    Writes a "STEM" container: up to 8 mono stems of a song (vocals, drums, bass...) interleaved
+    in large blocks, so that the engine plays all of them from one sequential read of the SD card
+    (MyStemPlayer feeding a MySpatialMixer) instead of seeking between separate WAV files.
+
+    Usage: makeStems.py output.stm vocals.wav:0:0 drums.wav:-30:0:0.8 bass.wav:30 ...
+    Each stem is "file[:azimuth[:elevation[:gain]]]" (degrees, default 0:0:1), stored in the
+    header as its default position. Stereo stems are mixed down to mono; all stems must share
+    the same sample rate, and shorter ones are padded with silence.
+
+    The data starts on a 512 byte boundary. Each block holds BLOCK_FRAMES samples of stem 0,
+    then of stem 1, and so on (16 bit PCM); the last block is padded with zeros.
+    """
+    if len(sys.argv) < 3:
+        print(main.__doc__)
+        sys.exit(1)
+    output_file = sys.argv[1]
+    stems = [parse_stem(a) for a in sys.argv[2:]]
+    if len(stems) > MAX_STEMS:
+        sys.exit(f"At most {MAX_STEMS} stems")
+
+    sampleRate = None
+    signals = []
+    for name, azimuth, elevation, gain in stems:
+        data, rate = sf.read(name, dtype="int16", always_2d=True)
+        if sampleRate is None:
+            sampleRate = rate
+        elif rate != sampleRate:
+            sys.exit(f"{name}: {rate} Hz, expected {sampleRate} Hz")
+        if data.shape[1] > 1:
+            data = np.round(data.astype(np.float64).mean(axis=1)).astype(np.int16)
+        else:
+            data = data[:, 0]
+        signals.append(data)
+        print(f"{name}: {len(data)} frames, azimuth {azimuth}, elevation {elevation}, gain {gain}")
+
+    N = len(signals)
+    frameCount = max(len(s) for s in signals)
+    blocks = (frameCount + BLOCK_FRAMES - 1) // BLOCK_FRAMES
+    padded = np.zeros((N, blocks * BLOCK_FRAMES), dtype="<i2")
+    for i, s in enumerate(signals):
+        padded[i, :len(s)] = s
+    # (stem, block, frame) -> (block, stem, frame)
+    interleaved = padded.reshape(N, blocks, BLOCK_FRAMES).transpose(1, 0, 2)
+
+    header_size = HEADER_BYTES + N * STEM_ENTRY_BYTES
+    dataOffset = (header_size + SECTOR - 1) // SECTOR * SECTOR
+    header = bytearray(dataOffset)
+    struct.pack_into("<4sHHIIII", header, 0, b"STEM", VERSION, N, sampleRate, frameCount,
+                     BLOCK_FRAMES, dataOffset)
+    for i, (name, azimuth, elevation, gain) in enumerate(stems):
+        label = name.replace("\\", "/").split("/")[-1].rsplit(".", 1)[0].encode()[:NAME_BYTES]
+        struct.pack_into(f"<hhf{NAME_BYTES}s", header, HEADER_BYTES + i * STEM_ENTRY_BYTES,
+                         azimuth, elevation, gain, label)
+
+    with open(output_file, "wb") as f:
+        f.write(header)
+        f.write(np.ascontiguousarray(interleaved).tobytes())
+    print(f"Wrote {output_file}: {N} stems, {frameCount} frames at {sampleRate} Hz, "
+          f"blocks of {BLOCK_FRAMES} frames ({N * BLOCK_FRAMES * 2} bytes)")
+
+if __name__ == "__main__":
+    main()